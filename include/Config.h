@@ -21,9 +21,120 @@
 // =================================================================================
 
 #define SERIAL_BAUD_RATE 115200
+
+// --- Task Layout ---
+// engine : Safety, inputs, session engine, event stream. Sleeps until the next
+//          engine second is due or a button edge arrives; polls only while a
+//          gesture/debounce is in flight.
+// io     : Serial drain, sensor sampling and (JLed only) LED animation. Never touches session state.
+// Define LEGACY_SINGLE_LOOP to run everything from the Arduino loop() instead.
+#define ENGINE_TASK_STACK 8192
+#define ENGINE_TASK_PRIORITY 3   // Above loopTask/io, below WiFi/LwIP
+#define ENGINE_TASK_CORE 1       // Arduino APP_CPU
+#define ENGINE_IDLE_WAIT_MS 1500 // Longest blocked wait (the engine deadline is never further than 1 s)
+#define INPUT_POLL_MS 10         // Button/interlock polling while a transition is in flight
+#define IO_TASK_STACK 3072       // Formats binary events
+#define IO_TASK_PRIORITY 1       // Just above idle
+#define IO_TASK_CORE 0           // Away from the engine core
+#define LED_UPDATE_MS 20         // JLed animation step
+
+// --- Status LED Driver ---
+// 1: patterns run on the LEDC peripheral (see LedcStatusLed), JLed only if LEDC setup fails.
+// 0: JLed, animated by the io task every LED_UPDATE_MS.
+#define LED_DRIVER_LEDC 1
+#define LED_LEDC_TIMER 3        // High numbers: Arduino's analogWrite/ledcAttach allocate from 0
+#define LED_LEDC_CHANNEL 7
+#define LED_LEDC_FREQ_HZ 5000   // PWM frequency (8-bit duty)
+
+// --- Low Power (LOCKED / ABORTED) ---
+// Long sessions drop to frequency scaling + automatic light sleep (see lib/PowerPolicy).
+// Timers are deadline based on esp_timer, which keeps counting through sleep.
+// Buttons and the interlock wake the CPU by GPIO level; WiFi modem sleep is chosen
+// so the radio never holds a keep-alive back longer than keepAliveInterval / divisor.
+// Light sleep also needs CONFIG_PM_ENABLE and CONFIG_FREERTOS_USE_TICKLESS_IDLE in
+// the framework; without them only modem sleep (and DFS, if PM is on) apply.
+#define LOW_POWER_MODE 1
+#define LOW_POWER_MAX_FREQ_MHZ 240       // Clock outside low-power mode
+#define LOW_POWER_MIN_FREQ_MHZ 40        // XTAL; the WiFi driver raises it while the radio works
+#define LOW_POWER_KEEPALIVE_DIVISOR 4    // Share of keepAliveInterval the radio may add to a keep-alive
+#define MODEM_SLEEP_MIN_LATENCY_MS 103   // Worst receive delay waking every DTIM (1 beacon)
+#define MODEM_SLEEP_MAX_LATENCY_MS 308   // Worst receive delay at the STA default listen interval (3 beacons)
+#define POWER_AWAKE_UA 25000             // Board draw awake at low clock with modem sleep (estimate input)
+#define POWER_LIGHT_SLEEP_UA 1500        // Board draw in light sleep, WiFi associated (estimate input)
+
 #define DEFAULT_WDT_TIMEOUT 20 // Relaxed for READY state
 #define CRITICAL_WDT_TIMEOUT 5 // Tight for LOCKED state
 #define MAX_SAFE_TEMP_C 85.0   // Safety Threshold (85°C)
+#define BUTTON_DEBOUNCE_MS 50  // Edge lockout per button
+#define BUTTON_CLICK_MS 400    // Double-click window
+#define BUTTON_EDGE_RING 128   // ISR -> engine edge queue per button (bytes, power of two)
+#define HEALTH_CHECK_MS 5000   // Heap / over-temperature check period (cached sample)
+#define SENSOR_SAMPLE_MS 1000  // Temperature, RSSI and heap sampling period (io task)
+#define SENSOR_EMA_ALPHA 0.2f  // Smoothing per sample (~5 s time constant at 1 Hz)
+#define SENSOR_STALE_MS 5000   // Older samples make the health check read the hardware itself
+
+// --- Web Responses ---
+// Every JSON document and response buffer is built in a leased arena (static,
+// never the heap). All arenas busy -> 503. Largest user is /details (~4 KB).
+#define JSON_ARENA_SIZE 6144 // Bytes per arena
+#define JSON_ARENA_COUNT 3   // Concurrent JSON builders (HTTP handlers + event stream)
+#define BODY_MAX_SIZE 2048   // Largest accepted request body (bigger -> 413)
+#define BODY_PENDING_MAX 2   // Fragmented bodies being reassembled at once (one arena each)
+
+// --- HTTP Admission Control ---
+// Per-client token bucket (see lib/AdmissionControl). /abort and /keepalive bypass it.
+// Empty bucket -> 429; heavy responses (/details, /log, /metrics) are also capped in flight.
+// Over the cap a heavy request waits for a slot; a full queue or a wait that runs out -> 503.
+#define ADMISSION_CLIENTS 8             // Client addresses tracked at once
+#define ADMISSION_BURST 20              // Requests a client may send back to back
+#define ADMISSION_RATE_PER_SEC 10       // Sustained requests per second per client
+#define ADMISSION_HEAVY_COST 4          // Tokens charged for a heavy response
+#define ADMISSION_HEAVY_MAX_IN_FLIGHT 2 // Heavy responses at once (leaves an arena for /status)
+#define ADMISSION_HEAVY_MAX_QUEUED 4    // Heavy requests waiting for a slot
+#define ADMISSION_HEAVY_MAX_WAIT_MS 2000
+#define ADMISSION_HEAVY_LOCK_MS 20      // Longest engine lock wait for a heavy handler
+
+// --- UDP Command Channel ---
+// Keep-alive / status / abort as single authenticated datagrams (see lib/UdpProtocol).
+#define UDP_COMMAND_PORT 4210
+#define UDP_REPLAY_CLIENTS 8 // Clients tracked for replay protection at once
+#define UDP_LOCK_TIMEOUT_MS 20 // Longest wait for the engine lock before answering BUSY
+#define UDP_PAIRING_WINDOW_MS (5UL * 60UL * 1000UL) // GET /udp hands out the key this long after boot or a key reset
+
+// --- BLE Provisioning ---
+// Characteristic writes are staged in a SettingsTransaction and committed as
+// one validated set once the client has been quiet this long (or on restart).
+#define PROV_COMMIT_IDLE_MS 1500
+
+// --- Session History ---
+// One record per finished session, appended to a raw flash ring (see lib/SessionEngine/SessionHistory.h)
+// at the start of the data partition with this label (the "spiffs" slot of no_ota.csv, otherwise unused).
+// The engine only queues the record; the io task writes it. GET /history pages through the ring.
+#define HISTORY_PARTITION_LABEL "spiffs"
+#define HISTORY_SECTORS 16       // 64 KB ring, a few thousand sessions; oldest sector recycled when full
+#define HISTORY_PENDING_RING 256 // Engine -> io task hand-off (bytes, power of two)
+#define HISTORY_PAGE_DEFAULT 20  // Entries per /history page without ?limit
+#define HISTORY_PAGE_MAX 100
+
+// --- Engine Trace (ENGINE_TRACE builds only, see include/EngineTracing.h) ---
+// Everything the engine reads and does from boot, for replay on the host. About
+// 12 bytes per engine second (~45 minutes); recording stops when full.
+#define TRACE_BUFFER_SIZE 32768
+
+// --- Network Boot ---
+// WiFi connects in the background after the engine is running. If the first
+// connection has not come up within this window, provisioning is requested.
+#define WIFI_BOOT_TIMEOUT_MS 30000
+// Reconnects try the last good BSSID/channel first (no scan) and fall back to a
+// full scan if that fails. Building with -D WIFI_REUSE_DHCP_LEASE=1 also replays
+// the DHCP lease as a static address on those directed attempts (no DHCP round
+// trip). Only enable it where the router keeps the lease reserved for this device.
+// Only a lease DHCP granted since boot is replayed, for WIFI_LEASE_MAX_AGE_MS; a
+// connection still on it then drops and reconnects through DHCP to renew it.
+#ifndef WIFI_REUSE_DHCP_LEASE
+#define WIFI_REUSE_DHCP_LEASE 0
+#endif
+#define WIFI_LEASE_MAX_AGE_MS (30UL * 60UL * 1000UL) // 30 minutes
 
 // System Identification
 #define MAGIC_VALUE 0x3CBDD200
@@ -42,8 +153,14 @@
 #endif
 
 // --- Channel-Specific Configuration ---
+// One GPIO per channel, in channel order. Boards with more outputs override both,
+// e.g. -D MAX_CHANNELS=8 -D 'BOARD_CHANNEL_PINS=16,17,26,27,18,19,22,25'.
+#ifndef BOARD_CHANNEL_PINS
+#define BOARD_CHANNEL_PINS 16, 17, 26, 27
+#endif
 
-static const int HARDWARE_PINS[MAX_CHANNELS] = {16, 17, 26, 27};
+static const int HARDWARE_PINS[] = {BOARD_CHANNEL_PINS};
+static_assert(sizeof(HARDWARE_PINS) / sizeof(HARDWARE_PINS[0]) == MAX_CHANNELS, "BOARD_CHANNEL_PINS must list MAX_CHANNELS pins");
 
 // --- Enums & Structs ---
 
@@ -60,7 +177,8 @@ static const SystemDefaults DEFAULT_SYSTEM_DEFS = {
     5,     // bootLoopThreshold
     30000, // stableBootTime
     3,     // wifiMaxRetries
-    60     // armedTimeout
+    60,    // armedTimeout
+    30     // checkpointInterval
 };
 
 #else
@@ -76,6 +194,7 @@ static const SystemDefaults DEFAULT_SYSTEM_DEFS = {
     5,      // bootLoopThreshold
     120000, // stableBootTime
     5,      // wifiMaxRetries
-    1800    // armedTimeout
+    1800,   // armedTimeout
+    60      // checkpointInterval
 };
 #endif
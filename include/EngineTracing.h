@@ -0,0 +1,47 @@
+/*
+ * =================================================================================
+ * File:      include/EngineTracing.h
+ * Description:
+ * On-device recording of engine traces (see lib/SessionEngine/EngineTrace.h),
+ * downloaded from GET /trace and replayed on the host by test/TraceReplay.h.
+ * - The engine runs on engineHal(): the trace recorder wrapping
+ *   Esp32SessionHAL, or Esp32SessionHAL itself.
+ * - TRACE_* record each call into the engine. Place them right before the
+ *   call, under the same state lock, so the trace keeps the real order.
+ * - Recording starts at boot and stops when TRACE_BUFFER_SIZE is full.
+ * - Compiled out entirely unless built with -D ENGINE_TRACE (the trace env).
+ * =================================================================================
+ */
+#pragma once
+#include "Esp32SessionHAL.h"
+
+#ifdef ENGINE_TRACE
+#include "Config.h"
+#include "EngineTrace.h"
+
+typedef TraceRecordingHAL<TRACE_BUFFER_SIZE> EngineTraceHAL;
+
+EngineTraceHAL &engineTrace();
+inline ISessionHAL &engineHal() { return engineTrace(); }
+
+#define TRACE_SETUP(defaults, presets, deterrents) engineTrace().recordSetup(defaults, presets, deterrents)
+#define TRACE_LOAD(state, timers, stats, config) engineTrace().recordLoad(state, timers, stats, config)
+#define TRACE_START(config) engineTrace().recordStart(config)
+#define TRACE_UPDATE(nowMs) engineTrace().recordUpdate(nowMs)
+#define TRACE_CALL(kind) engineTrace().recordCall(kind)
+#define TRACE_CALL_FLAG(kind, flag) engineTrace().recordCall(kind, flag)
+#define TRACE_RESULT(code) engineTrace().recordResult(code)
+
+#else
+
+inline ISessionHAL &engineHal() { return Esp32SessionHAL::getInstance(); }
+
+#define TRACE_SETUP(defaults, presets, deterrents) ((void)0)
+#define TRACE_LOAD(state, timers, stats, config) ((void)0)
+#define TRACE_START(config) ((void)0)
+#define TRACE_UPDATE(nowMs) ((void)0)
+#define TRACE_CALL(kind) ((void)0)
+#define TRACE_CALL_FLAG(kind, flag) ((void)0)
+#define TRACE_RESULT(code) ((void)0)
+
+#endif
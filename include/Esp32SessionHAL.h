@@ -8,13 +8,41 @@
  */
 #pragma once
 
+#include "ButtonGesture.h"
 #include "Globals.h"
+#include "LatencyStats.h"
+#include "LedcStatusLed.h"
+#include "LogArena.h"
+#include "PowerPolicy.h"
+#include "SensorStats.h"
+#include "SpscRing.h"
 #include "SessionContext.h"
 #include "Types.h"
 #include <Arduino.h>
-#include <OneButton.h>
+#include <esp_pm.h>
 #include <jled.h>
 
+// Boot pipeline stages, in the order setup() completes them.
+// WIFI completes asynchronously whenever the first GOT_IP arrives.
+enum BootPhase : uint8_t {
+  BOOT_PHASE_HAL,     // Pins safe, ISRs and io task up
+  BOOT_PHASE_RESTORE, // NVS settings and session state loaded
+  BOOT_PHASE_ENGINE,  // Engine restored and its task running
+  BOOT_PHASE_NETWORK, // WiFi connect started (not yet connected)
+  BOOT_PHASE_WEB,     // HTTP server listening
+  BOOT_PHASE_WIFI,    // First IP address acquired
+  BOOT_PHASE_COUNT
+};
+
+// Smoothed die temperature (C), RSSI (dBm) and free heap (bytes), sampled by the
+// io task every SENSOR_SAMPLE_MS. rssi is reset (invalid) while WiFi is down.
+struct SensorSample {
+  SmoothedReading temperature;
+  SmoothedReading rssi;
+  SmoothedReading heap;
+  unsigned long takenAtMs; // millis() of the latest sample (0 = none yet)
+};
+
 class Esp32SessionHAL : public ISessionHAL {
 private:
   Esp32SessionHAL();
@@ -26,6 +54,7 @@ private:
   volatile bool _triggerActionPending;
   volatile bool _abortActionPending;
   volatile bool _shortPressPending;
+  volatile bool _statePublishPending; // Set on every saveState(), drained by the event stream
 
   // -- Button State Tracking --
   volatile bool _pcbPressed;
@@ -41,51 +70,70 @@ private:
   DeviceState _cachedState;
 
   // --- Log State (RAM + Serial) ---
-  char _logBuffer[LOG_BUFFER_SIZE][MAX_LOG_LENGTH]; // For WebAPI
-  int _logBufferIndex;
-  char _serialQueue[SERIAL_QUEUE_SIZE][MAX_LOG_LENGTH]; // For Serial
-  int _queueHead;
-  int _queueTail;
+  // /log reads the packed arena by sequence; Serial is fed through a lock-free
+  // ring drained by a low-priority task, so UART time never lands in tick().
+  LogArena<LOG_ARENA_SIZE> _logArena; // Guarded by s_logMux
+  SpscRing<SERIAL_RING_SIZE> _serialRing;
+  TaskHandle_t _ioTask;
+  volatile uint32_t _serialDropped; // Records rejected because the serial ring was full
+
+  // --- Safety Latency (input -> engine -> mask) ---
+  LatencyTracker<SAFETY_CAUSE_COUNT> _latency; // Guarded by s_latencyMux
 
   // --- Peripherals ---
-  OneButton _pcbButton;
-  OneButton _extButton;
+  // Classified from ISR-timestamped edges (see pollButtons)
+  ButtonGesture _pcbButton;
+  ButtonGesture _extButton;
   JLed _statusLed;
 
   // --- LED ----
+  // Pattern changes come from the engine task. With LEDC the hardware runs them;
+  // otherwise the io task animates JLed.
+  SemaphoreHandle_t _ledMutex;
   bool _isLedEnabled;
+  LedcStatusLed _ledc;
+  bool _useLedc; // LED_DRIVER_LEDC and the LEDC setup succeeded
 
   // --- Channel ---
-  uint8_t _enabledChannelsMask;
+  ChannelMask _enabledChannelsMask;
+
+  // --- Sensor Sampler (written by the io task, copied out under a spinlock) ---
+  SensorSample _sensors;
+
+  // --- Power (see Config.h: Low Power) ---
+  // Both PM locks are held outside low-power mode; releasing them lets the
+  // CPU scale down and enter light sleep whenever every task is blocked.
+  esp_pm_lock_handle_t _pmCpuLock;
+  esp_pm_lock_handle_t _pmSleepLock;
+  bool _pmActive;   // esp_pm configured (DFS, plus light sleep when the framework has it)
+  bool _lightSleep; // Automatic light sleep enabled
+  bool _lowPower;
+  PowerMeter _power; // Guarded by a spinlock (sleep hook, engine task, web handlers)
 
   // --- Health Tracking ---
   unsigned long _lastHealthCheck;
   unsigned long _bootStartTime;
   bool _bootMarkedStable;
+  volatile int64_t _bootPhaseUs[BOOT_PHASE_COUNT]; // esp_timer time each phase completed (0 = pending)
 
   // --- Helpers ---
   void updateLedPattern(DeviceState state);
+  void updatePowerMode(DeviceState state);
+  void initPowerManagement();
   void checkSystemHealth();
   void checkBootLoop();
   void markBootStability();
-  void processLogQueue();
+  void startIoTask();
+  static void ioTask(void *arg);
+  void sampleSensors(); // Only caller of temperatureRead()/WiFi.RSSI() at runtime
+  bool updateLed(); // Returns true while an animation is running
   void checkPressState();   // Helper to manage start time logic
   void updateSafetyLogic(); // Internal Debounce & Grace Period Logic
 
-  // --- Static Interrupt/Callback Handlers ---
-  // PCB Handlers
-  static void handlePcbPressStart();  // Tracks button down
-  static void handlePcbClick();       // Tracks button up + Short Press Action
-  static void handlePcbDoubleClick(); // Tracks button up + Trigger Action
-  static void handlePcbLongStart();   // Abort Action
-  static void handlePcbLongStop();    // Tracks button up
-
-  // External Handlers
-  static void handleExtPressStart();
-  static void handleExtClick();
-  static void handleExtDoubleClick();
-  static void handleExtLongStart();
-  static void handleExtLongStop();
+  // --- Button Input ---
+  void pollButtons();                  // Drains captured edges and runs the classifiers
+  void applyGesture(uint8_t events, const ButtonGesture &button); // Maps ButtonGestureEvent bits to pending actions
+  void markLatencyDetected(uint8_t cause, uint32_t lateMs);       // lateMs: how long ago the condition became true
 
 public:
   static Esp32SessionHAL &getInstance();
@@ -93,6 +141,19 @@ public:
   void initialize();
   void tick();
 
+  // --- Task Wake-up (see Config.h: Task Layout) ---
+  static constexpr uint32_t NOTIFY_INPUT = 1u << 1; // Button/interlock edge
+
+  // Button edge interrupts notify 'task' with NOTIFY_INPUT.
+  void setInputWakeTask(TaskHandle_t task);
+
+  // How long the engine task may block before inputs need polling again.
+  uint32_t inputPollIntervalMs() const;
+
+  // Engine task woke up: by an input edge, or on its own deadline (esp_timer us).
+  // Feeds the low-power wake latency histograms.
+  void recordEngineWake(bool byInput, int64_t dueUs);
+
   // --- Thread Safety (Mutex Wrapper) ---
   // Returns true if lock acquired, false if timeout/busy
   bool lockState(uint32_t timeoutMs = 100);
@@ -100,16 +161,56 @@ public:
 
   // --- Logging API ---
   void log(const char *message) override;
+  void logEvent(const EngineEvent &event) override;
   void logKeyValue(const char *key, const char *value);
   void printStartupDiagnostics();
 
+  // Records when a boot phase completed (first call wins). Safe from any task.
+  void markBootPhase(BootPhase phase);
+
   // -- Accessor for WebServer
-  const char *getLogLine(int index) const {
-    if (index >= 0 && index < LOG_BUFFER_SIZE)
-      return _logBuffer[index];
-    return "";
-  }
-  int getLogBufferIndex() const { return _logBufferIndex; }
+  typedef LogArena<LOG_ARENA_SIZE>::Cursor LogCursor;
+
+  // Positions 'cursor' at line 'since' (the oldest retained line if 'since' is out of
+  // range, see LogArena::copySince). Returns the sequence the next logged line will get.
+  uint32_t seekLog(uint32_t since, LogCursor &cursor);
+
+  // Renders the line at 'cursor' into 'out' and advances it; false once the cursor
+  // reaches 'endSeq'. Lines evicted since the cursor was placed are skipped. Only the
+  // raw record is copied under the log lock; binary events are formatted outside it.
+  bool readLogLine(LogCursor &cursor, uint32_t endSeq, char *out, size_t outSize, size_t &len);
+
+  // Renders one arena record (text line or tagged binary event) as NUL-terminated text.
+  static size_t renderLogRecord(const uint8_t *rec, size_t len, char *out, size_t outSize);
+
+  // Arena occupancy for /details
+  struct LogStats {
+    uint32_t capacityBytes;
+    uint32_t usedBytes;
+    uint32_t lines;
+    uint32_t nextSeq;
+    uint32_t serialDropped;
+  };
+  LogStats getLogStats();
+
+  // Safety latency histograms for /details (copied under a spinlock)
+  typedef LatencyTracker<SAFETY_CAUSE_COUNT> LatencyReport;
+  void copyLatencyStats(LatencyReport &out);
+  void resetLatencyStats();
+
+  // Latest sensor sample (constant time, no hardware access). Safe from any task.
+  void getSensorSample(SensorSample &out);
+
+  // Power mode accounting for /details and /metrics (copied under a spinlock)
+  struct PowerReport {
+    PowerMeter meter;
+    uint64_t nowUs;   // Clock the meter's running interval is measured against
+    bool pmActive;
+    bool lightSleep;
+    bool sleepMeasured; // Light sleep time is reported by the framework (else the estimate is unavailable)
+    ModemSleep modemSleep;
+  };
+  void getPowerReport(PowerReport &out);
 
   // --- Used by BLE provisioning & Telemetry
   JLed getStatusLed() const { return _statusLed; }
@@ -121,12 +222,12 @@ public:
   uint32_t getCurrentPressDurationMs() const;
 
   // --- Channel modifiers
-  void setChannelMask(uint8_t mask);
-  uint8_t getChannelMask() const;
+  void setChannelMask(ChannelMask mask);
+  ChannelMask getChannelMask() const;
   bool isChannelEnabled(int channelIndex) const;
 
   // --- ISessionHAL Implementation ---
-  void setHardwareSafetyMask(uint8_t mask) override;
+  void setHardwareSafetyMask(ChannelMask mask) override;
   bool checkTriggerAction() override;
   bool checkAbortAction() override;
   bool checkShortPressAction() override;
@@ -144,11 +245,22 @@ public:
   void disarmFailsafeTimer() override;
 
   void saveState(const DeviceState &state, const SessionTimers &timers, const SessionStats &stats, const SessionConfig &config);
+  void saveCheckpoint(const DeviceState &state, const SessionTimers &timers, const SessionStats &stats) override;
+  void appendHistory(const HistoryEntry &entry) override;
   unsigned long getMillis() override;
   uint32_t getRandom(uint32_t min, uint32_t max) override;
+  void fillRandom(uint8_t *buf, size_t len) override;
+
+  // Returns true (once) if the engine persisted a state change since the last call
+  bool consumeStateChanged() {
+    bool pending = _statePublishPending;
+    _statePublishPending = false;
+    return pending;
+  }
 
   // Internal Setters for ISRs/Callbacks
   void setTriggerPending() { _triggerActionPending = true; }
   void setAbortPending() { _abortActionPending = true; }
+  bool isAbortPending() const { return _abortActionPending; }
   void setShortPressPending() { _shortPressPending = true; }
 };
\ No newline at end of file
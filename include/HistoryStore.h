@@ -0,0 +1,69 @@
+/*
+ * =================================================================================
+ * File:      include/HistoryStore.h
+ * Description:
+ * Device side of the session history (see lib/SessionEngine/SessionHistory.h).
+ * - Singleton Architecture, like WebManager.
+ * - The ring sits in the HISTORY_PARTITION_LABEL data partition, outside NVS.
+ * - enqueue() runs on the engine side and never touches flash; the io task
+ *   drains the queue, so a sector erase never delays an abort.
+ * - Readers (GET /history) page with a cursor under the store mutex.
+ * =================================================================================
+ */
+#pragma once
+#include "Config.h"
+#include "SessionHistory.h"
+#include "SpscRing.h"
+#include <Arduino.h>
+#include <esp_partition.h>
+
+typedef SessionHistory<HISTORY_SECTORS> HistoryLog;
+
+// Counters and bounds (exposed in /history and /metrics)
+struct HistoryStats {
+  bool mounted;
+  uint32_t first;    // Oldest seq still stored
+  uint32_t next;     // Seq the next record gets
+  uint32_t boot;     // Boot epoch stamped on this boot's records
+  uint32_t written;  // Records appended since boot
+  uint32_t dropped;  // Queue full (engine side)
+  uint32_t failed;   // Flash errors or no partition (io side)
+  uint32_t maxAppendUs;
+};
+
+class HistoryStore {
+public:
+  static HistoryStore &getInstance();
+
+  // Finds the partition and mounts the ring. Call before the engine restores its state.
+  bool begin();
+
+  // Engine side (Esp32SessionHAL::appendHistory). Callers serialize via the state lock.
+  bool enqueue(const HistoryEntry &entry);
+
+  // io task: writes queued records. Returns false if nothing was pending.
+  bool drain();
+
+  // Paging from any task: seek() once, then next() until it returns false
+  void seek(uint32_t seq, HistoryLog::Cursor &cursor);
+  bool next(HistoryLog::Cursor &cursor, HistoryEntry &out);
+
+  HistoryStats getStats();
+
+private:
+  HistoryStore();
+
+  class PartitionFlash : public IHistoryFlash {
+  public:
+    const esp_partition_t *part = nullptr;
+    bool read(uint32_t addr, void *buf, size_t len) override;
+    bool write(uint32_t addr, const void *buf, size_t len) override;
+    bool eraseSector(uint32_t addr) override;
+  };
+
+  PartitionFlash _flash;
+  HistoryLog _log;
+  SpscRing<HISTORY_PENDING_RING> _pending;
+  SemaphoreHandle_t _mutex;
+  HistoryStats _stats; // 'dropped' is engine side only, everything else under _mutex
+};
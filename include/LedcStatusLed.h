@@ -0,0 +1,39 @@
+/*
+ * =================================================================================
+ * File:      include/LedcStatusLed.h
+ * Description:
+ * Status LED driven by the LEDC peripheral instead of JLed.
+ * - Patterns come from lib/LedPattern; one segment is programmed at a time.
+ * - Ramps run on the LEDC fade engine, blinks and holds are plain duty writes.
+ * - An esp_timer one-shot advances to the next segment, so the CPU is only
+ *   involved at segment boundaries (a few times per second at most), never per frame.
+ * - Owned by Esp32SessionHAL, which falls back to JLed if begin() fails.
+ * =================================================================================
+ */
+#pragma once
+#include "LedPattern.h"
+#include <Arduino.h>
+#include <esp_timer.h>
+
+class LedcStatusLed {
+public:
+  LedcStatusLed();
+
+  // Configures the LEDC timer/channel on 'pin'. False if the peripheral is unavailable.
+  bool begin(int pin);
+
+  // Replaces the running pattern immediately. Safe from any task.
+  void play(const LedPattern &pattern);
+
+  bool isActive() const { return _timer != nullptr; }
+
+private:
+  static void onSegmentEnd(void *arg); // esp_timer task
+  void startSegment();                 // Caller holds _mutex
+  void writeLevel(uint8_t level);
+
+  esp_timer_handle_t _timer;
+  SemaphoreHandle_t _mutex;
+  LedSequencer _seq;
+  int64_t _segmentEndUs; // When the armed segment ends (filters stale timer callbacks)
+};
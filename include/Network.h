@@ -6,10 +6,25 @@
  * =================================================================================
  */
 #pragma once
+#include "PowerPolicy.h"
+#include "SettingsManager.h"
 #include <Arduino.h>
 #include <WiFi.h>
 #include <freertos/timers.h>
 
+// WiFi.begin() -> GOT_IP timing (exposed in /details).
+struct WiFiConnectStats {
+  uint32_t attempts;      // Connects started (directed and full scan)
+  uint32_t connects;      // Connects that reached GOT_IP
+  uint32_t directed;      // ...of which used the cached BSSID/channel
+  uint32_t fallbacks;     // Directed attempts that failed over to a full scan
+  uint32_t lastMs;
+  uint32_t avgMs;
+  uint32_t maxMs;
+  const char *lastMode;   // "directed", "scan" or "none"
+  const char *addressing; // "static", "lease" or "dhcp"
+};
+
 class NetworkManager {
 public:
   // Singleton Accessor
@@ -18,9 +33,10 @@ public:
   // --- Public API ---
 
   /**
-   * Attempts to connect to WiFi using stored credentials.
-   * If it fails after retries, it sets an internal flag requesting provisioning.
-   * It DOES NOT block or change state itself.
+   * Starts connecting to WiFi using stored credentials and returns immediately.
+   * mDNS comes up from the GOT_IP event. If the first connection is not up
+   * within WIFI_BOOT_TIMEOUT_MS (or retries run out), it sets an internal flag
+   * requesting provisioning. It DOES NOT block or change state itself.
    */
   void connectOrRequestProvisioning();
 
@@ -30,6 +46,22 @@ public:
    */
   bool isProvisioningNeeded() const { return _triggerProvisioning; }
 
+  /**
+   * Increments on every WiFi event (connect, IP change, disconnect).
+   * Lets readers cache network details (SSID, IP, gateway) until it moves.
+   */
+  uint32_t getEventGeneration() const { return _eventGeneration; }
+
+  // Connect-time counters (avg computed on read)
+  WiFiConnectStats getConnectStats() const;
+
+  /**
+   * Sets the WiFi power-save level (the HAL's low-power mode drives this).
+   * Safe before the radio is up: it is applied when the station starts.
+   */
+  void setModemSleep(ModemSleep level);
+  ModemSleep getModemSleep() const { return _modemSleep; }
+
   /**
    * Enters the blocking BLE Provisioning loop.
    * This function does not return until the device is rebooted.
@@ -43,6 +75,7 @@ private:
   NetworkManager(); // Private Constructor
 
   void log(const char *key, const char *value);
+  bool leaseFresh() const; // The cached lease may be replayed (granted since boot, within WIFI_LEASE_MAX_AGE_MS)
 
   // --- Internal State ---
   char _wifiSSID[33];
@@ -51,17 +84,49 @@ private:
 
   volatile bool _triggerProvisioning;
   volatile int _wifiRetries;
+  volatile uint32_t _eventGeneration;
   TimerHandle_t _wifiReconnectTimer;
+  TimerHandle_t _wifiBootTimer; // One-shot WIFI_BOOT_TIMEOUT_MS deadline for the first connection
+  volatile bool _mdnsStarted;
+  volatile ModemSleep _modemSleep;
+
+  // --- Fast Reconnect ---
+  WifiConnectCache _connectCache; // Last good BSSID/channel/lease
+  bool _connectCacheValid;        // Cleared when a directed attempt fails
+  WifiStaticIp _staticIp;
+  bool _hasStaticIp;
+  volatile bool _directedAttempt; // The attempt in flight uses the cache
+  volatile bool _leaseAttempt;    // ...and replays the cached lease
+  bool _leaseValid;               // DHCP granted _connectCache's lease since boot...
+  int64_t _leaseGrantedUs;        // ...at this time (replays never refresh it)
+  TimerHandle_t _leaseRenewTimer; // Drops a replayed lease at WIFI_LEASE_MAX_AGE_MS
+  int64_t _connectStartUs;
+
+  // --- Connect Stats ---
+  uint32_t _connectAttempts;
+  uint32_t _connectCount;
+  uint32_t _connectDirected;
+  uint32_t _connectFallbacks;
+  uint32_t _connectLastMs;
+  uint32_t _connectMaxMs;
+  uint64_t _connectTotalMs;
+  const char *_connectLastMode;
+  const char *_connectAddressing;
 
   // --- Helpers ---
   void connectToWiFi();
+  void recordConnected();
   void startMDNS();
 
   // --- Static Callbacks (Trampolines) ---
   static void onWiFiEvent(WiFiEvent_t event);
   static void onWifiTimer(TimerHandle_t t);
+  static void onWifiBootTimer(TimerHandle_t t);
+  static void onLeaseRenewTimer(TimerHandle_t t);
 
   // --- Member Event Handlers ---
   void handleWiFiEvent(WiFiEvent_t event);
   void handleWifiTimer();
+  void handleWifiBootTimeout();
+  void handleLeaseRenew();
 };
@@ -0,0 +1,103 @@
+/*
+ * =================================================================================
+ * File:      include/PerfProbes.h
+ * Description:
+ * Scoped timing probes for the on-device hot paths (exported by GET /metrics).
+ * - Fixed table of count / total / max microseconds per probe.
+ * - PERF_PROBE(id) times the enclosing scope with esp_timer_get_time(), which,
+ *   unlike the cycle counter, stays valid when a task migrates between cores.
+ * - Compiled out entirely unless built with -D PERF_PROBES (set in the debug env).
+ * =================================================================================
+ */
+#pragma once
+#include <stdint.h>
+
+enum PerfProbeId : uint8_t {
+  // HAL tick stages
+  PROBE_HAL_SAFETY,
+  PROBE_HAL_BUTTONS,
+  PROBE_HAL_HEALTH,
+  PROBE_HAL_LED,
+  PROBE_SERIAL_DRAIN,
+  PROBE_SENSOR_SAMPLE,
+
+  // Engine
+  PROBE_ENGINE_INPUTS,
+  PROBE_ENGINE_UPDATE,
+
+  // Persistence
+  PROBE_SAVE_STATE,
+  PROBE_SAVE_CHECKPOINT,
+  PROBE_HISTORY_APPEND,
+
+  // Web handlers
+  PROBE_WEB_ROOT,
+  PROBE_WEB_HEALTH,
+  PROBE_WEB_KEEPALIVE,
+  PROBE_WEB_REBOOT,
+  PROBE_WEB_FACTORY_RESET,
+  PROBE_WEB_ARM,
+  PROBE_WEB_START_TEST,
+  PROBE_WEB_ABORT,
+  PROBE_WEB_TIME_MOD,
+  PROBE_WEB_STATUS,
+  PROBE_WEB_DETAILS,
+  PROBE_WEB_LOG,
+  PROBE_WEB_LATENCY_RESET,
+  PROBE_WEB_REWARD,
+  PROBE_WEB_UPDATE_WIFI,
+  PROBE_WEB_METRICS,
+  PROBE_WEB_EVENTS,
+  PROBE_WEB_UDP_INFO,
+  PROBE_WEB_BATCH,
+  PROBE_WEB_HISTORY,
+  PROBE_WEB_TRACE,
+  PROBE_WEB_UDP_RESET_KEY,
+
+  // UDP command channel
+  PROBE_UDP_PACKET,
+
+  PROBE_COUNT
+};
+
+struct PerfProbeStats {
+  uint32_t count;
+  uint64_t totalUs;
+  uint32_t maxUs;
+};
+
+#ifdef PERF_PROBES
+
+class PerfProbes {
+public:
+  static void record(PerfProbeId id, uint32_t us);
+  static void countIteration(); // One engine service pass
+
+  // Consistent copy of the table for /metrics
+  static void snapshot(PerfProbeStats (&out)[PROBE_COUNT], uint32_t &iterations);
+
+  // Prometheus label value ("hal_safety", "web_status", ...)
+  static const char *name(PerfProbeId id);
+};
+
+class PerfProbeScope {
+public:
+  explicit PerfProbeScope(PerfProbeId id);
+  ~PerfProbeScope();
+
+private:
+  PerfProbeId _id;
+  int64_t _startUs;
+};
+
+#define PERF_PROBE_CONCAT_(a, b) a##b
+#define PERF_PROBE_CONCAT(a, b) PERF_PROBE_CONCAT_(a, b)
+#define PERF_PROBE(id) PerfProbeScope PERF_PROBE_CONCAT(_perfProbe, __LINE__)(id)
+#define PERF_COUNT_ITERATION() PerfProbes::countIteration()
+
+#else
+
+#define PERF_PROBE(id) ((void)0)
+#define PERF_COUNT_ITERATION() ((void)0)
+
+#endif
@@ -5,12 +5,55 @@
  * Central controller for Device Configuration and Storage.
  * - Manages all NVS (Preferences) interactions.
  * - Validates inputs against safety limits.
+ * - SettingsTransaction batches many setter calls into one validated write.
  * =================================================================================
  */
 #pragma once
 #include "Types.h"
 #include <stdint.h>
 
+// Cost counters for the session-state persistence path (exposed in /details).
+struct PersistenceStats {
+  uint32_t saves;       // Successful record writes since boot
+  uint32_t failedSaves; // putBytes() short writes
+  uint32_t lastSaveUs;  // Duration of the most recent save
+  uint32_t maxSaveUs;   // Worst-case save since boot
+  uint32_t bootLoadUs;  // Duration of loadSessionState() at boot
+  uint32_t sequence;    // Lifetime record write counter (persisted)
+  uint32_t recordBytes; // Size of one record blob
+  const char *format;   // Format found at boot: "record", "legacy" or "none"
+};
+
+// Write counters for the checkpoint journal (exposed in /details).
+struct JournalStats {
+  uint32_t writes;           // Checkpoints written since boot
+  uint32_t failedWrites;     // putBytes() short writes
+  uint32_t bytesWritten;     // Payload bytes written since boot
+  uint32_t sequence;         // Lifetime journal sequence (resumed at boot)
+  uint32_t slotBytes;        // Size of one checkpoint slot
+  bool restoredAtBoot;       // A checkpoint was overlaid on the record at boot
+};
+
+// Last good association and DHCP lease, replayed for a directed reconnect.
+// Addresses are in lwIP byte order (IPAddress's uint32_t).
+struct WifiConnectCache {
+  uint8_t bssid[6];
+  uint8_t channel; // 0 = nothing cached
+  uint8_t reserved;
+  uint32_t ip; // 0 = no lease cached (association only)
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns;
+};
+
+// Operator-configured address. ip == 0 means DHCP.
+struct WifiStaticIp {
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns;
+};
+
 class SettingsManager {
 public:
   // --- WiFi Management ---
@@ -19,6 +62,20 @@ public:
   static void getWifiSSID(char *buf, size_t maxLen);
   static void getWifiPassword(char *buf, size_t maxLen);
 
+  // Fast reconnect: cleared whenever the SSID changes
+  static bool getWifiConnectCache(WifiConnectCache &out); // False if nothing cached
+  static void setWifiConnectCache(const WifiConnectCache &cache);
+  static void clearWifiConnectCache();
+
+  // Static addressing: returns false (and zeroes 'out') for DHCP
+  static bool getWifiStaticIp(WifiStaticIp &out);
+  static void setWifiStaticIp(const WifiStaticIp &cfg); // ip == 0 reverts to DHCP
+
+  // --- UDP Command Channel ---
+  // 16-byte SipHash key, generated on first use. Survives SSID changes, not a factory wipe.
+  static void getUdpKey(uint8_t *key);
+  static void resetUdpKey(uint8_t *key); // Stores (and returns) a new random key
+
   // --- Features and Provisioing ---
   static void setRewardCodeEnabled(bool enabled);
   static void setStreaksEnabled(bool enabled);
@@ -42,7 +99,7 @@ public:
   static void setTimeModificationStep(uint32_t seconds);
 
   // Loads all provisioning features into the updated structs
-  static void loadProvisioningConfig(DeterrentConfig &config, SessionPresets &presets, uint8_t &channelMask);
+  static void loadProvisioningConfig(DeterrentConfig &config, SessionPresets &presets, ChannelMask &channelMask);
 
   // --- Numeric Settings (Validated) ---
   // Sets the fixed/base duration for these deterrents
@@ -56,6 +113,11 @@ public:
   static void saveSessionState(const DeviceState &state, const SessionTimers &timers, const SessionStats &stats,
                                const SessionConfig &config);
   static bool loadSessionState(DeviceState &state, SessionTimers &timers, SessionStats &stats, SessionConfig &config);
+  static const PersistenceStats &getPersistenceStats();
+
+  // --- Checkpoint Journal (running countdowns between full saves) ---
+  static void saveCheckpoint(const DeviceState &state, const SessionTimers &timers, const SessionStats &stats);
+  static const JournalStats &getJournalStats();
 
   // --- Boot & Crash Diagnostics ---
   static int getCrashCount();
@@ -65,8 +127,81 @@ public:
   // --- Factory Reset ---
   static void wipeAll();
 
+  // --- Change Tracking ---
+  // Increments after every setter; compare to detect stale copies of the settings.
+  static uint32_t getConfigGeneration();
+
 private:
-  // Internal helper to perform clamping and logging
-  static uint32_t validateAndSave(const char *key, uint32_t value, uint32_t min, uint32_t max, const char *label);
+  friend class SettingsTransaction;
+
+  static void loadLegacySessionState(DeviceState &state, SessionTimers &timers, SessionStats &stats, SessionConfig &config);
+  static bool applyNewestCheckpoint(DeviceState state, SessionTimers &timers, SessionStats &stats);
   static void log(const char *key, const char *value);
+};
+
+/**
+ * Stages settings changes in RAM and persists them as one set.
+ * - Starts from the stored provisioning config (one read-only open).
+ * - Setters mirror SettingsManager's (same clamps) but touch RAM only.
+ * - commit() validates the staged set with SessionEngine::validateConfig and
+ *   writes it as one settings record (a single blob write), then the staged
+ *   credentials. An invalid set is rejected whole, nothing is written.
+ *
+ * On an NVS error commit() returns false and leaves behind:
+ * - settings write failed: nothing; the previous record is intact.
+ * - credential write failed: the new settings, plus the credential keys
+ *   written before the error (ssid, pass, static IP, in that order). The
+ *   credentials stay staged, so another commit() retries only them.
+ */
+class SettingsTransaction {
+public:
+  SettingsTransaction();
+
+  // --- Credentials (not part of the validated set) ---
+  void setWifiSSID(const char *ssid);
+  void setWifiPassword(const char *pass);
+  void setWifiStaticIp(const WifiStaticIp &cfg); // ip == 0 reverts to DHCP
+
+  // --- Features ---
+  void setRewardCodeEnabled(bool enabled);
+  void setStreaksEnabled(bool enabled);
+  void setPaybackEnabled(bool enabled);
+
+  // --- Session Configuration ---
+  void setSessionLimits(uint32_t minDuration, uint32_t maxDuration);
+  void setDurationPreset(DurationType type, uint32_t min, uint32_t max);
+
+  // --- Deterrents ---
+  void setPaybackStrategy(DeterrentStrategy strategy);
+  void setPaybackRange(uint32_t min, uint32_t max);
+  void setRewardStrategy(DeterrentStrategy strategy);
+  void setRewardRange(uint32_t min, uint32_t max);
+  void setTimeModificationEnabled(bool enabled);
+  uint32_t setTimeModificationStep(uint32_t seconds);
+  uint32_t setPaybackDuration(uint32_t seconds);
+  uint32_t setRewardPenaltyDuration(uint32_t seconds);
+
+  // --- Hardware ---
+  void setChannelEnabled(int channelIndex, bool enabled);
+
+  // --- Staged View (for read-modify-write of min/max pairs) ---
+  const DeterrentConfig &config() const { return _config; }
+  const SessionPresets &presets() const { return _presets; }
+  ChannelMask channelMask() const { return _channelMask; }
+  bool hasChanges() const { return _dirty != 0; }
+
+  // Validates and persists everything staged. False = rejected or NVS error.
+  bool commit();
+
+  // Drops staged settings (credentials stay staged).
+  void discardSettings();
+
+private:
+  DeterrentConfig _config, _baseConfig;
+  SessionPresets _presets, _basePresets;
+  ChannelMask _channelMask, _baseChannelMask;
+  char _ssid[33];
+  char _pass[65];
+  WifiStaticIp _staticIp;
+  uint32_t _dirty; // TXN_* bits (see SettingsManager.cpp)
 };
\ No newline at end of file
@@ -0,0 +1,66 @@
+/*
+ * =================================================================================
+ * File:      include/UdpCommand.h
+ * Description:
+ * Authenticated UDP channel for keep-alive, status digest and abort.
+ * - Singleton Architecture, like WebManager.
+ * - One datagram in, one datagram out (see lib/UdpProtocol for the format).
+ * - Key comes from SettingsManager::getUdpKey(); clients fetch it via GET /udp.
+ *
+ * Trust model: the key keeps datagrams from outside the LAN, spoofed ones and
+ * replays out. It is no stronger than the HTTP API, which is unauthenticated
+ * and offers the same keep-alive and abort. GET /udp only hands the key out
+ * while pairing is open (UDP_PAIRING_WINDOW_MS after boot or a key reset, and
+ * only in READY), so a client that joins the LAN later cannot just read it.
+ * POST /udp/reset-key revokes every paired client.
+ * =================================================================================
+ */
+#pragma once
+#include "Config.h"
+#include "Session.h"
+#include "UdpProtocol.h"
+#include <AsyncUDP.h>
+
+// Datagram counters (exposed in /metrics).
+struct UdpCommandStats {
+  uint32_t received;   // Datagrams handled (including rejects)
+  uint32_t keepAlives; // Accepted keep-alives
+  uint32_t aborts;     // Accepted aborts
+  uint32_t badTag;     // Authentication failures (dropped, no reply)
+  uint32_t malformed;  // Wrong size/magic/version (dropped, no reply)
+  uint32_t replays;    // Stale nonce or non-increasing seq
+  uint32_t busy;       // Engine lock not available in time
+  uint32_t maxHandlerUs;
+};
+
+class UdpCommandServer {
+public:
+  static UdpCommandServer &getInstance();
+
+  // Starts listening on UDP_COMMAND_PORT (call after the network stack is up)
+  void begin(SessionEngine *engine);
+
+  uint32_t getBootNonce() const { return _bootNonce; }
+
+  // Key hand-out for GET /udp
+  bool isPairingOpen() const;
+  void copyKey(uint8_t *out) const;
+  // New key (paired clients stop being accepted); reopens pairing
+  void resetKey();
+  UdpCommandStats getStats() const { return _stats; }
+
+private:
+  UdpCommandServer();
+
+  void handlePacket(AsyncUDPPacket &packet);
+  uint8_t execute(const UdpRequest &req);
+  void fillDigest(UdpDigest &digest);
+
+  AsyncUDP _udp;
+  SessionEngine *_engine;
+  uint8_t _key[UDP_KEY_SIZE]; // Guarded by s_keyMux (reset from the async_tcp task)
+  int64_t _pairingUntilUs;
+  uint32_t _bootNonce;
+  UdpReplayGuard<UDP_REPLAY_CLIENTS> _replay; // Only touched from the AsyncUDP task
+  UdpCommandStats _stats;
+};
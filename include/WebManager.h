@@ -6,13 +6,22 @@
  * - Singleton Architecture.
  * - Handles all REST endpoints for Session and Device control.
  * - Uses Dependency Injection for Engine and HAL.
+ * - JSON is built in a fixed pool of static arenas and streamed out (no heap).
+ * - Requests pass admission control first (per-client rate limit, heavy lane).
  * =================================================================================
  */
 #pragma once
+#include "AdmissionControl.h"
+#include "BodyAccumulator.h"
+#include "Config.h"
+#include "FixedArena.h"
 #include "Session.h"
 #include <ArduinoJson.h>
 #include <ESPAsyncWebServer.h>
 
+typedef ArenaPool<JSON_ARENA_SIZE, JSON_ARENA_COUNT> JsonArenaPool;
+typedef AdmissionController<ADMISSION_CLIENTS, ADMISSION_HEAVY_MAX_QUEUED> HttpAdmission;
+
 class WebManager {
 public:
   static WebManager &getInstance();
@@ -20,18 +29,90 @@ public:
   // Initialization (Call in setup)
   void begin(SessionEngine *engine);
 
+  // Event Stream (Call from loop, outside the state lock)
+  // Sends a full snapshot on state changes / new subscribers, a timer delta on ticks.
+  void publishEvents(bool ticked, bool stateChanged);
+
 private:
   WebManager();
 
+  // Consistent copy of everything /status reports (from the engine's lock-free snapshot)
+  struct StatusSnapshot {
+    DeviceState state;
+    SessionOutcome outcome;
+    SessionTimers timers;
+    SessionStats stats;
+    SessionConfig config;
+    uint32_t generation;
+    bool verified;
+    bool buttonPressed;
+    uint32_t currentPressDurationMs;
+  };
+
   // --- Dependencies ---
   AsyncWebServer _server;
+  AsyncEventSource _events;
   SessionEngine *_engine;
 
+  // --- Event Stream State ---
+  volatile bool _eventsNeedSnapshot; // Set when a subscriber connects
+  uint32_t _eventId;
+
+  // --- /details Cache (static portion, see rebuildDetailsCache) ---
+  String _detailsHead;
+  String _detailsBody;
+  bool _detailsCached;
+  uint32_t _detailsConfigGen;  // SettingsManager::getConfigGeneration() at build
+  uint32_t _detailsNetworkGen; // NetworkManager::getEventGeneration() at build
+  ChannelMask _detailsChannelMask;
+
+  // --- Response Arenas (leased per request, see JsonArenaLease) ---
+  JsonArenaPool _jsonArenas;
+
+  // --- Admission Control (async_tcp task only, see admit) ---
+  HttpAdmission _admission;
+  typedef void (WebManager::*HeavyHandler)(AsyncWebServerRequest *request);
+  struct DeferredRequest {
+    AsyncWebServerRequest *request; // nullptr = free; queued in _admission otherwise
+    HeavyHandler handler;
+  };
+  DeferredRequest _deferred[ADMISSION_HEAVY_MAX_QUEUED];
+
+  // --- Fragmented Request Bodies (async_tcp task only, see collectBody) ---
+  struct PendingBody {
+    AsyncWebServerRequest *owner; // nullptr = free
+    FixedArena *arena;           // Leased from _jsonArenas until handed over
+    BodyAccumulator body;
+  };
+  PendingBody _pendingBodies[BODY_PENDING_MAX];
+
   // --- Helper Functions ---
   void sendJsonError(AsyncWebServerRequest *request, int code, const std::string &message);
+  // Same, built in 'doc' (cleared first) so a handler holding an arena needs no second one
+  void sendJsonError(AsyncWebServerRequest *request, int code, const std::string &message, JsonDocument &doc);
+  void sendJson(AsyncWebServerRequest *request, int code, JsonDocument &doc);
+  void sendArenaBusy(AsyncWebServerRequest *request);
   void registerEndpoints();
+  bool admit(AsyncWebServerRequest *request, AdmitLane lane);
+  bool settle(AsyncWebServerRequest *request, uint32_t cost);
+  void sendAdmissionRejection(AsyncWebServerRequest *request, AdmitResult result);
+  ArRequestHandlerFunction admitted(AdmitLane lane, ArRequestHandlerFunction handler);
+  ArRequestHandlerFunction admittedHeavy(HeavyHandler handler);
+  void runHeavy(AsyncWebServerRequest *request, HeavyHandler handler);
+  void releaseHeavy();
+  void expireDeferred();
+  bool collectBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total, const char *&body,
+                   size_t &bodyLen, FixedArena *&arena);
+  void dropPendingBody(AsyncWebServerRequest *request);
   void log(const char *key, const char *value);
 
+  // --- Status Serialization (shared by /status and /events) ---
+  bool captureStatus(StatusSnapshot &snap);
+  void buildStatusJson(JsonObject doc, const StatusSnapshot &snap);
+  void buildTimerDeltaJson(JsonObject doc, const StatusSnapshot &snap);
+  void formatStatusETag(const StatusSnapshot &snap, char *buf, size_t len);
+  bool rebuildDetailsCache();
+
   // --- Route Handlers ---
 
   // System & Health
@@ -46,12 +127,21 @@ private:
   void handleStartTest(AsyncWebServerRequest *request);
   void handleAbort(AsyncWebServerRequest *request);
   void handleTimeMod(AsyncWebServerRequest *request, bool increase);
+  void handleBatch(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
 
   // Information
   void handleStatus(AsyncWebServerRequest *request);
   void handleDetails(AsyncWebServerRequest *request);
   void handleLog(AsyncWebServerRequest *request);
+  void handleHistory(AsyncWebServerRequest *request);
+#ifdef ENGINE_TRACE
+  void handleTrace(AsyncWebServerRequest *request);
+#endif
+  void handleLatencyReset(AsyncWebServerRequest *request);
+  void handleMetrics(AsyncWebServerRequest *request);
   void handleReward(AsyncWebServerRequest *request);
+  void handleUdpInfo(AsyncWebServerRequest *request);
+  void handleUdpResetKey(AsyncWebServerRequest *request);
 
   // Configuration
   void handleUpdateWifi(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
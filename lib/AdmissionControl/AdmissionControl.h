@@ -0,0 +1,284 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/AdmissionControl/AdmissionControl.h
+ *
+ * Description:
+ * Admission control for the HTTP API, so a flooding client cannot starve
+ * the engine of the state lock, heap or CPU.
+ *
+ * Three lanes:
+ *   SAFETY  Abort and keep-alive. Always admitted, never charged, never capped.
+ *   NORMAL  Everything else; charged against the client's token bucket.
+ *   HEAVY   Large responses (/log, /details, /metrics); charged more and
+ *           capped in flight, released when the response is finished.
+ *           Over the cap a request may wait in a short FIFO (QUEUED
+ *           entries) for the next slot instead of being turned away.
+ *
+ * One token bucket per client address in a small LRU table. A client that
+ * is not in the table starts with a full bucket. Time is in milliseconds
+ * from a monotonic clock.
+ * =================================================================================
+ */
+#pragma once
+#include <stdint.h>
+
+enum AdmitLane : uint8_t { ADMIT_SAFETY, ADMIT_NORMAL, ADMIT_HEAVY, ADMIT_LANE_COUNT };
+
+enum AdmitResult : uint8_t {
+    ADMIT_OK,
+    ADMIT_RATE_LIMITED, // Client's bucket is empty -> 429
+    ADMIT_BUSY,         // Heavy lane and its queue full -> 503
+    ADMIT_QUEUED,       // Heavy lane full; release() hands the request a slot later
+};
+
+/**
+ * Classic token bucket with millisecond refill. Tokens are stored in
+ * thousandths so slow rates still refill smoothly.
+ */
+class TokenBucket {
+public:
+    TokenBucket() : _milliTokens(0), _lastMs(0) {}
+
+    void reset(uint32_t nowMs, uint32_t capacity) {
+        _milliTokens = capacity * 1000;
+        _lastMs = nowMs;
+    }
+
+    bool take(uint32_t nowMs, uint32_t cost, uint32_t capacity, uint32_t ratePerSec) {
+        refill(nowMs, capacity, ratePerSec);
+        if (_milliTokens < cost * 1000) return false;
+        _milliTokens -= cost * 1000;
+        return true;
+    }
+
+    // Milliseconds until 'cost' tokens are available (0 = now)
+    uint32_t msUntil(uint32_t cost, uint32_t ratePerSec) const {
+        if (_milliTokens >= cost * 1000 || ratePerSec == 0) return 0;
+        return (cost * 1000 - _milliTokens + ratePerSec - 1) / ratePerSec;
+    }
+
+    // Returns tokens (never above the capacity)
+    void give(uint32_t tokens, uint32_t capacity) {
+        uint64_t next = (uint64_t)_milliTokens + (uint64_t)tokens * 1000;
+        uint64_t cap = (uint64_t)capacity * 1000;
+        _milliTokens = (uint32_t)(next > cap ? cap : next);
+    }
+
+    uint32_t lastMs() const { return _lastMs; }
+
+private:
+    uint32_t _milliTokens;
+    uint32_t _lastMs;
+
+    void refill(uint32_t nowMs, uint32_t capacity, uint32_t ratePerSec) {
+        uint32_t elapsed = nowMs - _lastMs;
+        _lastMs = nowMs;
+        uint64_t next = (uint64_t)_milliTokens + (uint64_t)elapsed * ratePerSec;
+        uint64_t cap = (uint64_t)capacity * 1000;
+        _milliTokens = (uint32_t)(next > cap ? cap : next);
+    }
+};
+
+struct AdmissionConfig {
+    uint32_t burst;         // Bucket capacity (tokens)
+    uint32_t ratePerSec;    // Refill rate (tokens per second)
+    uint32_t heavyCost;     // Tokens charged for a HEAVY request (NORMAL costs 1)
+    uint8_t heavyMaxInFlight;
+    uint32_t heavyMaxWaitMs; // Longest a queued HEAVY request waits for a slot
+};
+
+struct AdmissionStats {
+    uint32_t admitted[ADMIT_LANE_COUNT];
+    uint32_t rateLimited;
+    uint32_t busy;
+    uint32_t evictions;  // Clients pushed out of the table by a new one
+    uint8_t heavyInFlight;
+    uint8_t heavyInFlightMax;
+    uint32_t queued;           // HEAVY requests that had to wait for a slot
+    uint32_t queueTimeouts;    // ...gave up after heavyMaxWaitMs (503)
+    uint32_t queueCancels;     // ...went away before their turn
+    uint32_t queueWaitMsTotal; // Time the ones handed a slot spent waiting
+    uint32_t queueWaitMsMax;
+    uint8_t queueDepth;
+    uint8_t queueDepthMax;
+};
+
+/**
+ * CLIENTS client buckets and up to QUEUED waiting HEAVY requests. A waiter is
+ * an opaque pointer owned by the caller; the controller only orders them.
+ */
+template <uint8_t CLIENTS, uint8_t QUEUED = 0> class AdmissionController {
+public:
+    explicit AdmissionController(const AdmissionConfig &cfg) : _cfg(cfg) { reset(); }
+
+    void reset() {
+        for (uint8_t i = 0; i < CLIENTS; i++) _clients[i].used = false;
+        for (uint8_t i = 0; i < ADMIT_LANE_COUNT; i++) _stats.admitted[i] = 0;
+        _stats.rateLimited = 0;
+        _stats.busy = 0;
+        _stats.evictions = 0;
+        _stats.heavyInFlight = 0;
+        _stats.heavyInFlightMax = 0;
+        _stats.queued = 0;
+        _stats.queueTimeouts = 0;
+        _stats.queueCancels = 0;
+        _stats.queueWaitMsTotal = 0;
+        _stats.queueWaitMsMax = 0;
+        _stats.queueDepth = 0;
+        _stats.queueDepthMax = 0;
+        _lastRetryMs = 0;
+    }
+
+    /**
+     * Decides one request. An admitted HEAVY request holds a slot until
+     * release(ADMIT_HEAVY) is called for it. A HEAVY request over the cap
+     * that passes a 'waiter' is charged, queued and gets ADMIT_QUEUED.
+     */
+    AdmitResult admit(uint32_t client, AdmitLane lane, uint32_t nowMs, void *waiter = nullptr) {
+        _lastRetryMs = 0;
+        if (lane == ADMIT_SAFETY) {
+            _stats.admitted[ADMIT_SAFETY]++;
+            return ADMIT_OK;
+        }
+
+        // Capacity first, so a rejected heavy request does not cost tokens
+        bool wait = lane == ADMIT_HEAVY && _stats.heavyInFlight >= _cfg.heavyMaxInFlight;
+        if (wait && (waiter == nullptr || _stats.queueDepth >= QUEUED)) {
+            _stats.busy++;
+            return ADMIT_BUSY;
+        }
+
+        uint32_t cost = (lane == ADMIT_HEAVY) ? _cfg.heavyCost : 1;
+        TokenBucket &bucket = bucketFor(client, nowMs);
+        if (!bucket.take(nowMs, cost, _cfg.burst, _cfg.ratePerSec)) {
+            _lastRetryMs = bucket.msUntil(cost, _cfg.ratePerSec);
+            _stats.rateLimited++;
+            return ADMIT_RATE_LIMITED;
+        }
+
+        if (wait) {
+            _queue[_stats.queueDepth].waiter = waiter;
+            _queue[_stats.queueDepth].sinceMs = nowMs;
+            _stats.queueDepth++;
+            if (_stats.queueDepth > _stats.queueDepthMax) _stats.queueDepthMax = _stats.queueDepth;
+            _stats.queued++;
+            return ADMIT_QUEUED;
+        }
+
+        if (lane == ADMIT_HEAVY) {
+            _stats.heavyInFlight++;
+            if (_stats.heavyInFlight > _stats.heavyInFlightMax) _stats.heavyInFlightMax = _stats.heavyInFlight;
+        }
+        _stats.admitted[lane]++;
+        return ADMIT_OK;
+    }
+
+    /**
+     * Settles a request admitted on NORMAL before its cost was known (a body
+     * that has to be parsed first, e.g. /batch). 'cost' is what it turned out
+     * to be: 0 refunds the admission token and moves the request to the
+     * SAFETY lane, above 1 the rest is charged now.
+     */
+    AdmitResult settle(uint32_t client, uint32_t cost, uint32_t nowMs) {
+        _lastRetryMs = 0;
+        TokenBucket &bucket = bucketFor(client, nowMs);
+        if (cost == 0) {
+            bucket.give(1, _cfg.burst);
+            _stats.admitted[ADMIT_NORMAL]--;
+            _stats.admitted[ADMIT_SAFETY]++;
+            return ADMIT_OK;
+        }
+        if (cost > 1 && !bucket.take(nowMs, cost - 1, _cfg.burst, _cfg.ratePerSec)) {
+            _lastRetryMs = bucket.msUntil(cost - 1, _cfg.ratePerSec);
+            _stats.rateLimited++;
+            return ADMIT_RATE_LIMITED;
+        }
+        return ADMIT_OK;
+    }
+
+    /**
+     * Frees a HEAVY slot. If a request is queued the slot passes straight to
+     * the oldest one, which is returned for the caller to run; else nullptr.
+     * Call expire() first so a waiter past heavyMaxWaitMs is not picked.
+     */
+    void *release(AdmitLane lane, uint32_t nowMs) {
+        if (lane != ADMIT_HEAVY || _stats.heavyInFlight == 0) return nullptr;
+        if (_stats.queueDepth == 0) {
+            _stats.heavyInFlight--;
+            return nullptr;
+        }
+        uint32_t waitedMs = nowMs - _queue[0].sinceMs;
+        _stats.queueWaitMsTotal += waitedMs;
+        if (waitedMs > _stats.queueWaitMsMax) _stats.queueWaitMsMax = waitedMs;
+        _stats.admitted[ADMIT_HEAVY]++;
+        return pop(0);
+    }
+
+    // Removes and returns the oldest waiter queued longer than heavyMaxWaitMs (answer it 503), or nullptr
+    void *expire(uint32_t nowMs) {
+        if (_stats.queueDepth == 0 || nowMs - _queue[0].sinceMs < _cfg.heavyMaxWaitMs) return nullptr;
+        _stats.queueTimeouts++;
+        return pop(0);
+    }
+
+    // A waiter that went away before its turn. False if it was not queued.
+    bool cancel(void *waiter) {
+        for (uint8_t i = 0; i < _stats.queueDepth; i++) {
+            if (_queue[i].waiter == waiter) {
+                pop(i);
+                _stats.queueCancels++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // After ADMIT_RATE_LIMITED: how long until the request would pass
+    uint32_t retryAfterMs() const { return _lastRetryMs; }
+
+    const AdmissionStats &stats() const { return _stats; }
+    const AdmissionConfig &config() const { return _cfg; }
+
+private:
+    struct Client {
+        bool used;
+        uint32_t address;
+        TokenBucket bucket;
+    };
+
+    struct Waiter {
+        void *waiter;
+        uint32_t sinceMs;
+    };
+
+    AdmissionConfig _cfg;
+    Client _clients[CLIENTS];
+    Waiter _queue[QUEUED > 0 ? QUEUED : 1];
+    AdmissionStats _stats;
+    uint32_t _lastRetryMs;
+
+    void *pop(uint8_t index) {
+        void *waiter = _queue[index].waiter;
+        for (uint8_t i = index + 1; i < _stats.queueDepth; i++) _queue[i - 1] = _queue[i];
+        _stats.queueDepth--;
+        return waiter;
+    }
+
+    TokenBucket &bucketFor(uint32_t address, uint32_t nowMs) {
+        uint8_t victim = 0;
+        for (uint8_t i = 0; i < CLIENTS; i++) {
+            Client &c = _clients[i];
+            if (c.used && c.address == address) return c.bucket;
+            if (!_clients[victim].used) continue;
+            if (!c.used || (nowMs - c.bucket.lastMs()) > (nowMs - _clients[victim].bucket.lastMs())) victim = i;
+        }
+
+        Client &c = _clients[victim];
+        if (c.used) _stats.evictions++;
+        c.used = true;
+        c.address = address;
+        c.bucket.reset(nowMs, _cfg.burst);
+        return c.bucket;
+    }
+};
@@ -0,0 +1,141 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/ButtonGesture/ButtonGesture.h
+ *
+ * Description:
+ * Button gesture classifier driven by timestamped edges.
+ *
+ * Edges are captured by a GPIO interrupt (with their own timestamp) and fed
+ * in later through onEdge(); update() handles the time-based transitions
+ * (long press threshold, double-click window). Because durations come from
+ * the edge timestamps, classification does not depend on how often the
+ * caller gets to run, only the reporting latency does.
+ *
+ * Semantics follow the OneButton callbacks it replaces:
+ * PRESS on every debounced press, CLICK after the double-click window
+ * expires, DOUBLE_CLICK on the second release, LONG_START once the press
+ * has been held for longPressMs, LONG_STOP on release after a long press.
+ *
+ * Debounce is a lockout: the first edge is accepted immediately and further
+ * changes within debounceMs are ignored. update() re-syncs with the raw pin
+ * level, so a lost or bounced final edge cannot leave the state stuck.
+ * =================================================================================
+ */
+#pragma once
+#include <stdint.h>
+
+enum ButtonGestureEvent : uint8_t {
+    GESTURE_NONE = 0,
+    GESTURE_PRESS = 1 << 0,
+    GESTURE_CLICK = 1 << 1,
+    GESTURE_DOUBLE_CLICK = 1 << 2,
+    GESTURE_LONG_START = 1 << 3,
+    GESTURE_LONG_STOP = 1 << 4,
+};
+
+class ButtonGesture {
+public:
+    struct Config {
+        uint32_t debounceMs;
+        uint32_t clickMs;     // Double-click window after a release
+        uint32_t longPressMs; // Hold time for LONG_START
+    };
+
+    ButtonGesture() : _cfg{50, 400, 1000}, _phase(IDLE), _level(false), _lastChangeMs(0), _pressStartMs(0), _releaseMs(0) {}
+
+    void configure(const Config &cfg) { _cfg = cfg; }
+    const Config &config() const { return _cfg; }
+
+    /**
+     * Feeds one captured edge.
+     * @param pressed Logical level after the edge (true = pressed).
+     * @return Bitmask of ButtonGestureEvent.
+     */
+    uint8_t onEdge(uint32_t ms, bool pressed) {
+        // Redundant edge (bounce back to the current level), or within the lockout
+        if (pressed == _level) return GESTURE_NONE;
+        if ((uint32_t)(ms - _lastChangeMs) < _cfg.debounceMs) return GESTURE_NONE;
+
+        _level = pressed;
+        _lastChangeMs = ms;
+        return pressed ? handlePress(ms) : handleRelease(ms);
+    }
+
+    /**
+     * Time-based transitions. Call periodically while !isIdle().
+     * @param rawPressed Current pin level, used to recover lost edges.
+     * @return Bitmask of ButtonGestureEvent.
+     */
+    uint8_t update(uint32_t nowMs, bool rawPressed) {
+        uint8_t events = GESTURE_NONE;
+        if (rawPressed != _level && (uint32_t)(nowMs - _lastChangeMs) >= _cfg.debounceMs) {
+            events |= onEdge(nowMs, rawPressed);
+        }
+
+        switch (_phase) {
+        case PRESSED:
+        case SECOND_PRESS: // A long hold always wins, even after a tap
+            if ((uint32_t)(nowMs - _pressStartMs) >= _cfg.longPressMs) {
+                _phase = LONG;
+                events |= GESTURE_LONG_START;
+            }
+            break;
+        case RELEASED:
+            if ((uint32_t)(nowMs - _releaseMs) >= _cfg.clickMs) {
+                _phase = IDLE;
+                events |= GESTURE_CLICK;
+            }
+            break;
+        default:
+            break;
+        }
+        return events;
+    }
+
+    bool isPressed() const { return _level; }
+    bool isIdle() const { return _phase == IDLE; }
+
+    // Timestamp of the current press (valid while isPressed())
+    uint32_t pressStartMs() const { return _pressStartMs; }
+
+private:
+    enum Phase : uint8_t { IDLE, PRESSED, RELEASED, SECOND_PRESS, LONG };
+
+    Config _cfg;
+    Phase _phase;
+    bool _level;
+    uint32_t _lastChangeMs;
+    uint32_t _pressStartMs;
+    uint32_t _releaseMs;
+
+    uint8_t handlePress(uint32_t ms) {
+        _pressStartMs = ms;
+        _phase = (_phase == RELEASED) ? SECOND_PRESS : PRESSED;
+        return GESTURE_PRESS;
+    }
+
+    uint8_t handleRelease(uint32_t ms) {
+        // A press held past the threshold that update() has not seen yet is still a long press
+        if ((_phase == PRESSED || _phase == SECOND_PRESS) && (uint32_t)(ms - _pressStartMs) >= _cfg.longPressMs) {
+            _phase = IDLE;
+            return GESTURE_LONG_START | GESTURE_LONG_STOP;
+        }
+
+        switch (_phase) {
+        case PRESSED:
+            _releaseMs = ms;
+            _phase = RELEASED;
+            return GESTURE_NONE;
+        case SECOND_PRESS:
+            _phase = IDLE;
+            return GESTURE_DOUBLE_CLICK;
+        case LONG:
+            _phase = IDLE;
+            return GESTURE_LONG_STOP;
+        default:
+            _phase = IDLE;
+            return GESTURE_NONE;
+        }
+    }
+};
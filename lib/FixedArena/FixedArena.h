@@ -0,0 +1,165 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/FixedArena/FixedArena.h
+ *
+ * Description:
+ * Fixed-size bump arenas for short-lived, per-request allocations.
+ *
+ * FixedArena hands out aligned blocks from one static buffer and frees them
+ * all at once with reset(), so repeated requests never fragment the heap.
+ * The most recent block can grow, shrink or be freed in place, which covers
+ * the grow-then-shrink pattern of string and pool builders (ArduinoJson).
+ * Older blocks are only reclaimed by reset().
+ *
+ * ArenaPool owns COUNT arenas of SIZE bytes, sized at compile time, with a
+ * lock-free acquire/release so handlers on different tasks can lease them.
+ * acquire() returns nullptr when every arena is leased; callers turn that
+ * into a clean "busy" response instead of falling back to the heap.
+ * =================================================================================
+ */
+#pragma once
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define FIXED_ARENA_ALIGN 8
+
+class FixedArena {
+public:
+    FixedArena() : _buf(nullptr), _size(0), _used(0), _lastOffset(0), _highWater(0), _failures(0) {}
+
+    void attach(uint8_t *buf, size_t size) {
+        _buf = buf;
+        _size = size;
+        reset();
+    }
+
+    // Releases every block. The buffer is reused as-is.
+    void reset() {
+        _used = 0;
+        _lastOffset = SIZE_MAX;
+    }
+
+    void *allocate(size_t size) {
+        size_t offset = alignUp(_used);
+        if (size > _size || offset > _size - size) {
+            _failures++;
+            return nullptr;
+        }
+        _lastOffset = offset;
+        _used = offset + size;
+        if (_used > _highWater) _highWater = _used;
+        return _buf + offset;
+    }
+
+    // Only the most recent block is actually returned to the arena.
+    void deallocate(void *ptr) {
+        if (ptr != nullptr && isLast(ptr)) {
+            _used = _lastOffset;
+            _lastOffset = SIZE_MAX;
+        }
+    }
+
+    void *reallocate(void *ptr, size_t size) {
+        if (ptr == nullptr) return allocate(size);
+
+        // Grow or shrink the most recent block in place
+        if (isLast(ptr)) {
+            if (size > _size - _lastOffset) {
+                _failures++;
+                return nullptr;
+            }
+            _used = _lastOffset + size;
+            if (_used > _highWater) _highWater = _used;
+            return ptr;
+        }
+
+        // Older block: its size is unknown, but never more than up to _used
+        size_t oldMax = _used - (size_t)((uint8_t *)ptr - _buf);
+        void *moved = allocate(size);
+        if (moved != nullptr) memcpy(moved, ptr, size < oldMax ? size : oldMax);
+        return moved;
+    }
+
+    size_t capacity() const { return _size; }
+    size_t used() const { return _used; }
+    size_t highWater() const { return _highWater; }
+    uint32_t failures() const { return _failures; } // Allocations refused (arena full)
+    bool owns(const void *ptr) const { return ptr >= _buf && ptr < _buf + _size; }
+
+private:
+    uint8_t *_buf;
+    size_t _size;
+    size_t _used;
+    size_t _lastOffset; // SIZE_MAX = no block can be resized in place
+    size_t _highWater;
+    uint32_t _failures;
+
+    static size_t alignUp(size_t n) { return (n + FIXED_ARENA_ALIGN - 1) & ~(size_t)(FIXED_ARENA_ALIGN - 1); }
+    bool isLast(const void *ptr) const { return _lastOffset != SIZE_MAX && ptr == _buf + _lastOffset; }
+};
+
+template <size_t SIZE, uint8_t COUNT> class ArenaPool {
+    static_assert(COUNT > 0 && COUNT <= 32, "ArenaPool: COUNT must be 1..32");
+
+public:
+    ArenaPool() : _inUse(0), _exhausted(0) {
+        for (uint8_t i = 0; i < COUNT; i++) _arenas[i].attach(_storage[i], SIZE);
+    }
+
+    // Leases a reset arena, or nullptr if all are in use.
+    FixedArena *acquire() {
+        uint32_t mask = _inUse.load();
+        for (;;) {
+            uint8_t slot = COUNT;
+            for (uint8_t i = 0; i < COUNT; i++) {
+                if (!(mask & (1u << i))) {
+                    slot = i;
+                    break;
+                }
+            }
+            if (slot == COUNT) {
+                _exhausted++;
+                return nullptr;
+            }
+            if (_inUse.compare_exchange_weak(mask, mask | (1u << slot))) {
+                _arenas[slot].reset();
+                return &_arenas[slot];
+            }
+        }
+    }
+
+    void release(FixedArena *arena) {
+        for (uint8_t i = 0; i < COUNT; i++) {
+            if (arena == &_arenas[i]) {
+                _inUse.fetch_and(~(1u << i));
+                return;
+            }
+        }
+    }
+
+    uint8_t count() const { return COUNT; }
+    uint8_t inUse() const { return (uint8_t)__builtin_popcount(_inUse.load()); }
+    uint32_t exhausted() const { return _exhausted; } // acquire() calls that found no free arena
+
+    // Largest fill and refused allocations over all arenas
+    size_t highWater() const {
+        size_t hw = 0;
+        for (uint8_t i = 0; i < COUNT; i++)
+            if (_arenas[i].highWater() > hw) hw = _arenas[i].highWater();
+        return hw;
+    }
+    uint32_t failures() const {
+        uint32_t f = 0;
+        for (uint8_t i = 0; i < COUNT; i++) f += _arenas[i].failures();
+        return f;
+    }
+
+private:
+    alignas(FIXED_ARENA_ALIGN) uint8_t _storage[COUNT][(SIZE + FIXED_ARENA_ALIGN - 1) & ~(size_t)(FIXED_ARENA_ALIGN - 1)];
+    FixedArena _arenas[COUNT];
+    std::atomic<uint32_t> _inUse;
+    std::atomic<uint32_t> _exhausted;
+};
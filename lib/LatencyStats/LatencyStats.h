@@ -0,0 +1,131 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/LatencyStats/LatencyStats.h
+ *
+ * Description:
+ * Latency accounting for the safety path (input -> engine -> output mask).
+ *
+ * LatencyHistogram keeps count/min/avg/max plus log2-bucketed counts, so the
+ * full distribution fits in ~100 bytes. LatencyTracker follows one trace per
+ * cause through three stages (detected, engine processed, mask written) and
+ * records the per-stage and end-to-end durations when the mask is written.
+ *
+ * Timestamps are microseconds from a monotonic clock (esp_timer_get_time()
+ * on the device).
+ * =================================================================================
+ */
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#define LATENCY_BUCKETS 24 // Bucket i counts samples < 2^(i+1) us; the last is open-ended (>= ~4.2 s)
+
+class LatencyHistogram {
+public:
+    LatencyHistogram() { reset(); }
+
+    void reset() {
+        _count = 0;
+        _sum = 0;
+        _min = UINT32_MAX;
+        _max = 0;
+        memset(_buckets, 0, sizeof(_buckets));
+    }
+
+    void record(uint32_t us) {
+        _count++;
+        _sum += us;
+        if (us < _min) _min = us;
+        if (us > _max) _max = us;
+        _buckets[bucketFor(us)]++;
+    }
+
+    static uint8_t bucketFor(uint32_t us) {
+        uint8_t b = 0;
+        while (us > 1 && b < LATENCY_BUCKETS - 1) {
+            us >>= 1;
+            b++;
+        }
+        return b;
+    }
+
+    uint32_t count() const { return _count; }
+    uint32_t minUs() const { return _count ? _min : 0; }
+    uint32_t maxUs() const { return _max; }
+    uint32_t avgUs() const { return _count ? (uint32_t)(_sum / _count) : 0; }
+    uint32_t bucket(uint8_t i) const { return i < LATENCY_BUCKETS ? _buckets[i] : 0; }
+
+private:
+    uint32_t _count;
+    uint64_t _sum;
+    uint32_t _min;
+    uint32_t _max;
+    uint32_t _buckets[LATENCY_BUCKETS];
+};
+
+template <uint8_t CAUSES> class LatencyTracker {
+public:
+    struct CauseStats {
+        LatencyHistogram total;          // Detected -> mask written
+        LatencyHistogram detectToEngine; // Detected -> engine processed
+        LatencyHistogram engineToMask;   // Engine processed -> mask written
+    };
+
+    LatencyTracker() { reset(); }
+
+    void reset() {
+        memset(_traces, 0, sizeof(_traces));
+        for (uint8_t i = 0; i < CAUSES; i++) {
+            _stats[i].total.reset();
+            _stats[i].detectToEngine.reset();
+            _stats[i].engineToMask.reset();
+        }
+    }
+
+    // Stage 1. A newer detection replaces one the engine never acted on.
+    void markDetected(uint8_t cause, uint64_t us) {
+        if (cause >= CAUSES) return;
+        _traces[cause].detectedUs = us;
+        _traces[cause].processedUs = 0;
+    }
+
+    // Stage 2. Without a prior detection (cause found by the engine itself) the stages coincide.
+    void markProcessed(uint8_t cause, uint64_t us) {
+        if (cause >= CAUSES) return;
+        if (_traces[cause].detectedUs == 0) _traces[cause].detectedUs = us;
+        _traces[cause].processedUs = us;
+    }
+
+    // Stage 3. Completes every trace the engine has processed.
+    void markMaskWritten(uint64_t us) {
+        for (uint8_t i = 0; i < CAUSES; i++) {
+            Trace &t = _traces[i];
+            if (t.processedUs == 0) continue;
+            _stats[i].detectToEngine.record(clampUs(t.processedUs - t.detectedUs));
+            _stats[i].engineToMask.record(clampUs(us - t.processedUs));
+            _stats[i].total.record(clampUs(us - t.detectedUs));
+            t.detectedUs = 0;
+            t.processedUs = 0;
+        }
+    }
+
+    bool hasPending() const {
+        for (uint8_t i = 0; i < CAUSES; i++)
+            if (_traces[i].processedUs != 0) return true;
+        return false;
+    }
+
+    const CauseStats &stats(uint8_t cause) const { return _stats[cause < CAUSES ? cause : 0]; }
+
+private:
+    struct Trace {
+        uint64_t detectedUs;
+        uint64_t processedUs;
+    };
+
+    Trace _traces[CAUSES];
+    CauseStats _stats[CAUSES];
+
+    static uint32_t clampUs(uint64_t us) { return us > UINT32_MAX ? UINT32_MAX : (uint32_t)us; }
+};
@@ -0,0 +1,126 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/LedPattern/LedPattern.h
+ *
+ * Description:
+ * Status LED patterns as data, for the hardware (LEDC) LED driver.
+ *
+ * A pattern is a short loop of segments. Each segment either jumps to a level
+ * and holds it, or ramps to it (hardware fade), for 'ms'. A segment with
+ * ms == 0 is held forever (static patterns). The driver programs one segment
+ * at a time and is only woken at segment boundaries, never per frame.
+ *
+ * The table mirrors the JLed effects in Esp32SessionHAL::updateLedPattern,
+ * which remain the fallback driver.
+ *
+ * LedFadePlan converts "ramp from A to B in T ms" into the LEDC fade engine's
+ * step parameters (steps x cycles-per-step x duty-per-step).
+ * =================================================================================
+ */
+#pragma once
+#include <stdint.h>
+#include "Types.h"
+
+#define LED_LEVEL_MAX 255 // 8-bit duty
+
+struct LedSegment {
+    uint8_t level; // Duty at the end of the segment (0..LED_LEVEL_MAX)
+    bool fade;     // Ramp from the previous level (else jump)
+    uint16_t ms;   // Duration; 0 = hold forever
+};
+
+struct LedPattern {
+    const LedSegment *segments;
+    uint8_t count;
+};
+
+class LedPatterns {
+public:
+    static LedPattern off() {
+        static const LedSegment s[] = {{0, false, 0}};
+        return {s, 1};
+    }
+
+    static LedPattern forState(DeviceState state) {
+        static const LedSegment ready[] = {{LED_LEVEL_MAX, true, 2000}, {0, true, 2000}}; // Breathe(4000)
+        static const LedSegment armed[] = {{LED_LEVEL_MAX, false, 250}, {0, false, 250}};  // Blink(250, 250)
+        static const LedSegment locked[] = {{LED_LEVEL_MAX, false, 0}};                    // On
+        static const LedSegment aborted[] = {{LED_LEVEL_MAX, false, 500}, {0, false, 500}}; // Blink(500, 500)
+        static const LedSegment completed[] = {                                           // 2 blinks, 3 s pause
+            {LED_LEVEL_MAX, false, 200}, {0, false, 200}, {LED_LEVEL_MAX, false, 200}, {0, false, 3200}};
+        static const LedSegment testing[] = {{LED_LEVEL_MAX, true, 750}, {0, true, 750}}; // FadeOn/FadeOff(750)
+
+        switch (state) {
+        case READY: return {ready, 2};
+        case ARMED: return {armed, 2};
+        case LOCKED: return {locked, 1};
+        case ABORTED: return {aborted, 2};
+        case COMPLETED: return {completed, 4};
+        case TESTING: return {testing, 2};
+        default: return off();
+        }
+    }
+};
+
+/** Walks a pattern's segments in a loop. */
+class LedSequencer {
+public:
+    LedSequencer() : _index(0), _level(0) { _pattern = LedPatterns::off(); }
+
+    void start(const LedPattern &pattern) {
+        _pattern = pattern;
+        _index = 0;
+    }
+
+    const LedSegment &current() const { return _pattern.segments[_index]; }
+
+    // Level the current segment starts from (the previous segment's end)
+    uint8_t startLevel() const { return _level; }
+
+    // Moves to the next segment. False if the current one is held forever.
+    bool advance() {
+        if (current().ms == 0) return false;
+        _level = current().level;
+        _index = (uint8_t)((_index + 1) % _pattern.count);
+        return true;
+    }
+
+    // The driver reports where the hardware actually is when a pattern is cut short
+    void setLevel(uint8_t level) { _level = level; }
+
+private:
+    LedPattern _pattern;
+    uint8_t _index;
+    uint8_t _level;
+};
+
+struct LedFadePlan {
+    bool increase;
+    uint32_t steps;         // Number of duty increments
+    uint32_t cyclesPerStep; // PWM periods per increment
+    uint32_t scale;         // Duty change per increment
+
+    // LEDC fade registers are 10 bits wide
+    static const uint32_t MAX_FIELD = 1023;
+
+    // False if there is nothing to ramp (from == to, or no time): jump instead.
+    static bool compute(uint8_t from, uint8_t to, uint32_t ms, uint32_t pwmHz, LedFadePlan &out) {
+        if (from == to) return false;
+        uint32_t delta = (from < to) ? (uint32_t)(to - from) : (uint32_t)(from - to);
+        uint32_t cycles = (uint32_t)((uint64_t)ms * pwmHz / 1000);
+        if (cycles == 0) return false;
+
+        out.increase = from < to;
+
+        // Fine steps where time allows, coarser when the ramp is shorter than one cycle per level
+        out.scale = (delta + cycles - 1) / cycles;
+        if (out.scale == 0) out.scale = 1;
+        out.steps = delta / out.scale;
+        if (out.steps == 0) out.steps = 1;
+        out.cyclesPerStep = cycles / out.steps;
+        if (out.cyclesPerStep == 0) out.cyclesPerStep = 1;
+        if (out.cyclesPerStep > MAX_FIELD) out.cyclesPerStep = MAX_FIELD;
+        return true;
+    }
+};
@@ -0,0 +1,179 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/LogArena/LogArena.h
+ *
+ * Description:
+ * Byte-packed ring of length-prefixed log records.
+ *
+ * Replaces fixed [lines][MAX_LOG_LENGTH] arrays: each record costs exactly
+ * 2 + length bytes, so short key/value lines no longer waste padding.
+ * Records are opaque bytes (text lines or binary events); rendering them
+ * is left to the owner, outside any lock.
+ * When space runs out the oldest records are evicted. Every line gets a
+ * monotonically increasing sequence number. Readers either copy a range at
+ * once (copySince) or page through it with their own Cursor (/log), so no
+ * lock is held between records. Serial output does not read the arena; it
+ * is fed through a separate SpscRing.
+ * =================================================================================
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LOG_ARENA_MAX_LINE 255 // Longest stored line (longer lines are truncated; tiny arenas clamp further)
+
+template <size_t N> class LogArena {
+    static_assert(N > 2 && N < 0x10000000, "Arena size out of range");
+    static constexpr size_t MAX_LINE = (N - 2 < LOG_ARENA_MAX_LINE) ? N - 2 : LOG_ARENA_MAX_LINE;
+
+public:
+    // Read position of an independent consumer.
+    struct Cursor {
+        uint32_t seq;
+        uint32_t offset;
+    };
+
+    LogArena() : _head(0), _tail(0), _used(0), _tailSeq(0), _headSeq(0) {}
+
+    /**
+     * Appends a text line (without its NUL), evicting the oldest records if needed.
+     * @return Sequence number assigned to the line.
+     */
+    uint32_t append(const char *line) { return append((const uint8_t *)line, strnlen(line, MAX_LINE)); }
+
+    /**
+     * Appends an opaque record (truncated to the maximum record length).
+     * @return Sequence number assigned to the record.
+     */
+    uint32_t append(const uint8_t *data, size_t len) {
+        if (len > MAX_LINE) len = MAX_LINE;
+        size_t need = 2 + len;
+
+        while (N - _used < need) evictOldest();
+
+        uint8_t hdr[2] = {(uint8_t)(len & 0xFF), (uint8_t)(len >> 8)};
+        writeBytes(_head, hdr, 2);
+        writeBytes((_head + 2) % N, data, len);
+
+        _head = (uint32_t)((_head + need) % N);
+        _used += need;
+        return _headSeq++;
+    }
+
+    /**
+     * Copies up to 'limit' records with sequence >= 'since', oldest-first, into
+     * 'out' in the arena's own framing (2-byte length + bytes; walk it with
+     * nextFramed). A cursor older than the retained range (or newer than anything
+     * written, e.g. from a previous boot) restarts at the oldest retained record.
+     * The copy is never larger than capacity().
+     * @param firstSeq Sequence of the first copied record.
+     * @param nextSeq  Cursor for the next call.
+     * @return Bytes written.
+     */
+    size_t copySince(uint32_t since, uint32_t limit, uint8_t *out, size_t outSize, uint32_t &firstSeq,
+                     uint32_t &nextSeq) const {
+        Cursor c = seek(since);
+        firstSeq = c.seq;
+        size_t written = 0;
+        for (uint32_t n = 0; c.seq < _headSeq && n < limit; n++) {
+            size_t need = 2 + recordLength(c.offset);
+            if (written + need > outSize) break;
+            readBytes(c.offset, out + written, need);
+            written += need;
+            skip(c);
+        }
+        nextSeq = c.seq;
+        return written;
+    }
+
+    /**
+     * Iterates a buffer produced by copySince().
+     * @return false at the end of the buffer (or on a truncated frame).
+     */
+    static bool nextFramed(const uint8_t *buf, size_t bufLen, size_t &pos, const uint8_t *&rec, size_t &recLen) {
+        if (pos + 2 > bufLen) return false;
+        size_t len = (size_t)buf[pos] | ((size_t)buf[pos + 1] << 8);
+        if (pos + 2 + len > bufLen) return false;
+        rec = buf + pos + 2;
+        recLen = len;
+        pos += 2 + len;
+        return true;
+    }
+
+    /**
+     * Reads the next record for a consumer and advances its cursor. A cursor whose
+     * record was evicted restarts at the oldest retained record.
+     * @param len Record length copied into 'out' (truncated to outSize).
+     * @return false if the consumer is up to date.
+     */
+    bool next(Cursor &c, uint8_t *out, size_t outSize, size_t &len) const {
+        if (c.seq < _tailSeq || c.seq > _headSeq) {
+            c.seq = _tailSeq;
+            c.offset = _tail;
+        }
+        if (c.seq == _headSeq) return false;
+
+        size_t recLen = recordLength(c.offset);
+        len = (recLen < outSize) ? recLen : outSize;
+        readBytes((c.offset + 2) % N, out, len);
+        skip(c);
+        return true;
+    }
+
+    // Cursor positioned at the oldest retained line.
+    Cursor oldest() const { return {_tailSeq, _tail}; }
+
+    /**
+     * Cursor positioned at record 'since', with the same restart rule as copySince().
+     * Walks from the oldest record, so page with next() rather than seeking per record.
+     */
+    Cursor seek(uint32_t since) const {
+        Cursor c = {_tailSeq, _tail};
+        uint32_t start = (since < _tailSeq || since > _headSeq) ? _tailSeq : since;
+        while (c.seq < start) skip(c);
+        return c;
+    }
+
+    uint32_t lineCount() const { return _headSeq - _tailSeq; }
+    uint32_t nextSeq() const { return _headSeq; }
+    size_t bytesUsed() const { return _used; }
+    static constexpr size_t capacity() { return N; }
+
+private:
+    uint8_t _buf[N];
+    uint32_t _head;    // Write offset
+    uint32_t _tail;    // Offset of the oldest record
+    size_t _used;      // Bytes occupied by records
+    uint32_t _tailSeq; // Sequence of the oldest record
+    uint32_t _headSeq; // Sequence of the next record
+
+    size_t recordLength(uint32_t offset) const {
+        return (size_t)_buf[offset] | ((size_t)_buf[(offset + 1) % N] << 8);
+    }
+
+    void skip(Cursor &c) const {
+        c.offset = (uint32_t)((c.offset + 2 + recordLength(c.offset)) % N);
+        c.seq++;
+    }
+
+    void evictOldest() {
+        size_t len = recordLength(_tail);
+        _tail = (uint32_t)((_tail + 2 + len) % N);
+        _used -= 2 + len;
+        _tailSeq++;
+    }
+
+    void writeBytes(uint32_t offset, const uint8_t *src, size_t len) {
+        size_t first = (len < N - offset) ? len : N - offset;
+        memcpy(_buf + offset, src, first);
+        memcpy(_buf, src + first, len - first);
+    }
+
+    void readBytes(uint32_t offset, uint8_t *dst, size_t len) const {
+        size_t first = (len < N - offset) ? len : N - offset;
+        memcpy(dst, _buf + offset, first);
+        memcpy(dst + first, _buf, len - first);
+    }
+};
@@ -0,0 +1,122 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/PowerPolicy/PowerPolicy.h
+ *
+ * Description:
+ * Low-power mode decisions and accounting.
+ *
+ * PowerPolicy says when the device may sleep (long LOCKED/ABORTED sessions,
+ * where only timers, the safety mask, inputs and keep-alives matter) and how
+ * deep the WiFi modem may sleep without making a keep-alive late.
+ *
+ * PowerMeter accounts time per mode, time actually spent in light sleep and
+ * wake-up latency, and turns the sleep residency into an average current
+ * estimate from per-board figures (for sizing battery packs).
+ *
+ * Timestamps are microseconds from a monotonic clock (esp_timer_get_time()
+ * on the device).
+ * =================================================================================
+ */
+#pragma once
+#include <stdint.h>
+#include "LatencyStats.h"
+#include "Types.h"
+
+enum PowerMode : uint8_t {
+    POWER_ACTIVE, // Full clock, no light sleep, WiFi always listening
+    POWER_LOW,    // Frequency scaling, automatic light sleep, modem sleep
+    POWER_MODE_COUNT
+};
+
+enum ModemSleep : uint8_t {
+    MODEM_SLEEP_NONE, // Radio always on
+    MODEM_SLEEP_MIN,  // Wakes for every DTIM beacon
+    MODEM_SLEEP_MAX   // Wakes every listen interval (several beacons)
+};
+
+class PowerPolicy {
+public:
+    // Long, quiet states: the engine only counts down and watches inputs
+    static bool wantsLowPower(DeviceState state) { return state == LOCKED || state == ABORTED; }
+
+    // Deepest modem sleep whose worst added receive latency stays within
+    // keepAliveMs / divisor, so keep-alives are never held back long enough to
+    // cost a strike. minLatencyMs / maxLatencyMs: worst latency of MIN / MAX.
+    static ModemSleep modemSleepFor(uint32_t keepAliveMs, uint32_t divisor, uint32_t minLatencyMs, uint32_t maxLatencyMs) {
+        uint32_t budgetMs = keepAliveMs / (divisor ? divisor : 1);
+        if (budgetMs >= maxLatencyMs) return MODEM_SLEEP_MAX;
+        if (budgetMs >= minLatencyMs) return MODEM_SLEEP_MIN;
+        return MODEM_SLEEP_NONE;
+    }
+};
+
+class PowerMeter {
+public:
+    LatencyHistogram timerWake; // Engine deadline -> engine running
+    LatencyHistogram inputWake; // Button/interlock edge -> engine running
+
+    PowerMeter() { reset(0); }
+
+    void reset(uint64_t nowUs) {
+        _mode = POWER_ACTIVE;
+        _sinceUs = nowUs;
+        for (uint8_t i = 0; i < POWER_MODE_COUNT; i++) _modeUs[i] = 0;
+        _sleptUs = 0;
+        _sleeps = 0;
+        timerWake.reset();
+        inputWake.reset();
+    }
+
+    // Closes the running interval and starts one in 'mode'
+    void enter(PowerMode mode, uint64_t nowUs) {
+        if (mode >= POWER_MODE_COUNT) return;
+        close(nowUs);
+        _mode = mode;
+    }
+
+    // Light sleep periods reported by the sleep exit hook
+    void addSleep(uint64_t us, uint32_t periods = 1) {
+        _sleptUs += us;
+        _sleeps += periods;
+    }
+
+    PowerMode mode() const { return _mode; }
+    uint64_t sleptUs() const { return _sleptUs; }
+    uint32_t sleeps() const { return _sleeps; }
+
+    // Time spent in 'mode', including the running interval
+    uint64_t timeInUs(PowerMode mode, uint64_t nowUs) const {
+        if (mode >= POWER_MODE_COUNT) return 0;
+        uint64_t us = _modeUs[mode];
+        if (mode == _mode && nowUs > _sinceUs) us += nowUs - _sinceUs;
+        return us;
+    }
+
+    // Share of low-power time spent in light sleep, in permille
+    uint32_t sleepPermille(uint64_t nowUs) const {
+        uint64_t lowUs = timeInUs(POWER_LOW, nowUs);
+        if (lowUs == 0) return 0;
+        uint64_t slept = _sleptUs < lowUs ? _sleptUs : lowUs;
+        return (uint32_t)(slept * 1000 / lowUs);
+    }
+
+    // Average current over low-power time, from the sleep residency and the
+    // board's awake / light-sleep currents (uA). Excludes LED and channel loads.
+    uint32_t estimateLowPowerMicroAmps(uint32_t awakeUa, uint32_t sleepUa, uint64_t nowUs) const {
+        uint32_t sleep = sleepPermille(nowUs);
+        return (uint32_t)(((uint64_t)awakeUa * (1000 - sleep) + (uint64_t)sleepUa * sleep) / 1000);
+    }
+
+private:
+    PowerMode _mode;
+    uint64_t _sinceUs;
+    uint64_t _modeUs[POWER_MODE_COUNT];
+    uint64_t _sleptUs;
+    uint32_t _sleeps;
+
+    void close(uint64_t nowUs) {
+        if (nowUs > _sinceUs) _modeUs[_mode] += nowUs - _sinceUs;
+        _sinceUs = nowUs;
+    }
+};
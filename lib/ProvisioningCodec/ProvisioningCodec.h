@@ -0,0 +1,242 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/ProvisioningCodec/ProvisioningCodec.h
+ *
+ * Description:
+ * Packed BLE provisioning format: every setting in one characteristic write.
+ *
+ * Wire format (version 1):
+ *   [version u8] then any number of records [tag u8][len u8][value; len bytes]
+ *   Integers are little-endian, 1..4 bytes. Strings are raw bytes, no NUL.
+ *   Unknown tags are skipped, so newer apps can talk to older firmware.
+ *
+ * Each tag maps to one field of ProvisioningFields through a constant table
+ * (kind + offset), so decoding is a table lookup per record with no string
+ * compares or allocations. The legacy one-setting-per-characteristic writes
+ * carry the same value encoding and go through decodeValue() with the tag
+ * of their characteristic.
+ *
+ * Decoding is all-or-nothing: a malformed packet leaves the fields untouched.
+ * =================================================================================
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Types.h"
+
+#define PROV_PACKET_VERSION 1
+#define PROV_SSID_MAX 32
+#define PROV_PASS_MAX 64
+
+// Wire tags. Values are protocol: append only, never renumber.
+enum ProvisioningTag : uint8_t {
+    PROV_TAG_NONE = 0,
+    // Credentials
+    PROV_TAG_SSID = 1,
+    PROV_TAG_PASS = 2,
+    // Features
+    PROV_TAG_ENABLE_REWARD_CODE = 3,
+    PROV_TAG_ENABLE_STREAKS = 4,
+    PROV_TAG_ENABLE_PAYBACK = 5,
+    PROV_TAG_ENABLE_TIME_MOD = 6,
+    // Deterrents
+    PROV_TAG_REWARD_STRATEGY = 7,
+    PROV_TAG_REWARD_PENALTY = 8,
+    PROV_TAG_REWARD_MIN = 9,
+    PROV_TAG_REWARD_MAX = 10,
+    PROV_TAG_PAYBACK_STRATEGY = 11,
+    PROV_TAG_PAYBACK_TIME = 12,
+    PROV_TAG_PAYBACK_MIN = 13,
+    PROV_TAG_PAYBACK_MAX = 14,
+    PROV_TAG_TIME_MOD_STEP = 15,
+    // Session Presets
+    PROV_TAG_MIN_SESSION = 16,
+    PROV_TAG_MAX_SESSION = 17,
+    PROV_TAG_SHORT_MIN = 18,
+    PROV_TAG_SHORT_MAX = 19,
+    PROV_TAG_MEDIUM_MIN = 20,
+    PROV_TAG_MEDIUM_MAX = 21,
+    PROV_TAG_LONG_MIN = 22,
+    PROV_TAG_LONG_MAX = 23,
+    // Hardware
+    PROV_TAG_CHANNEL_MASK = 24,
+    PROV_TAG_CH1_ENABLE = 25, // Single-bit views of the mask (legacy characteristics)
+    PROV_TAG_CH2_ENABLE = 26,
+    PROV_TAG_CH3_ENABLE = 27,
+    PROV_TAG_CH4_ENABLE = 28,
+    PROV_TAG_COUNT
+};
+static_assert(PROV_TAG_COUNT <= 32, "ProvisioningFields::present is a 32-bit mask");
+
+#define PROV_TAG_BIT(tag) (1u << (tag))
+
+enum ProvDecodeResult : uint8_t {
+    PROV_DECODE_OK,
+    PROV_DECODE_BAD_VERSION, // Empty packet or unsupported version byte
+    PROV_DECODE_TRUNCATED,   // Record runs past the end of the buffer
+    PROV_DECODE_BAD_LENGTH,  // Value length does not fit its field
+};
+
+// Decoded settings. Pre-fill with the current values; decoding overwrites
+// the fields it finds and sets their bits in 'present'.
+struct ProvisioningFields {
+    DeterrentConfig config;
+    SessionPresets presets;
+    uint8_t channelMask;
+    char ssid[PROV_SSID_MAX + 1];
+    char pass[PROV_PASS_MAX + 1];
+    uint32_t present; // PROV_TAG_BIT(tag) for each decoded tag
+
+    bool has(uint8_t tag) const { return (present & PROV_TAG_BIT(tag)) != 0; }
+};
+
+class ProvisioningCodec {
+public:
+    // All-or-nothing: on error 'fields' is unchanged.
+    static ProvDecodeResult decodePacket(const uint8_t *buf, size_t len, ProvisioningFields &fields) {
+        if (len == 0 || buf[0] != PROV_PACKET_VERSION) return PROV_DECODE_BAD_VERSION;
+
+        ProvisioningFields staged = fields;
+        size_t pos = 1;
+        while (pos < len) {
+            if (len - pos < 2) return PROV_DECODE_TRUNCATED;
+            uint8_t tag = buf[pos];
+            uint8_t valueLen = buf[pos + 1];
+            pos += 2;
+            if (len - pos < valueLen) return PROV_DECODE_TRUNCATED;
+
+            ProvDecodeResult r = decodeValue(tag, buf + pos, valueLen, staged);
+            if (r != PROV_DECODE_OK) return r;
+            pos += valueLen;
+        }
+
+        fields = staged;
+        return PROV_DECODE_OK;
+    }
+
+    // One value with a known tag (legacy characteristic writes). Unknown tags are ignored.
+    static ProvDecodeResult decodeValue(uint8_t tag, const uint8_t *value, size_t len, ProvisioningFields &fields) {
+        const FieldSpec &f = spec(tag);
+        uint8_t *dst = (uint8_t *)&fields + f.offset;
+
+        switch (f.kind) {
+        case KIND_BOOL:
+        case KIND_U8:
+        case KIND_U32:
+        case KIND_BIT: {
+            if (len < 1 || len > 4) return PROV_DECODE_BAD_LENGTH;
+            uint32_t v = 0;
+            for (size_t i = 0; i < len; i++) v |= (uint32_t)value[i] << (8 * i);
+            if (f.kind == KIND_BOOL) *(bool *)dst = (v != 0);
+            else if (f.kind == KIND_U8) *dst = (uint8_t)v;
+            else if (f.kind == KIND_U32) memcpy(dst, &v, sizeof(v));
+            else if (v) *dst |= (uint8_t)(1u << f.arg);
+            else *dst &= (uint8_t)~(1u << f.arg);
+            break;
+        }
+        case KIND_STR:
+            if (len > f.arg) return PROV_DECODE_BAD_LENGTH;
+            memcpy(dst, value, len);
+            dst[len] = '\0';
+            break;
+        default:
+            return PROV_DECODE_OK; // Unknown tag: skipped
+        }
+        fields.present |= PROV_TAG_BIT(tag);
+        return PROV_DECODE_OK;
+    }
+
+    /**
+     * Encodes the fields flagged in 'present' (what an app sends).
+     * @return Bytes written, 0 if 'cap' is too small.
+     */
+    static size_t encodePacket(const ProvisioningFields &fields, uint8_t *out, size_t cap) {
+        if (cap < 1) return 0;
+        out[0] = PROV_PACKET_VERSION;
+        size_t pos = 1;
+        for (uint8_t tag = 1; tag < PROV_TAG_COUNT; tag++) {
+            if (!fields.has(tag)) continue;
+            const FieldSpec &f = spec(tag);
+            const uint8_t *src = (const uint8_t *)&fields + f.offset;
+
+            uint8_t valueLen;
+            uint32_t v = 0;
+            switch (f.kind) {
+            case KIND_STR: valueLen = (uint8_t)strnlen((const char *)src, f.arg); break;
+            case KIND_U32: valueLen = 4; memcpy(&v, src, sizeof(v)); break;
+            case KIND_BIT: valueLen = 1; v = (*src >> f.arg) & 1u; break;
+            default: valueLen = 1; v = *src; break;
+            }
+            if (cap - pos < 2u + valueLen) return 0;
+
+            out[pos++] = tag;
+            out[pos++] = valueLen;
+            if (f.kind == KIND_STR) {
+                memcpy(out + pos, src, valueLen);
+            } else {
+                for (uint8_t i = 0; i < valueLen; i++) out[pos + i] = (uint8_t)(v >> (8 * i));
+            }
+            pos += valueLen;
+        }
+        return pos;
+    }
+
+    static const char *resultName(ProvDecodeResult r) {
+        switch (r) {
+        case PROV_DECODE_OK: return "OK";
+        case PROV_DECODE_BAD_VERSION: return "Bad version";
+        case PROV_DECODE_TRUNCATED: return "Truncated";
+        case PROV_DECODE_BAD_LENGTH: return "Bad value length";
+        default: return "Unknown";
+        }
+    }
+
+private:
+    enum Kind : uint8_t { KIND_NONE, KIND_BOOL, KIND_U8, KIND_U32, KIND_STR, KIND_BIT };
+
+    struct FieldSpec {
+        uint8_t kind;
+        uint8_t arg; // KIND_STR: max length, KIND_BIT: bit index
+        uint16_t offset;
+    };
+
+    static const FieldSpec &spec(uint8_t tag) {
+#define PROV_FIELD(kind, arg, member) {kind, arg, (uint16_t)offsetof(ProvisioningFields, member)}
+        static const FieldSpec table[PROV_TAG_COUNT] = {
+            {KIND_NONE, 0, 0},
+            PROV_FIELD(KIND_STR, PROV_SSID_MAX, ssid),
+            PROV_FIELD(KIND_STR, PROV_PASS_MAX, pass),
+            PROV_FIELD(KIND_BOOL, 0, config.enableRewardCode),
+            PROV_FIELD(KIND_BOOL, 0, config.enableStreaks),
+            PROV_FIELD(KIND_BOOL, 0, config.enablePaybackTime),
+            PROV_FIELD(KIND_BOOL, 0, config.enableTimeModification),
+            PROV_FIELD(KIND_U8, 0, config.rewardPenaltyStrategy),
+            PROV_FIELD(KIND_U32, 0, config.rewardPenalty),
+            PROV_FIELD(KIND_U32, 0, config.rewardPenaltyMin),
+            PROV_FIELD(KIND_U32, 0, config.rewardPenaltyMax),
+            PROV_FIELD(KIND_U8, 0, config.paybackTimeStrategy),
+            PROV_FIELD(KIND_U32, 0, config.paybackTime),
+            PROV_FIELD(KIND_U32, 0, config.paybackTimeMin),
+            PROV_FIELD(KIND_U32, 0, config.paybackTimeMax),
+            PROV_FIELD(KIND_U32, 0, config.timeModificationStep),
+            PROV_FIELD(KIND_U32, 0, presets.minSessionDuration),
+            PROV_FIELD(KIND_U32, 0, presets.maxSessionDuration),
+            PROV_FIELD(KIND_U32, 0, presets.shortMin),
+            PROV_FIELD(KIND_U32, 0, presets.shortMax),
+            PROV_FIELD(KIND_U32, 0, presets.mediumMin),
+            PROV_FIELD(KIND_U32, 0, presets.mediumMax),
+            PROV_FIELD(KIND_U32, 0, presets.longMin),
+            PROV_FIELD(KIND_U32, 0, presets.longMax),
+            PROV_FIELD(KIND_U8, 0, channelMask),
+            PROV_FIELD(KIND_BIT, 0, channelMask),
+            PROV_FIELD(KIND_BIT, 1, channelMask),
+            PROV_FIELD(KIND_BIT, 2, channelMask),
+            PROV_FIELD(KIND_BIT, 3, channelMask),
+        };
+#undef PROV_FIELD
+        return table[tag < PROV_TAG_COUNT ? tag : 0];
+    }
+};
@@ -0,0 +1,58 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/SensorStats/SensorStats.h
+ *
+ * Description:
+ * Smoothing for periodically sampled sensors (die temperature, RSSI, heap).
+ *
+ * SmoothedReading keeps the latest sample, an exponential moving average and
+ * the min/max since the last reset. The first sample seeds the average, so it
+ * is meaningful from the start. Non-finite samples (a failed temperature
+ * read) are ignored. With alpha = a and a sample every T, a step change is
+ * ~63% reflected after T / a.
+ * =================================================================================
+ */
+#pragma once
+#include <stdint.h>
+
+class SmoothedReading {
+public:
+    explicit SmoothedReading(float alpha = 0.2f) : _alpha(alpha) { reset(); }
+
+    void reset() {
+        _count = 0;
+        _last = 0;
+        _ema = 0;
+        _min = 0;
+        _max = 0;
+    }
+
+    void add(float sample) {
+        if (!(sample == sample) || sample > 3.0e38f || sample < -3.0e38f) return; // NaN / inf
+        _last = sample;
+        if (_count == 0) {
+            _ema = _min = _max = sample;
+        } else {
+            _ema += _alpha * (sample - _ema);
+            if (sample < _min) _min = sample;
+            if (sample > _max) _max = sample;
+        }
+        _count++;
+    }
+
+    bool valid() const { return _count > 0; }
+    uint32_t count() const { return _count; }
+    float last() const { return _last; }
+    float ema() const { return _ema; }
+    float minimum() const { return _min; }
+    float maximum() const { return _max; }
+
+private:
+    float _alpha;
+    uint32_t _count;
+    float _last;
+    float _ema;
+    float _min;
+    float _max;
+};
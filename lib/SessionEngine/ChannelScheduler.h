@@ -0,0 +1,91 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/SessionEngine/ChannelScheduler.h
+ *
+ * Description:
+ * Deadline-ordered channel activation for the auto countdown.
+ *
+ * Each channel's delay becomes an absolute deadline (seconds since the
+ * countdown started), kept in an array sorted once at start. The engine then
+ * only looks at the head: the next boundary is O(1), advancing pops the
+ * channels that came due and sets their mask bits, and nothing is done per
+ * channel between deadlines. Remaining delays are derived on demand for
+ * snapshots and persistence.
+ *
+ * N is the channel count (MAX_CHANNELS in the engine); Mask must hold N bits.
+ * =================================================================================
+ */
+#pragma once
+#include <stdint.h>
+
+template <uint8_t N, typename Mask> class ChannelScheduler {
+public:
+    ChannelScheduler() { clear(); }
+
+    void clear() {
+        _count = 0;
+        _head = 0;
+        _elapsed = 0;
+        _mask = 0;
+        _running = false;
+        for (uint8_t i = 0; i < N; i++) _deadline[i] = 0;
+    }
+
+    // Starts a countdown. A zero delay is active immediately (the engine zeroes
+    // disabled channels, the installed mask filters them at the pins).
+    void start(const uint32_t delays[N]) {
+        clear();
+        _running = true;
+        for (uint8_t i = 0; i < N; i++) {
+            _deadline[i] = delays[i];
+            if (delays[i] == 0) {
+                _mask |= (Mask)(1u << i);
+                continue;
+            }
+            // Insertion sort: N is tiny and this runs once per session
+            uint8_t pos = _count++;
+            while (pos > 0 && _deadline[_order[pos - 1]] > delays[i]) {
+                _order[pos] = _order[pos - 1];
+                pos--;
+            }
+            _order[pos] = i;
+        }
+    }
+
+    // Seconds until the next channel comes due; 0 = none left
+    uint32_t secondsUntilNext() const {
+        return (_head < _count) ? _deadline[_order[_head]] - _elapsed : 0;
+    }
+
+    // Moves time forward and activates every channel whose deadline passed
+    void advance(uint32_t seconds) {
+        _elapsed += seconds;
+        while (_head < _count && _deadline[_order[_head]] <= _elapsed) {
+            _mask |= (Mask)(1u << _order[_head]);
+            _head++;
+        }
+    }
+
+    uint32_t remaining(uint8_t channel) const {
+        if (channel >= N || _deadline[channel] <= _elapsed) return 0;
+        return _deadline[channel] - _elapsed;
+    }
+
+    // Writes the remaining delay of every channel (the SessionTimers view)
+    void copyRemaining(uint32_t out[N]) const {
+        for (uint8_t i = 0; i < N; i++) out[i] = remaining(i);
+    }
+
+    Mask activeMask() const { return _mask; }
+    bool isRunning() const { return _running; }
+
+private:
+    uint32_t _deadline[N]; // Per channel, seconds from start
+    uint8_t _order[N];     // Pending channels by deadline; [_head, _count) still waiting
+    uint8_t _count;
+    uint8_t _head;
+    uint32_t _elapsed;
+    Mask _mask;
+    bool _running;
+};
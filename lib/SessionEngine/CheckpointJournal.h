@@ -0,0 +1,104 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/SessionEngine/CheckpointJournal.h
+ *
+ * Description:
+ * Append-only checkpoint journal for running countdowns.
+ *
+ * The full SessionRecord is only rewritten on state changes. In between,
+ * the engine emits small fixed-size checkpoints (every N seconds) that are
+ * written round-robin into a ring of slots. Each slot carries a sequence
+ * number and the sequence of the SessionRecord it extends, so on boot the
+ * newest valid slot can be overlaid on the record without ever trusting a
+ * checkpoint that predates the last full save.
+ * =================================================================================
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "LogicUtils.h"
+#include "Types.h"
+
+#define CHECKPOINT_MAGIC 0x4A43 // "CJ"
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_SLOTS 8
+
+struct __attribute__((packed)) CheckpointSlot {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t state;
+    uint32_t sequence;       // Journal sequence (newest wins)
+    uint32_t recordSequence; // SessionRecord.sequence this checkpoint extends
+    uint32_t lockRemaining;
+    uint32_t penaltyRemaining;
+    uint32_t totalLockedTime;
+    uint32_t crc;
+};
+
+class CheckpointJournal {
+public:
+    /**
+     * Builds a sealed slot from the live counters.
+     */
+    static void encode(const DeviceState &state, const SessionTimers &timers, const SessionStats &stats,
+                       uint32_t sequence, uint32_t recordSequence, CheckpointSlot &out) {
+        memset(&out, 0, sizeof(out));
+        out.magic = CHECKPOINT_MAGIC;
+        out.version = CHECKPOINT_VERSION;
+        out.state = (uint8_t)state;
+        out.sequence = sequence;
+        out.recordSequence = recordSequence;
+        out.lockRemaining = timers.lockRemaining;
+        out.penaltyRemaining = timers.penaltyRemaining;
+        out.totalLockedTime = stats.totalLockedTime;
+        out.crc = computeCrc(out);
+    }
+
+    static bool isValid(const CheckpointSlot &slot) {
+        return slot.magic == CHECKPOINT_MAGIC && slot.version == CHECKPOINT_VERSION && slot.crc == computeCrc(slot);
+    }
+
+    // Ring position for a given journal sequence.
+    static int slotIndex(uint32_t sequence) { return (int)(sequence % CHECKPOINT_SLOTS); }
+
+    /**
+     * Finds the newest intact slot.
+     * @return Index into 'slots', or -1 if none is valid.
+     */
+    static int findNewest(const CheckpointSlot *slots, int count) {
+        int best = -1;
+        for (int i = 0; i < count; i++) {
+            if (!isValid(slots[i])) continue;
+            if (best < 0 || slots[i].sequence > slots[best].sequence) best = i;
+        }
+        return best;
+    }
+
+    /**
+     * Overlays a checkpoint onto state restored from the SessionRecord.
+     * Only applies if the slot extends exactly that record and the state
+     * matches; anything else is stale (a full save happened afterwards).
+     * Counters may only move forward in time (remaining down, locked time up).
+     * @return true if the restored timers were updated.
+     */
+    static bool apply(const CheckpointSlot &slot, uint32_t recordSequence, DeviceState state, SessionTimers &timers,
+                      SessionStats &stats) {
+        if (!isValid(slot)) return false;
+        if (slot.recordSequence != recordSequence) return false;
+        if ((DeviceState)slot.state != state) return false;
+        if (state != LOCKED && state != ABORTED) return false;
+
+        if (slot.lockRemaining < timers.lockRemaining) timers.lockRemaining = slot.lockRemaining;
+        if (slot.penaltyRemaining < timers.penaltyRemaining) timers.penaltyRemaining = slot.penaltyRemaining;
+        if (slot.totalLockedTime > stats.totalLockedTime) stats.totalLockedTime = slot.totalLockedTime;
+        return true;
+    }
+
+private:
+    static uint32_t computeCrc(const CheckpointSlot &slot) {
+        return LogicUtils::crc32((const uint8_t *)&slot, offsetof(CheckpointSlot, crc));
+    }
+};
@@ -0,0 +1,155 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/SessionEngine/EngineEvents.h
+ *
+ * Description:
+ * Compact binary events for the engine hot path.
+ *
+ * Frequent log points (state changes, time mods, watchdog strikes, ...) are
+ * emitted as an event id plus up to three numeric arguments instead of text.
+ * Nothing is formatted while the state lock is held; readers (/log, serial
+ * drain) call EngineEvents::format() when they actually need the text.
+ * =================================================================================
+ */
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Types.h"
+
+enum EngineEventId : uint8_t {
+    EVT_STATE_CHANGE,      // a0 = new DeviceState
+    EVT_TIME_MODIFIED,     // a0 = 1 increase / 0 decrease, a1 = step (s), a2 = remaining (s)
+    EVT_REWARD_GENERATED,  // a0, a1 = first 8 code chars (packed little-endian)
+    EVT_SESSION_STATS,     // a0 = streak, a1 = completed
+    EVT_PENALTY_ENFORCED,  // a0 = penalty (s)
+    EVT_KEEPALIVE_RESET,   // a0 = strikes cleared
+    EVT_KEEPALIVE_STRIKE,  // a0 = strikes, a1 = max strikes
+    EVT_FAILSAFE_ARMED,    // a0 = seconds
+    EVT_FAILSAFE_DISARMED, // (no args)
+    EVT_SAFETY_ABORT,      // a0 = SafetyAbortCause (engine acted on a safety input)
+    EVT_COUNT
+};
+
+// Safety inputs whose input-to-output latency is tracked
+enum SafetyAbortCause : uint8_t {
+    SAFETY_CAUSE_LONG_PRESS,
+    SAFETY_CAUSE_INTERLOCK,
+    SAFETY_CAUSE_KEEPALIVE,
+    SAFETY_CAUSE_COUNT
+};
+
+struct __attribute__((packed)) EngineEvent {
+    uint32_t timestampMs;
+    uint8_t id;
+    uint32_t args[3];
+};
+
+class EngineEvents {
+public:
+    static EngineEvent make(uint32_t timestampMs, EngineEventId id, uint32_t a0 = 0, uint32_t a1 = 0, uint32_t a2 = 0) {
+        EngineEvent e;
+        e.timestampMs = timestampMs;
+        e.id = (uint8_t)id;
+        e.args[0] = a0;
+        e.args[1] = a1;
+        e.args[2] = a2;
+        return e;
+    }
+
+    // Packs up to 4 characters into one argument (for short text snippets).
+    static uint32_t packChars(const char *s) {
+        uint32_t v = 0;
+        for (int i = 0; i < 4 && s[i] != '\0'; i++) v |= (uint32_t)(uint8_t)s[i] << (8 * i);
+        return v;
+    }
+
+    /**
+     * Renders an event as the same " Key      : message" line the text log uses.
+     * @return Characters written (excluding NUL), clamped to bufSize - 1.
+     */
+    static size_t format(const EngineEvent &e, char *buf, size_t bufSize) {
+        if (bufSize == 0) return 0;
+        int n = 0;
+
+        switch ((EngineEventId)e.id) {
+        case EVT_STATE_CHANGE:
+            n = snprintf(buf, bufSize, " %-8s : >>> STATE CHANGE: %s", "Session", stateName((DeviceState)e.args[0]));
+            break;
+        case EVT_TIME_MODIFIED:
+            n = snprintf(buf, bufSize, " %-8s : Time Mod: %s %u s. Rem: %u", "Session", e.args[0] ? "+" : "-",
+                         (unsigned)e.args[1], (unsigned)e.args[2]);
+            break;
+        case EVT_REWARD_GENERATED: {
+            char snippet[9];
+            unpackChars(e.args[0], snippet);
+            unpackChars(e.args[1], snippet + 4);
+            snippet[8] = '\0';
+            n = snprintf(buf, bufSize, " %-8s : New Reward Code Generated: %s...", "Session", snippet);
+            break;
+        }
+        case EVT_SESSION_STATS:
+            n = snprintf(buf, bufSize, " %-8s : %-20s : %u, %s : %u", "Session", "New Streak", (unsigned)e.args[0],
+                         "Total Completed", (unsigned)e.args[1]);
+            break;
+        case EVT_PENALTY_ENFORCED:
+            n = snprintf(buf, bufSize, " %-8s : Penalty Enforced: %u s", "Rules", (unsigned)e.args[0]);
+            break;
+        case EVT_KEEPALIVE_RESET:
+            n = snprintf(buf, bufSize, " %-8s : Keep-Alive Signal. Resetting %u strikes.", "Session", (unsigned)e.args[0]);
+            break;
+        case EVT_KEEPALIVE_STRIKE:
+            if (e.args[0] >= e.args[1])
+                n = snprintf(buf, bufSize, " %-8s : Keep-Alive UI Watchdog: Strike %u/%u! ABORTING.", "Session",
+                             (unsigned)e.args[0], (unsigned)e.args[1]);
+            else
+                n = snprintf(buf, bufSize, " %-8s : Keep-Alive UI Watchdog Missed check. Strike %u/%u", "Session",
+                             (unsigned)e.args[0], (unsigned)e.args[1]);
+            break;
+        case EVT_FAILSAFE_ARMED:
+            n = snprintf(buf, bufSize, " %-8s : Death Grip ARMED: %u s", "System", (unsigned)e.args[0]);
+            break;
+        case EVT_FAILSAFE_DISARMED:
+            n = snprintf(buf, bufSize, " %-8s : Death Grip Timer DISARMED.", "System");
+            break;
+        case EVT_SAFETY_ABORT:
+            n = snprintf(buf, bufSize, " %-8s : Safety abort: %s", "Safety", causeName(e.args[0]));
+            break;
+        default:
+            n = snprintf(buf, bufSize, " %-8s : Unknown event %u (%u, %u, %u)", "Event", (unsigned)e.id,
+                         (unsigned)e.args[0], (unsigned)e.args[1], (unsigned)e.args[2]);
+            break;
+        }
+
+        if (n < 0) return 0;
+        return ((size_t)n < bufSize) ? (size_t)n : bufSize - 1;
+    }
+
+    static const char *causeName(uint32_t cause) {
+        switch (cause) {
+        case SAFETY_CAUSE_LONG_PRESS: return "Long-Press";
+        case SAFETY_CAUSE_INTERLOCK: return "Interlock";
+        case SAFETY_CAUSE_KEEPALIVE: return "Keep-Alive";
+        }
+        return "Unknown";
+    }
+
+private:
+    static void unpackChars(uint32_t v, char *out) {
+        for (int i = 0; i < 4; i++) out[i] = (char)((v >> (8 * i)) & 0xFF);
+    }
+
+    static const char *stateName(DeviceState s) {
+        switch (s) {
+        case READY: return "READY";
+        case ARMED: return "ARMED";
+        case LOCKED: return "LOCKED";
+        case ABORTED: return "ABORTED";
+        case COMPLETED: return "COMPLETED";
+        case TESTING: return "TESTING";
+        }
+        return "UNKNOWN";
+    }
+};
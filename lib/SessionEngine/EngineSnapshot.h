@@ -0,0 +1,77 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/SessionEngine/EngineSnapshot.h
+ *
+ * Description:
+ * Read-only copy of the engine state for observers (Web API, telemetry).
+ *
+ * The engine publishes a snapshot at the end of every tick and state change.
+ * Readers copy it through a sequence lock, so they never take the state mutex
+ * and never stall the engine: a reader that overlaps a publish simply retries.
+ * There must only ever be one writer at a time (the engine publishes while the
+ * caller holds the state lock, which already serializes all mutations).
+ * =================================================================================
+ */
+#pragma once
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+#include "Types.h"
+
+struct EngineSnapshot {
+    DeviceState state;
+    SessionOutcome outcome;
+    SessionTimers timers;
+    SessionStats stats;
+    SessionConfig config;
+    uint32_t generation;
+    bool interlockValid;
+
+    // Rewards are only copied while they may be revealed (READY/COMPLETED).
+    bool rewardsVisible;
+    Reward rewards[REWARD_HISTORY_SIZE];
+};
+
+class SnapshotSeqLock {
+public:
+    SnapshotSeqLock() : _seq(0) { memset(&_data, 0, sizeof(_data)); }
+
+    /**
+     * Writer side. Sequence is odd while the copy is in progress.
+     */
+    void publish(const EngineSnapshot &snap) {
+        uint32_t seq = _seq.load(std::memory_order_relaxed);
+        _seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        memcpy(&_data, &snap, sizeof(_data));
+
+        _seq.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * Reader side. Never blocks.
+     * @return false only if every attempt overlapped a publish.
+     */
+    bool read(EngineSnapshot &out, int maxAttempts = 16) const {
+        for (int i = 0; i < maxAttempts; i++) {
+            uint32_t before = _seq.load(std::memory_order_acquire);
+            if (before & 1) continue;
+
+            memcpy(&out, &_data, sizeof(out));
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_seq.load(std::memory_order_relaxed) == before) return true;
+        }
+        return false;
+    }
+
+    // Number of completed publishes (diagnostics)
+    uint32_t publishCount() const { return _seq.load(std::memory_order_relaxed) / 2; }
+
+private:
+    std::atomic<uint32_t> _seq;
+    EngineSnapshot _data;
+};
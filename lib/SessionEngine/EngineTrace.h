@@ -0,0 +1,456 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/SessionEngine/EngineTrace.h
+ *
+ * Description:
+ * Compact binary trace of everything the session engine sees, for replaying
+ * field incidents deterministically on the host (test/TraceReplay.h).
+ *
+ * A trace is a 4-byte header followed by records, in the order they happened:
+ * - Calls into the engine (setup, restored state, update(nowMs), abort, ...),
+ *   written by the caller just before making them.
+ * - Inputs the engine read from the HAL during the call (clock, random
+ *   numbers, buttons, interlock, network flags, channel enables).
+ * - Safety relevant outputs (safety mask, saved state, call results), which
+ *   the replay compares against what the engine does now.
+ *
+ * Record: [kind | 0x80 if flag][payload]. Boolean inputs live in the flag bit
+ * (1 byte), times are zigzag deltas against the previous time in the trace
+ * (2 bytes for a second), everything else a LEB128 varint or a length-prefixed
+ * blob. Records are written whole or not at all; once the buffer is full the
+ * trace stops, so it always replays from its start.
+ * =================================================================================
+ */
+#pragma once
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "SessionContext.h"
+#include "SessionHistory.h" // HistoryCodec varints
+#include "SessionRecord.h"
+
+#define TRACE_MAGIC 0x5445 // "ET"
+#define TRACE_VERSION 1
+#define TRACE_HEADER_SIZE 4 // magic, version, MAX_CHANNELS
+#define TRACE_FLAG 0x80
+#define TRACE_KIND_MASK 0x7F
+#define TRACE_FILL_CHUNK 32 // fillRandom() bytes per record
+#define TRACE_BLOB_MAX 256  // Largest blob payload (setup, restored state, config)
+
+enum TraceKind : uint8_t {
+    // --- Inputs (HAL -> engine) ---
+    TRACE_IN_MILLIS = 1,        // time
+    TRACE_IN_RANDOM,            // value
+    TRACE_IN_FILL,              // blob, one per TRACE_FILL_CHUNK
+    TRACE_IN_TRIGGER,           // flag
+    TRACE_IN_ABORT,             // flag
+    TRACE_IN_SHORT_PRESS,       // flag
+    TRACE_IN_INTERLOCK_VALID,   // flag
+    TRACE_IN_INTERLOCK_ENGAGED, // flag
+    TRACE_IN_PROVISIONING,      // flag
+    TRACE_IN_CHANNEL,           // value = channel, flag = enabled
+
+    // --- Outputs (engine -> HAL, compared on replay) ---
+    TRACE_OUT_MASK = 32, // value
+    TRACE_OUT_STATE,     // value (saveState)
+    TRACE_OUT_RESULT,    // value = zigzag(return code) of the previous call
+
+    // --- Calls (caller -> engine) ---
+    TRACE_CALL_SETUP = 64, // blob: SystemDefaults, SessionPresets, DeterrentConfig
+    TRACE_CALL_LOAD,       // blob: SessionRecord of the restored state
+    TRACE_CALL_REBOOT,
+    TRACE_CALL_UPDATE, // time
+    TRACE_CALL_INPUTS,
+    TRACE_CALL_START, // blob: SessionConfig
+    TRACE_CALL_TEST_START,
+    TRACE_CALL_TEST_STOP,
+    TRACE_CALL_ABORT,
+    TRACE_CALL_TRIGGER,
+    TRACE_CALL_PET,
+    TRACE_CALL_MODIFY, // flag = increase
+    TRACE_CALL_DIAGNOSTICS,
+    TRACE_CALL_END // Not a record: number of call kinds is TRACE_CALL_END - TRACE_CALL_SETUP
+};
+
+enum TracePayload : uint8_t { TRACE_PAYLOAD_NONE, TRACE_PAYLOAD_VALUE, TRACE_PAYLOAD_TIME, TRACE_PAYLOAD_BLOB };
+
+struct TraceRecord {
+    uint8_t kind;
+    bool flag;
+    uint32_t value;      // VALUE and TIME (absolute ms) records
+    const uint8_t *blob; // BLOB records
+    size_t blobLen;
+    size_t offset; // Where the record starts in the trace
+    size_t next;   // Where the following one starts
+};
+
+class TraceCodec {
+public:
+    static bool isCall(uint8_t kind) { return kind >= TRACE_CALL_SETUP && kind < TRACE_CALL_END; }
+    static bool isOutput(uint8_t kind) { return kind >= TRACE_OUT_MASK && kind < TRACE_CALL_SETUP; }
+
+    static uint8_t payloadOf(uint8_t kind) {
+        switch (kind) {
+        case TRACE_IN_MILLIS:
+        case TRACE_CALL_UPDATE:
+            return TRACE_PAYLOAD_TIME;
+        case TRACE_IN_RANDOM:
+        case TRACE_IN_CHANNEL:
+        case TRACE_OUT_MASK:
+        case TRACE_OUT_STATE:
+        case TRACE_OUT_RESULT:
+            return TRACE_PAYLOAD_VALUE;
+        case TRACE_IN_FILL:
+        case TRACE_CALL_SETUP:
+        case TRACE_CALL_LOAD:
+        case TRACE_CALL_START:
+            return TRACE_PAYLOAD_BLOB;
+        default:
+            return TRACE_PAYLOAD_NONE;
+        }
+    }
+
+    static void writeHeader(uint8_t *p) {
+        p[0] = (uint8_t)(TRACE_MAGIC & 0xFF);
+        p[1] = (uint8_t)(TRACE_MAGIC >> 8);
+        p[2] = TRACE_VERSION;
+        p[3] = MAX_CHANNELS;
+    }
+
+    static bool checkHeader(const uint8_t *p, size_t len) {
+        return len >= TRACE_HEADER_SIZE && (p[0] | (p[1] << 8)) == TRACE_MAGIC && p[2] == TRACE_VERSION &&
+               p[3] == MAX_CHANNELS;
+    }
+
+    // --- Blobs (field by field, never a memcpy of the structs) ---
+
+    static size_t encodeSetup(const SystemDefaults &d, const SessionPresets &p, const DeterrentConfig &c, uint8_t *out) {
+        uint8_t *w = out;
+        const uint32_t defaults[] = {d.longPressDuration, d.extButtonSignalDuration, d.testModeDuration,
+                                     d.keepAliveInterval, d.keepAliveMaxStrikes,    d.bootLoopThreshold,
+                                     d.stableBootTime,    d.wifiMaxRetries,         d.armedTimeout,
+                                     d.checkpointInterval};
+        const uint32_t presets[] = {p.shortMin, p.shortMax, p.mediumMin, p.mediumMax,
+                                    p.longMin,  p.longMax,  p.maxSessionDuration, p.minSessionDuration};
+        const uint32_t deterrents[] = {c.rewardPenaltyStrategy, c.rewardPenaltyMin, c.rewardPenaltyMax, c.rewardPenalty,
+                                       c.paybackTimeStrategy,   c.paybackTimeMin,   c.paybackTimeMax,   c.paybackTime,
+                                       c.timeModificationStep};
+        for (uint32_t v : defaults) w = HistoryCodec::putVarint(w, v);
+        for (uint32_t v : presets) w = HistoryCodec::putVarint(w, v);
+        *w++ = (c.enableStreaks ? 1 : 0) | (c.enableRewardCode ? 2 : 0) | (c.enablePaybackTime ? 4 : 0) |
+               (c.enableTimeModification ? 8 : 0);
+        for (uint32_t v : deterrents) w = HistoryCodec::putVarint(w, v);
+        return (size_t)(w - out);
+    }
+
+    static bool decodeSetup(const uint8_t *p, size_t len, SystemDefaults &d, SessionPresets &s, DeterrentConfig &c) {
+        const uint8_t *end = p + len;
+        uint32_t *defaults[] = {&d.longPressDuration, &d.extButtonSignalDuration, &d.testModeDuration,
+                                &d.keepAliveInterval, &d.keepAliveMaxStrikes,    &d.bootLoopThreshold,
+                                &d.stableBootTime,    &d.wifiMaxRetries,         &d.armedTimeout,
+                                &d.checkpointInterval};
+        uint32_t *presets[] = {&s.shortMin, &s.shortMax, &s.mediumMin, &s.mediumMax,
+                               &s.longMin,  &s.longMax,  &s.maxSessionDuration, &s.minSessionDuration};
+        uint32_t rewardStrategy, paybackStrategy;
+        uint32_t *deterrents[] = {&rewardStrategy,  &c.rewardPenaltyMin, &c.rewardPenaltyMax, &c.rewardPenalty,
+                                  &paybackStrategy, &c.paybackTimeMin,   &c.paybackTimeMax,   &c.paybackTime,
+                                  &c.timeModificationStep};
+        for (uint32_t *v : defaults)
+            if (!HistoryCodec::getVarint(p, end, *v)) return false;
+        for (uint32_t *v : presets)
+            if (!HistoryCodec::getVarint(p, end, *v)) return false;
+        if (p >= end) return false;
+        uint8_t flags = *p++;
+        for (uint32_t *v : deterrents)
+            if (!HistoryCodec::getVarint(p, end, *v)) return false;
+        c.enableStreaks = flags & 1;
+        c.enableRewardCode = flags & 2;
+        c.enablePaybackTime = flags & 4;
+        c.enableTimeModification = flags & 8;
+        c.rewardPenaltyStrategy = (DeterrentStrategy)rewardStrategy;
+        c.paybackTimeStrategy = (DeterrentStrategy)paybackStrategy;
+        return p == end;
+    }
+
+    static size_t encodeConfig(const SessionConfig &c, uint8_t *out) {
+        uint8_t *w = out;
+        w = HistoryCodec::putVarint(w, c.durationType);
+        w = HistoryCodec::putVarint(w, c.durationFixed);
+        w = HistoryCodec::putVarint(w, c.durationMin);
+        w = HistoryCodec::putVarint(w, c.durationMax);
+        w = HistoryCodec::putVarint(w, c.triggerStrategy);
+        *w++ = (c.hideTimer ? 1 : 0) | (c.disableLED ? 2 : 0);
+        for (int i = 0; i < MAX_CHANNELS; i++) w = HistoryCodec::putVarint(w, c.channelDelays[i]);
+        return (size_t)(w - out);
+    }
+
+    static bool decodeConfig(const uint8_t *p, size_t len, SessionConfig &c) {
+        const uint8_t *end = p + len;
+        uint32_t type, strategy;
+        if (!HistoryCodec::getVarint(p, end, type) || !HistoryCodec::getVarint(p, end, c.durationFixed) ||
+            !HistoryCodec::getVarint(p, end, c.durationMin) || !HistoryCodec::getVarint(p, end, c.durationMax) ||
+            !HistoryCodec::getVarint(p, end, strategy) || p >= end)
+            return false;
+        uint8_t flags = *p++;
+        for (int i = 0; i < MAX_CHANNELS; i++)
+            if (!HistoryCodec::getVarint(p, end, c.channelDelays[i])) return false;
+        c.durationType = (DurationType)type;
+        c.triggerStrategy = (TriggerStrategy)strategy;
+        c.hideTimer = flags & 1;
+        c.disableLED = flags & 2;
+        return p == end;
+    }
+};
+
+/**
+ * Appends records to a caller-owned buffer. One writer at a time (the engine
+ * state lock); size() may be read from any task and only covers whole records.
+ */
+class TraceWriter {
+public:
+    TraceWriter(uint8_t *buf, size_t capacity) : _buf(buf), _cap(capacity), _len(0), _lastMs(0), _full(false) {
+        _published.store(0, std::memory_order_relaxed);
+        if (_cap < TRACE_HEADER_SIZE) {
+            _full = true;
+            return;
+        }
+        TraceCodec::writeHeader(_buf);
+        _len = TRACE_HEADER_SIZE;
+        _published.store(_len, std::memory_order_release);
+    }
+
+    bool put(uint8_t kind, bool flag = false) { return append(kind, flag, nullptr, 0); }
+
+    bool putValue(uint8_t kind, uint32_t value, bool flag = false) {
+        uint8_t tmp[5];
+        return append(kind, flag, tmp, (size_t)(HistoryCodec::putVarint(tmp, value) - tmp));
+    }
+
+    bool putTime(uint8_t kind, uint32_t ms) {
+        uint8_t tmp[5];
+        size_t n = (size_t)(HistoryCodec::putVarint(tmp, HistoryCodec::zigzag((int32_t)(ms - _lastMs))) - tmp);
+        if (!append(kind, false, tmp, n)) return false;
+        _lastMs = ms;
+        return true;
+    }
+
+    bool putBlob(uint8_t kind, const uint8_t *data, size_t len) {
+        uint8_t tmp[5 + TRACE_BLOB_MAX];
+        if (len > TRACE_BLOB_MAX) return false;
+        uint8_t *w = HistoryCodec::putVarint(tmp, (uint32_t)len);
+        memcpy(w, data, len);
+        return append(kind, false, tmp, (size_t)(w - tmp) + len);
+    }
+
+    const uint8_t *data() const { return _buf; }
+    size_t size() const { return _published.load(std::memory_order_acquire); }
+    size_t capacity() const { return _cap; }
+    bool full() const { return _full; }
+
+private:
+    bool append(uint8_t kind, bool flag, const uint8_t *payload, size_t len) {
+        if (_full) return false;
+        if (_len + 1 + len > _cap) {
+            _full = true; // Stop here: the trace must stay replayable from its start
+            return false;
+        }
+        _buf[_len] = (uint8_t)(kind | (flag ? TRACE_FLAG : 0));
+        if (len) memcpy(_buf + _len + 1, payload, len);
+        _len += 1 + len;
+        _published.store(_len, std::memory_order_release);
+        return true;
+    }
+
+    uint8_t *_buf;
+    size_t _cap;
+    size_t _len;
+    uint32_t _lastMs;
+    bool _full;
+    std::atomic<size_t> _published;
+};
+
+/**
+ * Walks a trace record by record. peek() decodes without moving, so a replay
+ * can check the kind before consuming it.
+ */
+class TraceReader {
+public:
+    TraceReader(const uint8_t *data, size_t len)
+        : _data(data), _len(len), _pos(TRACE_HEADER_SIZE), _lastMs(0), _valid(TraceCodec::checkHeader(data, len)),
+          _corrupt(false) {}
+
+    bool valid() const { return _valid; }
+    bool corrupt() const { return _corrupt; }
+    bool atEnd() const { return !_valid || _corrupt || _pos >= _len; }
+    size_t offset() const { return _pos; }
+
+    bool peek(TraceRecord &r) {
+        if (atEnd()) return false;
+        const uint8_t *p = _data + _pos;
+        const uint8_t *end = _data + _len;
+        r.offset = _pos;
+        r.kind = *p & TRACE_KIND_MASK;
+        r.flag = (*p & TRACE_FLAG) != 0;
+        r.value = 0;
+        r.blob = nullptr;
+        r.blobLen = 0;
+        p++;
+
+        uint32_t v = 0;
+        switch (TraceCodec::payloadOf(r.kind)) {
+        case TRACE_PAYLOAD_VALUE:
+            if (!HistoryCodec::getVarint(p, end, r.value)) return fail();
+            break;
+        case TRACE_PAYLOAD_TIME:
+            if (!HistoryCodec::getVarint(p, end, v)) return fail();
+            r.value = _lastMs + (uint32_t)HistoryCodec::unzigzag(v);
+            break;
+        case TRACE_PAYLOAD_BLOB:
+            if (!HistoryCodec::getVarint(p, end, v) || v > (uint32_t)(end - p)) return fail();
+            r.blob = p;
+            r.blobLen = v;
+            p += v;
+            break;
+        default:
+            break;
+        }
+        r.next = (size_t)(p - _data);
+        return true;
+    }
+
+    void consume(const TraceRecord &r) {
+        _pos = r.next;
+        if (TraceCodec::payloadOf(r.kind) == TRACE_PAYLOAD_TIME) _lastMs = r.value;
+    }
+
+    bool next(TraceRecord &r) {
+        if (!peek(r)) return false;
+        consume(r);
+        return true;
+    }
+
+private:
+    bool fail() {
+        _corrupt = true;
+        return false;
+    }
+
+    const uint8_t *_data;
+    size_t _len;
+    size_t _pos;
+    uint32_t _lastMs;
+    bool _valid;
+    bool _corrupt;
+};
+
+/**
+ * HAL decorator: forwards every call to 'inner' and records what the engine
+ * read and wrote. Construct the engine on this instead of the real HAL, and
+ * record each call into the engine (recordCall() and friends) right before
+ * making it, under the same lock.
+ */
+template <size_t Capacity>
+class TraceRecordingHAL : public ISessionHAL {
+public:
+    explicit TraceRecordingHAL(ISessionHAL &inner) : _inner(inner), _trace(_buf, Capacity) {}
+
+    // --- Calls into the engine ---
+    void recordSetup(const SystemDefaults &defaults, const SessionPresets &presets, const DeterrentConfig &deterrents) {
+        uint8_t blob[TRACE_BLOB_MAX];
+        _trace.putBlob(TRACE_CALL_SETUP, blob, TraceCodec::encodeSetup(defaults, presets, deterrents, blob));
+    }
+
+    void recordLoad(const DeviceState &state, const SessionTimers &timers, const SessionStats &stats,
+                    const SessionConfig &config) {
+        SessionRecord rec;
+        SessionRecordCodec::encode(state, timers, stats, config, 0, rec);
+        _trace.putBlob(TRACE_CALL_LOAD, reinterpret_cast<const uint8_t *>(&rec), sizeof(rec));
+    }
+
+    void recordStart(const SessionConfig &config) {
+        uint8_t blob[TRACE_BLOB_MAX];
+        _trace.putBlob(TRACE_CALL_START, blob, TraceCodec::encodeConfig(config, blob));
+    }
+
+    void recordUpdate(unsigned long nowMs) { _trace.putTime(TRACE_CALL_UPDATE, (uint32_t)nowMs); }
+    void recordCall(TraceKind kind, bool flag = false) { _trace.put(kind, flag); }
+    void recordResult(int code) { _trace.putValue(TRACE_OUT_RESULT, HistoryCodec::zigzag(code)); }
+
+    const uint8_t *data() const { return _trace.data(); }
+    size_t size() const { return _trace.size(); }
+    size_t capacity() const { return Capacity; }
+    bool full() const { return _trace.full(); }
+
+    // --- ISessionHAL (recorded) ---
+    void setHardwareSafetyMask(ChannelMask mask) override {
+        _trace.putValue(TRACE_OUT_MASK, mask);
+        _inner.setHardwareSafetyMask(mask);
+    }
+
+    bool isChannelEnabled(int channelIndex) const override {
+        bool enabled = _inner.isChannelEnabled(channelIndex);
+        _trace.putValue(TRACE_IN_CHANNEL, (uint32_t)channelIndex, enabled);
+        return enabled;
+    }
+
+    bool checkTriggerAction() override { return flag(TRACE_IN_TRIGGER, _inner.checkTriggerAction()); }
+    bool checkAbortAction() override { return flag(TRACE_IN_ABORT, _inner.checkAbortAction()); }
+    bool checkShortPressAction() override { return flag(TRACE_IN_SHORT_PRESS, _inner.checkShortPressAction()); }
+    bool isSafetyInterlockValid() override { return flag(TRACE_IN_INTERLOCK_VALID, _inner.isSafetyInterlockValid()); }
+    bool isSafetyInterlockEngaged() override {
+        return flag(TRACE_IN_INTERLOCK_ENGAGED, _inner.isSafetyInterlockEngaged());
+    }
+    bool isNetworkProvisioningRequested() override {
+        return flag(TRACE_IN_PROVISIONING, _inner.isNetworkProvisioningRequested());
+    }
+
+    void saveState(const DeviceState &state, const SessionTimers &timers, const SessionStats &stats,
+                   const SessionConfig &config) override {
+        _trace.putValue(TRACE_OUT_STATE, state);
+        _inner.saveState(state, timers, stats, config);
+    }
+
+    unsigned long getMillis() override {
+        unsigned long now = _inner.getMillis();
+        _trace.putTime(TRACE_IN_MILLIS, (uint32_t)now);
+        return now;
+    }
+
+    uint32_t getRandom(uint32_t min, uint32_t max) override {
+        uint32_t v = _inner.getRandom(min, max);
+        _trace.putValue(TRACE_IN_RANDOM, v);
+        return v;
+    }
+
+    void fillRandom(uint8_t *buf, size_t len) override {
+        _inner.fillRandom(buf, len);
+        for (size_t off = 0; off < len; off += TRACE_FILL_CHUNK)
+            _trace.putBlob(TRACE_IN_FILL, buf + off, len - off < TRACE_FILL_CHUNK ? len - off : TRACE_FILL_CHUNK);
+    }
+
+    // --- ISessionHAL (forwarded only) ---
+    void setLedEnabled(bool enabled) override { _inner.setLedEnabled(enabled); }
+    void enterNetworkProvisioning() override { _inner.enterNetworkProvisioning(); }
+    void setWatchdogTimeout(uint32_t seconds) override { _inner.setWatchdogTimeout(seconds); }
+    void armFailsafeTimer(uint32_t seconds) override { _inner.armFailsafeTimer(seconds); }
+    void disarmFailsafeTimer() override { _inner.disarmFailsafeTimer(); }
+    void saveCheckpoint(const DeviceState &state, const SessionTimers &timers, const SessionStats &stats) override {
+        _inner.saveCheckpoint(state, timers, stats);
+    }
+    void appendHistory(const HistoryEntry &entry) override { _inner.appendHistory(entry); }
+    void log(const char *message) override { _inner.log(message); }
+    void logEvent(const EngineEvent &event) override { _inner.logEvent(event); }
+
+private:
+    bool flag(TraceKind kind, bool value) {
+        _trace.put(kind, value);
+        return value;
+    }
+
+    ISessionHAL &_inner;
+    uint8_t _buf[Capacity];
+    mutable TraceWriter _trace; // isChannelEnabled() is const
+};
@@ -13,6 +13,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <stddef.h>
 
 class LogicUtils {
 public:
@@ -88,5 +89,24 @@ public:
         // Ensure buffer safety in caller
         snprintf(outString, 16, "%s-%02d", getNatoWord(alphaChar), rollingVal);
     }
+
+    /**
+     * Standard CRC-32 (IEEE 802.3, reflected, poly 0xEDB88320).
+     * Used to validate persisted binary records before they are trusted.
+     * Bitwise implementation: no lookup table, so no RAM/flash cost.
+     * @param data Buffer to checksum
+     * @param len  Number of bytes
+     * @param crc  Running value when chaining calls (start with 0)
+     */
+    static uint32_t crc32(const uint8_t *data, size_t len, uint32_t crc = 0) {
+        crc = ~crc;
+        for (size_t i = 0; i < len; i++) {
+            crc ^= data[i];
+            for (int b = 0; b < 8; b++) {
+                crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1UL)));
+            }
+        }
+        return ~crc;
+    }
 };
 
@@ -40,14 +40,23 @@ SessionEngine::SessionEngine(ISessionHAL& hal,
     memset(&_timers, 0, sizeof(_timers));
     memset(&_stats, 0, sizeof(_stats));
     memset(&_activeConfig, 0, sizeof(_activeConfig));
-    memset(_rewardHistory, 0, sizeof(_rewardHistory));
+    memset(_rewardRing, 0, sizeof(_rewardRing));
+    _rewardHead = 0;
     
     _lastKeepAliveTime = 0;
     _currentKeepAliveStrikes = 0;
+    _secondsSinceCheckpoint = 0;
+    _lockStartMs = 0;
+    _lockStartKnown = false;
+    _timeModSec = 0;
+    _clockMs = 0;
+    _clockStarted = false;
+    _generation = 1;
 
     // Generate the initial reward code upon startup.
     // This ensures getRewardHistory() returns a valid code immediately in the READY state.
     rotateAndGenerateReward();
+    publishSnapshot();
 }
 
 // =================================================================================
@@ -61,6 +70,11 @@ void SessionEngine::logKeyValue(const char *key, const char *value) {
     _hal.log(tempBuf);
 }
 
+// Hot-path counterpart of logKeyValue: no formatting while the state lock is held.
+void SessionEngine::emitEvent(EngineEventId id, uint32_t a0, uint32_t a1, uint32_t a2) {
+    _hal.logEvent(EngineEvents::make((uint32_t)_hal.getMillis(), id, a0, a1, a2));
+}
+
 /**
  * Validates a specific Session Request.
  * Performs sanity checks on user inputs (Duration and Delays).
@@ -99,7 +113,7 @@ bool SessionEngine::validateSessionConfig(const SessionConfig& config) const {
  * 1. Checks that Presets are logically sound (Min <= Max, Non-zero).
  * 2. Checks that Deterrents respect the Global Safety Limits defined in Presets.
  */
-bool SessionEngine::validateConfig(const DeterrentConfig& deterrents, const SessionPresets& presets) const {
+bool SessionEngine::validateConfig(const DeterrentConfig& deterrents, const SessionPresets& presets) {
     
     // --- 1. Session Presets Validation ---
     
@@ -396,25 +410,17 @@ void SessionEngine::changeState(DeviceState newState) {
     _state = newState;
     
     // 1. Log Visuals
-    const char* sStr = "UNKNOWN";
-    switch(_state) {
-        case READY:      sStr = "READY"; break;
-        case ARMED:      sStr = "ARMED"; break;
-        case LOCKED:     sStr = "LOCKED"; break;
-        case ABORTED:    sStr = "ABORTED"; break;
-        case COMPLETED:  sStr = "COMPLETED"; break;
-        case TESTING:    sStr = "TESTING"; break;
-    }
-    
-    char logBuf[64];
-    snprintf(logBuf, sizeof(logBuf), ">>> STATE CHANGE: %s", sStr);
-    logKeyValue("Session", logBuf);
+    emitEvent(EVT_STATE_CHANGE, (uint32_t)_state);
 
     // 2. Apply Safety Configuration (Side Effects)
     applyStateSafetyProfile();
 
     // 3. Persist to NVS
+    _generation++;
+    syncChannelTimers();
     _hal.saveState(_state, _timers, _stats, _activeConfig);
+    _secondsSinceCheckpoint = 0;
+    publishSnapshot();
 }
 
 // =================================================================================
@@ -433,6 +439,7 @@ void SessionEngine::updateSafetyInterlock() {
             // Only log if this is a new event (prevent log spamming handled by state change)
             // The HAL's logging handles verbose debugging.
             logKeyValue("Safety", "Critical: Interlock invalid/disconnected.");
+            emitEvent(EVT_SAFETY_ABORT, SAFETY_CAUSE_INTERLOCK);
             abort("Safety Disconnect");
         }
     }
@@ -490,43 +497,109 @@ SessionOutcome SessionEngine::getOutcome() const {
 }
 
 /**
- * Handles the "Auto Countdown" strategy.
- * Decrements delays and triggers lock when complete.
+ * Advances the active state by up to 'seconds', stopping at the first event
+ * boundary so the transition runs with the timers exactly at that point.
+ * Returns the seconds consumed (>= 1). Sets 'halted' when the keep-alive
+ * watchdog aborted the session; the abort has already dropped the outputs.
  */
-void SessionEngine::processAutoCountdown() {
-  bool allDelaysZero = true;
-  
-  for (size_t i = 0; i < MAX_CHANNELS; i++) {
-    // Decrement Logic
-    if (_timers.channelDelays[i] > 0) {
-      allDelaysZero = false;
-      _timers.channelDelays[i]--;
+uint32_t SessionEngine::advanceState(uint32_t seconds, bool &halted) {
+  switch (_state) {
+  case ARMED:
+    if (_activeConfig.triggerStrategy == STRAT_AUTO_COUNTDOWN) {
+      return processAutoCountdown(seconds);
+    }
+    return processButtonTriggerWait(seconds);
+
+  case LOCKED: {
+    if (checkKeepAliveWatchdog()) {
+      halted = true;
+      return 0;
+    }
+    if (_timers.lockRemaining == 0) return seconds;
+
+    uint32_t step = (seconds < _timers.lockRemaining) ? seconds : _timers.lockRemaining;
+
+    // DELEGATE: Rules track time stats
+    _rules.onElapsedLocked(_stats, step);
+
+    _timers.lockRemaining -= step;
+    if (_timers.lockRemaining == 0) completeSession();
+    else checkpointProgress(step);
+    return step;
+  }
+
+  case ABORTED: {
+    // Penalty only counts down if hardware is connected!
+    if (_timers.penaltyRemaining == 0) return seconds;
+
+    uint32_t step = (seconds < _timers.penaltyRemaining) ? seconds : _timers.penaltyRemaining;
+    _timers.penaltyRemaining -= step;
+    if (_timers.penaltyRemaining == 0) completeSession();
+    else checkpointProgress(step);
+    return step;
+  }
+
+  case TESTING: {
+    if (checkKeepAliveWatchdog()) {
+      halted = true;
+      return 0;
+    }
+    if (_timers.testRemaining == 0) return seconds;
+
+    uint32_t step = (seconds < _timers.testRemaining) ? seconds : _timers.testRemaining;
+    _timers.testRemaining -= step;
+    if (_timers.testRemaining == 0) {
+      logKeyValue("Session", "Test session done.");
+      stopTest();
     }
+    return step;
   }
 
-  if (allDelaysZero) {
+  case READY:
+  case COMPLETED:
+  default:
+    return seconds;
+  }
+}
+
+/**
+ * Handles the "Auto Countdown" strategy.
+ * Jumps to the next channel deadline (O(1), see ChannelScheduler) and
+ * triggers lock one second after the last delay expired.
+ */
+uint32_t SessionEngine::processAutoCountdown(uint32_t seconds) {
+  uint32_t step = _channels.secondsUntilNext();
+  if (step == 0) {
     enterLockedState("Auto Sequence");
+    return 1;
   }
+
+  if (step > seconds) step = seconds;
+  _channels.advance(step);
+  return step;
 }
 
 /**
  * Handles the "Button Trigger" strategy.
  * Checks for user input (Polling) or timeout.
  */
-void SessionEngine::processButtonTriggerWait() {
+uint32_t SessionEngine::processButtonTriggerWait(uint32_t seconds) {
   // 1. POLL THE HAL: Did the user double-click?
   if (_hal.checkTriggerAction()) {
       enterLockedState("Button Double-Click");
-      return;
+      return 1;
   }
 
   // 2. Handle Timeout
   if (_timers.triggerTimeout > 0) {
-    _timers.triggerTimeout--;
-  } else {
-    logKeyValue("Session", "Armed Timeout: Button not pressed in time. Aborting.");
-    abort("Arm Timeout");
+    uint32_t step = (seconds < _timers.triggerTimeout) ? seconds : _timers.triggerTimeout;
+    _timers.triggerTimeout -= step;
+    return step;
   }
+
+  logKeyValue("Session", "Armed Timeout: Button not pressed in time. Aborting.");
+  abort("Arm Timeout");
+  return 1;
 }
 
 uint32_t SessionEngine::calculateFailsafeDuration(uint32_t baseSeconds) const {
@@ -587,6 +660,7 @@ int SessionEngine::modifyTime(bool increase) {
         // C. Update Debt Logic (Only in LOCKED state, not ARMED/TESTING)
         if (_state == LOCKED) {
             _timers.lockDuration += step; // Track total duration increase
+            _timeModSec += (int32_t)step;
             
             // Calculate original base (committed time without debt)
             // Current Total - Current Debt portion = Base
@@ -621,6 +695,7 @@ int SessionEngine::modifyTime(bool increase) {
             // Reduce total duration record
             if (_timers.lockDuration > step) _timers.lockDuration -= step;
             else _timers.lockDuration = *targetRemaining; // Sanity sync
+            _timeModSec -= (int32_t)step;
 
             // Recalculate Debt: Debt takes the hit first.
             // If we have debt served, reduce it by the step.
@@ -633,11 +708,12 @@ int SessionEngine::modifyTime(bool increase) {
     }
 
     // 5. Persist Changes
-    char logBuf[64];
-    snprintf(logBuf, sizeof(logBuf), "Time Mod: %s %u s. Rem: %u", increase ? "+" : "-", step, *targetRemaining);
-    logKeyValue("Session", logBuf);
+    emitEvent(EVT_TIME_MODIFIED, increase ? 1 : 0, step, *targetRemaining);
     
+    _generation++;
     _hal.saveState(_state, _timers, _stats, _activeConfig);
+    _secondsSinceCheckpoint = 0;
+    publishSnapshot();
     return 200;
 }
 
@@ -646,61 +722,74 @@ int SessionEngine::modifyTime(bool increase) {
 // =================================================================================
 
 /**
- * This is the main state-machine handler, called 1x/sec.
+ * Handles the abort gesture as soon as the HAL reports it.
+ * Drops the output mask immediately instead of at the end of the next tick.
+ */
+void SessionEngine::processInputs() {
+  if (!_hal.checkAbortAction()) return;
+
+  logKeyValue("Session", "Universal Abort Triggered (Hardware Input)");
+  emitEvent(EVT_SAFETY_ABORT, SAFETY_CAUSE_LONG_PRESS);
+  abort("Manual Long-Press");
+
+  _hal.setHardwareSafetyMask(calculateSafetyMask());
+  publishSnapshot();
+}
+
+/**
+ * This is the main state-machine handler for exactly one elapsed second.
  * Logic is now delegated to specific private helpers.
  */
-void SessionEngine::tick() {
+void SessionEngine::tick() { advance(1); }
+
+/**
+ * Millisecond timebase: consumes every second whose deadline has passed.
+ * The deadline advances in whole seconds, so the sub-second remainder is
+ * kept for the next call instead of being lost to wake-up jitter.
+ */
+bool SessionEngine::update(unsigned long nowMs) {
+  if (!_clockStarted) restartClock();
+
+  uint32_t elapsedSeconds = (uint32_t)(nowMs - _clockMs) / 1000;
+  if (elapsedSeconds == 0) return false;
+
+  _clockMs += elapsedSeconds * 1000UL;
+  advance(elapsedSeconds);
+  return true;
+}
+
+uint32_t SessionEngine::msUntilNextSecond(unsigned long nowMs) const {
+  if (!_clockStarted) return 0;
+  uint32_t sinceLast = (uint32_t)(nowMs - _clockMs);
+  return sinceLast >= 1000 ? 0 : 1000 - sinceLast;
+}
+
+void SessionEngine::restartClock() {
+  _clockMs = _hal.getMillis();
+  _clockStarted = true;
+}
+
+/**
+ * Runs the safety checks once, then the state countdown boundary by
+ * boundary, then enforces the outputs once.
+ */
+void SessionEngine::advance(uint32_t seconds) {
   // 1. Priority Checks: Safety & Connectivity
   updateSafetyInterlock(); // This will change state to ABORTED if safety is lost
   checkNetworkHealth();
 
-  if (_hal.checkAbortAction()) {
-      logKeyValue("Session", "Universal Abort Triggered (Hardware Input)");
-      abort("Manual Long-Press");
-  }
+  processInputs();
 
   // 2. Process Logic based on State (ONLY IF HARDWARE IS VALID)
   // If hardware is not permitted (disconnected/stabilizing), 
   // we pause all timer decrements.
   if (_hal.isSafetyInterlockValid()) {
-      
-      switch (_state) {
-      case ARMED:
-        if (_activeConfig.triggerStrategy == STRAT_AUTO_COUNTDOWN) {
-          processAutoCountdown();
-        } else {
-          processButtonTriggerWait();
-        }
-        break;
-
-      case LOCKED:
-        if (checkKeepAliveWatchdog()) return;
-        if (_timers.lockRemaining > 0) {
-          
-          // DELEGATE: Rules track time stats
-          _rules.onTickLocked(_stats);
-
-          if (--_timers.lockRemaining == 0) completeSession();
-        }
-        break;
-
-      case ABORTED:
-        // Penalty only counts down if hardware is connected!
-        if (_timers.penaltyRemaining > 0 && --_timers.penaltyRemaining == 0) completeSession();
-        break;
-
-      case TESTING:
-        if (checkKeepAliveWatchdog()) return;
-        if (_timers.testRemaining > 0 && --_timers.testRemaining == 0) {
-          logKeyValue("Session", "Test session done.");
-          stopTest();
-        }
-        break;
-
-      case READY:
-      case COMPLETED:
-      default:
-        break;
+      uint32_t remaining = seconds;
+      while (remaining > 0) {
+          bool halted = false;
+          uint32_t used = advanceState(remaining, halted);
+          if (halted) return;
+          remaining -= used;
       }
   } 
 
@@ -709,7 +798,7 @@ void SessionEngine::tick() {
   // If safety is invalid, calculateSafetyMask might return pins HIGH (if LOCKED), 
   // but ISessionHAL implementations should logically gate this. 
   // However, specifically setting it here ensures the logical intent is sent.
-  uint8_t targetMask = calculateSafetyMask();
+  ChannelMask targetMask = calculateSafetyMask();
   _hal.setHardwareSafetyMask(targetMask);
 
   // 4. LED CONTROL
@@ -718,6 +807,76 @@ void SessionEngine::tick() {
       shouldLedBeEnabled = false;
   }
   _hal.setLedEnabled(shouldLedBeEnabled);
+
+  // 5. Publish for lock-free readers
+  publishSnapshot();
+}
+
+/**
+ * Copies the observable state into the seqlock-protected snapshot.
+ * Called at the end of tick() and after every persisted change.
+ */
+void SessionEngine::publishSnapshot() {
+  syncChannelTimers();
+
+  EngineSnapshot snap;
+  snap.state = _state;
+  snap.outcome = getOutcome();
+  snap.timers = _timers;
+  snap.stats = _stats;
+  snap.config = _activeConfig;
+  snap.generation = _generation;
+  snap.interlockValid = _hal.isSafetyInterlockValid();
+
+  const Reward *history = getRewardHistory();
+  snap.rewardsVisible = (history != nullptr);
+  if (history) memcpy(snap.rewards, history, sizeof(snap.rewards));
+  else memset(snap.rewards, 0, sizeof(snap.rewards));
+
+  _snapshot.publish(snap);
+}
+
+/**
+ * Hands one finished session to the history log (LOCKED -> COMPLETED or
+ * LOCKED -> abort). Reads lockRemaining, so call before it is cleared.
+ */
+void SessionEngine::recordHistory(SessionOutcome outcome, uint32_t penaltySeconds) {
+  HistoryEntry e;
+  memset(&e, 0, sizeof(e));
+  e.endS = (uint32_t)(_hal.getMillis() / 1000);
+  e.startS = _lockStartKnown ? (uint32_t)(_lockStartMs / 1000) : 0;
+  e.outcome = (uint8_t)outcome;
+  e.plannedS = _timers.lockDuration;
+  e.lockedS = _timers.lockDuration > _timers.lockRemaining ? _timers.lockDuration - _timers.lockRemaining : 0;
+  e.penaltyS = penaltySeconds;
+  e.timeModS = _timeModSec;
+  _hal.appendHistory(e);
+  _lockStartKnown = false;
+}
+
+/**
+ * Refreshes the remaining channel delays in _timers from the scheduler,
+ * so the snapshot, NVS and tests keep seeing per-channel countdowns.
+ */
+void SessionEngine::syncChannelTimers() {
+  if (_channels.isRunning()) _channels.copyRemaining(_timers.channelDelays);
+}
+
+/**
+ * Emits a lightweight checkpoint every 'checkpointInterval' counted seconds
+ * so running countdowns survive a brownout without a full record rewrite.
+ * Full saves (changeState/modifyTime) reset the interval.
+ */
+void SessionEngine::checkpointProgress(uint32_t seconds) {
+  if (_sysDefaults.checkpointInterval == 0) return;
+  if (_state != LOCKED && _state != ABORTED) return;
+
+  // A span covering several intervals needs only the latest checkpoint
+  _secondsSinceCheckpoint += seconds;
+  if (_secondsSinceCheckpoint >= _sysDefaults.checkpointInterval) {
+    _secondsSinceCheckpoint = 0;
+    _hal.saveCheckpoint(_state, _timers, _stats);
+  }
 }
 
 // =================================================================================
@@ -866,6 +1025,7 @@ int SessionEngine::startSession(const SessionConfig &config) {
         _timers.channelDelays[i] = _activeConfig.channelDelays[i];
     }
   }
+  _channels.start(_timers.channelDelays);
 
   char logBuf[256];
   char timeStr[64];
@@ -897,6 +1057,7 @@ int SessionEngine::startSession(const SessionConfig &config) {
   // This handles Logging, Safety Profile, and Saving
   _isAbortedSession = false;
   changeState(ARMED); 
+  restartClock(); // Channel delays run from the arm request, not the previous second boundary
 
   return 200;
 }
@@ -907,6 +1068,9 @@ void SessionEngine::enterLockedState(const char *source) {
   logKeyValue("Session", logBuf);
   
   _timers.lockRemaining = _timers.lockDuration;
+  _lockStartMs = _hal.getMillis();
+  _lockStartKnown = true;
+  _timeModSec = 0;
   
   // Transition
   changeState(LOCKED);
@@ -923,11 +1087,8 @@ void SessionEngine::completeSession() {
     // DELEGATE: Rules update Stats (Streaks, Debt clear)
     _rules.onCompletion(_stats, _timers, _deterrents);
 
-    char logBuf[100];
-    snprintf(logBuf, sizeof(logBuf), "%-20s : %u", "New Streak", _stats.streaks);
-    logKeyValue("Session", logBuf);
-    snprintf(logBuf, sizeof(logBuf), "%-20s : %u", "Total Completed", _stats.completed);
-    logKeyValue("Session", logBuf);
+    emitEvent(EVT_SESSION_STATS, _stats.streaks, _stats.completed);
+    recordHistory(OUTCOME_SUCCESS, 0);
   } else if (previousState == ABORTED) {
     logKeyValue("Session", "Penalty time served.");
   }
@@ -941,9 +1102,12 @@ void SessionEngine::completeSession() {
     _activeConfig.channelDelays[i] = 0;
     _timers.channelDelays[i] = 0;
   }
+  _channels.clear();
   
   // Save again to capture the stats update
+  _generation++;
   _hal.saveState(_state, _timers, _stats, _activeConfig);
+  publishSnapshot();
 }
 
 void SessionEngine::abort(const char *source) {
@@ -956,6 +1120,7 @@ void SessionEngine::abort(const char *source) {
   if (_state == LOCKED) {
     // DELEGATE: Rules determine consequences
     AbortConsequences consequences = _rules.onAbort(_stats, _deterrents, _presets, _hal);
+    recordHistory(OUTCOME_ABORTED, consequences.enterPenaltyBox ? consequences.penaltyDuration : 0);
 
     // Log Consequences
     if (_deterrents.enablePaybackTime) {
@@ -970,8 +1135,7 @@ void SessionEngine::abort(const char *source) {
       _timers.penaltyRemaining = consequences.penaltyDuration; 
       _timers.lockRemaining = 0;
       
-      snprintf(logBuf, sizeof(logBuf), "Penalty Enforced: %u s", consequences.penaltyDuration);
-      logKeyValue("Rules", logBuf);
+      emitEvent(EVT_PENALTY_ENFORCED, consequences.penaltyDuration);
       
       // Transition to Penalty
       changeState(ABORTED);
@@ -995,9 +1159,7 @@ void SessionEngine::petWatchdog() {
   if (requiresKeepAlive(_state)) {
       _lastKeepAliveTime = _hal.getMillis();
       if (_currentKeepAliveStrikes > 0) {
-           char logBuf[100];
-           snprintf(logBuf, sizeof(logBuf), "Keep-Alive Signal. Resetting %d strikes.", _currentKeepAliveStrikes);
-           logKeyValue("Session", logBuf);
+           emitEvent(EVT_KEEPALIVE_RESET, (uint32_t)_currentKeepAliveStrikes);
       }
       _currentKeepAliveStrikes = 0;
   }
@@ -1015,6 +1177,7 @@ int SessionEngine::startTest() {
   if (_state != READY) return 409;
   _timers.testRemaining = _sysDefaults.testModeDuration;
   changeState(TESTING);
+  restartClock();
   return 200;
 }
 
@@ -1049,16 +1212,61 @@ void SessionEngine::handleReboot() {
     applyStateSafetyProfile();
     break;
   }
+  publishSnapshot();
 }
 
+namespace {
+
+// Open-addressing set over the checksums already in the history.
+// Slots hold history index + 1 (0 = empty); hash hits are confirmed with strncmp.
+class ChecksumSet {
+public:
+    static const uint8_t SLOTS = 32; // Power of two, > 2x REWARD_HISTORY_SIZE keeps probes short
+    static_assert(SLOTS >= 2 * REWARD_HISTORY_SIZE, "ChecksumSet too small for the reward history");
+
+    explicit ChecksumSet(const Reward *history) : _history(history) { memset(_slots, 0, sizeof(_slots)); }
+
+    void insert(uint8_t index) {
+        uint8_t s = hash(_history[index].checksum);
+        while (_slots[s] != 0) s = (s + 1) & (SLOTS - 1);
+        _slots[s] = index + 1;
+    }
+
+    bool contains(const char *checksum) const {
+        for (uint8_t s = hash(checksum); _slots[s] != 0; s = (s + 1) & (SLOTS - 1)) {
+            if (strncmp(_history[_slots[s] - 1].checksum, checksum, REWARD_CHECKSUM_LENGTH) == 0) return true;
+        }
+        return false;
+    }
+
+private:
+    const Reward *_history;
+    uint8_t _slots[SLOTS];
+
+    static uint8_t hash(const char *s) {
+        uint32_t h = 2166136261u; // FNV-1a
+        for (uint8_t i = 0; i < REWARD_CHECKSUM_LENGTH && s[i]; i++) h = (h ^ (uint8_t)s[i]) * 16777619u;
+        return (uint8_t)(h ^ (h >> 16)) & (SLOTS - 1);
+    }
+};
+
+} // namespace
+
 /**
  * Generates a unique reward code by checking against history.
  * Ensures strict uniqueness of the Checksum to prevent duplicates.
  */
 void SessionEngine::rotateAndGenerateReward() {
-    // 1. Shift History
-    for (int i = REWARD_HISTORY_SIZE - 1; i > 0; i--) {
-      _rewardHistory[i] = _rewardHistory[i - 1];
+    static_assert(REWARD_CODE_LENGTH % 4 == 0, "Reward code is packed 4 symbols per random byte");
+
+    // 1. Rotate: the new head is the slot pair of the oldest entry
+    _rewardHead = (_rewardHead + REWARD_HISTORY_SIZE - 1) % REWARD_HISTORY_SIZE;
+    Reward &fresh = _rewardRing[_rewardHead];
+    const Reward *history = &_rewardRing[_rewardHead];
+
+    ChecksumSet taken(history);
+    for (uint8_t i = 1; i < REWARD_HISTORY_SIZE; i++) {
+        if (history[i].checksum[0] != '\0') taken.insert(i);
     }
 
     const char chars[] = "UDLR";
@@ -1068,40 +1276,32 @@ void SessionEngine::rotateAndGenerateReward() {
     // 2. Loop until a unique checksum is found
     while (collision && safetyCounter < 50) {
         safetyCounter++;
-        collision = false;
 
-        // Generate Code
+        // Generate Code: 2-bit symbols from one bulk random read
+        uint8_t bits[REWARD_CODE_LENGTH / 4];
+        _hal.fillRandom(bits, sizeof(bits));
         for (int i = 0; i < REWARD_CODE_LENGTH; ++i) {
-            _rewardHistory[0].code[i] = chars[_hal.getRandom(0, 4)];
+            fresh.code[i] = chars[(bits[i >> 2] >> ((i & 3) * 2)) & 0x03];
         }
-        _rewardHistory[0].code[REWARD_CODE_LENGTH] = '\0';
+        fresh.code[REWARD_CODE_LENGTH] = '\0';
 
         // Calculate Checksum
-        LogicUtils::calculateChecksum(_rewardHistory[0].code, _rewardHistory[0].checksum);
+        LogicUtils::calculateChecksum(fresh.code, fresh.checksum);
 
         // Check History for collisions
-        for (int i = 1; i < REWARD_HISTORY_SIZE; i++) {
-            if (strlen(_rewardHistory[i].checksum) > 0) {
-                if (strncmp(_rewardHistory[0].checksum, _rewardHistory[i].checksum, REWARD_CHECKSUM_LENGTH) == 0) {
-                    collision = true;
-                    break;
-                }
-            }
-        }
+        collision = taken.contains(fresh.checksum);
     }
 
     if (safetyCounter >= 50) {
         logKeyValue("Session", "Warning: Reward Generation timed out (Potential collision accepted).");
     }
 
-    // Log the result
-    char codeSnippet[9];
-    strncpy(codeSnippet, _rewardHistory[0].code, 8);
-    codeSnippet[8] = '\0';
+    _rewardRing[_rewardHead + REWARD_HISTORY_SIZE] = fresh;
 
-    char logBuf[128];
-    snprintf(logBuf, sizeof(logBuf), "New Reward Code Generated: %s...", codeSnippet);
-    logKeyValue("Session", logBuf);
+    // Log the result (first 8 chars only)
+    const char *code = fresh.code;
+    emitEvent(EVT_REWARD_GENERATED, EngineEvents::packChars(code),
+              strlen(code) > 4 ? EngineEvents::packChars(code + 4) : 0);
 }
 
 void SessionEngine::resetToReady(bool generateNewCode) {
@@ -1119,6 +1319,7 @@ void SessionEngine::resetToReady(bool generateNewCode) {
     _activeConfig.channelDelays[i] = 0;
     _timers.channelDelays[i] = 0;
   }
+  _channels.clear();
 
   if (generateNewCode) {
     rotateAndGenerateReward();
@@ -1135,6 +1336,7 @@ void SessionEngine::resetToReady(bool generateNewCode) {
 void SessionEngine::trigger(const char *source) {
   if (_state == ARMED && _activeConfig.triggerStrategy == STRAT_BUTTON_TRIGGER) {
       enterLockedState(source);
+      restartClock(); // Lock time runs from the trigger itself
   } else if (_state == TESTING) {
       logKeyValue("Session", "Trigger ignored: Currently in Hardware Test.");
   }
@@ -1164,17 +1366,11 @@ bool SessionEngine::checkKeepAliveWatchdog() {
 
   if (calculatedStrikes > _currentKeepAliveStrikes) {
     _currentKeepAliveStrikes = calculatedStrikes;
-    char logBuf[100];
+    emitEvent(EVT_KEEPALIVE_STRIKE, (uint32_t)_currentKeepAliveStrikes, _sysDefaults.keepAliveMaxStrikes);
     if (_currentKeepAliveStrikes >= (int)_sysDefaults.keepAliveMaxStrikes) {
-      snprintf(logBuf, sizeof(logBuf), "Keep-Alive UI Watchdog: Strike %d/%u! ABORTING.", _currentKeepAliveStrikes,
-               _sysDefaults.keepAliveMaxStrikes);
-      logKeyValue("Session", logBuf);
+      emitEvent(EVT_SAFETY_ABORT, SAFETY_CAUSE_KEEPALIVE);
       abort("UI Watchdog Strikeout");
       return true;
-    } else {
-      snprintf(logBuf, sizeof(logBuf), "Keep-Alive UI Watchdog Missed check. Strike %d/%u", _currentKeepAliveStrikes,
-               _sysDefaults.keepAliveMaxStrikes);
-      logKeyValue("Session", logBuf);
     }
   }
   return false;
@@ -1184,20 +1380,17 @@ bool SessionEngine::checkKeepAliveWatchdog() {
  * Calculates the Safe Hardware Mask based on current state and timers.
  * This ensures continuous safety enforcement.
  */
-uint8_t SessionEngine::calculateSafetyMask() {
-    uint8_t mask = 0x00;
+ChannelMask SessionEngine::calculateSafetyMask() {
+    ChannelMask mask = 0x00;
     if (_state == LOCKED || _state == TESTING) {
         // In fully locked/testing mode, we request ALL logical channels ON.
         // The Hardware layer will filter this against the Physical Installed Mask.
-        mask = 0x0F; // 1111
+        mask = CHANNEL_MASK_ALL;
     } 
     else if (_state == ARMED) {
         // In Countdown, specific channels turn on as their individual delays expire.
-        for (int i = 0; i < MAX_CHANNELS; i++) {
-            if (_timers.channelDelays[i] == 0) {
-                mask |= (1 << i);
-            }
-        }
+        // The scheduler sets each bit once, when the channel's deadline passes.
+        mask = _channels.activeMask();
     }
     // READY, ABORTED, COMPLETED, VALIDATING -> Mask stays 0x00 (Safe)
 
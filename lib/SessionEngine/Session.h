@@ -18,6 +18,8 @@
  */
 #pragma once
 #include "Types.h"
+#include "ChannelScheduler.h"
+#include "EngineSnapshot.h"
 #include "SessionContext.h"
 #include "SessionRules.h"
 
@@ -31,7 +33,25 @@ public:
                   const DeterrentConfig& deterrents);
 
     // --- Main Loop Tick ---
-    void tick(); 
+    void tick(); // Exactly one elapsed second, same as advance(1)
+
+    // Applies 'seconds' of elapsed time in O(number of events), not O(seconds):
+    // timers jump straight to the next boundary (completion, channel
+    // activation, timeout). Safety checks, outputs, LED and snapshot run once.
+    void advance(uint32_t seconds);
+
+    // Millisecond timebase. Consumes every whole second whose deadline has
+    // passed since the last call and carries the remainder, so late or
+    // missed wake-ups neither lose nor drift time. Safety, outputs and the
+    // snapshot are evaluated once per call. Returns false if nothing was due.
+    bool update(unsigned long nowMs);
+
+    // Milliseconds until the next second is due (0 = call update() now).
+    uint32_t msUntilNextSecond(unsigned long nowMs) const;
+
+    // Latency-critical hardware input (long-press abort). Cheap; call on every
+    // input wake-up so an abort does not wait for the next 1 Hz tick.
+    void processInputs();
 
     // --- API Commands ---
     int startSession(const SessionConfig& config);
@@ -49,9 +69,17 @@ public:
     const SessionTimers& getTimers() const { return _timers; }
     const SessionStats& getStats() const { return _stats; }
     const SessionConfig& getActiveConfig() const { return _activeConfig; }
+
+    // Bumped whenever state, stats or the active config change.
+    // Per-second counters (timers, totalLockedTime) do NOT bump it.
+    uint32_t getGeneration() const { return _generation; }
+
+    // Lock-free copy for observers; safe to call without holding the state lock.
+    bool readSnapshot(EngineSnapshot& out) const { return _snapshot.read(out); }
+    // Newest first, REWARD_HISTORY_SIZE entries.
     const Reward* getRewardHistory() const { 
         if (_state == READY || _state == COMPLETED) {
-            return _rewardHistory; 
+            return &_rewardRing[_rewardHead]; 
         }
         return nullptr;
     }
@@ -64,13 +92,14 @@ public:
     bool isHardwarePermitted() const { return _hal.isSafetyInterlockValid(); }
 
     // --- State Setters (for Loading from NVS) ---
-    void loadState(DeviceState s) { _state = s; }
-    void loadTimers(SessionTimers t) { _timers = t; }
-    void loadStats(SessionStats s) { _stats = s; }
-    void loadConfig(SessionConfig s) {_activeConfig = s;}
+    void loadState(DeviceState s) { _state = s; _generation++; }
+    void loadTimers(SessionTimers t) { _timers = t; _generation++; }
+    void loadStats(SessionStats s) { _stats = s; _generation++; }
+    void loadConfig(SessionConfig s) {_activeConfig = s; _generation++; }
 
     void printStartupDiagnostics();
-    bool validateConfig(const DeterrentConfig& deterrents, const SessionPresets& presets) const;
+    // Stateless: also used to vet staged settings before they are persisted.
+    static bool validateConfig(const DeterrentConfig& deterrents, const SessionPresets& presets);
     bool validateSessionConfig(const SessionConfig& config) const;
     
 private:
@@ -88,7 +117,13 @@ private:
     SessionTimers _timers;
     SessionStats _stats;
     SessionConfig _activeConfig;
-    Reward _rewardHistory[REWARD_HISTORY_SIZE];
+    // Auto countdown deadlines; _timers.channelDelays is derived from it on publish/save
+    ChannelScheduler<MAX_CHANNELS, ChannelMask> _channels;
+    // Mirrored ring: each entry is stored at _rewardHead and _rewardHead + REWARD_HISTORY_SIZE,
+    // so the REWARD_HISTORY_SIZE entries from _rewardHead are always contiguous and ordered.
+    // A rotation writes one slot pair instead of shifting the whole history.
+    Reward _rewardRing[2 * REWARD_HISTORY_SIZE];
+    uint8_t _rewardHead;
     
     bool _isAbortedSession;
 
@@ -96,6 +131,22 @@ private:
     unsigned long _lastKeepAliveTime;
     int _currentKeepAliveStrikes;
 
+    // --- Timebase ---
+    unsigned long _clockMs;  // Deadline of the last consumed second
+    bool _clockStarted;
+
+    // --- Checkpoint Journal ---
+    uint32_t _secondsSinceCheckpoint;
+
+    // --- Session History (current lock, memory only) ---
+    unsigned long _lockStartMs;
+    bool _lockStartKnown; // False after a reboot into LOCKED
+    int32_t _timeModSec;
+
+    // --- Change Tracking ---
+    uint32_t _generation;
+    SnapshotSeqLock _snapshot;
+
     // =========================================================================
     // SECTION: STATE TRANSITION SYSTEM (Internal Events)
     // =========================================================================
@@ -112,13 +163,22 @@ private:
     // SECTION: LOGIC HELPERS
     // =========================================================================
     
+    // Runs the active state up to 'seconds' or its next boundary, whichever
+    // is first. Returns seconds consumed; 'halted' = watchdog aborted, stop.
+    uint32_t advanceState(uint32_t seconds, bool& halted);
+    void restartClock(); // Next second is due 1000 ms from now
+
     void updateSafetyInterlock(); // Polls HAL for processed safety status
     void checkNetworkHealth();    // Polls network status
 
     uint32_t calculateFailsafeDuration(uint32_t baseSeconds) const;
 
-    void processAutoCountdown();
-    void processButtonTriggerWait();
+    uint32_t processAutoCountdown(uint32_t seconds);
+    uint32_t processButtonTriggerWait(uint32_t seconds);
+    void checkpointProgress(uint32_t seconds);
+    void recordHistory(SessionOutcome outcome, uint32_t penaltySeconds);
+    void publishSnapshot();
+    void syncChannelTimers();
    
     uint32_t resolveBaseDuration(const SessionConfig &config);
     
@@ -132,7 +192,8 @@ private:
     bool checkKeepAliveWatchdog();
 
     void rotateAndGenerateReward();
-    uint8_t calculateSafetyMask();
+    ChannelMask calculateSafetyMask();
 
     void logKeyValue(const char *key, const char *value);
+    void emitEvent(EngineEventId id, uint32_t a0 = 0, uint32_t a1 = 0, uint32_t a2 = 0);
 };
\ No newline at end of file
@@ -6,13 +6,14 @@
  */
 #pragma once
 #include "Types.h"
+#include "EngineEvents.h"
 
 class ISessionHAL {
 public:
     virtual ~ISessionHAL() {}
 
     // --- Hardware Control ---
-    virtual void setHardwareSafetyMask(uint8_t mask) = 0;
+    virtual void setHardwareSafetyMask(ChannelMask mask) = 0;
     
     // Check if a specific channel is physically enabled (e.g. via DIP switch or Provisioning)
     virtual bool isChannelEnabled(int channelIndex) const = 0;
@@ -58,11 +59,26 @@ public:
 
     // --- Storage ---
     virtual void saveState(const DeviceState& state, const SessionTimers& timers, const SessionStats& stats, const SessionConfig& config) = 0;
+
+    // Lightweight periodic progress record for running countdowns (LOCKED/ABORTED).
+    // Only the fast-moving counters are written; the full state stays in saveState().
+    virtual void saveCheckpoint(const DeviceState& state, const SessionTimers& timers, const SessionStats& stats) = 0;
+
+    // One record per finished session (completion or abort from LOCKED).
+    // Called on the abort path: queue it, never wait on flash here.
+    virtual void appendHistory(const HistoryEntry& entry) = 0;
     
     // --- Logging ---
     virtual void log(const char* message) = 0;
+
+    // Hot-path structured event. Must be cheap: implementations store the raw
+    // event and format it only when a reader asks (see EngineEvents::format).
+    virtual void logEvent(const EngineEvent& event) = 0;
     
     // --- Utils ---
     virtual unsigned long getMillis() = 0; 
     virtual uint32_t getRandom(uint32_t min, uint32_t max) = 0;
+
+    // Fills 'len' bytes in one call (reward codes need 8 at once).
+    virtual void fillRandom(uint8_t* buf, size_t len) = 0;
 };
\ No newline at end of file
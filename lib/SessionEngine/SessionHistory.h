@@ -0,0 +1,367 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/SessionEngine/SessionHistory.h
+ *
+ * Description:
+ * Append-only per-session history in a raw flash ring.
+ *
+ * The region is split into 4 KB sectors used round-robin. Each sector starts
+ * with a sealed header (ring sequence, first record seq and the delta base)
+ * followed by records that never cross a sector boundary. A record is
+ * [len][payload][check]; check is the low 16 bits of a CRC-32 over len
+ * and payload (little-endian). The payload is varint-encoded and delta-encoded
+ * against the previous record (end time within the same boot, planned vs.
+ * locked time, zigzag time modification), so a typical entry is 12-18 bytes
+ * and seq is implicit. When the ring is full the oldest sector is erased.
+ *
+ * Erased flash reads 0xFF, which is never a valid length, so the end of the
+ * log is found by scanning the newest sector once at mount. A torn record
+ * (power loss mid-write) fails its CRC and closes that sector.
+ *
+ * Readers page through the log with a Cursor that holds one sector position,
+ * never the whole log.
+ * =================================================================================
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "LogicUtils.h"
+#include "Types.h"
+
+#define HISTORY_MAGIC 0x4853 // "HS"
+#define HISTORY_VERSION 1
+#define HISTORY_SECTOR_SIZE 4096
+#define HISTORY_RECORD_MAX 40 // len + 7 varints + outcome + 2-byte check
+
+struct __attribute__((packed)) HistorySectorHeader {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t reserved;
+    uint32_t sectorSeq; // Ring order (newest wins)
+    uint32_t firstSeq;  // Seq of the first record in this sector
+    uint32_t boot;      // Delta base: the record before firstSeq
+    uint32_t endS;
+    uint32_t crc;
+};
+
+// Delta base for the next record
+struct HistoryContext {
+    uint32_t seq;
+    uint32_t boot;
+    uint32_t endS;
+};
+
+class HistoryCodec {
+public:
+    // Writes one sealed record (at most HISTORY_RECORD_MAX bytes). Returns its size.
+    static size_t encode(const HistoryEntry &e, const HistoryContext &prev, uint8_t *out) {
+        uint8_t *p = out + 1;
+        uint32_t bootDelta = e.boot - prev.boot;
+        p = putVarint(p, bootDelta);
+        p = putVarint(p, bootDelta == 0 ? e.endS - prev.endS : e.endS);
+        p = putVarint(p, e.startS ? e.endS - e.startS + 1 : 0); // 0 = start unknown
+        *p++ = e.outcome;
+        p = putVarint(p, e.lockedS);
+        p = putVarint(p, e.plannedS - e.lockedS);
+        p = putVarint(p, e.penaltyS);
+        p = putVarint(p, zigzag(e.timeModS));
+
+        size_t len = (size_t)(p - out - 1);
+        out[0] = (uint8_t)len;
+        uint32_t crc = LogicUtils::crc32(out, 1 + len); // Low 16 bits stored
+        *p++ = (uint8_t)crc;
+        *p++ = (uint8_t)(crc >> 8);
+        return (size_t)(p - out);
+    }
+
+    /**
+     * Decodes the record at 'in' ('avail' readable bytes) on top of 'prev'.
+     * @return false if erased, torn or corrupt.
+     */
+    static bool decode(const uint8_t *in, size_t avail, const HistoryContext &prev, HistoryEntry &out, size_t &used) {
+        if (avail < 1) return false;
+        size_t len = in[0];
+        if (len == 0 || 1 + len + 2 > HISTORY_RECORD_MAX || 1 + len + 2 > avail) return false;
+        uint32_t crc = LogicUtils::crc32(in, 1 + len);
+        if (in[1 + len] != (uint8_t)crc || in[2 + len] != (uint8_t)(crc >> 8)) return false;
+
+        const uint8_t *p = in + 1;
+        const uint8_t *end = p + len;
+        uint32_t bootDelta, endV, span, locked, extra, penalty, mod;
+        if (!getVarint(p, end, bootDelta) || !getVarint(p, end, endV) || !getVarint(p, end, span)) return false;
+        if (p >= end) return false;
+        uint8_t outcome = *p++;
+        if (!getVarint(p, end, locked) || !getVarint(p, end, extra) || !getVarint(p, end, penalty) ||
+            !getVarint(p, end, mod) || p != end)
+            return false;
+
+        out.seq = prev.seq;
+        out.boot = prev.boot + bootDelta;
+        out.endS = bootDelta == 0 ? prev.endS + endV : endV;
+        out.startS = span ? out.endS - (span - 1) : 0;
+        out.outcome = outcome;
+        out.lockedS = locked;
+        out.plannedS = locked + extra;
+        out.penaltyS = penalty;
+        out.timeModS = unzigzag(mod);
+        used = 1 + len + 2;
+        return true;
+    }
+
+    static void advance(HistoryContext &ctx, const HistoryEntry &e) {
+        ctx.seq = e.seq + 1;
+        ctx.boot = e.boot;
+        ctx.endS = e.endS;
+    }
+
+    // LEB128, 1-5 bytes
+    static uint8_t *putVarint(uint8_t *p, uint32_t v) {
+        while (v >= 0x80) {
+            *p++ = (uint8_t)(v | 0x80);
+            v >>= 7;
+        }
+        *p++ = (uint8_t)v;
+        return p;
+    }
+
+    static bool getVarint(const uint8_t *&p, const uint8_t *end, uint32_t &v) {
+        v = 0;
+        for (int shift = 0; shift < 35 && p < end; shift += 7) {
+            uint8_t b = *p++;
+            v |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+    static int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+};
+
+// Raw storage behind the ring (a flash partition on the device, RAM in tests)
+class IHistoryFlash {
+public:
+    virtual ~IHistoryFlash() {}
+    virtual bool read(uint32_t addr, void *buf, size_t len) = 0;
+    virtual bool write(uint32_t addr, const void *buf, size_t len) = 0; // Only clears bits
+    virtual bool eraseSector(uint32_t addr) = 0;                         // HISTORY_SECTOR_SIZE aligned
+};
+
+template <uint16_t Sectors> class SessionHistory {
+    static_assert(Sectors >= 2, "The ring needs a sector to erase while keeping another");
+
+public:
+    // Read position; stays valid across appends, re-seeks if its sector was recycled
+    struct Cursor {
+        uint16_t sector;
+        uint16_t offset;
+        uint32_t sectorSeq;
+        HistoryContext ctx; // ctx.seq = seq of the record at this position
+    };
+
+    SessionHistory() : _flash(nullptr) { reset(); }
+
+    // Scans the sector headers and the newest sector. Any content is accepted;
+    // unreadable sectors simply count as empty.
+    void mount(IHistoryFlash *flash) {
+        _flash = flash;
+        reset();
+        for (uint16_t i = 0; i < Sectors; i++) {
+            HistorySectorHeader h;
+            if (!_flash->read(addr(i), &h, sizeof(h)) || !isValid(h)) continue;
+            _valid[i] = true;
+            _sectorSeq[i] = h.sectorSeq;
+            _base[i].seq = h.firstSeq;
+            _base[i].boot = h.boot;
+            _base[i].endS = h.endS;
+            if (_newest < 0 || h.sectorSeq > _sectorSeq[_newest]) _newest = i;
+        }
+        if (_newest < 0) return; // Empty: the first append opens sector 0
+
+        Cursor c;
+        startAt((uint16_t)_newest, c);
+        HistoryEntry e;
+        while (readAt(c, e)) {
+        }
+        _ctx = c.ctx;
+        _writeOff = c.offset;
+
+        // Anything but erased flash after the last good record is a torn write
+        uint8_t next = 0xFF;
+        if (_writeOff < HISTORY_SECTOR_SIZE && (!_flash->read(addr(_newest) + _writeOff, &next, 1) || next != 0xFF))
+            _writeOff = HISTORY_SECTOR_SIZE;
+    }
+
+    bool isMounted() const { return _flash != nullptr; }
+
+    // Assigns e.seq and appends. Erases the oldest sector when the newest is full.
+    bool append(HistoryEntry &e) {
+        if (!_flash) return false;
+        e.seq = _ctx.seq;
+        uint8_t buf[HISTORY_RECORD_MAX];
+        size_t n = HistoryCodec::encode(e, _ctx, buf);
+        if (_newest < 0 || _writeOff + n > HISTORY_SECTOR_SIZE) {
+            if (!openSector()) return false;
+        }
+        if (!_flash->write(addr(_newest) + _writeOff, buf, n)) {
+            _writeOff = HISTORY_SECTOR_SIZE; // Unknown bytes written: continue in a fresh sector
+            return false;
+        }
+        _writeOff += (uint16_t)n;
+        HistoryCodec::advance(_ctx, e);
+        return true;
+    }
+
+    // Oldest seq still stored / seq the next append gets
+    uint32_t firstSeq() const {
+        int oldest = oldestSector();
+        return oldest < 0 ? _ctx.seq : _base[oldest].seq;
+    }
+    uint32_t nextSeq() const { return _ctx.seq; }
+    // Boot epoch of the newest record (0 if empty)
+    uint32_t lastBoot() const { return _ctx.boot; }
+
+    // Positions 'c' at the first record with seq >= 'seq' (records already
+    // recycled are skipped). O(records in one sector).
+    void seek(uint32_t seq, Cursor &c) const {
+        // Newest sector starting at or before 'seq', else the oldest one
+        int best = -1;
+        for (uint16_t i = 0; i < Sectors; i++) {
+            if (_valid[i] && _base[i].seq <= seq && (best < 0 || _sectorSeq[i] > _sectorSeq[best])) best = i;
+        }
+        if (best < 0) best = oldestSector();
+        if (best < 0) {
+            atEnd(c);
+            return;
+        }
+        startAt((uint16_t)best, c);
+        HistoryEntry e;
+        while (c.ctx.seq < seq) {
+            Cursor before = c;
+            if (!next(c, e)) {
+                c = before;
+                return;
+            }
+        }
+    }
+
+    // Reads the record at 'c' and moves past it. False at the end of the log.
+    bool next(Cursor &c, HistoryEntry &out) const {
+        if (!_flash) return false;
+        for (uint16_t hops = 0; hops <= Sectors; hops++) {
+            if (c.ctx.seq >= _ctx.seq) return false;
+            if (!_valid[c.sector] || _sectorSeq[c.sector] != c.sectorSeq) {
+                // Recycled under the reader: resume at the oldest record kept
+                uint32_t want = c.ctx.seq;
+                uint32_t oldest = firstSeq();
+                seek(want > oldest ? want : oldest, c);
+                if (!_valid[c.sector] || _sectorSeq[c.sector] != c.sectorSeq) return false;
+                continue;
+            }
+            if (readAt(c, out)) return true;
+
+            // End of this sector: continue in the next one if it follows in ring order
+            uint16_t n = (uint16_t)((c.sector + 1) % Sectors);
+            if (!_valid[n] || _sectorSeq[n] != c.sectorSeq + 1) return false;
+            startAt(n, c);
+        }
+        return false;
+    }
+
+private:
+    IHistoryFlash *_flash;
+    bool _valid[Sectors];
+    uint32_t _sectorSeq[Sectors];
+    HistoryContext _base[Sectors]; // Header contents per sector
+    int _newest;                   // Sector being appended to, -1 = none yet
+    uint16_t _writeOff;
+    HistoryContext _ctx; // Base for the next append
+
+    static uint32_t addr(uint16_t sector) { return (uint32_t)sector * HISTORY_SECTOR_SIZE; }
+
+    void reset() {
+        _newest = -1;
+        _writeOff = HISTORY_SECTOR_SIZE;
+        _ctx.seq = 0;
+        _ctx.boot = 0;
+        _ctx.endS = 0;
+        for (uint16_t i = 0; i < Sectors; i++) {
+            _valid[i] = false;
+            _sectorSeq[i] = 0;
+            _base[i] = _ctx;
+        }
+    }
+
+    static uint32_t headerCrc(const HistorySectorHeader &h) {
+        return LogicUtils::crc32(reinterpret_cast<const uint8_t *>(&h), offsetof(HistorySectorHeader, crc));
+    }
+
+    static bool isValid(const HistorySectorHeader &h) {
+        return h.magic == HISTORY_MAGIC && h.version == HISTORY_VERSION && h.crc == headerCrc(h);
+    }
+
+    int oldestSector() const {
+        int oldest = -1;
+        for (uint16_t i = 0; i < Sectors; i++) {
+            if (_valid[i] && (oldest < 0 || _sectorSeq[i] < _sectorSeq[oldest])) oldest = i;
+        }
+        return oldest;
+    }
+
+    bool openSector() {
+        uint16_t next = _newest < 0 ? 0 : (uint16_t)((_newest + 1) % Sectors);
+        uint32_t sectorSeq = _newest < 0 ? 0 : _sectorSeq[_newest] + 1;
+
+        _valid[next] = false;
+        if (!_flash->eraseSector(addr(next))) return false;
+
+        HistorySectorHeader h;
+        memset(&h, 0, sizeof(h));
+        h.magic = HISTORY_MAGIC;
+        h.version = HISTORY_VERSION;
+        h.sectorSeq = sectorSeq;
+        h.firstSeq = _ctx.seq;
+        h.boot = _ctx.boot;
+        h.endS = _ctx.endS;
+        h.crc = headerCrc(h);
+        if (!_flash->write(addr(next), &h, sizeof(h))) return false;
+
+        _valid[next] = true;
+        _sectorSeq[next] = sectorSeq;
+        _base[next] = _ctx;
+        _newest = next;
+        _writeOff = sizeof(h);
+        return true;
+    }
+
+    void startAt(uint16_t sector, Cursor &c) const {
+        c.sector = sector;
+        c.offset = sizeof(HistorySectorHeader);
+        c.sectorSeq = _sectorSeq[sector];
+        c.ctx = _base[sector];
+    }
+
+    void atEnd(Cursor &c) const {
+        c.sector = 0;
+        c.offset = HISTORY_SECTOR_SIZE;
+        c.sectorSeq = 0;
+        c.ctx = _ctx;
+    }
+
+    bool readAt(Cursor &c, HistoryEntry &out) const {
+        if (c.offset >= HISTORY_SECTOR_SIZE) return false;
+        uint8_t buf[HISTORY_RECORD_MAX];
+        size_t avail = HISTORY_SECTOR_SIZE - c.offset;
+        if (avail > sizeof(buf)) avail = sizeof(buf);
+        if (!_flash->read(addr(c.sector) + c.offset, buf, avail)) return false;
+
+        size_t used = 0;
+        if (!HistoryCodec::decode(buf, avail, c.ctx, out, used)) return false;
+        c.offset += (uint16_t)used;
+        HistoryCodec::advance(c.ctx, out);
+        return true;
+    }
+};
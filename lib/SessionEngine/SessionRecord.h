@@ -0,0 +1,174 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/SessionEngine/SessionRecord.h
+ *
+ * Description:
+ * Versioned, packed binary image of the dynamic session state
+ * (DeviceState + SessionTimers + SessionStats + SessionConfig).
+ *
+ * The whole record is persisted with a single NVS blob write instead of
+ * one entry per field. A CRC-32 over the record body guards against torn
+ * writes and stale layouts; the schema version allows future migrations.
+ * Kept free of Arduino dependencies so the codec runs in native tests.
+ * =================================================================================
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "LogicUtils.h"
+#include "Types.h"
+
+#define SESSION_RECORD_MAGIC 0x4C53 // "SL"
+#define SESSION_RECORD_VERSION 1
+
+// Config flag bits
+#define SESSION_RECORD_FLAG_HIDE_TIMER 0x01
+#define SESSION_RECORD_FLAG_DISABLE_LED 0x02
+
+// Explicit fixed-width layout. Deliberately NOT a memcpy of the engine
+// structs, so that reordering Types.h never silently corrupts saved data.
+struct __attribute__((packed)) SessionRecord {
+    // --- Header ---
+    uint16_t magic;
+    uint8_t version;
+    uint8_t channelCount; // MAX_CHANNELS at write time
+    uint32_t sequence;    // Monotonic write counter (also a flash wear metric)
+
+    // --- State ---
+    uint8_t state;
+
+    // --- SessionTimers ---
+    uint32_t lockDuration;
+    uint32_t potentialDebtServed;
+    uint32_t penaltyDuration;
+    uint32_t lockRemaining;
+    uint32_t penaltyRemaining;
+    uint32_t testRemaining;
+    uint32_t triggerTimeout;
+    uint32_t timerChannelDelays[MAX_CHANNELS];
+
+    // --- SessionStats ---
+    uint32_t streaks;
+    uint32_t completed;
+    uint32_t aborted;
+    uint32_t paybackAccumulated;
+    uint32_t totalLockedTime;
+
+    // --- SessionConfig ---
+    uint8_t durationType;
+    uint32_t durationFixed;
+    uint32_t durationMin;
+    uint32_t durationMax;
+    uint8_t triggerStrategy;
+    uint8_t configFlags;
+    uint32_t configChannelDelays[MAX_CHANNELS];
+
+    // --- Integrity (must stay last) ---
+    uint32_t crc;
+};
+
+class SessionRecordCodec {
+public:
+    /**
+     * Packs the engine state into a record and seals it with a CRC.
+     */
+    static void encode(const DeviceState &state, const SessionTimers &timers, const SessionStats &stats,
+                       const SessionConfig &config, uint32_t sequence, SessionRecord &out) {
+        memset(&out, 0, sizeof(out));
+
+        out.magic = SESSION_RECORD_MAGIC;
+        out.version = SESSION_RECORD_VERSION;
+        out.channelCount = MAX_CHANNELS;
+        out.sequence = sequence;
+
+        out.state = (uint8_t)state;
+
+        out.lockDuration = timers.lockDuration;
+        out.potentialDebtServed = timers.potentialDebtServed;
+        out.penaltyDuration = timers.penaltyDuration;
+        out.lockRemaining = timers.lockRemaining;
+        out.penaltyRemaining = timers.penaltyRemaining;
+        out.testRemaining = timers.testRemaining;
+        out.triggerTimeout = timers.triggerTimeout;
+
+        out.streaks = stats.streaks;
+        out.completed = stats.completed;
+        out.aborted = stats.aborted;
+        out.paybackAccumulated = stats.paybackAccumulated;
+        out.totalLockedTime = stats.totalLockedTime;
+
+        out.durationType = (uint8_t)config.durationType;
+        out.durationFixed = config.durationFixed;
+        out.durationMin = config.durationMin;
+        out.durationMax = config.durationMax;
+        out.triggerStrategy = (uint8_t)config.triggerStrategy;
+        if (config.hideTimer) out.configFlags |= SESSION_RECORD_FLAG_HIDE_TIMER;
+        if (config.disableLED) out.configFlags |= SESSION_RECORD_FLAG_DISABLE_LED;
+
+        for (int i = 0; i < MAX_CHANNELS; i++) {
+            out.timerChannelDelays[i] = timers.channelDelays[i];
+            out.configChannelDelays[i] = config.channelDelays[i];
+        }
+
+        out.crc = computeCrc(out);
+    }
+
+    /**
+     * Validates and unpacks a raw blob.
+     * Outputs are only written when the record is intact and of a known schema.
+     * @return true on success, false if the blob is truncated, corrupt or foreign.
+     */
+    static bool decode(const uint8_t *data, size_t len, DeviceState &state, SessionTimers &timers, SessionStats &stats,
+                       SessionConfig &config, uint32_t *sequence = nullptr) {
+        if (data == nullptr || len != sizeof(SessionRecord)) return false;
+
+        SessionRecord rec;
+        memcpy(&rec, data, sizeof(rec));
+
+        if (rec.magic != SESSION_RECORD_MAGIC) return false;
+        if (rec.version != SESSION_RECORD_VERSION) return false;
+        if (rec.channelCount != MAX_CHANNELS) return false;
+        if (rec.crc != computeCrc(rec)) return false;
+
+        state = (DeviceState)rec.state;
+
+        timers.lockDuration = rec.lockDuration;
+        timers.potentialDebtServed = rec.potentialDebtServed;
+        timers.penaltyDuration = rec.penaltyDuration;
+        timers.lockRemaining = rec.lockRemaining;
+        timers.penaltyRemaining = rec.penaltyRemaining;
+        timers.testRemaining = rec.testRemaining;
+        timers.triggerTimeout = rec.triggerTimeout;
+
+        stats.streaks = rec.streaks;
+        stats.completed = rec.completed;
+        stats.aborted = rec.aborted;
+        stats.paybackAccumulated = rec.paybackAccumulated;
+        stats.totalLockedTime = rec.totalLockedTime;
+
+        config.durationType = (DurationType)rec.durationType;
+        config.durationFixed = rec.durationFixed;
+        config.durationMin = rec.durationMin;
+        config.durationMax = rec.durationMax;
+        config.triggerStrategy = (TriggerStrategy)rec.triggerStrategy;
+        config.hideTimer = (rec.configFlags & SESSION_RECORD_FLAG_HIDE_TIMER) != 0;
+        config.disableLED = (rec.configFlags & SESSION_RECORD_FLAG_DISABLE_LED) != 0;
+
+        for (int i = 0; i < MAX_CHANNELS; i++) {
+            timers.channelDelays[i] = rec.timerChannelDelays[i];
+            config.channelDelays[i] = rec.configChannelDelays[i];
+        }
+
+        if (sequence) *sequence = rec.sequence;
+        return true;
+    }
+
+private:
+    // CRC covers every byte before the trailing crc field.
+    static uint32_t computeCrc(const SessionRecord &rec) {
+        return LogicUtils::crc32((const uint8_t *)&rec, offsetof(SessionRecord, crc));
+    }
+};
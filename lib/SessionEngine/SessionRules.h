@@ -36,6 +36,14 @@ public:
      */
     virtual void onTickLocked(SessionStats& stats) = 0;
 
+    /**
+     * Called once for a span of 'seconds' elapsed while LOCKED (catch-up, simulation).
+     * Must equal 'seconds' calls of onTickLocked(). Override with closed-form math.
+     */
+    virtual void onElapsedLocked(SessionStats& stats, uint32_t seconds) {
+        for (uint32_t i = 0; i < seconds; i++) onTickLocked(stats);
+    }
+
     /**
      * Called upon successful completion (timer reached 0).
      * Responsibility: Update streaks, clear debt, increment counters.
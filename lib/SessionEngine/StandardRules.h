@@ -40,6 +40,10 @@ public:
         stats.totalLockedTime++;
     }
 
+    void onElapsedLocked(SessionStats& stats, uint32_t seconds) override {
+        stats.totalLockedTime += seconds;
+    }
+
     // --- 3. Completion Logic ---
     void onCompletion(SessionStats& stats, const SessionTimers& timers, const DeterrentConfig& deterrents) override {
         if (stats.paybackAccumulated >= timers.potentialDebtServed) {
@@ -23,12 +23,25 @@ enum SessionOutcome : uint8_t { OUTCOME_SUCCESS, OUTCOME_ABORTED, OUTCOME_UNKNOW
 #define REWARD_CHECKSUM_LENGTH 16
 
 // Logging
-#define SERIAL_QUEUE_SIZE 50
-#define LOG_BUFFER_SIZE 150
+#define LOG_ARENA_SIZE 8192 // Byte-packed RAM log read by /log
+#define SERIAL_RING_SIZE 2048 // Lock-free hand-off to the serial drain task (power of two)
 #define MAX_LOG_LENGTH 150
 
-// Hardware 
+// Hardware
+// Output channels, set per board (e.g. -D MAX_CHANNELS=8 with a matching
+// BOARD_CHANNEL_PINS in Config.h). 1..16; masks widen to 16 bits above 8.
+#ifndef MAX_CHANNELS
 #define MAX_CHANNELS 4
+#endif
+
+static_assert(MAX_CHANNELS >= 1 && MAX_CHANNELS <= 16, "MAX_CHANNELS must be 1..16");
+
+// One bit per channel: 8 bits up to 8 channels, 16 above
+template <bool Wide> struct ChannelMaskFor { typedef uint8_t type; };
+template <> struct ChannelMaskFor<true> { typedef uint16_t type; };
+
+typedef ChannelMaskFor<(MAX_CHANNELS > 8)>::type ChannelMask;
+static const ChannelMask CHANNEL_MASK_ALL = (ChannelMask)((1u << MAX_CHANNELS) - 1);
 
 // --- Configuration Structs ---
 struct SessionConfig {
@@ -80,6 +93,7 @@ struct SystemDefaults {
   uint32_t stableBootTime;
   uint32_t wifiMaxRetries;
   uint32_t armedTimeout;
+  uint32_t checkpointInterval; // Seconds between LOCKED/ABORTED timer checkpoints (0 = off)
 };
 
 // --- State Structs ---
@@ -107,6 +121,20 @@ struct Reward {
   char checksum[REWARD_CHECKSUM_LENGTH + 1];
 };
 
+// One finished session in the history log (see SessionHistory.h).
+// There is no wall clock: times are seconds of uptime within 'boot'.
+struct HistoryEntry {
+  uint32_t seq;      // Assigned by the log, consecutive
+  uint32_t boot;     // Boot the session ended in (stamped by the HAL)
+  uint32_t startS;   // Uptime when the lock began; 0 = began in an earlier boot
+  uint32_t endS;     // Uptime when the session ended (completion or abort)
+  uint8_t outcome;   // SessionOutcome
+  uint32_t lockedS;  // Seconds actually locked
+  uint32_t plannedS; // Lock duration at the end, including time modifications
+  uint32_t penaltyS; // Penalty assigned by the abort (0 on success)
+  int32_t timeModS;  // Net seconds added (+) or removed (-) while locked this boot
+};
+
 extern const char *stateToString(DeviceState s);
 extern const char *durTypeToString(DurationType d);
 extern const char *outcomeToString(SessionOutcome o);
\ No newline at end of file
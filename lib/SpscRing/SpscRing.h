@@ -0,0 +1,97 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/SpscRing/SpscRing.h
+ *
+ * Description:
+ * Lock-free single-producer / single-consumer queue of variable-length records.
+ *
+ * Used to hand log records from the logging call sites to the serial drain
+ * task without either side ever blocking the other. Each record is stored as
+ * a 2-byte length followed by its bytes. When the ring is full, push() fails
+ * immediately and the caller counts the drop (nothing is overwritten, so the
+ * consumer never sees a torn record).
+ *
+ * Exactly one thread may push and exactly one thread may pop. Multiple
+ * producers must serialize among themselves (e.g. under the log spinlock).
+ * =================================================================================
+ */
+#pragma once
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+template <size_t N> class SpscRing {
+    static_assert(N >= 4 && N <= 0x8000 && (N & (N - 1)) == 0, "Ring size must be a power of two (4..32768)");
+
+public:
+    SpscRing() : _head(0), _tail(0) {}
+
+    /**
+     * Producer side. Never blocks.
+     * @return false if the record does not fit (ring full or record too large).
+     */
+    bool push(const uint8_t *data, size_t len) {
+        size_t need = 2 + len;
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        if (len > 0xFFFF || N - (size_t)(head - tail) < need) return false;
+
+        uint8_t hdr[2] = {(uint8_t)(len & 0xFF), (uint8_t)(len >> 8)};
+        writeBytes(head, hdr, 2);
+        writeBytes(head + 2, data, len);
+
+        _head.store(head + (uint32_t)need, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer side. Never blocks.
+     * @param len Bytes copied into 'out' (the record is truncated to outSize).
+     * @return false if the ring is empty.
+     */
+    bool pop(uint8_t *out, size_t outSize, size_t &len) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t head = _head.load(std::memory_order_acquire);
+        if (head == tail) return false;
+
+        uint8_t hdr[2];
+        readBytes(tail, hdr, 2);
+        size_t recLen = (size_t)hdr[0] | ((size_t)hdr[1] << 8);
+        len = (recLen < outSize) ? recLen : outSize;
+        readBytes(tail + 2, out, len);
+
+        _tail.store(tail + 2 + (uint32_t)recLen, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+    // Approximate when called concurrently with push/pop (diagnostics only)
+    size_t bytesUsed() const {
+        return (size_t)(_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire));
+    }
+    static constexpr size_t capacity() { return N; }
+
+private:
+    uint8_t _buf[N];
+    std::atomic<uint32_t> _head; // Free-running write index (producer-owned)
+    std::atomic<uint32_t> _tail; // Free-running read index (consumer-owned)
+
+    void writeBytes(uint32_t index, const uint8_t *src, size_t len) {
+        size_t offset = index & (N - 1);
+        size_t first = (len < N - offset) ? len : N - offset;
+        memcpy(_buf + offset, src, first);
+        memcpy(_buf, src + first, len - first);
+    }
+
+    void readBytes(uint32_t index, uint8_t *dst, size_t len) const {
+        size_t offset = index & (N - 1);
+        size_t first = (len < N - offset) ? len : N - offset;
+        memcpy(dst, _buf + offset, first);
+        memcpy(dst + first, _buf, len - first);
+    }
+};
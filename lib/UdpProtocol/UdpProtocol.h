@@ -0,0 +1,284 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/UdpProtocol/UdpProtocol.h
+ *
+ * Description:
+ * Compact authenticated datagrams for keep-alive, status digest and abort.
+ *
+ * Request (24 bytes, little-endian):
+ *   [magic 'L'][version][opcode][0][bootNonce u32][clientId u32][seq u32][tag u64]
+ * Response (40 bytes):
+ *   [magic 'L'][version][opcode|0x80][result][bootNonce u32][clientId u32][seq u32]
+ *   [state u8][outcome u8][0][0][generation u32][lockRemaining u32]
+ *   [penaltyRemaining u32][tag u64]
+ *
+ * The tag is SipHash-2-4 over everything before it, keyed with the device's
+ * 128-bit UDP key. Datagrams with a bad tag are dropped without a reply.
+ *
+ * Replay protection: 'bootNonce' is chosen at random on every boot and must
+ * match (a mismatch is answered with UDP_RESULT_NONCE carrying the current
+ * nonce, nothing is executed), and 'seq' must increase per clientId within
+ * a boot (UdpReplayGuard).
+ * =================================================================================
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#define UDP_PROTOCOL_MAGIC 0x4C // 'L'
+#define UDP_PROTOCOL_VERSION 1
+#define UDP_KEY_SIZE 16
+#define UDP_TAG_SIZE 8
+#define UDP_REQUEST_SIZE 24
+#define UDP_RESPONSE_SIZE 40
+#define UDP_RESPONSE_FLAG 0x80
+
+// Opcodes. Values are protocol: append only, never renumber.
+enum UdpOpcode : uint8_t {
+    UDP_OP_KEEPALIVE = 1,
+    UDP_OP_STATUS = 2,
+    UDP_OP_ABORT = 3,
+};
+
+enum UdpResult : uint8_t {
+    UDP_RESULT_OK = 0,
+    UDP_RESULT_NONCE = 1,  // Stale bootNonce: retry with the one in this reply
+    UDP_RESULT_REPLAY = 2, // seq not newer than the last accepted for this clientId
+    UDP_RESULT_BUSY = 3,   // Engine lock not available, retry
+    UDP_RESULT_UNKNOWN_OP = 4,
+};
+
+enum UdpDecodeResult : uint8_t {
+    UDP_DECODE_OK,
+    UDP_DECODE_MALFORMED, // Wrong size, magic, version or direction
+    UDP_DECODE_BAD_TAG,   // Authentication failed
+};
+
+struct UdpRequest {
+    uint8_t opcode;
+    uint32_t bootNonce;
+    uint32_t clientId;
+    uint32_t seq;
+};
+
+// Status digest carried by every reply.
+struct UdpDigest {
+    uint8_t state;   // DeviceState
+    uint8_t outcome; // SessionOutcome
+    uint32_t generation;
+    uint32_t lockRemaining;
+    uint32_t penaltyRemaining;
+};
+
+struct UdpResponse {
+    uint8_t opcode; // Without UDP_RESPONSE_FLAG
+    uint8_t result; // UdpResult
+    uint32_t bootNonce;
+    uint32_t clientId;
+    uint32_t seq;
+    UdpDigest digest;
+};
+
+class SipHash {
+public:
+    // SipHash-2-4, 64-bit output.
+    static uint64_t hash(const uint8_t key[UDP_KEY_SIZE], const uint8_t *data, size_t len) {
+        uint64_t k0 = readU64(key);
+        uint64_t k1 = readU64(key + 8);
+        uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+        uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+        uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+        uint64_t v3 = 0x7465646279746573ULL ^ k1;
+
+        size_t whole = len & ~(size_t)7;
+        for (size_t i = 0; i < whole; i += 8) {
+            uint64_t m = readU64(data + i);
+            v3 ^= m;
+            round(v0, v1, v2, v3);
+            round(v0, v1, v2, v3);
+            v0 ^= m;
+        }
+
+        // Last block: remaining bytes plus the length in the top byte
+        uint64_t b = (uint64_t)(len & 0xFF) << 56;
+        for (size_t i = 0; i < (len & 7); i++)
+            b |= (uint64_t)data[whole + i] << (8 * i);
+        v3 ^= b;
+        round(v0, v1, v2, v3);
+        round(v0, v1, v2, v3);
+        v0 ^= b;
+
+        v2 ^= 0xFF;
+        for (int i = 0; i < 4; i++)
+            round(v0, v1, v2, v3);
+        return v0 ^ v1 ^ v2 ^ v3;
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int b) { return (x << b) | (x >> (64 - b)); }
+
+    static void round(uint64_t &v0, uint64_t &v1, uint64_t &v2, uint64_t &v3) {
+        v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);
+        v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;
+        v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;
+        v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);
+    }
+
+    static uint64_t readU64(const uint8_t *p) {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; i--)
+            v = (v << 8) | p[i];
+        return v;
+    }
+};
+
+class UdpProtocol {
+public:
+    static size_t encodeRequest(const uint8_t key[UDP_KEY_SIZE], const UdpRequest &req, uint8_t *out, size_t outSize) {
+        if (outSize < UDP_REQUEST_SIZE) return 0;
+        out[0] = UDP_PROTOCOL_MAGIC;
+        out[1] = UDP_PROTOCOL_VERSION;
+        out[2] = req.opcode;
+        out[3] = 0;
+        putU32(out + 4, req.bootNonce);
+        putU32(out + 8, req.clientId);
+        putU32(out + 12, req.seq);
+        sign(key, out, UDP_REQUEST_SIZE);
+        return UDP_REQUEST_SIZE;
+    }
+
+    static UdpDecodeResult decodeRequest(const uint8_t key[UDP_KEY_SIZE], const uint8_t *buf, size_t len, UdpRequest &out) {
+        if (len != UDP_REQUEST_SIZE || buf[0] != UDP_PROTOCOL_MAGIC || buf[1] != UDP_PROTOCOL_VERSION ||
+            (buf[2] & UDP_RESPONSE_FLAG))
+            return UDP_DECODE_MALFORMED;
+        if (!verify(key, buf, UDP_REQUEST_SIZE)) return UDP_DECODE_BAD_TAG;
+
+        out.opcode = buf[2];
+        out.bootNonce = getU32(buf + 4);
+        out.clientId = getU32(buf + 8);
+        out.seq = getU32(buf + 12);
+        return UDP_DECODE_OK;
+    }
+
+    static size_t encodeResponse(const uint8_t key[UDP_KEY_SIZE], const UdpResponse &res, uint8_t *out, size_t outSize) {
+        if (outSize < UDP_RESPONSE_SIZE) return 0;
+        out[0] = UDP_PROTOCOL_MAGIC;
+        out[1] = UDP_PROTOCOL_VERSION;
+        out[2] = res.opcode | UDP_RESPONSE_FLAG;
+        out[3] = res.result;
+        putU32(out + 4, res.bootNonce);
+        putU32(out + 8, res.clientId);
+        putU32(out + 12, res.seq);
+        out[16] = res.digest.state;
+        out[17] = res.digest.outcome;
+        out[18] = 0;
+        out[19] = 0;
+        putU32(out + 20, res.digest.generation);
+        putU32(out + 24, res.digest.lockRemaining);
+        putU32(out + 28, res.digest.penaltyRemaining);
+        sign(key, out, UDP_RESPONSE_SIZE);
+        return UDP_RESPONSE_SIZE;
+    }
+
+    static UdpDecodeResult decodeResponse(const uint8_t key[UDP_KEY_SIZE], const uint8_t *buf, size_t len, UdpResponse &out) {
+        if (len != UDP_RESPONSE_SIZE || buf[0] != UDP_PROTOCOL_MAGIC || buf[1] != UDP_PROTOCOL_VERSION ||
+            !(buf[2] & UDP_RESPONSE_FLAG))
+            return UDP_DECODE_MALFORMED;
+        if (!verify(key, buf, UDP_RESPONSE_SIZE)) return UDP_DECODE_BAD_TAG;
+
+        out.opcode = buf[2] & ~UDP_RESPONSE_FLAG;
+        out.result = buf[3];
+        out.bootNonce = getU32(buf + 4);
+        out.clientId = getU32(buf + 8);
+        out.seq = getU32(buf + 12);
+        out.digest.state = buf[16];
+        out.digest.outcome = buf[17];
+        out.digest.generation = getU32(buf + 20);
+        out.digest.lockRemaining = getU32(buf + 24);
+        out.digest.penaltyRemaining = getU32(buf + 28);
+        return UDP_DECODE_OK;
+    }
+
+private:
+    // Tag occupies the last UDP_TAG_SIZE bytes of the datagram
+    static void sign(const uint8_t *key, uint8_t *buf, size_t total) {
+        uint64_t tag = SipHash::hash(key, buf, total - UDP_TAG_SIZE);
+        for (int i = 0; i < UDP_TAG_SIZE; i++)
+            buf[total - UDP_TAG_SIZE + i] = (uint8_t)(tag >> (8 * i));
+    }
+
+    // Constant time, so the comparison leaks nothing about the expected tag
+    static bool verify(const uint8_t *key, const uint8_t *buf, size_t total) {
+        uint64_t tag = SipHash::hash(key, buf, total - UDP_TAG_SIZE);
+        uint8_t diff = 0;
+        for (int i = 0; i < UDP_TAG_SIZE; i++)
+            diff |= buf[total - UDP_TAG_SIZE + i] ^ (uint8_t)(tag >> (8 * i));
+        return diff == 0;
+    }
+
+    static void putU32(uint8_t *p, uint32_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        p[2] = (uint8_t)(v >> 16);
+        p[3] = (uint8_t)(v >> 24);
+    }
+
+    static uint32_t getU32(const uint8_t *p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+};
+
+/**
+ * Highest accepted seq per clientId, for the last SLOTS clients seen.
+ * A new client evicts the least recently used slot, and an evicted client's
+ * older datagrams would be accepted again, so size SLOTS above the number of
+ * clients expected at once.
+ */
+template <uint8_t SLOTS> class UdpReplayGuard {
+public:
+    UdpReplayGuard() { reset(); }
+
+    void reset() {
+        for (uint8_t i = 0; i < SLOTS; i++) {
+            _slots[i].used = false;
+            _slots[i].lastUse = 0;
+        }
+        _clock = 0;
+    }
+
+    // True (and records seq) if seq is newer than anything accepted for clientId.
+    bool accept(uint32_t clientId, uint32_t seq) {
+        _clock++;
+        uint8_t victim = 0;
+        for (uint8_t i = 0; i < SLOTS; i++) {
+            Slot &s = _slots[i];
+            if (s.used && s.clientId == clientId) {
+                if (seq <= s.lastSeq) return false;
+                s.lastSeq = seq;
+                s.lastUse = _clock;
+                return true;
+            }
+            if (!_slots[victim].used) continue;
+            if (!s.used || s.lastUse < _slots[victim].lastUse) victim = i;
+        }
+
+        Slot &s = _slots[victim];
+        s.used = true;
+        s.clientId = clientId;
+        s.lastSeq = seq;
+        s.lastUse = _clock;
+        return true;
+    }
+
+private:
+    struct Slot {
+        bool used;
+        uint32_t clientId;
+        uint32_t lastSeq;
+        uint32_t lastUse;
+    };
+
+    Slot _slots[SLOTS];
+    uint32_t _clock;
+};
@@ -0,0 +1,83 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      lib/WebValidators/BodyAccumulator.h
+ *
+ * Description:
+ * Reassembles an HTTP request body delivered in chunks (one per TCP segment)
+ * into a single contiguous buffer, ready for deserializeJson.
+ *
+ * - A body that arrives in one chunk is used in place (no copy, no arena).
+ * - A fragmented body is copied once into a FixedArena, sized from the
+ *   declared total on the first chunk. The parser's document can then share
+ *   the same arena, allocating after the body.
+ * - Bodies above the cap are refused before anything is buffered.
+ * =================================================================================
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "FixedArena.h"
+
+enum BodyStatus : uint8_t {
+    BODY_PARTIAL,   // More chunks expected
+    BODY_COMPLETE,  // data()/length() hold the whole body
+    BODY_TOO_LARGE, // Declared total above the cap -> 413
+    BODY_NO_MEMORY, // No arena, or the arena cannot hold it -> 503
+    BODY_BAD_CHUNK, // Chunk does not continue the body -> 400
+};
+
+class BodyAccumulator {
+public:
+    BodyAccumulator() { reset(); }
+
+    void reset() {
+        _data = nullptr;
+        _buf = nullptr;
+        _len = 0;
+        _total = 0;
+    }
+
+    /**
+     * Feeds one chunk ('index' = offset of 'chunk' in the body, 'total' = full
+     * length). 'arena' is only used when the body is fragmented and may be
+     * nullptr for a body known to arrive whole.
+     */
+    BodyStatus feed(FixedArena *arena, const uint8_t *chunk, size_t len, size_t index, size_t total, size_t maxSize) {
+        if (total > maxSize) return BODY_TOO_LARGE;
+
+        if (index == 0) {
+            reset();
+            _total = total;
+            if (len == total) {
+                _data = chunk;
+                _len = len;
+                return BODY_COMPLETE;
+            }
+            if (arena == nullptr) return BODY_NO_MEMORY;
+            _buf = (uint8_t *)arena->allocate(total);
+            if (_buf == nullptr) return BODY_NO_MEMORY;
+            _data = _buf;
+        } else if (_buf == nullptr || index != _len || total != _total) {
+            return BODY_BAD_CHUNK;
+        }
+
+        if (len > _total - _len) return BODY_BAD_CHUNK;
+        memcpy(_buf + _len, chunk, len);
+        _len += len;
+        return (_len == _total) ? BODY_COMPLETE : BODY_PARTIAL;
+    }
+
+    const char *data() const { return (const char *)_data; }
+    size_t length() const { return _len; }
+
+    // True if the body was reassembled in an arena rather than used in place
+    bool buffered() const { return _buf != nullptr; }
+
+private:
+    const uint8_t *_data;
+    uint8_t *_buf;
+    size_t _len;
+    size_t _total;
+};
@@ -17,7 +17,7 @@ bool WebValidators::validateWifiCredentials(const char* ssid, const char* pass,
     return true;
 }
 
-bool WebValidators::parseSessionConfig(const JsonVariant& json, uint8_t allowedChannelMask, SessionConfig& outConfig, std::string& errorMsg) {
+bool WebValidators::parseSessionConfig(const JsonVariant& json, ChannelMask allowedChannelMask, SessionConfig& outConfig, std::string& errorMsg) {
     // 1. Duration Type Mapping (Matching TS Enums)
     std::string typeStr = json["durationType"] | "DUR_FIXED";
     
@@ -52,7 +52,7 @@ bool WebValidators::parseSessionConfig(const JsonVariant& json, uint8_t allowedC
     outConfig.hideTimer = json["hideTimer"] | false;
     outConfig.disableLED = json["disableLED"] | false;
 
-    // 5. Channel Mask Logic (Expecting Array [ch1, ch2, ch3, ch4])
+    // 5. Channel Mask Logic (Expecting Array [ch1 .. chN], N = MAX_CHANNELS)
     // Reset delays
     for (int i = 0; i < MAX_CHANNELS; i++) outConfig.channelDelays[i] = 0;
     
@@ -62,7 +62,7 @@ bool WebValidators::parseSessionConfig(const JsonVariant& json, uint8_t allowedC
         // Ensure we don't overflow if the array is too large
         int count = 0;
         for (JsonVariant v : delays) {
-            if (count >= 4) break;
+            if (count >= MAX_CHANNELS) break;
             
             uint32_t delayVal = v.as<uint32_t>();
 
@@ -83,4 +83,108 @@ bool WebValidators::parseSessionConfig(const JsonVariant& json, uint8_t allowedC
     }
     
     return true;
-}
\ No newline at end of file
+}
+
+bool WebValidators::parseIPv4(const char* text, uint32_t& out) {
+    if (!text) return false;
+
+    uint32_t value = 0;
+    for (int octet = 0; octet < 4; octet++) {
+        if (*text < '0' || *text > '9') return false;
+        uint32_t part = 0;
+        int digits = 0;
+        while (*text >= '0' && *text <= '9') {
+            part = part * 10 + (uint32_t)(*text++ - '0');
+            if (++digits > 3 || part > 255) return false;
+        }
+        value |= part << (8 * octet);
+        if (octet < 3 && *text++ != '.') return false;
+    }
+    if (*text != '\0') return false;
+
+    out = value;
+    return true;
+}
+
+bool WebValidators::parseStaticIp(const JsonVariant& json, uint32_t& ip, uint32_t& gateway, uint32_t& subnet, uint32_t& dns,
+                                  std::string& errorMsg) {
+    ip = gateway = subnet = dns = 0;
+
+    // 1. No address -> DHCP
+    const char* ipStr = json["ip"] | "";
+    if (strlen(ipStr) == 0) return true;
+
+    if (!parseIPv4(ipStr, ip) || ip == 0) {
+        errorMsg = "Invalid static ip.";
+        return false;
+    }
+    if (!parseIPv4(json["gateway"] | "", gateway)) {
+        errorMsg = "Invalid gateway.";
+        return false;
+    }
+    if (!parseIPv4(json["subnet"] | "", subnet)) {
+        errorMsg = "Invalid subnet.";
+        return false;
+    }
+
+    // 2. Netmask must be contiguous ones (compared in host order)
+    uint32_t maskHost = ((subnet & 0xFF) << 24) | ((subnet & 0xFF00) << 8) | ((subnet >> 8) & 0xFF00) | (subnet >> 24);
+    if (maskHost == 0 || (~maskHost & (~maskHost + 1)) != 0) {
+        errorMsg = "Invalid subnet.";
+        return false;
+    }
+    if ((ip & subnet) != (gateway & subnet)) {
+        errorMsg = "Gateway is outside the subnet.";
+        return false;
+    }
+
+    // 3. DNS is optional
+    const char* dnsStr = json["dns"] | "";
+    if (strlen(dnsStr) == 0) {
+        dns = gateway;
+    } else if (!parseIPv4(dnsStr, dns)) {
+        errorMsg = "Invalid dns.";
+        return false;
+    }
+    return true;
+}
+
+static const char* const BATCH_OP_NAMES[BATCH_OP_COUNT] = {"keepalive", "status", "time/add", "time/remove", "reward", "abort"};
+
+const char* WebValidators::batchOpName(BatchOp op) { return op < BATCH_OP_COUNT ? BATCH_OP_NAMES[op] : "unknown"; }
+
+bool WebValidators::parseBatch(const JsonVariant& json, BatchOp* ops, size_t maxOps, size_t& count, std::string& errorMsg) {
+    count = 0;
+    if (!json["ops"].is<JsonArray>()) {
+        errorMsg = "ops must be an array.";
+        return false;
+    }
+
+    JsonArray list = json["ops"].as<JsonArray>();
+    if (list.size() == 0) {
+        errorMsg = "ops cannot be empty.";
+        return false;
+    }
+    if (list.size() > maxOps) {
+        errorMsg = "Too many ops (max " + std::to_string(maxOps) + ").";
+        return false;
+    }
+
+    for (JsonVariant v : list) {
+        const char* name = v | "";
+        int found = -1;
+        for (int i = 0; i < BATCH_OP_COUNT; i++) {
+            if (strcmp(name, BATCH_OP_NAMES[i]) == 0) {
+                found = i;
+                break;
+            }
+        }
+        if (found < 0) {
+            errorMsg = std::string("Unknown op: ") + name;
+            count = 0;
+            return false;
+        }
+        ops[count++] = (BatchOp)found;
+    }
+    return true;
+}
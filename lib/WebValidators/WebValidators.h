@@ -3,6 +3,11 @@
 #include <string>
 #include "Session.h"
 
+// Operations accepted by POST /batch, named after their standalone endpoints.
+enum BatchOp : uint8_t { BATCH_KEEPALIVE, BATCH_STATUS, BATCH_TIME_ADD, BATCH_TIME_REMOVE, BATCH_REWARD, BATCH_ABORT, BATCH_OP_COUNT };
+
+#define BATCH_MAX_OPS 8
+
 class WebValidators {
 public:
     // Validates WiFi credentials (length checks, empty checks)
@@ -11,5 +16,22 @@ public:
 
     // Parses JSON and validates against a hardware mask.
     // Returns true if valid. Populates outConfig.
-    static bool parseSessionConfig(const JsonVariant& json, uint8_t allowedChannelMask, SessionConfig& outConfig, std::string& errorMsg);
+    static bool parseSessionConfig(const JsonVariant& json, ChannelMask allowedChannelMask, SessionConfig& outConfig, std::string& errorMsg);
+
+    // Parses a dotted quad ("192.168.1.20") into lwIP byte order (first octet
+    // in the low byte, same as IPAddress's uint32_t). Returns false if malformed.
+    static bool parseIPv4(const char* text, uint32_t& out);
+
+    // Parses {"ip","gateway","subnet","dns"}. An empty or missing "ip" means DHCP
+    // (all outputs 0). Otherwise gateway and subnet are required, the subnet must be
+    // contiguous and contain the gateway; dns defaults to the gateway.
+    static bool parseStaticIp(const JsonVariant& json, uint32_t& ip, uint32_t& gateway, uint32_t& subnet, uint32_t& dns,
+                              std::string& errorMsg);
+
+    // Parses {"ops":["keepalive","status",...]} into at most maxOps entries, in order.
+    // Unknown names reject the whole batch.
+    static bool parseBatch(const JsonVariant& json, BatchOp* ops, size_t maxOps, size_t& count, std::string& errorMsg);
+
+    // Wire name of an op ("keepalive", "time/add", ...)
+    static const char* batchOpName(BatchOp op);
 };
\ No newline at end of file
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""
+compare_bench.py - Compares native benchmark results against a stored baseline.
+
+Usage:
+    python scripts/compare_bench.py <results.json> <baseline.json> [--threshold 0.25]
+    python scripts/compare_bench.py <results.json> <baseline.json> --update
+
+Fails (exit 1) when a metric's nsPerOp grew by more than the threshold, or
+when its allocsPerOp grew at all (allocation counts are deterministic).
+A baseline metric without nsPerOp only gates allocations, so a baseline
+recorded on a different machine can still be committed. Metrics missing
+from the baseline are reported but never fail. A missing baseline file fails
+the check: record one with --update (timings from the CI runner's
+bench-results artifact).
+"""
+import argparse
+import json
+import os
+import shutil
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return json.load(f)["metrics"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare bench_engine results against a baseline.")
+    parser.add_argument("results")
+    parser.add_argument("baseline")
+    parser.add_argument("--threshold", type=float, default=0.25, help="Allowed nsPerOp regression (0.25 = +25%%)")
+    parser.add_argument("--update", action="store_true", help="Replace the baseline with the results")
+    args = parser.parse_args()
+
+    if args.update:
+        shutil.copyfile(args.results, args.baseline)
+        print(f"Baseline updated: {args.baseline}")
+        return 0
+
+    results = load(args.results)
+    if not os.path.exists(args.baseline):
+        print(f"No baseline at {args.baseline}.")
+        print(f"Record one with: python {sys.argv[0]} {args.results} {args.baseline} --update")
+        return 1
+
+    baseline = load(args.baseline)
+    failures = []
+
+    print(f"{'metric':<24} {'base ns':>10} {'now ns':>10} {'delta':>8} {'allocs':>12}")
+    for name, now in results.items():
+        base = baseline.get(name)
+        if base is None:
+            print(f"{name:<24} {'-':>10} {now['nsPerOp']:>10.1f} {'new':>8} {now['allocsPerOp']:>12.2f}")
+            continue
+
+        allocs = f"{base['allocsPerOp']:.2f}->{now['allocsPerOp']:.2f}"
+        base_ns = base.get("nsPerOp")
+        if base_ns is None:
+            # Allocation-only entry
+            print(f"{name:<24} {'-':>10} {now['nsPerOp']:>10.1f} {'-':>8} {allocs:>12}")
+        else:
+            delta = (now["nsPerOp"] - base_ns) / base_ns if base_ns > 0 else 0.0
+            print(f"{name:<24} {base_ns:>10.1f} {now['nsPerOp']:>10.1f} {delta:>+8.1%} {allocs:>12}")
+            if delta > args.threshold:
+                failures.append(f"{name}: {delta:+.1%} time per op (limit +{args.threshold:.0%})")
+        if now["allocsPerOp"] > base["allocsPerOp"] + 1e-9:
+            failures.append(f"{name}: allocations per op {base['allocsPerOp']:.2f} -> {now['allocsPerOp']:.2f}")
+
+    if failures:
+        print("\nBenchmark regressions:")
+        for f in failures:
+            print(f"  - {f}")
+        return 1
+
+    print("\nNo benchmark regressions.")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,180 @@
+# memory_budget.py
+"""
+Static memory report and budget check for the ESP32 builds.
+
+After every link, reads the linker map and prints how much .bss, .data and
+IRAM each module takes:
+  - firmware sources (src/) and project libraries: one row per object file
+  - third-party libraries: one row per library
+  - Arduino core / ESP-IDF archives: one row per archive ("sdk:<name>")
+
+Budgets (bytes) come from the environment in platformio.ini:
+  custom_mem_budget_dram = 114688  ; .bss + .data, whole image
+  custom_mem_budget_iram = 131072  ; .iram0.*, whole image
+  custom_mem_budget_app  = 49152   ; .bss + .data of src/ and lib/ only
+A budget left empty is not checked. Going over any budget fails the build,
+so a feature's memory cost shows up in review, not on the device.
+
+The full breakdown is also written to $BUILD_DIR/memory_report.json.
+"""
+Import("env")
+import json
+import os
+import re
+
+# Output sections by category (first match wins)
+CATEGORIES = (
+    ("bss", (".dram0.bss", ".noinit")),
+    ("data", (".dram0.data",)),
+    ("iram", (".iram0.",)),
+)
+
+# " .bss.name  0x3ffb1234  0x20 path/obj.o" (name may sit alone on the line before)
+INPUT_RE = re.compile(r"^ (\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+NAME_ONLY_RE = re.compile(r"^ (\S+)$")
+ARCHIVE_RE = re.compile(r"^(.*?)\(([^)]+)\)$")
+
+REPORT_ROWS = 25
+
+
+def category_of(output_section):
+    for name, prefixes in CATEGORIES:
+        if output_section.startswith(prefixes):
+            return name
+    return None
+
+
+def module_of(path, project_dirs):
+    """Maps an input file of the map to (module, owned_by_project)."""
+    archive_match = ARCHIVE_RE.match(path)
+    member = None
+    if archive_match:
+        path, member = archive_match.group(1), archive_match.group(2)
+
+    norm = os.path.normpath(path)
+    object_name = os.path.basename(member or norm)
+    stem = re.sub(r"\.(c|cc|cpp|S)?\.?o(bj)?$", "", object_name)
+
+    if member is None:
+        # Loose object: firmware sources are linked from $BUILD_DIR/src
+        owned = any(norm.startswith(d) for d in project_dirs["src"])
+        return (stem if owned else object_name), owned
+
+    archive = re.sub(r"^lib|\.a$", "", os.path.basename(norm))
+    if any(norm.startswith(d) for d in project_dirs["build"]):
+        owned = archive in project_dirs["libs"]
+        return f"{archive}/{stem}" if owned else archive, owned
+    return f"sdk:{archive}", False
+
+
+def parse_map(map_path, project_dirs):
+    modules = {}
+    section = None
+    pending_name = None
+    in_memory_map = False
+
+    with open(map_path, errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if not in_memory_map:
+                in_memory_map = line.startswith("Linker script and memory map")
+                continue
+
+            if line and not line[0].isspace():
+                # New output section (".dram0.bss   0x3ffb... 0x..." or the name alone)
+                section = category_of(line.split()[0])
+                pending_name = None
+                continue
+            if section is None:
+                continue
+
+            name_only = NAME_ONLY_RE.match(line)
+            if name_only:
+                pending_name = name_only.group(1)
+                continue
+
+            m = INPUT_RE.match(line)
+            if not m:
+                continue
+            name = m.group(1) or pending_name
+            pending_name = None
+            size = int(m.group(3), 16)
+            if name is None or name == "*fill*" or size == 0:
+                continue
+
+            module, owned = module_of(m.group(4).strip(), project_dirs)
+            row = modules.setdefault(module, {"bss": 0, "data": 0, "iram": 0, "app": owned})
+            row[section] += size
+    return modules
+
+
+def project_dirs_for(env):
+    build = os.path.normpath(env.subst("$BUILD_DIR"))
+    project_lib = env.subst("$PROJECT_DIR/lib")
+    libs = set()
+    if os.path.isdir(project_lib):
+        libs = {d for d in os.listdir(project_lib) if os.path.isdir(os.path.join(project_lib, d))}
+    return {
+        "build": (build,),
+        "src": (os.path.join(build, "src"),),
+        "libs": libs,
+    }
+
+
+def budget(env, option):
+    value = env.GetProjectOption(option, "")
+    return int(str(value).strip(), 0) if str(value).strip() else None
+
+
+def report(source, target, env):
+    map_path = env.subst("$BUILD_DIR/${PROGNAME}.map")
+    if not os.path.exists(map_path):
+        print(f"memory_budget: no linker map at {map_path}; skipping.")
+        return
+
+    modules = parse_map(map_path, project_dirs_for(env))
+    totals = {k: sum(r[k] for r in modules.values()) for k in ("bss", "data", "iram")}
+    app_dram = sum(r["bss"] + r["data"] for r in modules.values() if r["app"])
+
+    rows = sorted(modules.items(), key=lambda kv: kv[1]["bss"] + kv[1]["data"] + kv[1]["iram"], reverse=True)
+    print("")
+    print(f"{'module':<40} {'.bss':>8} {'.data':>8} {'iram':>8}")
+    for name, r in rows[:REPORT_ROWS]:
+        tag = "*" if r["app"] else " "
+        print(f"{tag}{name:<39} {r['bss']:>8} {r['data']:>8} {r['iram']:>8}")
+    rest = rows[REPORT_ROWS:]
+    if rest:
+        other = {k: sum(r[k] for _, r in rest) for k in ("bss", "data", "iram")}
+        print(f" {f'({len(rest)} more)':<39} {other['bss']:>8} {other['data']:>8} {other['iram']:>8}")
+    print(f" {'total':<39} {totals['bss']:>8} {totals['data']:>8} {totals['iram']:>8}")
+    print(f" (* = firmware module; static DRAM of firmware modules: {app_dram} bytes)")
+
+    with open(env.subst("$BUILD_DIR/memory_report.json"), "w") as f:
+        json.dump({"totals": dict(totals, app=app_dram), "modules": modules}, f, indent=2, sort_keys=True)
+
+    checks = (
+        ("custom_mem_budget_dram", "static DRAM (.bss + .data)", totals["bss"] + totals["data"]),
+        ("custom_mem_budget_iram", "IRAM", totals["iram"]),
+        ("custom_mem_budget_app", "firmware static DRAM", app_dram),
+    )
+    failures = []
+    for option, label, used in checks:
+        limit = budget(env, option)
+        if limit is None:
+            continue
+        print(f" {label:<28} {used:>8} / {limit:<8} ({used * 100 // limit}%)")
+        if used > limit:
+            failures.append(f"{label}: {used} bytes, budget {limit} ({option})")
+
+    if failures:
+        print("\nMemory budget exceeded:")
+        for f in failures:
+            print(f"  - {f}")
+        print("Trim the change, or raise the budget in platformio.ini as part of the review.")
+        env.Exit(1)
+    print("")
+
+
+# Ask the linker for a map next to the ELF, then check it after every link
+env.Append(LINKFLAGS=["-Wl,-Map," + env.subst("$BUILD_DIR/${PROGNAME}.map")])
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", report)
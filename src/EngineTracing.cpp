@@ -0,0 +1,18 @@
+/*
+ * =================================================================================
+ * File:      src/EngineTracing.cpp
+ * Description:
+ * The trace recorder behind engineHal() in ENGINE_TRACE builds. Static, so
+ * its buffer shows up in .bss and in the build's memory report.
+ * =================================================================================
+ */
+#ifdef ENGINE_TRACE
+
+#include "EngineTracing.h"
+
+EngineTraceHAL &engineTrace() {
+  static EngineTraceHAL instance(Esp32SessionHAL::getInstance());
+  return instance;
+}
+
+#endif
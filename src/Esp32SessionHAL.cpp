@@ -12,11 +12,17 @@
  */
 #include "Esp32SessionHAL.h"
 #include "esp_timer.h"
+#include <driver/gpio.h>
+#include <esp_idf_version.h>
+#include <esp_sleep.h>
 #include <esp_task_wdt.h>
+#include <hal/gpio_ll.h>
 
 #include "Config.h"
 #include "Globals.h"
+#include "HistoryStore.h"
 #include "Network.h"
+#include "PerfProbes.h"
 #include "SettingsManager.h"
 
 #define BYTE_TO_BINARY_PATTERN "%c%c%c%c%c%c%c%c"
@@ -31,6 +37,23 @@
 // Failsafe Timer Handle (Must be static/global for esp_timer callback)
 static esp_timer_handle_t s_failsafeTimer = NULL;
 
+// Guards the RAM log ring. log() is called from every task, with or without the state lock.
+static portMUX_TYPE s_logMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Guards _latency (engine task writes, web handlers read)
+static portMUX_TYPE s_latencyMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Guards _sensors (io task writes, engine task and web handlers read)
+static portMUX_TYPE s_sensorMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Guards _power and the sleep totals below (light sleep exit hook, engine task, web handlers)
+static portMUX_TYPE s_powerMux = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t s_sleptUs = 0; // Light sleep reported by the exit hook, folded into _power on read
+static uint32_t s_sleeps = 0;
+
+// First byte of a binary event record in the log arena (text lines never start with ASCII RS)
+static const uint8_t LOG_RECORD_EVENT = 0x1E;
+
 /**
  * Hardware Timer Callback for "Death Grip".
  * This runs in ISR context when the absolute maximum safety limit is hit.
@@ -44,31 +67,99 @@ static void IRAM_ATTR failsafe_timer_callback(void *arg) {
   esp_restart();
 }
 
+// =================================================================================
+// SECTION: BUTTON EDGE CAPTURE (ISR)
+// =================================================================================
+
+struct __attribute__((packed)) ButtonEdge {
+  uint32_t ms;
+  uint8_t pressed;
+};
+
+// One ring per pin keeps each strictly single-producer (its ISR) / single-consumer (pollButtons).
+// A full ring drops the edge; the classifier re-syncs from the raw pin level.
+static SpscRing<BUTTON_EDGE_RING> s_pcbEdges;
+static SpscRing<BUTTON_EDGE_RING> s_extEdges;
+static TaskHandle_t s_inputWakeTask = NULL;
+static volatile uint32_t s_lastEdgeUs = 0; // esp_timer low word of the latest edge (input wake latency)
+
+// Light sleep only wakes on GPIO levels, and a level interrupt keeps firing for as
+// long as the level holds. With light sleep enabled each input therefore waits for
+// the level it is not at: the ISR masks the pin and pollButtons() re-arms it for the
+// opposite level. Edges are still captured one by one, and a level that changed in
+// between fires as soon as the pin is re-armed.
+static bool s_levelWake = false;
+static volatile bool s_pcbRearm = false;
+static volatile bool s_extRearm = false;
+
+static void armLevelWake(int pin) {
+  gpio_int_type_t wakeOn = gpio_get_level((gpio_num_t)pin) ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL;
+  gpio_wakeup_enable((gpio_num_t)pin, wakeOn);
+  gpio_intr_enable((gpio_num_t)pin);
+}
+
+static inline void IRAM_ATTR captureEdge(SpscRing<BUTTON_EDGE_RING> &ring, int pin, int pressedLevel, volatile bool &rearm) {
+  if (s_levelWake) {
+    gpio_ll_intr_disable(&GPIO, (gpio_num_t)pin);
+    rearm = true;
+  }
+  s_lastEdgeUs = (uint32_t)esp_timer_get_time();
+
+  ButtonEdge edge;
+  edge.ms = millis();
+  edge.pressed = (gpio_get_level((gpio_num_t)pin) == pressedLevel);
+  ring.push((const uint8_t *)&edge, sizeof(edge));
+
+  BaseType_t woken = pdFALSE;
+  if (s_inputWakeTask != NULL)
+    xTaskNotifyFromISR(s_inputWakeTask, Esp32SessionHAL::NOTIFY_INPUT, eSetBits, &woken);
+  if (woken)
+    portYIELD_FROM_ISR();
+}
+
+static void IRAM_ATTR pcb_edge_isr() { captureEdge(s_pcbEdges, PCB_BUTTON_PIN, LOW, s_pcbRearm); }
+
+#ifdef EXT_BUTTON_PIN
+static void IRAM_ATTR ext_edge_isr() { captureEdge(s_extEdges, EXT_BUTTON_PIN, HIGH, s_extRearm); }
+#endif
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+#define LIGHT_SLEEP_MEASURED 1
+
+// Runs on the way out of every automatic light sleep, with the scheduler stopped
+static esp_err_t IRAM_ATTR onLightSleepExit(int64_t sleptUs, void *arg) {
+  portENTER_CRITICAL_ISR(&s_powerMux);
+  s_sleptUs += (uint64_t)sleptUs;
+  s_sleeps++;
+  portEXIT_CRITICAL_ISR(&s_powerMux);
+  return ESP_OK;
+}
+#else
+#define LIGHT_SLEEP_MEASURED 0 // Framework has no sleep hooks: residency unknown
+#endif
+
 // =================================================================================
 // SECTION: CLASS IMPLEMENTATION
 // =================================================================================
 
 Esp32SessionHAL::Esp32SessionHAL()
-    : _triggerActionPending(false), _abortActionPending(false), _shortPressPending(false), _pcbPressed(false), _extPressed(false),
-      _pressStartTime(0), _cachedState((DeviceState)-1), _logBufferIndex(0), _queueHead(0), _queueTail(0), _statusLed(JLed(STATUS_LED_PIN)),
-      _lastHealthCheck(0), _bootStartTime(0), _bootMarkedStable(false), _enabledChannelsMask(0x0F),
+    : _triggerActionPending(false), _abortActionPending(false), _shortPressPending(false), _statePublishPending(false), _pcbPressed(false),
+      _extPressed(false),
+      _pressStartTime(0), _cachedState((DeviceState)-1), _ioTask(NULL), _serialDropped(0), _statusLed(JLed(STATUS_LED_PIN)),
+      _lastHealthCheck(0), _bootStartTime(0), _bootMarkedStable(false), _enabledChannelsMask(CHANNEL_MASK_ALL),
 
       // Safety Logic Init
       _safetyStableStart(0), _safetyLostStart(0), _isSafetyValid(false), _lastSafetyRaw(false),
       // LED Control Init
-      _isLedEnabled(true) {
-  // OneButton Setup (Pin, ActiveLow, Pullup)
-  _pcbButton = OneButton(PCB_BUTTON_PIN, true, true);
-
-#ifdef EXT_BUTTON_PIN
-  if (EXT_BUTTON_PIN != -1) {
-    _extButton = OneButton(EXT_BUTTON_PIN, false, true);
-  }
-#endif
-
-  // Clear log buffer
-  for (int i = 0; i < LOG_BUFFER_SIZE; i++)
-    _logBuffer[i][0] = '\0';
+      _ledMutex(NULL), _isLedEnabled(true), _useLedc(false),
+      // Power Init
+      _pmCpuLock(NULL), _pmSleepLock(NULL), _pmActive(false), _lightSleep(false), _lowPower(false) {
+  for (int i = 0; i < BOOT_PHASE_COUNT; i++)
+    _bootPhaseUs[i] = 0;
+  _sensors.temperature = SmoothedReading(SENSOR_EMA_ALPHA);
+  _sensors.rssi = SmoothedReading(SENSOR_EMA_ALPHA);
+  _sensors.heap = SmoothedReading(SENSOR_EMA_ALPHA);
+  _sensors.takenAtMs = 0;
 }
 
 Esp32SessionHAL &Esp32SessionHAL::getInstance() {
@@ -86,11 +177,14 @@ void Esp32SessionHAL::initialize() {
     Serial.println("Critical Error: Could not create Mutex.");
     ESP.restart();
   }
+  _ledMutex = xSemaphoreCreateMutex();
 
   // 2. Random Number Generator
   randomSeed(esp_random());
 
-  // 3. Logging Init
+  // 3. Logging Init (lines logged before this point are queued and printed now)
+  sampleSensors(); // Valid readings before the io task takes over
+  startIoTask();
   logKeyValue("System", "Initializing Hardware...");
 
   // 4. Channels
@@ -100,27 +194,22 @@ void Esp32SessionHAL::initialize() {
     digitalWrite(HARDWARE_PINS[i], LOW);
   }
 
-  // 5. Button Attachments
-  // We use detailed handlers to track the "Pressed" state for telemetry
-  // while preserving the original Click/Double/Long logic.
+  // 5. Buttons
+  // Edges are timestamped in the GPIO ISR and classified in pollButtons(), so a
+  // long press is recognized at its real hold time and reaches the engine at once.
+  ButtonGesture::Config gesture = {BUTTON_DEBOUNCE_MS, BUTTON_CLICK_MS, g_systemDefaults.longPressDuration * 1000};
 
-  // -- PCB Button --
-  _pcbButton.attachPress(handlePcbPressStart);        // State: DOWN
-  _pcbButton.attachClick(handlePcbClick);             // State: UP + Action: Short
-  _pcbButton.attachDoubleClick(handlePcbDoubleClick); // State: UP + Action: Trigger
-  _pcbButton.setPressMs(g_systemDefaults.longPressDuration * 1000);
-  _pcbButton.attachLongPressStart(handlePcbLongStart); // Action: Abort
-  _pcbButton.attachLongPressStop(handlePcbLongStop);   // State: UP
+  // -- PCB Button (active LOW) --
+  pinMode(PCB_BUTTON_PIN, INPUT_PULLUP);
+  _pcbButton.configure(gesture);
+  attachInterrupt(digitalPinToInterrupt(PCB_BUTTON_PIN), pcb_edge_isr, CHANGE);
 
-  // -- EXT Button --
+  // -- EXT Button (NC switch: HIGH = pressed/disconnected) --
 #ifdef EXT_BUTTON_PIN
   if (EXT_BUTTON_PIN != -1) {
-    _extButton.attachPress(handleExtPressStart);
-    _extButton.attachClick(handleExtClick);
-    _extButton.attachDoubleClick(handleExtDoubleClick);
-    _extButton.setPressMs(g_systemDefaults.longPressDuration * 1000);
-    _extButton.attachLongPressStart(handleExtLongStart);
-    _extButton.attachLongPressStop(handleExtLongStop);
+    pinMode(EXT_BUTTON_PIN, INPUT_PULLUP);
+    _extButton.configure(gesture);
+    attachInterrupt(digitalPinToInterrupt(EXT_BUTTON_PIN), ext_edge_isr, CHANGE);
   }
 #endif
 
@@ -138,7 +227,54 @@ void Esp32SessionHAL::initialize() {
 
   // 8. Force Initial LED State
   // Initialize to READY pattern (Breathe) so device is not dark on boot
-  _statusLed.Breathe(4000).Forever();
+#if LED_DRIVER_LEDC
+  _useLedc = _ledc.begin(STATUS_LED_PIN);
+  logKeyValue("System", _useLedc ? "Status LED on LEDC." : "LEDC unavailable, status LED on JLed.");
+#endif
+  if (_useLedc) {
+    _ledc.play(LedPatterns::forState(READY));
+  } else {
+    xSemaphoreTake(_ledMutex, portMAX_DELAY);
+    _statusLed.Breathe(4000).Forever();
+    xSemaphoreGive(_ledMutex);
+  }
+
+  // 9. Power Management (full power until a LOCKED/ABORTED state releases it)
+  initPowerManagement();
+}
+
+// --- Task Wake-up ---
+
+void Esp32SessionHAL::setInputWakeTask(TaskHandle_t task) { s_inputWakeTask = task; }
+
+uint32_t Esp32SessionHAL::inputPollIntervalMs() const {
+  // Pressed, or the classifier still deciding between click/double/long
+  bool busy = _pcbPressed || _extPressed || !_pcbButton.isIdle();
+#ifdef EXT_BUTTON_PIN
+  if (EXT_BUTTON_PIN != -1) {
+    busy = busy || !_extButton.isIdle();
+    // Interlock on-delay (stabilizing) or off-delay (grace period) running
+    busy = busy || (_lastSafetyRaw && !_isSafetyValid) || _safetyLostStart != 0;
+  }
+#endif
+  return busy ? INPUT_POLL_MS : ENGINE_IDLE_WAIT_MS;
+}
+
+void Esp32SessionHAL::recordEngineWake(bool byInput, int64_t dueUs) {
+  if (!_lowPower)
+    return; // Only wake-ups from low-power mode are of interest
+  int64_t nowUs = esp_timer_get_time();
+  int64_t lateUs = byInput ? (int64_t)(uint32_t)((uint32_t)nowUs - s_lastEdgeUs) : nowUs - dueUs;
+  if (lateUs < 0)
+    lateUs = 0;
+  uint32_t us = lateUs > (int64_t)UINT32_MAX ? UINT32_MAX : (uint32_t)lateUs;
+
+  portENTER_CRITICAL(&s_powerMux);
+  if (byInput)
+    _power.inputWake.record(us);
+  else
+    _power.timerWake.record(us);
+  portEXIT_CRITICAL(&s_powerMux);
 }
 
 // --- Main Tick ---
@@ -150,21 +286,24 @@ void Esp32SessionHAL::tick() {
   }
 
   // 1. Process Safety Logic (Before peripherals to ensure graceful aborts)
-  updateSafetyLogic();
-
-  // 2. Process Serial Logs (Internal Queue)
-  processLogQueue();
+  {
+    PERF_PROBE(PROBE_HAL_SAFETY);
+    updateSafetyLogic();
+  }
 
   // 3. Tick Peripherals
-  _pcbButton.tick();
-#ifdef EXT_BUTTON_PIN
-  _extButton.tick();
-#endif
+  {
+    PERF_PROBE(PROBE_HAL_BUTTONS);
+    pollButtons();
+  }
 
-  _statusLed.Update();
+#ifdef LEGACY_SINGLE_LOOP
+  updateLed(); // Otherwise animated by the io task
+#endif
 
-  // 4. Periodic Health Checks (Every 60s)
-  if (millis() - _lastHealthCheck > 60000) {
+  // 4. Periodic Health Checks (reads the cached sensor sample, so it is cheap)
+  if (millis() - _lastHealthCheck > HEALTH_CHECK_MS) {
+    PERF_PROBE(PROBE_HAL_HEALTH);
     checkSystemHealth();
     _lastHealthCheck = millis();
   }
@@ -234,7 +373,7 @@ void Esp32SessionHAL::updateSafetyLogic() {
       }
 
       // Off-Delay: Wait for LongPress duration + Buffer (e.g., 500ms)
-      // This ensures OneButton has time to detect the LongPress event
+      // This ensures the button classifier has time to detect the LongPress event
       // before we declare the safety invalid.
       unsigned long gracePeriod = (g_systemDefaults.longPressDuration * 1000) + 500;
 
@@ -242,6 +381,7 @@ void Esp32SessionHAL::updateSafetyLogic() {
         // Time's up. It wasn't a button press. It's a disconnect.
         _isSafetyValid = false;
         _safetyStableStart = 0;
+        markLatencyDetected(SAFETY_CAUSE_INTERLOCK, now - (_safetyLostStart + gracePeriod));
         logKeyValue("Safety", "Interlock Signal Lost (Timeout).");
       }
       // Else: We are in the grace period. Keep _isSafetyValid = TRUE.
@@ -261,9 +401,9 @@ bool Esp32SessionHAL::isSafetyInterlockValid() { return _isSafetyValid; }
 // SECTION: CHANNEL CONFIGURATION
 // =================================================================================
 
-void Esp32SessionHAL::setChannelMask(uint8_t mask) { _enabledChannelsMask = mask; }
+void Esp32SessionHAL::setChannelMask(ChannelMask mask) { _enabledChannelsMask = mask; }
 
-uint8_t Esp32SessionHAL::getChannelMask() const { return _enabledChannelsMask; }
+ChannelMask Esp32SessionHAL::getChannelMask() const { return _enabledChannelsMask; }
 
 bool Esp32SessionHAL::isChannelEnabled(int channelIndex) const {
   if (channelIndex < 0 || channelIndex >= MAX_CHANNELS)
@@ -294,10 +434,26 @@ void Esp32SessionHAL::setLedEnabled(bool enabled) {
     DeviceState current = _cachedState;
     _cachedState = (DeviceState)-1; // Invalidate cache to force updateLedPattern logic to run
     updateLedPattern(current);
+  } else if (_useLedc) {
+    _ledc.play(LedPatterns::off());
   } else {
     // If disabling, turn off immediately
+    xSemaphoreTake(_ledMutex, portMAX_DELAY);
     _statusLed.Off().Forever();
+    xSemaphoreGive(_ledMutex);
   }
+  if (_ioTask != NULL)
+    xTaskNotifyGive(_ioTask);
+}
+
+bool Esp32SessionHAL::updateLed() {
+  if (_useLedc)
+    return false; // Nothing to step: the LEDC hardware runs the pattern
+  PERF_PROBE(PROBE_HAL_LED);
+  xSemaphoreTake(_ledMutex, portMAX_DELAY);
+  bool running = _statusLed.Update();
+  xSemaphoreGive(_ledMutex);
+  return running;
 }
 
 // =================================================================================
@@ -321,23 +477,124 @@ void Esp32SessionHAL::unlockState() {
 // =================================================================================
 
 void Esp32SessionHAL::log(const char *message) {
-  // 1. Write to RAM (WebAPI Buffer)
-  strncpy(_logBuffer[_logBufferIndex], message, MAX_LOG_LENGTH);
-  _logBuffer[_logBufferIndex][MAX_LOG_LENGTH - 1] = '\0';
+  // One copy into the arena (WebAPI) and one into the serial ring.
+  // The spinlock serializes producers, which makes the ring single-producer.
+  // If the drain task falls behind, new lines are dropped and counted.
+  size_t len = strnlen(message, LOG_ARENA_MAX_LINE);
+  portENTER_CRITICAL(&s_logMux);
+  _logArena.append((const uint8_t *)message, len);
+  if (!_serialRing.push((const uint8_t *)message, len))
+    _serialDropped++;
+  portEXIT_CRITICAL(&s_logMux);
+
+  if (_ioTask != NULL)
+    xTaskNotifyGive(_ioTask);
+}
 
-  _logBufferIndex++;
-  if (_logBufferIndex >= LOG_BUFFER_SIZE) {
-    _logBufferIndex = 0;
+void Esp32SessionHAL::logEvent(const EngineEvent &event) {
+  // Engine-side latency stages ride on the events the engine already emits
+  if (event.id == EVT_KEEPALIVE_STRIKE && event.args[0] >= event.args[1]) {
+    markLatencyDetected(SAFETY_CAUSE_KEEPALIVE, 0);
+  } else if (event.id == EVT_SAFETY_ABORT) {
+    uint64_t nowUs = esp_timer_get_time();
+    portENTER_CRITICAL(&s_latencyMux);
+    _latency.markProcessed((uint8_t)event.args[0], nowUs);
+    portEXIT_CRITICAL(&s_latencyMux);
   }
 
-  // 2. Write to Serial Queue
-  int nextHead = (_queueHead + 1) % SERIAL_QUEUE_SIZE;
-  if (nextHead != _queueTail) {
-    strncpy(_serialQueue[_queueHead], message, MAX_LOG_LENGTH);
-    _serialQueue[_queueHead][MAX_LOG_LENGTH - 1] = '\0';
-    _queueHead = nextHead;
+  // Hot path: 18 raw bytes, no formatting. Readers render it later.
+  uint8_t rec[1 + sizeof(EngineEvent)];
+  rec[0] = LOG_RECORD_EVENT;
+  memcpy(rec + 1, &event, sizeof(EngineEvent));
+
+  portENTER_CRITICAL(&s_logMux);
+  _logArena.append(rec, sizeof(rec));
+  if (!_serialRing.push(rec, sizeof(rec)))
+    _serialDropped++;
+  portEXIT_CRITICAL(&s_logMux);
+
+  if (_ioTask != NULL)
+    xTaskNotifyGive(_ioTask);
+}
+
+size_t Esp32SessionHAL::renderLogRecord(const uint8_t *rec, size_t len, char *out, size_t outSize) {
+  if (outSize == 0)
+    return 0;
+
+  if (len == 1 + sizeof(EngineEvent) && rec[0] == LOG_RECORD_EVENT) {
+    EngineEvent event;
+    memcpy(&event, rec + 1, sizeof(event));
+    return EngineEvents::format(event, out, outSize);
   }
-  // Else: Queue full, drop message to prevent blocking
+
+  size_t n = (len < outSize - 1) ? len : outSize - 1;
+  memcpy(out, rec, n);
+  out[n] = '\0';
+  return n;
+}
+
+uint32_t Esp32SessionHAL::seekLog(uint32_t since, LogCursor &cursor) {
+  portENTER_CRITICAL(&s_logMux);
+  cursor = _logArena.seek(since);
+  uint32_t nextSeq = _logArena.nextSeq();
+  portEXIT_CRITICAL(&s_logMux);
+  return nextSeq;
+}
+
+bool Esp32SessionHAL::readLogLine(LogCursor &cursor, uint32_t endSeq, char *out, size_t outSize, size_t &len) {
+  // 1. Raw copy of one record (at most LOG_ARENA_MAX_LINE bytes) under the lock
+  uint8_t rec[LOG_ARENA_MAX_LINE];
+  size_t recLen = 0;
+  bool ok = false;
+  portENTER_CRITICAL(&s_logMux);
+  LogCursor oldest = _logArena.oldest();
+  if (cursor.seq < oldest.seq)
+    cursor = oldest; // Overwritten while the reader was away
+  if (cursor.seq < endSeq)
+    ok = _logArena.next(cursor, rec, sizeof(rec), recLen);
+  portEXIT_CRITICAL(&s_logMux);
+
+  // 2. Render outside the lock
+  if (!ok)
+    return false;
+  len = renderLogRecord(rec, recLen, out, outSize);
+  return true;
+}
+
+Esp32SessionHAL::LogStats Esp32SessionHAL::getLogStats() {
+  LogStats stats;
+  portENTER_CRITICAL(&s_logMux);
+  stats.capacityBytes = _logArena.capacity();
+  stats.usedBytes = _logArena.bytesUsed();
+  stats.lines = _logArena.lineCount();
+  stats.nextSeq = _logArena.nextSeq();
+  stats.serialDropped = _serialDropped;
+  portEXIT_CRITICAL(&s_logMux);
+  return stats;
+}
+
+// --- Safety Latency ---
+
+void Esp32SessionHAL::markLatencyDetected(uint8_t cause, uint32_t lateMs) {
+  uint64_t nowUs = esp_timer_get_time();
+  uint64_t lateUs = (uint64_t)lateMs * 1000ULL;
+  uint64_t detectedUs = (lateMs < 60000 && lateUs < nowUs) ? nowUs - lateUs : nowUs;
+  portENTER_CRITICAL(&s_latencyMux);
+  _latency.markDetected(cause, detectedUs);
+  portEXIT_CRITICAL(&s_latencyMux);
+}
+
+void Esp32SessionHAL::copyLatencyStats(LatencyReport &out) {
+  portENTER_CRITICAL(&s_latencyMux);
+  out = _latency;
+  portEXIT_CRITICAL(&s_latencyMux);
+}
+
+void Esp32SessionHAL::resetLatencyStats() {
+  portENTER_CRITICAL(&s_latencyMux);
+  _latency.reset();
+  portEXIT_CRITICAL(&s_latencyMux);
+  logKeyValue("System", "Safety latency statistics reset.");
 }
 
 void Esp32SessionHAL::logKeyValue(const char *key, const char *value) {
@@ -346,16 +603,81 @@ void Esp32SessionHAL::logKeyValue(const char *key, const char *value) {
   log(tempBuf);
 }
 
-void Esp32SessionHAL::processLogQueue() {
-  // Process a batch of logs to keep Serial active without blocking too long
-  int maxLines = 10;
-  while (_queueHead != _queueTail && maxLines > 0) {
-    Serial.println(_serialQueue[_queueTail]);
-    _queueTail = (_queueTail + 1) % SERIAL_QUEUE_SIZE;
-    maxLines--;
+void Esp32SessionHAL::startIoTask() {
+  if (_ioTask != NULL)
+    return;
+  xTaskCreatePinnedToCore(ioTask, "io", IO_TASK_STACK, this, IO_TASK_PRIORITY, &_ioTask, IO_TASK_CORE);
+}
+
+void Esp32SessionHAL::ioTask(void *arg) {
+  Esp32SessionHAL *self = static_cast<Esp32SessionHAL *>(arg);
+  uint8_t rec[LOG_ARENA_MAX_LINE];
+  char line[LOG_ARENA_MAX_LINE + 1];
+
+  for (;;) {
+    // 1. Serial: sole consumer of the ring, no lock needed, UART blocking only stalls this task
+    size_t len = 0;
+    if (!self->_serialRing.empty()) {
+      PERF_PROBE(PROBE_SERIAL_DRAIN);
+      while (self->_serialRing.pop(rec, sizeof(rec), len)) {
+        renderLogRecord(rec, len, line, sizeof(line));
+        Serial.println(line);
+      }
+    }
+
+    // 2. LED: step the animation; static patterns need no further wake-ups
+    bool animating = false;
+#ifndef LEGACY_SINGLE_LOOP
+    animating = self->updateLed();
+#endif
+
+    // 3. Sensors: fixed rate, whatever the request load
+    if (millis() - self->_sensors.takenAtMs >= SENSOR_SAMPLE_MS) {
+      PERF_PROBE(PROBE_SENSOR_SAMPLE);
+      self->sampleSensors();
+    }
+
+    // 4. History: finished sessions queued by the engine
+    HistoryStore::getInstance().drain();
+
+    // Woken by log(), LED pattern changes and history records; the timeout covers a notification that raced the drain.
+    // In low-power mode it only waits for the next sensor sample, so light sleeps are not cut short.
+    uint32_t waitMs = 100;
+    if (animating) {
+      waitMs = LED_UPDATE_MS;
+    } else if (self->_lowPower) {
+      uint32_t sinceSample = millis() - self->_sensors.takenAtMs;
+      waitMs = sinceSample >= SENSOR_SAMPLE_MS ? 1 : SENSOR_SAMPLE_MS - sinceSample;
+    }
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
   }
 }
 
+// Hardware reads happen outside the spinlock; only the updates are inside it.
+void Esp32SessionHAL::sampleSensors() {
+  float temp = temperatureRead();
+  bool connected = (WiFi.status() == WL_CONNECTED);
+  int rssi = connected ? WiFi.RSSI() : 0;
+  uint32_t heap = ESP.getFreeHeap();
+  unsigned long now = millis();
+
+  portENTER_CRITICAL(&s_sensorMux);
+  _sensors.temperature.add(temp);
+  if (connected)
+    _sensors.rssi.add((float)rssi);
+  else
+    _sensors.rssi.reset(); // A new link starts a fresh average
+  _sensors.heap.add((float)heap);
+  _sensors.takenAtMs = now ? now : 1;
+  portEXIT_CRITICAL(&s_sensorMux);
+}
+
+void Esp32SessionHAL::getSensorSample(SensorSample &out) {
+  portENTER_CRITICAL(&s_sensorMux);
+  out = _sensors;
+  portEXIT_CRITICAL(&s_sensorMux);
+}
+
 void Esp32SessionHAL::printStartupDiagnostics() {
   char logBuf[128];
 
@@ -429,18 +751,62 @@ void Esp32SessionHAL::printStartupDiagnostics() {
              HARDWARE_PINS[i], state == HIGH ? "HIGH (ON)" : "LOW (OFF)", enabledInMask ? "ENABLED" : "MASKED");
     log(logBuf);
   }
+
+  // -------------------------------------------------------------------------
+  // SECTION: BOOT PHASES
+  // -------------------------------------------------------------------------
+  log(""); // Spacer
+  log("[ BOOT PHASES ]");
+
+  static const char *phaseNames[BOOT_PHASE_COUNT] = {"HAL & Safety", "NVS Restore", "Engine & Task", "Network Start", "Web Server",
+                                                     "WiFi Connected"};
+  int64_t prevUs = 0;
+  for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+    int64_t doneUs = _bootPhaseUs[i];
+    if (doneUs == 0) {
+      snprintf(logBuf, sizeof(logBuf), " %-25s : %s", phaseNames[i], "PENDING (background)");
+    } else if (i == BOOT_PHASE_WIFI) {
+      // Asynchronous: only the time since reset is meaningful
+      snprintf(logBuf, sizeof(logBuf), " %-25s : at %lu ms", phaseNames[i], (unsigned long)(doneUs / 1000));
+    } else {
+      snprintf(logBuf, sizeof(logBuf), " %-25s : +%lu.%01lu ms (at %lu ms)", phaseNames[i], (unsigned long)((doneUs - prevUs) / 1000),
+               (unsigned long)(((doneUs - prevUs) % 1000) / 100), (unsigned long)(doneUs / 1000));
+      prevUs = doneUs;
+    }
+    log(logBuf);
+  }
+}
+
+void Esp32SessionHAL::markBootPhase(BootPhase phase) {
+  if (phase >= BOOT_PHASE_COUNT || _bootPhaseUs[phase] != 0)
+    return;
+  _bootPhaseUs[phase] = esp_timer_get_time();
+
+  if (phase == BOOT_PHASE_WIFI) {
+    char logBuf[48];
+    snprintf(logBuf, sizeof(logBuf), "WiFi up %lu ms after reset.", (unsigned long)(_bootPhaseUs[phase] / 1000));
+    logKeyValue("System", logBuf);
+  }
 }
 
 // =================================================================================
 // SECTION: ISessionHAL IMPLEMENTATION
 // =================================================================================
 
-void Esp32SessionHAL::setHardwareSafetyMask(uint8_t mask) {
+void Esp32SessionHAL::setHardwareSafetyMask(ChannelMask mask) {
   for (int i = 0; i < MAX_CHANNELS; i++) {
     // Logic: mask bit 1 = HIGH, 0 = LOW
     int level = (mask >> i) & 1 ? HIGH : LOW;
     digitalWrite(HARDWARE_PINS[i], level);
   }
+
+  // Final latency stage: outputs are physically low
+  if (mask == 0) {
+    uint64_t nowUs = esp_timer_get_time();
+    portENTER_CRITICAL(&s_latencyMux);
+    _latency.markMaskWritten(nowUs);
+    portEXIT_CRITICAL(&s_latencyMux);
+  }
 }
 
 // --- Input Events ---
@@ -514,15 +880,13 @@ void Esp32SessionHAL::armFailsafeTimer(uint32_t seconds) {
   esp_timer_stop(s_failsafeTimer);
   esp_timer_start_once(s_failsafeTimer, timeout_us);
 
-  char logBuf[64];
-  snprintf(logBuf, sizeof(logBuf), "Death Grip ARMED: %u s", seconds);
-  logKeyValue("System", logBuf);
+  logEvent(EngineEvents::make(millis(), EVT_FAILSAFE_ARMED, seconds));
 }
 
 void Esp32SessionHAL::disarmFailsafeTimer() {
   if (s_failsafeTimer != NULL) {
     esp_timer_stop(s_failsafeTimer);
-    logKeyValue("System", "Death Grip Timer DISARMED.");
+    logEvent(EngineEvents::make(millis(), EVT_FAILSAFE_DISARMED));
   }
 }
 
@@ -531,9 +895,24 @@ void Esp32SessionHAL::disarmFailsafeTimer() {
 void Esp32SessionHAL::saveState(const DeviceState &state, const SessionTimers &timers, const SessionStats &stats,
                                 const SessionConfig &config) {
   updateLedPattern(state);
+  updatePowerMode(state);
 
   // Delegate to SettingsManager
   SettingsManager::saveSessionState(state, timers, stats, config);
+
+  // Every transition/time change persists through here; flag it for the event stream.
+  _statePublishPending = true;
+}
+
+void Esp32SessionHAL::saveCheckpoint(const DeviceState &state, const SessionTimers &timers, const SessionStats &stats) {
+  // No LED update: the state has not changed, only the counters moved.
+  SettingsManager::saveCheckpoint(state, timers, stats);
+}
+
+void Esp32SessionHAL::appendHistory(const HistoryEntry &entry) {
+  // Queued only: the io task does the flash write (and any sector erase)
+  if (HistoryStore::getInstance().enqueue(entry) && _ioTask != NULL)
+    xTaskNotifyGive(_ioTask);
 }
 
 // --- Utils ---
@@ -542,6 +921,9 @@ unsigned long Esp32SessionHAL::getMillis() { return millis(); }
 
 uint32_t Esp32SessionHAL::getRandom(uint32_t min, uint32_t max) { return random(min, max); }
 
+// Hardware RNG (true random while the radio is on)
+void Esp32SessionHAL::fillRandom(uint8_t *buf, size_t len) { esp_fill_random(buf, len); }
+
 // =================================================================================
 // SECTION: INTERNAL LOGIC & HELPERS
 // =================================================================================
@@ -553,7 +935,13 @@ void Esp32SessionHAL::updateLedPattern(DeviceState state) {
   // 1. If LED is disabled, ensure it remains OFF and exit
   if (!_isLedEnabled) {
     // Force OFF if we just changed state or if we are here due to a toggle
+    if (_useLedc) {
+      _ledc.play(LedPatterns::off());
+      return;
+    }
+    xSemaphoreTake(_ledMutex, portMAX_DELAY);
     _statusLed.Off().Forever();
+    xSemaphoreGive(_ledMutex);
     return;
   }
 
@@ -563,6 +951,13 @@ void Esp32SessionHAL::updateLedPattern(DeviceState state) {
     snprintf(logBuf, sizeof(logBuf), "LED Pattern: State %s", stateToString(state));
     logKeyValue("System", logBuf);
 
+    // Programmed once; no further CPU work until the next state change
+    if (_useLedc) {
+      _ledc.play(LedPatterns::forState(state));
+      return;
+    }
+
+    xSemaphoreTake(_ledMutex, portMAX_DELAY);
     switch (state) {
     case READY:
       _statusLed.Breathe(4000).Forever();
@@ -586,7 +981,115 @@ void Esp32SessionHAL::updateLedPattern(DeviceState state) {
       _statusLed.Off().Forever();
       break;
     }
+    xSemaphoreGive(_ledMutex);
+
+    // Start the new animation now rather than at the io task's next timeout
+    if (_ioTask != NULL)
+      xTaskNotifyGive(_ioTask);
+  }
+}
+
+void Esp32SessionHAL::initPowerManagement() {
+  portENTER_CRITICAL(&s_powerMux);
+  _power.reset(esp_timer_get_time());
+  portEXIT_CRITICAL(&s_powerMux);
+
+#if LOW_POWER_MODE
+  // Created held, so nothing changes until updatePowerMode() lets go
+  if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "lobster_cpu", &_pmCpuLock) != ESP_OK ||
+      esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "lobster_awake", &_pmSleepLock) != ESP_OK) {
+    logKeyValue("Power", "Power management not in this build (CONFIG_PM_ENABLE). Modem sleep only.");
+    return;
+  }
+  esp_pm_lock_acquire(_pmCpuLock);
+  esp_pm_lock_acquire(_pmSleepLock);
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_pm_config_t pm = {};
+#else
+  esp_pm_config_esp32_t pm = {};
+#endif
+  pm.max_freq_mhz = LOW_POWER_MAX_FREQ_MHZ;
+  pm.min_freq_mhz = LOW_POWER_MIN_FREQ_MHZ;
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+  pm.light_sleep_enable = true;
+#endif
+  if (esp_pm_configure(&pm) != ESP_OK) {
+    logKeyValue("Power", "esp_pm_configure failed. Modem sleep only.");
+    return;
+  }
+  _pmActive = true;
+  _lightSleep = pm.light_sleep_enable;
+
+  if (_lightSleep) {
+    // Inputs wake the CPU by level; the LEDC status LED runs from RTC8M, which stays on
+    esp_sleep_enable_gpio_wakeup();
+    if (_useLedc)
+      esp_sleep_pd_config(ESP_PD_DOMAIN_RTC8M, ESP_PD_OPTION_ON);
+    s_levelWake = true;
+    armLevelWake(PCB_BUTTON_PIN);
+#ifdef EXT_BUTTON_PIN
+    if (EXT_BUTTON_PIN != -1)
+      armLevelWake(EXT_BUTTON_PIN);
+#endif
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    esp_pm_sleep_cbs_register_config_t cbs = {};
+    cbs.exit_cb = &onLightSleepExit;
+    esp_pm_light_sleep_register_cbs(&cbs);
+#endif
+  }
+  logKeyValue("Power", _lightSleep ? "DFS and light sleep ready for LOCKED/ABORTED."
+                                   : "DFS ready for LOCKED/ABORTED (no tickless idle in this build, no light sleep).");
+#endif
+}
+
+void Esp32SessionHAL::updatePowerMode(DeviceState state) {
+#if LOW_POWER_MODE
+  bool low = PowerPolicy::wantsLowPower(state);
+  if (low == _lowPower)
+    return;
+  _lowPower = low;
+
+  if (_pmActive) {
+    if (low) {
+      esp_pm_lock_release(_pmSleepLock);
+      esp_pm_lock_release(_pmCpuLock);
+    } else {
+      esp_pm_lock_acquire(_pmCpuLock);
+      esp_pm_lock_acquire(_pmSleepLock);
+    }
   }
+
+  ModemSleep modem = MODEM_SLEEP_NONE;
+  if (low)
+    modem = PowerPolicy::modemSleepFor(g_systemDefaults.keepAliveInterval, LOW_POWER_KEEPALIVE_DIVISOR, MODEM_SLEEP_MIN_LATENCY_MS,
+                                       MODEM_SLEEP_MAX_LATENCY_MS);
+  NetworkManager::getInstance().setModemSleep(modem);
+
+  portENTER_CRITICAL(&s_powerMux);
+  _power.enter(low ? POWER_LOW : POWER_ACTIVE, esp_timer_get_time());
+  portEXIT_CRITICAL(&s_powerMux);
+
+  static const char *const modemNames[] = {"off", "min", "max"};
+  char logBuf[64];
+  snprintf(logBuf, sizeof(logBuf), "%s (modem sleep %s)", low ? "Low-power mode" : "Full power", modemNames[modem]);
+  logKeyValue("Power", logBuf);
+#endif
+}
+
+void Esp32SessionHAL::getPowerReport(PowerReport &out) {
+  portENTER_CRITICAL(&s_powerMux);
+  _power.addSleep(s_sleptUs, s_sleeps);
+  s_sleptUs = 0;
+  s_sleeps = 0;
+  out.meter = _power;
+  out.nowUs = esp_timer_get_time();
+  portEXIT_CRITICAL(&s_powerMux);
+
+  out.pmActive = _pmActive;
+  out.lightSleep = _lightSleep;
+  out.sleepMeasured = _lightSleep && LIGHT_SLEEP_MEASURED;
+  out.modemSleep = NetworkManager::getInstance().getModemSleep();
 }
 
 void Esp32SessionHAL::checkBootLoop() {
@@ -623,7 +1126,22 @@ void Esp32SessionHAL::markBootStability() {
 }
 
 void Esp32SessionHAL::checkSystemHealth() {
-  size_t freeMem = ESP.getFreeHeap();
+  SensorSample sensors;
+  getSensorSample(sensors);
+
+  // Heap trips on the latest sample (a drop is immediate danger), temperature on
+  // the average (one noisy read must not cut the channels). If the io task has
+  // stalled, the sample is stale and the hardware is read directly.
+  size_t freeMem;
+  float currentTemp;
+  if (millis() - sensors.takenAtMs <= SENSOR_STALE_MS) {
+    freeMem = (size_t)sensors.heap.last();
+    currentTemp = sensors.temperature.valid() ? sensors.temperature.ema() : NAN;
+  } else {
+    freeMem = ESP.getFreeHeap();
+    currentTemp = temperatureRead();
+  }
+
   if (freeMem < 10000) {
     logKeyValue("System", "CRITICAL: Low Heap! Emergency Stop.");
     for (int i = 0; i < MAX_CHANNELS; i++)
@@ -631,7 +1149,6 @@ void Esp32SessionHAL::checkSystemHealth() {
     ESP.restart();
   }
 
-  float currentTemp = temperatureRead();
   if (!isnan(currentTemp) && currentTemp > MAX_SAFE_TEMP_C) {
     char logBuf[100];
     snprintf(logBuf, sizeof(logBuf), "CRITICAL: Overheating (%.1f C)!", currentTemp);
@@ -654,68 +1171,53 @@ void Esp32SessionHAL::checkPressState() {
 }
 
 // =================================================================================
-// SECTION: STATIC HANDLERS (OneButton Callbacks)
+// SECTION: BUTTON GESTURES
 // =================================================================================
 
-// --- PCB Button Handlers ---
-
-void Esp32SessionHAL::handlePcbPressStart() {
-  Esp32SessionHAL &inst = getInstance();
-  inst._pcbPressed = true;
-  inst.checkPressState();
-}
-
-void Esp32SessionHAL::handlePcbClick() {
-  Esp32SessionHAL &inst = getInstance();
-  inst._pcbPressed = false;
-  inst.checkPressState();
-  inst.setShortPressPending();
-}
+void Esp32SessionHAL::pollButtons() {
+  ButtonEdge edge;
+  size_t len = 0;
+  uint32_t now = millis();
 
-void Esp32SessionHAL::handlePcbDoubleClick() {
-  Esp32SessionHAL &inst = getInstance();
-  inst._pcbPressed = false;
-  inst.checkPressState();
-  inst.setTriggerPending();
-}
-
-void Esp32SessionHAL::handlePcbLongStart() {
-  Esp32SessionHAL &inst = getInstance();
-  inst.setAbortPending();
-}
-
-void Esp32SessionHAL::handlePcbLongStop() {
-  Esp32SessionHAL &inst = getInstance();
-  inst._pcbPressed = false;
-  inst.checkPressState();
-}
+  // Re-arm level wake-ups first: any change from here on interrupts again
+  if (s_pcbRearm) {
+    s_pcbRearm = false;
+    armLevelWake(PCB_BUTTON_PIN);
+  }
+#ifdef EXT_BUTTON_PIN
+  if (s_extRearm) {
+    s_extRearm = false;
+    armLevelWake(EXT_BUTTON_PIN);
+  }
+#endif
 
-// --- EXT Button Handlers ---
+  // -- PCB Button --
+  while (s_pcbEdges.pop((uint8_t *)&edge, sizeof(edge), len))
+    applyGesture(_pcbButton.onEdge(edge.ms, edge.pressed), _pcbButton);
+  applyGesture(_pcbButton.update(now, digitalRead(PCB_BUTTON_PIN) == LOW), _pcbButton);
+  _pcbPressed = _pcbButton.isPressed();
 
-void Esp32SessionHAL::handleExtPressStart() {
-  Esp32SessionHAL &inst = getInstance();
-  inst._extPressed = true;
-  inst.checkPressState();
-}
+  // -- EXT Button --
+#ifdef EXT_BUTTON_PIN
+  if (EXT_BUTTON_PIN != -1) {
+    while (s_extEdges.pop((uint8_t *)&edge, sizeof(edge), len))
+      applyGesture(_extButton.onEdge(edge.ms, edge.pressed), _extButton);
+    applyGesture(_extButton.update(now, digitalRead(EXT_BUTTON_PIN) == HIGH), _extButton);
+    _extPressed = _extButton.isPressed();
+  }
+#endif
 
-void Esp32SessionHAL::handleExtClick() {
-  Esp32SessionHAL &inst = getInstance();
-  inst._extPressed = false;
-  inst.checkPressState();
-  inst.setShortPressPending();
+  checkPressState();
 }
 
-void Esp32SessionHAL::handleExtDoubleClick() {
-  Esp32SessionHAL &inst = getInstance();
-  inst._extPressed = false;
-  inst.checkPressState();
-  inst.setTriggerPending();
+void Esp32SessionHAL::applyGesture(uint8_t events, const ButtonGesture &button) {
+  if (events & GESTURE_LONG_START) {
+    // Latency starts when the hold crossed the threshold, not when we noticed it
+    markLatencyDetected(SAFETY_CAUSE_LONG_PRESS, millis() - (button.pressStartMs() + button.config().longPressMs));
+    setAbortPending(); // Picked up by SessionEngine::processInputs() on this same wake-up
+  }
+  if (events & GESTURE_DOUBLE_CLICK)
+    setTriggerPending();
+  if (events & GESTURE_CLICK)
+    setShortPressPending();
 }
-
-void Esp32SessionHAL::handleExtLongStart() { getInstance().setAbortPending(); }
-
-void Esp32SessionHAL::handleExtLongStop() {
-  Esp32SessionHAL &inst = getInstance();
-  inst._extPressed = false;
-  inst.checkPressState();
-}
\ No newline at end of file
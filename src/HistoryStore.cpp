@@ -0,0 +1,157 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      src/HistoryStore.cpp
+ *
+ * Description:
+ * Session history on a raw flash partition. Appends run in the io task: one
+ * small flash write per record, plus a sector erase (tens of milliseconds)
+ * whenever the ring moves on to the next sector.
+ * =================================================================================
+ */
+#include <esp_timer.h>
+
+#include "Esp32SessionHAL.h"
+#include "HistoryStore.h"
+#include "PerfProbes.h"
+
+// =================================================================================
+// SECTION: FLASH BACKEND
+// =================================================================================
+
+bool HistoryStore::PartitionFlash::read(uint32_t addr, void *buf, size_t len) {
+  return esp_partition_read(part, addr, buf, len) == ESP_OK;
+}
+
+bool HistoryStore::PartitionFlash::write(uint32_t addr, const void *buf, size_t len) {
+  return esp_partition_write(part, addr, buf, len) == ESP_OK;
+}
+
+bool HistoryStore::PartitionFlash::eraseSector(uint32_t addr) {
+  return esp_partition_erase_range(part, addr, HISTORY_SECTOR_SIZE) == ESP_OK;
+}
+
+// =================================================================================
+// SECTION: SINGLETON & INIT
+// =================================================================================
+
+HistoryStore &HistoryStore::getInstance() {
+  static HistoryStore instance;
+  return instance;
+}
+
+HistoryStore::HistoryStore() : _mutex(NULL) { memset(&_stats, 0, sizeof(_stats)); }
+
+bool HistoryStore::begin() {
+  if (_mutex == NULL)
+    _mutex = xSemaphoreCreateMutex();
+
+  char logBuf[96];
+  const esp_partition_t *part =
+      esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, HISTORY_PARTITION_LABEL);
+  if (part == NULL || part->size < (uint32_t)HISTORY_SECTORS * HISTORY_SECTOR_SIZE) {
+    snprintf(logBuf, sizeof(logBuf), "No '%s' partition of %u KB. History disabled.", HISTORY_PARTITION_LABEL,
+             (unsigned)(HISTORY_SECTORS * HISTORY_SECTOR_SIZE / 1024));
+    Esp32SessionHAL::getInstance().logKeyValue("History", logBuf);
+    return false;
+  }
+
+  int64_t startUs = esp_timer_get_time();
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+  _flash.part = part;
+  _log.mount(&_flash);
+  _stats.mounted = true;
+  _stats.first = _log.firstSeq();
+  _stats.next = _log.nextSeq();
+  // Only has to differ from the newest stored record's epoch: uptimes of different boots never mix
+  _stats.boot = _log.lastBoot() + 1;
+  xSemaphoreGive(_mutex);
+
+  snprintf(logBuf, sizeof(logBuf), "%u sessions (#%u..#%u), mounted in %u us", (unsigned)(_stats.next - _stats.first),
+           (unsigned)_stats.first, (unsigned)_stats.next, (unsigned)(esp_timer_get_time() - startUs));
+  Esp32SessionHAL::getInstance().logKeyValue("History", logBuf);
+  return true;
+}
+
+// =================================================================================
+// SECTION: WRITE PATH
+// =================================================================================
+
+bool HistoryStore::enqueue(const HistoryEntry &entry) {
+  HistoryEntry e = entry;
+  e.boot = _stats.boot; // Set once in begin(), before the engine runs
+  if (!_pending.push(reinterpret_cast<const uint8_t *>(&e), sizeof(e))) {
+    _stats.dropped++;
+    return false;
+  }
+  return true;
+}
+
+bool HistoryStore::drain() {
+  if (_pending.empty() || _mutex == NULL)
+    return false;
+
+  HistoryEntry e;
+  size_t len = 0;
+  while (_pending.pop(reinterpret_cast<uint8_t *>(&e), sizeof(e), len)) {
+    if (len != sizeof(e))
+      continue;
+
+    PERF_PROBE(PROBE_HISTORY_APPEND);
+    int64_t startUs = esp_timer_get_time();
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    bool ok = _stats.mounted && _log.append(e);
+    uint32_t us = (uint32_t)(esp_timer_get_time() - startUs);
+    if (ok) {
+      _stats.written++;
+      _stats.next = _log.nextSeq();
+      _stats.first = _log.firstSeq();
+      if (us > _stats.maxAppendUs)
+        _stats.maxAppendUs = us;
+    } else {
+      _stats.failed++;
+    }
+    xSemaphoreGive(_mutex);
+
+    char logBuf[64];
+    if (ok)
+      snprintf(logBuf, sizeof(logBuf), "Session #%u recorded (%u us).", (unsigned)e.seq, (unsigned)us);
+    else
+      snprintf(logBuf, sizeof(logBuf), "Session record lost (%s).", _stats.mounted ? "flash error" : "no partition");
+    Esp32SessionHAL::getInstance().logKeyValue("History", logBuf);
+  }
+  return true;
+}
+
+// =================================================================================
+// SECTION: READ PATH
+// =================================================================================
+
+void HistoryStore::seek(uint32_t seq, HistoryLog::Cursor &cursor) {
+  if (_mutex == NULL) {
+    _log.seek(seq, cursor); // Unmounted: positions at the (empty) end
+    return;
+  }
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+  _log.seek(seq, cursor);
+  xSemaphoreGive(_mutex);
+}
+
+bool HistoryStore::next(HistoryLog::Cursor &cursor, HistoryEntry &out) {
+  if (_mutex == NULL)
+    return false;
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+  bool ok = _log.next(cursor, out);
+  xSemaphoreGive(_mutex);
+  return ok;
+}
+
+HistoryStats HistoryStore::getStats() {
+  HistoryStats s;
+  if (_mutex == NULL)
+    return _stats;
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+  s = _stats;
+  xSemaphoreGive(_mutex);
+  return s;
+}
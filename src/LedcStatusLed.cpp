@@ -0,0 +1,101 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      src/LedcStatusLed.cpp
+ *
+ * Description:
+ * Hardware status LED. Fades are programmed straight into the LEDC fade
+ * registers (ledc_set_fade), not through the fade service: that never blocks
+ * and lets a new pattern cut into a running ramp.
+ * =================================================================================
+ */
+#include <driver/ledc.h>
+
+#include "Config.h"
+#include "LedcStatusLed.h"
+
+LedcStatusLed::LedcStatusLed() : _timer(nullptr), _mutex(NULL), _segmentEndUs(0) {}
+
+bool LedcStatusLed::begin(int pin) {
+  ledc_timer_config_t timer = {};
+  timer.speed_mode = LEDC_LOW_SPEED_MODE;
+  timer.duty_resolution = LEDC_TIMER_8_BIT;
+  timer.timer_num = (ledc_timer_t)LED_LEDC_TIMER;
+  timer.freq_hz = LED_LEDC_FREQ_HZ;
+#if LOW_POWER_MODE
+  // APB changes with frequency scaling and stops in light sleep; RTC8M does neither
+  timer.clk_cfg = LEDC_USE_RTC8M_CLK;
+#else
+  timer.clk_cfg = LEDC_AUTO_CLK;
+#endif
+  if (ledc_timer_config(&timer) != ESP_OK)
+    return false;
+
+  ledc_channel_config_t channel = {};
+  channel.gpio_num = pin;
+  channel.speed_mode = LEDC_LOW_SPEED_MODE;
+  channel.channel = (ledc_channel_t)LED_LEDC_CHANNEL;
+  channel.intr_type = LEDC_INTR_DISABLE;
+  channel.timer_sel = (ledc_timer_t)LED_LEDC_TIMER;
+  channel.duty = 0;
+  channel.hpoint = 0;
+  if (ledc_channel_config(&channel) != ESP_OK)
+    return false;
+
+  _mutex = xSemaphoreCreateMutex();
+  if (_mutex == NULL)
+    return false;
+
+  esp_timer_create_args_t args = {};
+  args.callback = &LedcStatusLed::onSegmentEnd;
+  args.arg = this;
+  args.name = "status_led";
+  if (esp_timer_create(&args, &_timer) != ESP_OK) {
+    _timer = nullptr;
+    return false;
+  }
+  return true;
+}
+
+void LedcStatusLed::play(const LedPattern &pattern) {
+  if (_timer == nullptr)
+    return;
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+  esp_timer_stop(_timer); // Fails harmlessly if it already fired
+  _seq.setLevel((uint8_t)ledc_get_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)LED_LEDC_CHANNEL));
+  _seq.start(pattern);
+  startSegment();
+  xSemaphoreGive(_mutex);
+}
+
+void LedcStatusLed::onSegmentEnd(void *arg) {
+  LedcStatusLed *self = static_cast<LedcStatusLed *>(arg);
+  xSemaphoreTake(self->_mutex, portMAX_DELAY);
+
+  // A callback that fired just before play() re-armed the timer belongs to the old pattern
+  if (esp_timer_get_time() + 1000 >= self->_segmentEndUs && self->_seq.advance())
+    self->startSegment();
+  xSemaphoreGive(self->_mutex);
+}
+
+void LedcStatusLed::startSegment() {
+  const LedSegment &seg = _seq.current();
+  LedFadePlan plan;
+  if (seg.fade && LedFadePlan::compute(_seq.startLevel(), seg.level, seg.ms, LED_LEDC_FREQ_HZ, plan)) {
+    ledc_set_fade(LEDC_LOW_SPEED_MODE, (ledc_channel_t)LED_LEDC_CHANNEL, _seq.startLevel(),
+                  plan.increase ? LEDC_DUTY_DIR_INCREASE : LEDC_DUTY_DIR_DECREASE, plan.steps, plan.cyclesPerStep, plan.scale);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)LED_LEDC_CHANNEL);
+  } else {
+    writeLevel(seg.level);
+  }
+
+  if (seg.ms > 0) {
+    _segmentEndUs = esp_timer_get_time() + (int64_t)seg.ms * 1000;
+    esp_timer_start_once(_timer, (uint64_t)seg.ms * 1000);
+  }
+}
+
+void LedcStatusLed::writeLevel(uint8_t level) {
+  ledc_set_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)LED_LEDC_CHANNEL, level);
+  ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)LED_LEDC_CHANNEL);
+}
@@ -13,13 +13,16 @@
 #include <ESPmDNS.h>
 #include <WiFi.h>
 #include <esp_task_wdt.h>
+#include <esp_timer.h>
 
 #include "Config.h"
 #include "Esp32SessionHAL.h"
 #include "Globals.h"
 #include "Network.h"
+#include "ProvisioningCodec.h"
 #include "SettingsManager.h"
 #include "Types.h"
+#include "UdpProtocol.h"
 
 // =================================================================================
 // SECTION: CONSTANTS & UUIDS
@@ -70,6 +73,9 @@
 #define PROV_ENABLE_TIME_MOD_UUID "5a160030-8334-469b-a316-c340cf29188f"
 #define PROV_TIME_MOD_STEP_UUID "5a160031-8334-469b-a316-c340cf29188f"
 
+// --- Packed Config (ProvisioningCodec TLV, all of the above in one write) ---
+#define PROV_PACKED_CONFIG_UUID "5a160040-8334-469b-a316-c340cf29188f"
+
 // =================================================================================
 // SECTION: CLASS IMPLEMENTATION
 // =================================================================================
@@ -79,9 +85,17 @@ NetworkManager &NetworkManager::getInstance() {
   return instance;
 }
 
-NetworkManager::NetworkManager() : _wifiCredentialsExist(false), _triggerProvisioning(false), _wifiRetries(0), _wifiReconnectTimer(NULL) {
+NetworkManager::NetworkManager() : _wifiCredentialsExist(false), _triggerProvisioning(false), _wifiRetries(0), _eventGeneration(1),
+                                   _wifiReconnectTimer(NULL), _wifiBootTimer(NULL), _mdnsStarted(false), _modemSleep(MODEM_SLEEP_NONE),
+                                   _connectCacheValid(false),
+                                   _hasStaticIp(false), _directedAttempt(false), _leaseAttempt(false), _leaseValid(false),
+                                   _leaseGrantedUs(0), _leaseRenewTimer(NULL), _connectStartUs(0),
+                                   _connectAttempts(0), _connectCount(0), _connectDirected(0), _connectFallbacks(0), _connectLastMs(0),
+                                   _connectMaxMs(0), _connectTotalMs(0), _connectLastMode("none"), _connectAddressing("dhcp") {
   memset(_wifiSSID, 0, sizeof(_wifiSSID));
   memset(_wifiPass, 0, sizeof(_wifiPass));
+  memset(&_connectCache, 0, sizeof(_connectCache));
+  memset(&_staticIp, 0, sizeof(_staticIp));
 }
 
 void NetworkManager::log(const char *key, const char *val) { Esp32SessionHAL::getInstance().logKeyValue(key, val); }
@@ -96,8 +110,107 @@ void NetworkManager::connectToWiFi() {
   if (WiFi.status() == WL_CONNECTED)
     return;
 
-  log("Network", "Connecting...");
-  WiFi.begin(_wifiSSID, _wifiPass);
+  _directedAttempt = _connectCacheValid;
+  _leaseAttempt = false;
+
+  // Addressing: configured static IP, else a fresh DHCP lease (directed only), else DHCP
+  if (_hasStaticIp) {
+    WiFi.config(IPAddress(_staticIp.ip), IPAddress(_staticIp.gateway), IPAddress(_staticIp.subnet), IPAddress(_staticIp.dns));
+  } else if (WIFI_REUSE_DHCP_LEASE && _directedAttempt && leaseFresh()) {
+    _leaseAttempt = true;
+    WiFi.config(IPAddress(_connectCache.ip), IPAddress(_connectCache.gateway), IPAddress(_connectCache.subnet),
+                IPAddress(_connectCache.dns));
+  } else {
+    WiFi.config(IPAddress(), IPAddress(), IPAddress()); // 0.0.0.0 = DHCP
+  }
+
+  _connectStartUs = esp_timer_get_time();
+  _connectAttempts++;
+
+  // Directed: known channel and BSSID, no scan
+  if (_directedAttempt) {
+    log("Network", "Connecting (cached BSSID/channel)...");
+    WiFi.begin(_wifiSSID, _wifiPass, _connectCache.channel, _connectCache.bssid);
+  } else {
+    log("Network", "Connecting...");
+    WiFi.begin(_wifiSSID, _wifiPass);
+  }
+}
+
+void NetworkManager::recordConnected() {
+  // 1. Timing
+  uint32_t ms = (uint32_t)((esp_timer_get_time() - _connectStartUs) / 1000);
+  _connectCount++;
+  _connectLastMs = ms;
+  _connectTotalMs += ms;
+  if (ms > _connectMaxMs)
+    _connectMaxMs = ms;
+  if (_directedAttempt)
+    _connectDirected++;
+  _connectLastMode = _directedAttempt ? "directed" : "scan";
+  _connectAddressing = _hasStaticIp ? "static" : (_leaseAttempt ? "lease" : "dhcp");
+  _directedAttempt = false;
+
+  char logBuf[64];
+  snprintf(logBuf, sizeof(logBuf), "Connected in %u ms (%s, %s).", (unsigned)ms, _connectLastMode, _connectAddressing);
+  log("Network", logBuf);
+
+  // 2. Cache this association (and lease) for the next connect; NVS only on change
+  WifiConnectCache c;
+  memset(&c, 0, sizeof(c));
+  const uint8_t *bssid = WiFi.BSSID();
+  if (bssid != NULL)
+    memcpy(c.bssid, bssid, sizeof(c.bssid));
+  c.channel = (uint8_t)WiFi.channel();
+  if (_leaseAttempt) {
+    // Replayed, not assigned: keep the DHCP lease (and its age) and renew it when it runs out
+    c.ip = _connectCache.ip;
+    c.gateway = _connectCache.gateway;
+    c.subnet = _connectCache.subnet;
+    c.dns = _connectCache.dns;
+    int64_t leftMs = (int64_t)WIFI_LEASE_MAX_AGE_MS - (esp_timer_get_time() - _leaseGrantedUs) / 1000;
+    if (_leaseRenewTimer != NULL)
+      xTimerChangePeriod(_leaseRenewTimer, pdMS_TO_TICKS(leftMs > 1000 ? leftMs : 1000), 0);
+  } else if (!_hasStaticIp) {
+    c.ip = (uint32_t)WiFi.localIP();
+    c.gateway = (uint32_t)WiFi.gatewayIP();
+    c.subnet = (uint32_t)WiFi.subnetMask();
+    c.dns = (uint32_t)WiFi.dnsIP(0);
+    _leaseValid = c.ip != 0;
+    _leaseGrantedUs = esp_timer_get_time();
+  }
+
+  if (bssid != NULL && c.channel != 0) {
+    if (!_connectCacheValid || memcmp(&c, &_connectCache, sizeof(c)) != 0)
+      SettingsManager::setWifiConnectCache(c);
+    _connectCache = c;
+    _connectCacheValid = true;
+  }
+}
+
+bool NetworkManager::leaseFresh() const {
+  // A lease read back from NVS has no known age, so only one granted since boot counts
+  return _leaseValid && _connectCache.ip != 0 && (esp_timer_get_time() - _leaseGrantedUs) < (int64_t)WIFI_LEASE_MAX_AGE_MS * 1000;
+}
+
+WiFiConnectStats NetworkManager::getConnectStats() const {
+  WiFiConnectStats st;
+  st.attempts = _connectAttempts;
+  st.connects = _connectCount;
+  st.directed = _connectDirected;
+  st.fallbacks = _connectFallbacks;
+  st.lastMs = _connectLastMs;
+  st.avgMs = _connectCount > 0 ? (uint32_t)(_connectTotalMs / _connectCount) : 0;
+  st.maxMs = _connectMaxMs;
+  st.lastMode = _connectLastMode;
+  st.addressing = _connectAddressing;
+  return st;
+}
+
+void NetworkManager::setModemSleep(ModemSleep level) {
+  static const wifi_ps_type_t PS_TYPES[] = {WIFI_PS_NONE, WIFI_PS_MIN_MODEM, WIFI_PS_MAX_MODEM};
+  _modemSleep = level;
+  WiFi.setSleep(PS_TYPES[level]); // Stored by the WiFi class and re-applied on every station start
 }
 
 // --- Static Callbacks ---
@@ -106,19 +219,68 @@ void NetworkManager::onWiFiEvent(WiFiEvent_t event) { getInstance().handleWiFiEv
 
 void NetworkManager::onWifiTimer(TimerHandle_t t) { getInstance().handleWifiTimer(); }
 
+void NetworkManager::onWifiBootTimer(TimerHandle_t t) { getInstance().handleWifiBootTimeout(); }
+
+void NetworkManager::onLeaseRenewTimer(TimerHandle_t t) { getInstance().handleLeaseRenew(); }
+
 // --- Member Handlers ---
 
 void NetworkManager::handleWifiTimer() { connectToWiFi(); }
 
+void NetworkManager::handleWifiBootTimeout() {
+  if (WiFi.status() == WL_CONNECTED)
+    return;
+
+  // Failure: Just flag it. The Engine will decide what to do.
+  log("Network", "Startup WiFi Failed. Requesting Provisioning...");
+  if (_wifiReconnectTimer != NULL)
+    xTimerStop(_wifiReconnectTimer, 0);
+  _triggerProvisioning = true;
+}
+
+void NetworkManager::handleLeaseRenew() {
+  // Still on the replayed address: the router may reassign it, so reconnect through DHCP
+  _leaseValid = false;
+  if (WiFi.status() != WL_CONNECTED || !_leaseAttempt)
+    return;
+  log("Network", "Replayed lease expired. Reconnecting via DHCP...");
+  WiFi.disconnect();
+}
+
 void NetworkManager::handleWiFiEvent(WiFiEvent_t event) {
+  _eventGeneration++;
+
   switch (event) {
   case ARDUINO_EVENT_WIFI_STA_GOT_IP:
-    log("Network", "Connected.");
+    recordConnected();
     _wifiRetries = 0;
     if (_wifiReconnectTimer != NULL)
       xTimerStop(_wifiReconnectTimer, 0);
+    if (_wifiBootTimer != NULL)
+      xTimerStop(_wifiBootTimer, 0);
+    Esp32SessionHAL::getInstance().markBootPhase(BOOT_PHASE_WIFI);
+
+    // The responder stays up across reconnects, so this only runs once
+    if (!_mdnsStarted) {
+      _mdnsStarted = true;
+      startMDNS();
+    }
     break;
   case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+    if (_leaseRenewTimer != NULL)
+      xTimerStop(_leaseRenewTimer, 0);
+    // Stale cache (AP moved channel or was replaced): full scan next, not counted as a retry
+    if (_directedAttempt) {
+      _directedAttempt = false;
+      _connectCacheValid = false;
+      _leaseValid = false; // A replay may be what failed; the scan always runs DHCP
+      _connectFallbacks++;
+      log("Network", "Directed connect failed. Falling back to full scan.");
+      if (_wifiReconnectTimer != NULL)
+        xTimerStart(_wifiReconnectTimer, 0);
+      break;
+    }
+
     // If we fail too many times, we don't abort directly.
     // We just raise the flag. The Engine will decide what to do.
     if (_wifiRetries >= g_systemDefaults.wifiMaxRetries) {
@@ -160,6 +322,10 @@ void NetworkManager::startMDNS() {
   MDNS.addServiceTxt("lobster-lock", "tcp", "mac", (const char *)macStr);
   MDNS.addServiceTxt("lobster-lock", "tcp", "deviceName", "Lobster Lock (diymore)");
 
+  // UDP command channel (key and nonce via GET /udp)
+  MDNS.addServiceTxt("lobster-lock", "tcp", "udpPort", String(UDP_COMMAND_PORT));
+  MDNS.addServiceTxt("lobster-lock", "tcp", "udpVersion", String(UDP_PROTOCOL_VERSION));
+
   char logBuf[64];
   snprintf(logBuf, sizeof(logBuf), "mDNS active: %s.local", uniqueHostname);
   log("Network", logBuf);
@@ -169,37 +335,133 @@ void NetworkManager::startMDNS() {
 // SECTION: BLE PROVISIONING (Transport Only)
 // =================================================================================
 
-uint16_t bytesToUint16(uint8_t *data) { return (uint16_t)data[0] | ((uint16_t)data[1] << 8); }
-uint32_t bytesToUint32(uint8_t *data) {
-  return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
-}
-
+/**
+ * Stages every characteristic write in one SettingsTransaction (RAM only).
+ * The provisioning loop commits the set once the client goes quiet, right
+ * after a packed write and before restarting, so a full provisioning pass is
+ * one validated NVS write instead of one open/commit per characteristic.
+ *
+ * Writes are dispatched by characteristic: the packed characteristic carries
+ * a ProvisioningCodec packet, every legacy characteristic maps to one codec
+ * tag through a table filled at registration (no UUID strings per write).
+ */
 class ProvisioningCallbacks : public BLECharacteristicCallbacks {
   // Flag to signal completion to the manager
   bool *_credentialsReceivedPtr;
 
+  // Staged changes. onWrite runs on the BLE task, commits on the provisioning loop.
+  SettingsTransaction _txn;
+  SemaphoreHandle_t _txnMutex;
+  uint32_t _lastWriteMs;
+  bool _unattempted; // Writes since the last commit attempt
+  bool _commitNow;   // A packed write delivered a complete set
+
+  // Characteristic -> codec tag dispatch
+  struct LegacyChar {
+    BLECharacteristic *characteristic;
+    uint8_t tag;
+  };
+  LegacyChar _legacy[PROV_TAG_COUNT];
+  uint8_t _legacyCount;
+  BLECharacteristic *_packedChar;
+
 private:
   void log(const char *key, const char *val) { Esp32SessionHAL::getInstance().logKeyValue(key, val); }
 
 public:
-  ProvisioningCallbacks(bool *flagPtr) : _credentialsReceivedPtr(flagPtr) {}
+  ProvisioningCallbacks(bool *flagPtr)
+      : _credentialsReceivedPtr(flagPtr), _txnMutex(xSemaphoreCreateMutex()), _lastWriteMs(0), _unattempted(false), _commitNow(false),
+        _legacyCount(0), _packedChar(nullptr) {}
+
+  // --- Registration (before the service starts) ---
+  void registerLegacy(BLECharacteristic *c, uint8_t tag) {
+    if (_legacyCount < PROV_TAG_COUNT)
+      _legacy[_legacyCount++] = {c, tag};
+  }
+  void registerPacked(BLECharacteristic *c) { _packedChar = c; }
+
+  // Commits after a packed write, or once no write has arrived for
+  // PROV_COMMIT_IDLE_MS. A rejected (invalid) set stays staged until the
+  // client writes again.
+  void commitIfDue(uint32_t nowMs) {
+    xSemaphoreTake(_txnMutex, portMAX_DELAY);
+    if (_unattempted && _txn.hasChanges() && (_commitNow || (uint32_t)(nowMs - _lastWriteMs) >= PROV_COMMIT_IDLE_MS)) {
+      _unattempted = false;
+      _commitNow = false;
+      _txn.commit();
+    }
+    xSemaphoreGive(_txnMutex);
+  }
+
+  // Before restart: credentials are always kept, an invalid settings set is dropped.
+  void commitFinal() {
+    xSemaphoreTake(_txnMutex, portMAX_DELAY);
+    if (!_txn.commit()) {
+      log("BLE", "Staged settings invalid. Discarding them, keeping credentials.");
+      _txn.discardSettings();
+      _txn.commit();
+    }
+    xSemaphoreGive(_txnMutex);
+  }
 
   void onWrite(BLECharacteristic *pCharacteristic) {
-    std::string uuid = pCharacteristic->getUUID().toString();
     uint8_t *data = pCharacteristic->getData();
     size_t len = pCharacteristic->getLength();
 
     if (len == 0)
       return;
 
+    xSemaphoreTake(_txnMutex, portMAX_DELAY);
+
+    // Decode on top of the staged values, so partial writes keep the rest
+    ProvisioningFields fields;
+    fields.config = _txn.config();
+    fields.presets = _txn.presets();
+    fields.channelMask = (uint8_t)_txn.channelMask(); // The BLE codec carries channels 1-8
+    fields.ssid[0] = '\0';
+    fields.pass[0] = '\0';
+    fields.present = 0;
+
+    ProvDecodeResult result;
+    bool packed = (pCharacteristic == _packedChar);
+    if (packed) {
+      result = ProvisioningCodec::decodePacket(data, len, fields);
+    } else {
+      result = ProvisioningCodec::decodeValue(tagFor(pCharacteristic), data, len, fields);
+    }
+
+    if (result == PROV_DECODE_OK) {
+      stage(fields);
+      _lastWriteMs = millis();
+      _unattempted = true;
+      _commitNow = _commitNow || packed;
+    } else {
+      char logBuf[64];
+      snprintf(logBuf, sizeof(logBuf), "Write rejected: %s", ProvisioningCodec::resultName(result));
+      log("BLE", logBuf);
+    }
+
+    xSemaphoreGive(_txnMutex);
+  }
+
+private:
+  uint8_t tagFor(BLECharacteristic *c) const {
+    for (uint8_t i = 0; i < _legacyCount; i++)
+      if (_legacy[i].characteristic == c)
+        return _legacy[i].tag;
+    return PROV_TAG_NONE;
+  }
+
+  // Hands every decoded field to the transaction. Min/max pairs are staged
+  // together; the half that was not written comes from the staged values.
+  void stage(const ProvisioningFields &f) {
     // --- Credentials ---
-    if (uuid == PROV_SSID_CHAR_UUID) {
-      std::string val(data, data + len);
-      SettingsManager::setWifiSSID(val.c_str());
+    if (f.has(PROV_TAG_SSID)) {
+      _txn.setWifiSSID(f.ssid);
       log("BLE", "SSID Received");
-    } else if (uuid == PROV_PASS_CHAR_UUID) {
-      std::string val(data, data + len);
-      SettingsManager::setWifiPassword(val.c_str());
+    }
+    if (f.has(PROV_TAG_PASS)) {
+      _txn.setWifiPassword(f.pass);
       log("BLE", "Password Received");
       // Signal completion - Triggers Reboot
       if (_credentialsReceivedPtr)
@@ -207,91 +469,49 @@ public:
     }
 
     // --- Toggles & Fixed Values ---
-    else if (uuid == PROV_ENABLE_REWARD_CODE_CHAR_UUID)
-      SettingsManager::setRewardCodeEnabled((bool)data[0]);
-    else if (uuid == PROV_ENABLE_STREAKS_CHAR_UUID)
-      SettingsManager::setStreaksEnabled((bool)data[0]);
-    else if (uuid == PROV_ENABLE_PAYBACK_TIME_CHAR_UUID)
-      SettingsManager::setPaybackEnabled((bool)data[0]);
-    else if (uuid == PROV_PAYBACK_TIME_CHAR_UUID)
-      SettingsManager::setPaybackDuration(bytesToUint32(data));
-    else if (uuid == PROV_REWARD_PENALTY_CHAR_UUID)
-      SettingsManager::setRewardPenaltyDuration(bytesToUint32(data));
-    else if (uuid == PROV_ENABLE_TIME_MOD_UUID)
-      SettingsManager::setTimeModificationEnabled((bool)data[0]);
-    else if (uuid == PROV_TIME_MOD_STEP_UUID)
-      SettingsManager::setTimeModificationStep(bytesToUint32(data));
+    if (f.has(PROV_TAG_ENABLE_REWARD_CODE))
+      _txn.setRewardCodeEnabled(f.config.enableRewardCode);
+    if (f.has(PROV_TAG_ENABLE_STREAKS))
+      _txn.setStreaksEnabled(f.config.enableStreaks);
+    if (f.has(PROV_TAG_ENABLE_PAYBACK))
+      _txn.setPaybackEnabled(f.config.enablePaybackTime);
+    if (f.has(PROV_TAG_PAYBACK_TIME))
+      _txn.setPaybackDuration(f.config.paybackTime);
+    if (f.has(PROV_TAG_REWARD_PENALTY))
+      _txn.setRewardPenaltyDuration(f.config.rewardPenalty);
+    if (f.has(PROV_TAG_ENABLE_TIME_MOD))
+      _txn.setTimeModificationEnabled(f.config.enableTimeModification);
+    if (f.has(PROV_TAG_TIME_MOD_STEP))
+      _txn.setTimeModificationStep(f.config.timeModificationStep);
 
     // --- Hardware ---
-    else if (uuid == PROV_CH1_ENABLE_UUID)
-      SettingsManager::setChannelEnabled(0, (bool)data[0]);
-    else if (uuid == PROV_CH2_ENABLE_UUID)
-      SettingsManager::setChannelEnabled(1, (bool)data[0]);
-    else if (uuid == PROV_CH3_ENABLE_UUID)
-      SettingsManager::setChannelEnabled(2, (bool)data[0]);
-    else if (uuid == PROV_CH4_ENABLE_UUID)
-      SettingsManager::setChannelEnabled(3, (bool)data[0]);
+    const uint32_t channelTags = PROV_TAG_BIT(PROV_TAG_CHANNEL_MASK) | PROV_TAG_BIT(PROV_TAG_CH1_ENABLE) |
+                                 PROV_TAG_BIT(PROV_TAG_CH2_ENABLE) | PROV_TAG_BIT(PROV_TAG_CH3_ENABLE) |
+                                 PROV_TAG_BIT(PROV_TAG_CH4_ENABLE);
+    if (f.present & channelTags) {
+      for (int i = 0; i < MAX_CHANNELS && i < 8; i++)
+        _txn.setChannelEnabled(i, (f.channelMask >> i) & 1);
+    }
 
     // --- Strategies ---
-    else if (uuid == PROV_PAYBACK_STRATEGY_UUID)
-      SettingsManager::setPaybackStrategy((DeterrentStrategy)data[0]);
-    else if (uuid == PROV_REWARD_STRATEGY_UUID)
-      SettingsManager::setRewardStrategy((DeterrentStrategy)data[0]);
-
-    // --- Ranges (Read-Modify-Write) ---
-    // Since we receive Min/Max individually but save them as pairs, we must:
-    // 1. Load the current config to get the "other" value of the pair.
-    // 2. Update the specific value we received.
-    // 3. Save the pair back using the SettingsManager.
-    else {
-      DeterrentConfig config;
-      SessionPresets presets;
-      uint8_t mask;
-      SettingsManager::loadProvisioningConfig(config, presets, mask);
-      uint32_t val = bytesToUint32(data);
-
-      // 1. Global Session Safety Limits
-      if (uuid == PROV_MIN_SESSION_DURATION_UUID) {
-        SettingsManager::setSessionLimits(val, presets.maxSessionDuration);
-      } else if (uuid == PROV_MAX_SESSION_DURATION_UUID) {
-        SettingsManager::setSessionLimits(presets.minSessionDuration, val);
-      }
-
-      // 2. Deterrent: Payback Range
-      else if (uuid == PROV_PAYBACK_MIN_DURATION_UUID) {
-        SettingsManager::setPaybackRange(val, config.paybackTimeMax);
-      } else if (uuid == PROV_PAYBACK_MAX_DURATION_UUID) {
-        SettingsManager::setPaybackRange(config.paybackTimeMin, val);
-      }
-
-      // 3. Deterrent: Reward Penalty Range
-      else if (uuid == PROV_REWARD_MIN_DURATION_UUID) {
-        SettingsManager::setRewardRange(val, config.rewardPenaltyMax);
-      } else if (uuid == PROV_REWARD_MAX_DURATION_UUID) {
-        SettingsManager::setRewardRange(config.rewardPenaltyMin, val);
-      }
-
-      // 4. Session Presets: Short
-      else if (uuid == PROV_SHORT_MIN_UUID) {
-        SettingsManager::setDurationPreset(DUR_RANGE_SHORT, val, presets.shortMax);
-      } else if (uuid == PROV_SHORT_MAX_UUID) {
-        SettingsManager::setDurationPreset(DUR_RANGE_SHORT, presets.shortMin, val);
-      }
-
-      // 5. Session Presets: Medium
-      else if (uuid == PROV_MEDIUM_MIN_UUID) {
-        SettingsManager::setDurationPreset(DUR_RANGE_MEDIUM, val, presets.mediumMax);
-      } else if (uuid == PROV_MEDIUM_MAX_UUID) {
-        SettingsManager::setDurationPreset(DUR_RANGE_MEDIUM, presets.mediumMin, val);
-      }
-
-      // 6. Session Presets: Long
-      else if (uuid == PROV_LONG_MIN_UUID) {
-        SettingsManager::setDurationPreset(DUR_RANGE_LONG, val, presets.longMax);
-      } else if (uuid == PROV_LONG_MAX_UUID) {
-        SettingsManager::setDurationPreset(DUR_RANGE_LONG, presets.longMin, val);
-      }
-    }
+    if (f.has(PROV_TAG_PAYBACK_STRATEGY))
+      _txn.setPaybackStrategy(f.config.paybackTimeStrategy);
+    if (f.has(PROV_TAG_REWARD_STRATEGY))
+      _txn.setRewardStrategy(f.config.rewardPenaltyStrategy);
+
+    // --- Ranges ---
+    if (f.has(PROV_TAG_MIN_SESSION) || f.has(PROV_TAG_MAX_SESSION))
+      _txn.setSessionLimits(f.presets.minSessionDuration, f.presets.maxSessionDuration);
+    if (f.has(PROV_TAG_PAYBACK_MIN) || f.has(PROV_TAG_PAYBACK_MAX))
+      _txn.setPaybackRange(f.config.paybackTimeMin, f.config.paybackTimeMax);
+    if (f.has(PROV_TAG_REWARD_MIN) || f.has(PROV_TAG_REWARD_MAX))
+      _txn.setRewardRange(f.config.rewardPenaltyMin, f.config.rewardPenaltyMax);
+    if (f.has(PROV_TAG_SHORT_MIN) || f.has(PROV_TAG_SHORT_MAX))
+      _txn.setDurationPreset(DUR_RANGE_SHORT, f.presets.shortMin, f.presets.shortMax);
+    if (f.has(PROV_TAG_MEDIUM_MIN) || f.has(PROV_TAG_MEDIUM_MAX))
+      _txn.setDurationPreset(DUR_RANGE_MEDIUM, f.presets.mediumMin, f.presets.mediumMax);
+    if (f.has(PROV_TAG_LONG_MIN) || f.has(PROV_TAG_LONG_MAX))
+      _txn.setDurationPreset(DUR_RANGE_LONG, f.presets.longMin, f.presets.longMax);
   }
 };
 
@@ -314,54 +534,61 @@ void NetworkManager::startBLEProvisioningBlocking() {
 
   ProvisioningCallbacks *callbacks = new ProvisioningCallbacks(&localCredentialsReceived);
 
-  auto createChar = [&](const char *uuid) {
+  // Legacy: one setting per characteristic, mapped to its codec tag
+  auto createChar = [&](const char *uuid, uint8_t tag) {
     BLECharacteristic *p = pService->createCharacteristic(uuid, BLECharacteristic::PROPERTY_WRITE);
     p->setCallbacks(callbacks);
+    callbacks->registerLegacy(p, tag);
     return p;
   };
 
+  // Packed: every setting in one TLV write (ProvisioningCodec)
+  BLECharacteristic *packed = pService->createCharacteristic(PROV_PACKED_CONFIG_UUID, BLECharacteristic::PROPERTY_WRITE);
+  packed->setCallbacks(callbacks);
+  callbacks->registerPacked(packed);
+
   // Credentials
-  createChar(PROV_SSID_CHAR_UUID);
-  createChar(PROV_PASS_CHAR_UUID);
+  createChar(PROV_SSID_CHAR_UUID, PROV_TAG_SSID);
+  createChar(PROV_PASS_CHAR_UUID, PROV_TAG_PASS);
 
   // Feature Toggles
-  createChar(PROV_ENABLE_REWARD_CODE_CHAR_UUID);
-  createChar(PROV_ENABLE_STREAKS_CHAR_UUID);
-  createChar(PROV_ENABLE_PAYBACK_TIME_CHAR_UUID);
+  createChar(PROV_ENABLE_REWARD_CODE_CHAR_UUID, PROV_TAG_ENABLE_REWARD_CODE);
+  createChar(PROV_ENABLE_STREAKS_CHAR_UUID, PROV_TAG_ENABLE_STREAKS);
+  createChar(PROV_ENABLE_PAYBACK_TIME_CHAR_UUID, PROV_TAG_ENABLE_PAYBACK);
 
   // Base Values
-  createChar(PROV_PAYBACK_TIME_CHAR_UUID);
-  createChar(PROV_REWARD_PENALTY_CHAR_UUID);
+  createChar(PROV_PAYBACK_TIME_CHAR_UUID, PROV_TAG_PAYBACK_TIME);
+  createChar(PROV_REWARD_PENALTY_CHAR_UUID, PROV_TAG_REWARD_PENALTY);
 
   // Hardware
-  createChar(PROV_CH1_ENABLE_UUID);
-  createChar(PROV_CH2_ENABLE_UUID);
-  createChar(PROV_CH3_ENABLE_UUID);
-  createChar(PROV_CH4_ENABLE_UUID);
+  createChar(PROV_CH1_ENABLE_UUID, PROV_TAG_CH1_ENABLE);
+  createChar(PROV_CH2_ENABLE_UUID, PROV_TAG_CH2_ENABLE);
+  createChar(PROV_CH3_ENABLE_UUID, PROV_TAG_CH3_ENABLE);
+  createChar(PROV_CH4_ENABLE_UUID, PROV_TAG_CH4_ENABLE);
 
   // Global Limits
-  createChar(PROV_MIN_SESSION_DURATION_UUID);
-  createChar(PROV_MAX_SESSION_DURATION_UUID);
+  createChar(PROV_MIN_SESSION_DURATION_UUID, PROV_TAG_MIN_SESSION);
+  createChar(PROV_MAX_SESSION_DURATION_UUID, PROV_TAG_MAX_SESSION);
 
   // Deterrent Strategies & Ranges
-  createChar(PROV_PAYBACK_STRATEGY_UUID);
-  createChar(PROV_PAYBACK_MIN_DURATION_UUID);
-  createChar(PROV_PAYBACK_MAX_DURATION_UUID);
+  createChar(PROV_PAYBACK_STRATEGY_UUID, PROV_TAG_PAYBACK_STRATEGY);
+  createChar(PROV_PAYBACK_MIN_DURATION_UUID, PROV_TAG_PAYBACK_MIN);
+  createChar(PROV_PAYBACK_MAX_DURATION_UUID, PROV_TAG_PAYBACK_MAX);
 
-  createChar(PROV_REWARD_STRATEGY_UUID);
-  createChar(PROV_REWARD_MIN_DURATION_UUID);
-  createChar(PROV_REWARD_MAX_DURATION_UUID);
+  createChar(PROV_REWARD_STRATEGY_UUID, PROV_TAG_REWARD_STRATEGY);
+  createChar(PROV_REWARD_MIN_DURATION_UUID, PROV_TAG_REWARD_MIN);
+  createChar(PROV_REWARD_MAX_DURATION_UUID, PROV_TAG_REWARD_MAX);
 
-  createChar(PROV_ENABLE_TIME_MOD_UUID);
-  createChar(PROV_TIME_MOD_STEP_UUID);
+  createChar(PROV_ENABLE_TIME_MOD_UUID, PROV_TAG_ENABLE_TIME_MOD);
+  createChar(PROV_TIME_MOD_STEP_UUID, PROV_TAG_TIME_MOD_STEP);
 
   // Duration Presets
-  createChar(PROV_SHORT_MIN_UUID);
-  createChar(PROV_SHORT_MAX_UUID);
-  createChar(PROV_MEDIUM_MIN_UUID);
-  createChar(PROV_MEDIUM_MAX_UUID);
-  createChar(PROV_LONG_MIN_UUID);
-  createChar(PROV_LONG_MAX_UUID);
+  createChar(PROV_SHORT_MIN_UUID, PROV_TAG_SHORT_MIN);
+  createChar(PROV_SHORT_MAX_UUID, PROV_TAG_SHORT_MAX);
+  createChar(PROV_MEDIUM_MIN_UUID, PROV_TAG_MEDIUM_MIN);
+  createChar(PROV_MEDIUM_MAX_UUID, PROV_TAG_MEDIUM_MAX);
+  createChar(PROV_LONG_MIN_UUID, PROV_TAG_LONG_MIN);
+  createChar(PROV_LONG_MAX_UUID, PROV_TAG_LONG_MAX);
 
   pService->start();
 
@@ -378,7 +605,11 @@ void NetworkManager::startBLEProvisioningBlocking() {
     for (int i = 0; i < MAX_CHANNELS; i++)
       digitalWrite(HARDWARE_PINS[i], LOW);
 
+    // Persist staged settings once the client has gone quiet
+    callbacks->commitIfDue(millis());
+
     if (localCredentialsReceived) {
+      callbacks->commitFinal();
       log("BLE", "Credentials received. Restarting...");
       Esp32SessionHAL::getInstance().tick();
       delay(3000);
@@ -395,8 +626,11 @@ void NetworkManager::startBLEProvisioningBlocking() {
 // =================================================================================
 
 void NetworkManager::connectOrRequestProvisioning() {
-  // Create Timer
+  // Create Timers
   _wifiReconnectTimer = xTimerCreate("wifiTimer", pdMS_TO_TICKS(2000), pdFALSE, (void *)0, NetworkManager::onWifiTimer);
+  _wifiBootTimer = xTimerCreate("wifiBoot", pdMS_TO_TICKS(WIFI_BOOT_TIMEOUT_MS), pdFALSE, (void *)0, NetworkManager::onWifiBootTimer);
+  _leaseRenewTimer =
+      xTimerCreate("wifiLease", pdMS_TO_TICKS(WIFI_LEASE_MAX_AGE_MS), pdFALSE, (void *)0, NetworkManager::onLeaseRenewTimer);
 
   log("Network", "Booting the network stack.");
 
@@ -406,38 +640,24 @@ void NetworkManager::connectOrRequestProvisioning() {
   SettingsManager::getWifiPassword(_wifiPass, sizeof(_wifiPass));
 
   // Determine if we can connect
-  if (strlen(_wifiSSID) > 0) {
-    log("Network", "Found Wi-Fi credentials.");
-    _wifiCredentialsExist = true;
-    WiFi.onEvent(NetworkManager::onWiFiEvent);
-    connectToWiFi();
-  }
-
-  // Blocking wait for initial connection
-  if (_wifiCredentialsExist) {
-    unsigned long wifiWaitStart = millis();
-    WiFi.setSleep(false);
-
-    // Wait for connection (Blocking briefly on startup)
-    while (WiFi.status() != WL_CONNECTED && (millis() - wifiWaitStart < 30000)) {
-      Esp32SessionHAL::getInstance().tick();
-      esp_task_wdt_reset();
-      delay(100);
-    }
-
-    if (WiFi.status() == WL_CONNECTED) {
-      startMDNS();
-      return;
-    }
-
-    // Failure: Just flag it.
-    log("Network", "Startup WiFi Failed. Requesting Provisioning...");
-    _triggerProvisioning = true;
-  } else {
+  if (strlen(_wifiSSID) == 0) {
     // No creds? Flag immediately.
     log("Network", "No WiFi credentials found. Requesting Provisioning...");
     _triggerProvisioning = true;
+    return;
   }
+
+  log("Network", "Found Wi-Fi credentials.");
+  _wifiCredentialsExist = true;
+  _connectCacheValid = SettingsManager::getWifiConnectCache(_connectCache);
+  _hasStaticIp = SettingsManager::getWifiStaticIp(_staticIp);
+  setModemSleep(_modemSleep); // Off, unless a restored session is already in low-power mode
+  WiFi.onEvent(NetworkManager::onWiFiEvent);
+
+  // Non-blocking: the result arrives as GOT_IP / DISCONNECTED events
+  if (_wifiBootTimer != NULL)
+    xTimerStart(_wifiBootTimer, 0);
+  connectToWiFi();
 }
 
 void NetworkManager::printStartupDiagnostics() {
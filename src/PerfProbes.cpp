@@ -0,0 +1,90 @@
+/*
+ * =================================================================================
+ * File:      src/PerfProbes.cpp
+ * Description:
+ * Probe table behind PERF_PROBE(). Probes fire from the engine, io and web
+ * tasks on both cores, so updates are serialized by a spinlock; the critical
+ * section is a handful of adds.
+ * =================================================================================
+ */
+#ifdef PERF_PROBES
+
+#include "PerfProbes.h"
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <string.h>
+
+static PerfProbeStats s_probes[PROBE_COUNT];
+static uint32_t s_iterations = 0;
+static portMUX_TYPE s_probeMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Order matches PerfProbeId
+static const char *const PROBE_NAMES[PROBE_COUNT] = {
+    "hal_safety",
+    "hal_buttons",
+    "hal_health",
+    "hal_led",
+    "serial_drain",
+    "sensor_sample",
+    "engine_inputs",
+    "engine_update",
+    "save_state",
+    "save_checkpoint",
+    "history_append",
+    "web_root",
+    "web_health",
+    "web_keepalive",
+    "web_reboot",
+    "web_factory_reset",
+    "web_arm",
+    "web_start_test",
+    "web_abort",
+    "web_time_mod",
+    "web_status",
+    "web_details",
+    "web_log",
+    "web_latency_reset",
+    "web_reward",
+    "web_update_wifi",
+    "web_metrics",
+    "web_events",
+    "web_udp_info",
+    "web_batch",
+    "web_history",
+    "web_trace",
+    "web_udp_reset_key",
+    "udp_packet",
+};
+
+void PerfProbes::record(PerfProbeId id, uint32_t us) {
+  if (id >= PROBE_COUNT)
+    return;
+  portENTER_CRITICAL(&s_probeMux);
+  PerfProbeStats &p = s_probes[id];
+  p.count++;
+  p.totalUs += us;
+  if (us > p.maxUs)
+    p.maxUs = us;
+  portEXIT_CRITICAL(&s_probeMux);
+}
+
+void PerfProbes::countIteration() {
+  portENTER_CRITICAL(&s_probeMux);
+  s_iterations++;
+  portEXIT_CRITICAL(&s_probeMux);
+}
+
+void PerfProbes::snapshot(PerfProbeStats (&out)[PROBE_COUNT], uint32_t &iterations) {
+  portENTER_CRITICAL(&s_probeMux);
+  memcpy(out, s_probes, sizeof(s_probes));
+  iterations = s_iterations;
+  portEXIT_CRITICAL(&s_probeMux);
+}
+
+const char *PerfProbes::name(PerfProbeId id) { return id < PROBE_COUNT ? PROBE_NAMES[id] : "unknown"; }
+
+PerfProbeScope::PerfProbeScope(PerfProbeId id) : _id(id), _startUs(esp_timer_get_time()) {}
+
+PerfProbeScope::~PerfProbeScope() { PerfProbes::record(_id, (uint32_t)(esp_timer_get_time() - _startUs)); }
+
+#endif
@@ -7,8 +7,15 @@
 #include "SettingsManager.h"
 #include "Esp32SessionHAL.h" // For logging
 #include "Globals.h"
+#include "LogicUtils.h"
+#include "PerfProbes.h"
+#include "CheckpointJournal.h"
+#include "Session.h"
+#include "SessionRecord.h"
 #include <Arduino.h>
 #include <Preferences.h>
+#include <esp_timer.h>
+#include <nvs.h>
 
 // --- Preferences Namespaces ---
 static Preferences wifiPrefs;
@@ -16,6 +23,157 @@ static Preferences provPrefs;
 static Preferences sessionPrefs;
 static Preferences sessionConfig;
 static Preferences bootPrefs;
+static Preferences journalPrefs;
+
+// --- WiFi Fast Reconnect ---
+#define WIFI_CACHE_KEY "connCache"
+#define WIFI_STATIC_KEY "staticIp"
+#define UDP_KEY_KEY "udpKey"
+#define UDP_KEY_BYTES 16
+
+// --- Session Record ---
+#define SESSION_RECORD_KEY "rec"
+static PersistenceStats s_persistStats = {0, 0, 0, 0, 0, 0, sizeof(SessionRecord), "none"};
+
+// --- Checkpoint Journal ---
+// Ring of CHECKPOINT_SLOTS keys ("cp0".."cp7") in its own namespace, so a
+// torn checkpoint write can never damage the full session record.
+static JournalStats s_journalStats = {0, 0, 0, 0, sizeof(CheckpointSlot), false};
+
+static void journalKey(int index, char *buf, size_t len) { snprintf(buf, len, "cp%d", index); }
+
+// --- Channel Mask (per-key layout of older firmware) ---
+// NVS entries are typed: boards with more than 8 channels kept a u16 under its own key.
+#if MAX_CHANNELS > 8
+#define CHANNEL_MASK_KEY "chMask16"
+static ChannelMask readChannelMask(Preferences &prefs) { return prefs.getUShort(CHANNEL_MASK_KEY, CHANNEL_MASK_ALL); }
+#else
+#define CHANNEL_MASK_KEY "chMask"
+static ChannelMask readChannelMask(Preferences &prefs) { return prefs.getUChar(CHANNEL_MASK_KEY, CHANNEL_MASK_ALL); }
+#endif
+
+// --- Settings Record ---
+// The provisioning settings as one fixed-layout, CRC-checked blob. Every
+// settings write replaces the whole record with a single nvs_set_blob, so an
+// error or power loss mid-write leaves the previous set intact. The per-key
+// values of older firmware are only read while no record exists.
+#define SETTINGS_RECORD_KEY "settings"
+#define SETTINGS_RECORD_VERSION 1
+
+enum : uint8_t {
+  SETTINGS_FLAG_STREAKS = 1u << 0,
+  SETTINGS_FLAG_CODE = 1u << 1,
+  SETTINGS_FLAG_PAYBACK = 1u << 2,
+  SETTINGS_FLAG_TIME_MOD = 1u << 3,
+};
+
+struct SettingsRecord {
+  uint8_t version;
+  uint8_t flags; // SETTINGS_FLAG_*
+  uint8_t payStrategy;
+  uint8_t rewardStrategy;
+  uint16_t channelMask;
+  uint16_t reserved;
+  uint32_t payMin, payMax, paySeconds;
+  uint32_t penMin, penMax, penSeconds;
+  uint32_t timeModStep;
+  uint32_t shMin, shMax, mdMin, mdMax, lgMin, lgMax;
+  uint32_t minSessionDur, maxSessionDur;
+  uint32_t crc; // Over every byte before it
+};
+static_assert(sizeof(SettingsRecord) == 72, "SettingsRecord layout is persisted");
+
+static void packSettings(const DeterrentConfig &c, const SessionPresets &p, ChannelMask mask, SettingsRecord &rec) {
+  memset(&rec, 0, sizeof(rec));
+  rec.version = SETTINGS_RECORD_VERSION;
+  rec.flags = (c.enableStreaks ? SETTINGS_FLAG_STREAKS : 0) | (c.enableRewardCode ? SETTINGS_FLAG_CODE : 0) |
+              (c.enablePaybackTime ? SETTINGS_FLAG_PAYBACK : 0) | (c.enableTimeModification ? SETTINGS_FLAG_TIME_MOD : 0);
+  rec.payStrategy = (uint8_t)c.paybackTimeStrategy;
+  rec.rewardStrategy = (uint8_t)c.rewardPenaltyStrategy;
+  rec.channelMask = mask;
+  rec.payMin = c.paybackTimeMin;
+  rec.payMax = c.paybackTimeMax;
+  rec.paySeconds = c.paybackTime;
+  rec.penMin = c.rewardPenaltyMin;
+  rec.penMax = c.rewardPenaltyMax;
+  rec.penSeconds = c.rewardPenalty;
+  rec.timeModStep = c.timeModificationStep;
+  rec.shMin = p.shortMin;
+  rec.shMax = p.shortMax;
+  rec.mdMin = p.mediumMin;
+  rec.mdMax = p.mediumMax;
+  rec.lgMin = p.longMin;
+  rec.lgMax = p.longMax;
+  rec.minSessionDur = p.minSessionDuration;
+  rec.maxSessionDur = p.maxSessionDuration;
+  rec.crc = LogicUtils::crc32((const uint8_t *)&rec, offsetof(SettingsRecord, crc));
+}
+
+static bool unpackSettings(const SettingsRecord &rec, DeterrentConfig &c, SessionPresets &p, ChannelMask &mask) {
+  if (rec.version != SETTINGS_RECORD_VERSION || rec.crc != LogicUtils::crc32((const uint8_t *)&rec, offsetof(SettingsRecord, crc)))
+    return false;
+  c.enableStreaks = rec.flags & SETTINGS_FLAG_STREAKS;
+  c.enableRewardCode = rec.flags & SETTINGS_FLAG_CODE;
+  c.enablePaybackTime = rec.flags & SETTINGS_FLAG_PAYBACK;
+  c.enableTimeModification = rec.flags & SETTINGS_FLAG_TIME_MOD;
+  c.paybackTimeStrategy = (DeterrentStrategy)rec.payStrategy;
+  c.rewardPenaltyStrategy = (DeterrentStrategy)rec.rewardStrategy;
+  mask = (ChannelMask)(rec.channelMask & CHANNEL_MASK_ALL);
+  c.paybackTimeMin = rec.payMin;
+  c.paybackTimeMax = rec.payMax;
+  c.paybackTime = rec.paySeconds;
+  c.rewardPenaltyMin = rec.penMin;
+  c.rewardPenaltyMax = rec.penMax;
+  c.rewardPenalty = rec.penSeconds;
+  c.timeModificationStep = rec.timeModStep;
+  p.shortMin = rec.shMin;
+  p.shortMax = rec.shMax;
+  p.mediumMin = rec.mdMin;
+  p.mediumMax = rec.mdMax;
+  p.longMin = rec.lgMin;
+  p.longMax = rec.lgMax;
+  p.minSessionDuration = rec.minSessionDur;
+  p.maxSessionDuration = rec.maxSessionDur;
+  return true;
+}
+
+// Replaces the stored set: one blob write and one commit.
+static esp_err_t storeSettings(const DeterrentConfig &config, const SessionPresets &presets, ChannelMask mask) {
+  SettingsRecord rec;
+  packSettings(config, presets, mask, rec);
+  nvs_handle_t h;
+  esp_err_t err = nvs_open("provisioning", NVS_READWRITE, &h);
+  if (err != ESP_OK)
+    return err;
+  err = nvs_set_blob(h, SETTINGS_RECORD_KEY, &rec, sizeof(rec));
+  if (err == ESP_OK)
+    err = nvs_commit(h);
+  nvs_close(h);
+  return err;
+}
+
+// Direct setters: change one field of the stored set and write the record back.
+template <typename Change> static void updateSettings(Change change) {
+  DeterrentConfig config = {};
+  SessionPresets presets = {};
+  ChannelMask mask = CHANNEL_MASK_ALL;
+  SettingsManager::loadProvisioningConfig(config, presets, mask);
+  change(config, presets, mask);
+
+  esp_err_t err = storeSettings(config, presets, mask);
+  if (err != ESP_OK) {
+    char logBuf[64];
+    snprintf(logBuf, sizeof(logBuf), "CRITICAL: Settings write failed (%s).", esp_err_to_name(err));
+    Esp32SessionHAL::getInstance().logKeyValue("Settings", logBuf);
+  }
+}
+
+// --- Change Tracking ---
+// Bumped by every setter so caches of reported settings (the /details
+// response) know to rebuild.
+static volatile uint32_t s_configGeneration = 1;
+
+uint32_t SettingsManager::getConfigGeneration() { return s_configGeneration; }
 
 // --- Safety Limits ---
 static const uint32_t ABS_MIN_PAYBACK = 1 * 60;
@@ -23,9 +181,35 @@ static const uint32_t ABS_MAX_PAYBACK = 720 * 60;
 static const uint32_t ABS_MIN_PENALTY = 1 * 60;
 static const uint32_t ABS_MAX_PENALTY = 360 * 60;
 
+static const uint32_t TIME_MOD_STEP_MIN = 60;
+static const uint32_t TIME_MOD_STEP_MAX = 3600;
+
 // Helper for logging via HAL
 void SettingsManager::log(const char *key, const char *val) { Esp32SessionHAL::getInstance().logKeyValue(key, val); }
 
+// Clamps to [min, max] and logs the outcome (shared by direct and transactional setters).
+static uint32_t clampSetting(uint32_t value, uint32_t min, uint32_t max, const char *label) {
+  uint32_t finalValue = value;
+  const char *note = "";
+
+  if (finalValue < min) {
+    finalValue = min;
+    note = " (Clamped Min)";
+  } else if (finalValue > max) {
+    finalValue = max;
+    note = " (Clamped Max)";
+  }
+
+  char logBuf[128];
+  if (value != finalValue) {
+    snprintf(logBuf, sizeof(logBuf), "%s: %u s%s (Req: %u)", label, finalValue, note, value);
+  } else {
+    snprintf(logBuf, sizeof(logBuf), "%s: %u s", label, finalValue);
+  }
+  Esp32SessionHAL::getInstance().logKeyValue("Settings", logBuf);
+  return finalValue;
+}
+
 // =================================================================================
 // SECTION: FACTORY RESET
 // =================================================================================
@@ -45,8 +229,12 @@ void SettingsManager::wipeAll() {
   bootPrefs.begin("boot", false);
   bootPrefs.clear();
   bootPrefs.end();
+  journalPrefs.begin("journal", false);
+  journalPrefs.clear();
+  journalPrefs.end();
 
   log("Settings", "Factory Wipe Complete.");
+  s_configGeneration++;
 }
 
 // =================================================================================
@@ -56,8 +244,10 @@ void SettingsManager::wipeAll() {
 void SettingsManager::setWifiSSID(const char *ssid) {
   wifiPrefs.begin("wifi-creds", false);
   wifiPrefs.putString("ssid", ssid);
+  wifiPrefs.remove(WIFI_CACHE_KEY); // Cached BSSID/lease belonged to the old network
   wifiPrefs.end();
   log("Settings", "SSID Updated");
+  s_configGeneration++;
 }
 
 void SettingsManager::setWifiPassword(const char *pass) {
@@ -65,6 +255,7 @@ void SettingsManager::setWifiPassword(const char *pass) {
   wifiPrefs.putString("pass", pass);
   wifiPrefs.end();
   log("Settings", "WiFi Password Updated");
+  s_configGeneration++;
 }
 
 void SettingsManager::getWifiSSID(char *buf, size_t maxLen) {
@@ -87,245 +278,525 @@ void SettingsManager::getWifiPassword(char *buf, size_t maxLen) {
   }
 }
 
+bool SettingsManager::getWifiConnectCache(WifiConnectCache &out) {
+  memset(&out, 0, sizeof(out));
+  wifiPrefs.begin("wifi-creds", true);
+  size_t len = wifiPrefs.getBytesLength(WIFI_CACHE_KEY);
+  if (len == sizeof(out))
+    wifiPrefs.getBytes(WIFI_CACHE_KEY, &out, sizeof(out));
+  wifiPrefs.end();
+
+  // A size mismatch is a layout from another build: ignore it
+  if (len != sizeof(out))
+    memset(&out, 0, sizeof(out));
+  return out.channel != 0;
+}
+
+void SettingsManager::setWifiConnectCache(const WifiConnectCache &cache) {
+  wifiPrefs.begin("wifi-creds", false);
+  wifiPrefs.putBytes(WIFI_CACHE_KEY, &cache, sizeof(cache));
+  wifiPrefs.end();
+}
+
+void SettingsManager::clearWifiConnectCache() {
+  wifiPrefs.begin("wifi-creds", false);
+  wifiPrefs.remove(WIFI_CACHE_KEY);
+  wifiPrefs.end();
+}
+
+bool SettingsManager::getWifiStaticIp(WifiStaticIp &out) {
+  memset(&out, 0, sizeof(out));
+  wifiPrefs.begin("wifi-creds", true);
+  if (wifiPrefs.getBytesLength(WIFI_STATIC_KEY) == sizeof(out))
+    wifiPrefs.getBytes(WIFI_STATIC_KEY, &out, sizeof(out));
+  wifiPrefs.end();
+  return out.ip != 0;
+}
+
+void SettingsManager::setWifiStaticIp(const WifiStaticIp &cfg) {
+  wifiPrefs.begin("wifi-creds", false);
+  if (cfg.ip != 0)
+    wifiPrefs.putBytes(WIFI_STATIC_KEY, &cfg, sizeof(cfg));
+  else
+    wifiPrefs.remove(WIFI_STATIC_KEY);
+  wifiPrefs.end();
+  log("Settings", cfg.ip != 0 ? "Static IP Updated" : "Static IP Cleared (DHCP)");
+  s_configGeneration++;
+}
+
 // =================================================================================
 // SECTION: FEATURES & PROVISIONING
 // =================================================================================
 
 void SettingsManager::setRewardCodeEnabled(bool enabled) {
-  provPrefs.begin("provisioning", false);
-  provPrefs.putBool("enableCode", enabled);
-  provPrefs.end();
+  updateSettings([&](DeterrentConfig &c, SessionPresets &, ChannelMask &) { c.enableRewardCode = enabled; });
   log("Settings", enabled ? "Reward Code: ENABLED" : "Reward Code: DISABLED");
+  s_configGeneration++;
 }
 
 void SettingsManager::setStreaksEnabled(bool enabled) {
-  provPrefs.begin("provisioning", false);
-  provPrefs.putBool("enableStreaks", enabled);
-  provPrefs.end();
+  updateSettings([&](DeterrentConfig &c, SessionPresets &, ChannelMask &) { c.enableStreaks = enabled; });
   log("Settings", enabled ? "Streaks: ENABLED" : "Streaks: DISABLED");
+  s_configGeneration++;
 }
 
 void SettingsManager::setPaybackEnabled(bool enabled) {
-  provPrefs.begin("provisioning", false);
-  provPrefs.putBool("enablePayback", enabled);
-  provPrefs.end();
+  updateSettings([&](DeterrentConfig &c, SessionPresets &, ChannelMask &) { c.enablePaybackTime = enabled; });
   log("Settings", enabled ? "Payback: ENABLED" : "Payback: DISABLED");
+  s_configGeneration++;
 }
 
 // --- Session Configuration ---
 
 void SettingsManager::setSessionLimits(uint32_t minDuration, uint32_t maxDuration) {
-  provPrefs.begin("provisioning", false);
-  provPrefs.putUInt("minSessionDur", minDuration);
-  provPrefs.putUInt("maxSessionDur", maxDuration);
-  provPrefs.end();
+  updateSettings([&](DeterrentConfig &, SessionPresets &p, ChannelMask &) {
+    p.minSessionDuration = minDuration;
+    p.maxSessionDuration = maxDuration;
+  });
 
   char logBuf[64];
   snprintf(logBuf, sizeof(logBuf), "Global Limits: %u - %u s", minDuration, maxDuration);
   log("Settings", logBuf);
+  s_configGeneration++;
 }
 
 void SettingsManager::setDurationPreset(DurationType type, uint32_t min, uint32_t max) {
-  provPrefs.begin("provisioning", false);
-  const char *keyMin = "";
-  const char *keyMax = "";
   const char *label = "";
 
   switch (type) {
   case DUR_RANGE_SHORT:
-    keyMin = "shMin";
-    keyMax = "shMax";
     label = "Short Preset";
     break;
   case DUR_RANGE_MEDIUM:
-    keyMin = "mdMin";
-    keyMax = "mdMax";
     label = "Medium Preset";
     break;
   case DUR_RANGE_LONG:
-    keyMin = "lgMin";
-    keyMax = "lgMax";
     label = "Long Preset";
     break;
   default:
-    provPrefs.end();
     return;
   }
 
-  provPrefs.putUInt(keyMin, min);
-  provPrefs.putUInt(keyMax, max);
-  provPrefs.end();
+  updateSettings([&](DeterrentConfig &, SessionPresets &p, ChannelMask &) {
+    if (type == DUR_RANGE_SHORT) {
+      p.shortMin = min;
+      p.shortMax = max;
+    } else if (type == DUR_RANGE_MEDIUM) {
+      p.mediumMin = min;
+      p.mediumMax = max;
+    } else {
+      p.longMin = min;
+      p.longMax = max;
+    }
+  });
 
   char logBuf[64];
   snprintf(logBuf, sizeof(logBuf), "%s: %u - %u s", label, min, max);
   log("Settings", logBuf);
+  s_configGeneration++;
 }
 
 // --- Deterrent Configuration ---
 
 void SettingsManager::setPaybackStrategy(DeterrentStrategy strategy) {
-  provPrefs.begin("provisioning", false);
-  provPrefs.putUChar("payStrat", (uint8_t)strategy);
-  provPrefs.end();
+  updateSettings([&](DeterrentConfig &c, SessionPresets &, ChannelMask &) { c.paybackTimeStrategy = strategy; });
   log("Settings", strategy == DETERRENT_RANDOM ? "Payback: RANDOM" : "Payback: FIXED");
+  s_configGeneration++;
 }
 
 void SettingsManager::setPaybackRange(uint32_t min, uint32_t max) {
-  provPrefs.begin("provisioning", false);
-  provPrefs.putUInt("payMin", min);
-  provPrefs.putUInt("payMax", max);
-  provPrefs.end();
+  updateSettings([&](DeterrentConfig &c, SessionPresets &, ChannelMask &) {
+    c.paybackTimeMin = min;
+    c.paybackTimeMax = max;
+  });
 
   char logBuf[64];
   snprintf(logBuf, sizeof(logBuf), "Payback Range: %u - %u s", min, max);
   log("Settings", logBuf);
+  s_configGeneration++;
 }
 
 void SettingsManager::setRewardStrategy(DeterrentStrategy strategy) {
-  provPrefs.begin("provisioning", false);
-  provPrefs.putUChar("rwdStrat", (uint8_t)strategy);
-  provPrefs.end();
+  updateSettings([&](DeterrentConfig &c, SessionPresets &, ChannelMask &) { c.rewardPenaltyStrategy = strategy; });
   log("Settings", strategy == DETERRENT_RANDOM ? "Reward Pen: RANDOM" : "Reward Pen: FIXED");
+  s_configGeneration++;
 }
 
 void SettingsManager::setRewardRange(uint32_t min, uint32_t max) {
-  provPrefs.begin("provisioning", false);
-  provPrefs.putUInt("penMin", min);
-  provPrefs.putUInt("penMax", max);
-  provPrefs.end();
+  updateSettings([&](DeterrentConfig &c, SessionPresets &, ChannelMask &) {
+    c.rewardPenaltyMin = min;
+    c.rewardPenaltyMax = max;
+  });
 
   char logBuf[64];
   snprintf(logBuf, sizeof(logBuf), "Reward Pen Range: %u - %u s", min, max);
   log("Settings", logBuf);
+  s_configGeneration++;
 }
 
 void SettingsManager::setTimeModificationEnabled(bool enabled) {
-  provPrefs.begin("provisioning", false);
-  provPrefs.putBool("enTimeMod", enabled);
-  provPrefs.end();
+  updateSettings([&](DeterrentConfig &c, SessionPresets &, ChannelMask &) { c.enableTimeModification = enabled; });
   log("Settings", enabled ? "Time Mod: ENABLED" : "Time Mod: DISABLED");
+  s_configGeneration++;
 }
 
 void SettingsManager::setTimeModificationStep(uint32_t seconds) {
   // Enforce a sanity limit (e.g., min 1 minute, max 1 hour)
-  uint32_t final = validateAndSave("timeModStep", seconds, 60, 3600, "Time Mod Step");
+  uint32_t final = clampSetting(seconds, TIME_MOD_STEP_MIN, TIME_MOD_STEP_MAX, "Time Mod Step");
+  updateSettings([&](DeterrentConfig &c, SessionPresets &, ChannelMask &) { c.timeModificationStep = final; });
+  s_configGeneration++;
 }
 
 // =================================================================================
 // SECTION: LOADER
 // =================================================================================
 
-void SettingsManager::loadProvisioningConfig(DeterrentConfig &config, SessionPresets &presets, uint8_t &channelMask) {
+void SettingsManager::loadProvisioningConfig(DeterrentConfig &config, SessionPresets &presets, ChannelMask &channelMask) {
   provPrefs.begin("provisioning", true);
 
-  // 1. Hardware Mask
-  channelMask = provPrefs.getUChar("chMask", 0x0F);
+  // The record holds the whole set; older firmware's per-key values are only a fallback
+  SettingsRecord rec;
+  bool fromRecord = provPrefs.getBytesLength(SETTINGS_RECORD_KEY) == sizeof(rec) &&
+                    provPrefs.getBytes(SETTINGS_RECORD_KEY, &rec, sizeof(rec)) == sizeof(rec) &&
+                    unpackSettings(rec, config, presets, channelMask);
+
+  if (!fromRecord) {
+    // 1. Hardware Mask
+    channelMask = readChannelMask(provPrefs);
+
+    // 2. Deterrent Config - Flags
+    config.enableStreaks = provPrefs.getBool("enableStreaks", config.enableStreaks);
+    config.enableRewardCode = provPrefs.getBool("enableCode", config.enableRewardCode);
+    config.enablePaybackTime = provPrefs.getBool("enablePayback", config.enablePaybackTime);
+
+    // 3. Deterrent Config - Strategies & Values
+    config.paybackTimeStrategy = (DeterrentStrategy)provPrefs.getUChar("payStrat", (uint8_t)DETERRENT_FIXED);
+    config.paybackTime = provPrefs.getUInt("paybackSeconds", config.paybackTime);
+    config.paybackTimeMin = provPrefs.getUInt("payMin", 300);
+    config.paybackTimeMax = provPrefs.getUInt("payMax", 900);
+
+    config.rewardPenaltyStrategy = (DeterrentStrategy)provPrefs.getUChar("rwdStrat", (uint8_t)DETERRENT_FIXED);
+    config.rewardPenalty = provPrefs.getUInt("rwdPenaltySec", config.rewardPenalty);
+    config.rewardPenaltyMin = provPrefs.getUInt("penMin", 300);
+    config.rewardPenaltyMax = provPrefs.getUInt("penMax", 1800);
+
+    config.enableTimeModification = provPrefs.getBool("enTimeMod", false);
+    config.timeModificationStep = provPrefs.getUInt("timeModStep", 300);
+
+    // 4. Session Presets - Generators
+    // Default values are provided if NVS is empty
+    presets.shortMin = provPrefs.getUInt("shMin", 300);  // 5m
+    presets.shortMax = provPrefs.getUInt("shMax", 1800); // 30m
+
+    presets.mediumMin = provPrefs.getUInt("mdMin", 1800); // 30m
+    presets.mediumMax = provPrefs.getUInt("mdMax", 7200); // 2h
+
+    presets.longMin = provPrefs.getUInt("lgMin", 7200);  // 2h
+    presets.longMax = provPrefs.getUInt("lgMax", 21600); // 6h
+
+    // 5. Session Presets - Global Safety Limits
+    presets.maxSessionDuration = provPrefs.getUInt("maxSessionDur", presets.maxSessionDuration);
+    presets.minSessionDuration = provPrefs.getUInt("minSessionDur", presets.minSessionDuration);
+  }
 
-  // 2. Deterrent Config - Flags
-  config.enableStreaks = provPrefs.getBool("enableStreaks", config.enableStreaks);
-  config.enableRewardCode = provPrefs.getBool("enableCode", config.enableRewardCode);
-  config.enablePaybackTime = provPrefs.getBool("enablePayback", config.enablePaybackTime);
+  // Sanity check to prevent logic errors in global limits
+  if (presets.maxSessionDuration < presets.minSessionDuration) {
+    presets.maxSessionDuration = presets.minSessionDuration;
+  }
 
-  // 3. Deterrent Config - Strategies & Values
-  config.paybackTimeStrategy = (DeterrentStrategy)provPrefs.getUChar("payStrat", (uint8_t)DETERRENT_FIXED);
-  config.paybackTime = provPrefs.getUInt("paybackSeconds", config.paybackTime);
-  config.paybackTimeMin = provPrefs.getUInt("payMin", 300);
-  config.paybackTimeMax = provPrefs.getUInt("payMax", 900);
+  provPrefs.end();
+}
 
-  config.rewardPenaltyStrategy = (DeterrentStrategy)provPrefs.getUChar("rwdStrat", (uint8_t)DETERRENT_FIXED);
-  config.rewardPenalty = provPrefs.getUInt("rwdPenaltySec", config.rewardPenalty);
-  config.rewardPenaltyMin = provPrefs.getUInt("penMin", 300);
-  config.rewardPenaltyMax = provPrefs.getUInt("penMax", 1800);
+// =================================================================================
+// SECTION: VALIDATED NUMERICS
+// =================================================================================
 
-  config.enableTimeModification = provPrefs.getBool("enTimeMod", false);
-  config.timeModificationStep = provPrefs.getUInt("timeModStep", 300);
+uint32_t SettingsManager::setPaybackDuration(uint32_t seconds) {
+  uint32_t finalValue = clampSetting(seconds, ABS_MIN_PAYBACK, ABS_MAX_PAYBACK, "Payback Time");
+  updateSettings([&](DeterrentConfig &c, SessionPresets &, ChannelMask &) { c.paybackTime = finalValue; });
+  s_configGeneration++;
+  return finalValue;
+}
 
-  // 4. Session Presets - Generators
-  // Default values are provided if NVS is empty
-  presets.shortMin = provPrefs.getUInt("shMin", 300);  // 5m
-  presets.shortMax = provPrefs.getUInt("shMax", 1800); // 30m
+uint32_t SettingsManager::setRewardPenaltyDuration(uint32_t seconds) {
+  uint32_t finalValue = clampSetting(seconds, ABS_MIN_PENALTY, ABS_MAX_PENALTY, "Reward Penalty");
+  updateSettings([&](DeterrentConfig &c, SessionPresets &, ChannelMask &) { c.rewardPenalty = finalValue; });
+  s_configGeneration++;
+  return finalValue;
+}
 
-  presets.mediumMin = provPrefs.getUInt("mdMin", 1800); // 30m
-  presets.mediumMax = provPrefs.getUInt("mdMax", 7200); // 2h
+// =================================================================================
+// SECTION: HARDWARE CONFIG
+// =================================================================================
 
-  presets.longMin = provPrefs.getUInt("lgMin", 7200);  // 2h
-  presets.longMax = provPrefs.getUInt("lgMax", 21600); // 6h
+void SettingsManager::setChannelEnabled(int channelIndex, bool enabled) {
+  if (channelIndex < 0 || channelIndex >= MAX_CHANNELS)
+    return;
 
-  // 5. Session Presets - Global Safety Limits
-  presets.maxSessionDuration = provPrefs.getUInt("maxSessionDur", presets.maxSessionDuration);
-  presets.minSessionDuration = provPrefs.getUInt("minSessionDur", presets.minSessionDuration);
+  ChannelMask currentMask = 0;
+  updateSettings([&](DeterrentConfig &, SessionPresets &, ChannelMask &mask) {
+    if (enabled)
+      mask |= (ChannelMask)(1u << channelIndex);
+    else
+      mask &= (ChannelMask)~(1u << channelIndex);
+    currentMask = mask;
+  });
 
-  // Sanity check to prevent logic errors in global limits
-  if (presets.maxSessionDuration < presets.minSessionDuration) {
-    presets.maxSessionDuration = presets.minSessionDuration;
+  Esp32SessionHAL::getInstance().setChannelMask(currentMask);
+
+  char logBuf[64];
+  snprintf(logBuf, sizeof(logBuf), "Ch%d Config: %s (Mask: 0x%02X)", channelIndex + 1, enabled ? "ENABLED" : "DISABLED", currentMask);
+  log("Settings", logBuf);
+  s_configGeneration++;
+}
+
+// =================================================================================
+// SECTION: UDP COMMAND CHANNEL
+// =================================================================================
+
+void SettingsManager::getUdpKey(uint8_t *key) {
+  wifiPrefs.begin("wifi-creds", false);
+  if (wifiPrefs.getBytesLength(UDP_KEY_KEY) == UDP_KEY_BYTES) {
+    wifiPrefs.getBytes(UDP_KEY_KEY, key, UDP_KEY_BYTES);
+  } else {
+    esp_fill_random(key, UDP_KEY_BYTES);
+    wifiPrefs.putBytes(UDP_KEY_KEY, key, UDP_KEY_BYTES);
+    log("Settings", "Generated UDP command key.");
   }
+  wifiPrefs.end();
+}
 
-  provPrefs.end();
+void SettingsManager::resetUdpKey(uint8_t *key) {
+  esp_fill_random(key, UDP_KEY_BYTES);
+  wifiPrefs.begin("wifi-creds", false);
+  wifiPrefs.putBytes(UDP_KEY_KEY, key, UDP_KEY_BYTES);
+  wifiPrefs.end();
+  log("Settings", "Replaced UDP command key.");
 }
 
 // =================================================================================
-// SECTION: VALIDATED NUMERICS
+// SECTION: TRANSACTIONS
 // =================================================================================
 
-uint32_t SettingsManager::validateAndSave(const char *key, uint32_t value, uint32_t min, uint32_t max, const char *label) {
-  uint32_t finalValue = value;
-  const char *note = "";
+// Staged-change bits. Credentials are separate keys; any staged setting
+// rewrites the whole settings record.
+enum : uint32_t {
+  TXN_SSID = 1u << 0,
+  TXN_PASS = 1u << 1,
+  TXN_STATIC_IP = 1u << 2,
+  TXN_SETTINGS = 1u << 3,
+};
+static const uint32_t TXN_WIFI = TXN_SSID | TXN_PASS | TXN_STATIC_IP;
+
+SettingsTransaction::SettingsTransaction() : _config(), _presets(), _channelMask(CHANNEL_MASK_ALL), _dirty(0) {
+  SettingsManager::loadProvisioningConfig(_config, _presets, _channelMask);
+  _baseConfig = _config;
+  _basePresets = _presets;
+  _baseChannelMask = _channelMask;
+  _ssid[0] = '\0';
+  _pass[0] = '\0';
+  memset(&_staticIp, 0, sizeof(_staticIp));
+}
 
-  if (finalValue < min) {
-    finalValue = min;
-    note = " (Clamped Min)";
-  } else if (finalValue > max) {
-    finalValue = max;
-    note = " (Clamped Max)";
-  }
+void SettingsTransaction::setWifiSSID(const char *ssid) {
+  strncpy(_ssid, ssid, sizeof(_ssid) - 1);
+  _ssid[sizeof(_ssid) - 1] = '\0';
+  _dirty |= TXN_SSID;
+}
 
-  provPrefs.begin("provisioning", false);
-  provPrefs.putUInt(key, finalValue);
-  provPrefs.end();
+void SettingsTransaction::setWifiPassword(const char *pass) {
+  strncpy(_pass, pass, sizeof(_pass) - 1);
+  _pass[sizeof(_pass) - 1] = '\0';
+  _dirty |= TXN_PASS;
+}
 
-  char logBuf[128];
-  if (value != finalValue) {
-    snprintf(logBuf, sizeof(logBuf), "%s: %u s%s (Req: %u)", label, finalValue, note, value);
-  } else {
-    snprintf(logBuf, sizeof(logBuf), "%s: %u s", label, finalValue);
+void SettingsTransaction::setWifiStaticIp(const WifiStaticIp &cfg) {
+  _staticIp = cfg;
+  _dirty |= TXN_STATIC_IP;
+}
+
+void SettingsTransaction::setRewardCodeEnabled(bool enabled) {
+  _config.enableRewardCode = enabled;
+  _dirty |= TXN_SETTINGS;
+}
+
+void SettingsTransaction::setStreaksEnabled(bool enabled) {
+  _config.enableStreaks = enabled;
+  _dirty |= TXN_SETTINGS;
+}
+
+void SettingsTransaction::setPaybackEnabled(bool enabled) {
+  _config.enablePaybackTime = enabled;
+  _dirty |= TXN_SETTINGS;
+}
+
+void SettingsTransaction::setSessionLimits(uint32_t minDuration, uint32_t maxDuration) {
+  _presets.minSessionDuration = minDuration;
+  _presets.maxSessionDuration = maxDuration;
+  _dirty |= TXN_SETTINGS;
+}
+
+void SettingsTransaction::setDurationPreset(DurationType type, uint32_t min, uint32_t max) {
+  switch (type) {
+  case DUR_RANGE_SHORT:
+    _presets.shortMin = min;
+    _presets.shortMax = max;
+    _dirty |= TXN_SETTINGS;
+    break;
+  case DUR_RANGE_MEDIUM:
+    _presets.mediumMin = min;
+    _presets.mediumMax = max;
+    _dirty |= TXN_SETTINGS;
+    break;
+  case DUR_RANGE_LONG:
+    _presets.longMin = min;
+    _presets.longMax = max;
+    _dirty |= TXN_SETTINGS;
+    break;
+  default:
+    break;
   }
-  log("Settings", logBuf);
+}
 
-  return finalValue;
+void SettingsTransaction::setPaybackStrategy(DeterrentStrategy strategy) {
+  _config.paybackTimeStrategy = strategy;
+  _dirty |= TXN_SETTINGS;
 }
 
-uint32_t SettingsManager::setPaybackDuration(uint32_t seconds) {
-  return validateAndSave("paybackSeconds", seconds, ABS_MIN_PAYBACK, ABS_MAX_PAYBACK, "Payback Time");
+void SettingsTransaction::setPaybackRange(uint32_t min, uint32_t max) {
+  _config.paybackTimeMin = min;
+  _config.paybackTimeMax = max;
+  _dirty |= TXN_SETTINGS;
 }
 
-uint32_t SettingsManager::setRewardPenaltyDuration(uint32_t seconds) {
-  return validateAndSave("rwdPenaltySec", seconds, ABS_MIN_PENALTY, ABS_MAX_PENALTY, "Reward Penalty");
+void SettingsTransaction::setRewardStrategy(DeterrentStrategy strategy) {
+  _config.rewardPenaltyStrategy = strategy;
+  _dirty |= TXN_SETTINGS;
 }
 
-// =================================================================================
-// SECTION: HARDWARE CONFIG
-// =================================================================================
+void SettingsTransaction::setRewardRange(uint32_t min, uint32_t max) {
+  _config.rewardPenaltyMin = min;
+  _config.rewardPenaltyMax = max;
+  _dirty |= TXN_SETTINGS;
+}
 
-void SettingsManager::setChannelEnabled(int channelIndex, bool enabled) {
-  if (channelIndex < 0 || channelIndex >= 4)
-    return;
+void SettingsTransaction::setTimeModificationEnabled(bool enabled) {
+  _config.enableTimeModification = enabled;
+  _dirty |= TXN_SETTINGS;
+}
 
-  provPrefs.begin("provisioning", false);
-  uint8_t currentMask = provPrefs.getUChar("chMask", 0x0F);
+uint32_t SettingsTransaction::setTimeModificationStep(uint32_t seconds) {
+  _config.timeModificationStep = clampSetting(seconds, TIME_MOD_STEP_MIN, TIME_MOD_STEP_MAX, "Time Mod Step");
+  _dirty |= TXN_SETTINGS;
+  return _config.timeModificationStep;
+}
+
+uint32_t SettingsTransaction::setPaybackDuration(uint32_t seconds) {
+  _config.paybackTime = clampSetting(seconds, ABS_MIN_PAYBACK, ABS_MAX_PAYBACK, "Payback Time");
+  _dirty |= TXN_SETTINGS;
+  return _config.paybackTime;
+}
+
+uint32_t SettingsTransaction::setRewardPenaltyDuration(uint32_t seconds) {
+  _config.rewardPenalty = clampSetting(seconds, ABS_MIN_PENALTY, ABS_MAX_PENALTY, "Reward Penalty");
+  _dirty |= TXN_SETTINGS;
+  return _config.rewardPenalty;
+}
 
+void SettingsTransaction::setChannelEnabled(int channelIndex, bool enabled) {
+  if (channelIndex < 0 || channelIndex >= MAX_CHANNELS)
+    return;
   if (enabled)
-    currentMask |= (1 << channelIndex);
+    _channelMask |= (ChannelMask)(1u << channelIndex);
   else
-    currentMask &= ~(1 << channelIndex);
+    _channelMask &= (ChannelMask)~(1u << channelIndex);
+  _dirty |= TXN_SETTINGS;
+}
 
-  provPrefs.putUChar("chMask", currentMask);
-  provPrefs.end();
+void SettingsTransaction::discardSettings() {
+  _config = _baseConfig;
+  _presets = _basePresets;
+  _channelMask = _baseChannelMask;
+  _dirty &= TXN_WIFI;
+}
 
-  Esp32SessionHAL::getInstance().setChannelMask(currentMask);
+bool SettingsTransaction::commit() {
+  if (_dirty == 0)
+    return true;
 
-  char logBuf[64];
-  snprintf(logBuf, sizeof(logBuf), "Ch%d Config: %s (Mask: 0x%02X)", channelIndex + 1, enabled ? "ENABLED" : "DISABLED", currentMask);
-  log("Settings", logBuf);
+  // 1. Validate the staged set as a whole; nothing is written on failure
+  if ((_dirty & TXN_SETTINGS) && !SessionEngine::validateConfig(_config, _presets)) {
+    SettingsManager::log("Settings", "Transaction rejected: staged configuration is invalid.");
+    return false;
+  }
+
+  int64_t startUs = esp_timer_get_time();
+  esp_err_t err = ESP_OK;
+  bool settingsStored = false;
+  char logBuf[96];
+
+  // 2. Settings: the whole set as one record, replaced in a single write
+  if (_dirty & TXN_SETTINGS) {
+    err = storeSettings(_config, _presets, _channelMask);
+    if (err != ESP_OK) {
+      snprintf(logBuf, sizeof(logBuf), "CRITICAL: Settings write failed (%s). Nothing changed.", esp_err_to_name(err));
+      SettingsManager::log("Settings", logBuf);
+      return false;
+    }
+    if (_channelMask != _baseChannelMask)
+      Esp32SessionHAL::getInstance().setChannelMask(_channelMask);
+    _baseConfig = _config;
+    _basePresets = _presets;
+    _baseChannelMask = _channelMask;
+    _dirty &= ~TXN_SETTINGS;
+    settingsStored = true;
+    s_configGeneration++;
+  }
+
+  // 3. Credentials, only once the settings are stored: one handle, one commit
+  int keys = 0;
+  if (_dirty & TXN_WIFI) {
+    nvs_handle_t h;
+    err = nvs_open("wifi-creds", NVS_READWRITE, &h);
+    if (err == ESP_OK) {
+      if (_dirty & TXN_SSID) {
+        err = nvs_set_str(h, "ssid", _ssid);
+        keys++;
+      }
+      if ((_dirty & TXN_PASS) && err == ESP_OK) {
+        err = nvs_set_str(h, "pass", _pass);
+        keys++;
+      }
+      if ((_dirty & TXN_STATIC_IP) && err == ESP_OK) {
+        err = _staticIp.ip != 0 ? nvs_set_blob(h, WIFI_STATIC_KEY, &_staticIp, sizeof(_staticIp)) : nvs_erase_key(h, WIFI_STATIC_KEY);
+        if (err == ESP_ERR_NVS_NOT_FOUND)
+          err = ESP_OK;
+        keys++;
+      }
+      // Cached BSSID/lease belonged to the old network
+      if ((_dirty & TXN_SSID) && err == ESP_OK) {
+        err = nvs_erase_key(h, WIFI_CACHE_KEY);
+        if (err == ESP_ERR_NVS_NOT_FOUND)
+          err = ESP_OK;
+      }
+      if (err == ESP_OK)
+        err = nvs_commit(h);
+      nvs_close(h);
+    }
+    if (err != ESP_OK) {
+      // Keys written before the failing one keep their new values (see SettingsTransaction)
+      snprintf(logBuf, sizeof(logBuf), "CRITICAL: Credential write failed (%s).", esp_err_to_name(err));
+      SettingsManager::log("Settings", logBuf);
+      return false;
+    }
+    _dirty = 0;
+    s_configGeneration++;
+  }
+
+  snprintf(logBuf, sizeof(logBuf), "Transaction committed: %s%d credential keys in %u us", settingsStored ? "settings record, " : "",
+           keys, (unsigned)(esp_timer_get_time() - startUs));
+  SettingsManager::log("Settings", logBuf);
+  return true;
 }
 
 // =================================================================================
@@ -334,59 +805,140 @@ void SettingsManager::setChannelEnabled(int channelIndex, bool enabled) {
 
 void SettingsManager::saveSessionState(const DeviceState &state, const SessionTimers &timers, const SessionStats &stats,
                                        const SessionConfig &config) {
+  PERF_PROBE(PROBE_SAVE_STATE);
+  int64_t startUs = esp_timer_get_time();
+
+  SessionRecord rec;
+  SessionRecordCodec::encode(state, timers, stats, config, s_persistStats.sequence + 1, rec);
+
+  // Single blob write: one NVS entry update instead of ~25 separate keys.
   sessionConfig.begin("session", false);
+  size_t written = sessionConfig.putBytes(SESSION_RECORD_KEY, &rec, sizeof(rec));
+  sessionConfig.end();
 
-  // 1. Save Device State
-  sessionConfig.putUChar("state", (uint8_t)state);
+  uint32_t elapsedUs = (uint32_t)(esp_timer_get_time() - startUs);
 
-  // 2. Save SessionTimers
-  sessionConfig.putULong("t_lockDur", timers.lockDuration);
-  sessionConfig.putULong("t_penDur", timers.penaltyDuration);
-  sessionConfig.putULong("t_lockRem", timers.lockRemaining);
-  sessionConfig.putULong("t_penRem", timers.penaltyRemaining);
-  sessionConfig.putULong("t_testRem", timers.testRemaining);
-  sessionConfig.putULong("t_trigOut", timers.triggerTimeout);
+  if (written != sizeof(rec)) {
+    s_persistStats.failedSaves++;
+    log("Settings", "CRITICAL: Session record write failed.");
+    return;
+  }
 
-  // Timer Channel Delays
-  char keyBuf[16];
-  for (int i = 0; i < MAX_CHANNELS; i++) {
-    snprintf(keyBuf, sizeof(keyBuf), "t_delay%d", i);
-    sessionConfig.putULong(keyBuf, timers.channelDelays[i]);
+  s_persistStats.sequence = rec.sequence;
+  s_persistStats.saves++;
+  s_persistStats.lastSaveUs = elapsedUs;
+  if (elapsedUs > s_persistStats.maxSaveUs)
+    s_persistStats.maxSaveUs = elapsedUs;
+}
+
+bool SettingsManager::loadSessionState(DeviceState &state, SessionTimers &timers, SessionStats &stats, SessionConfig &config) {
+  int64_t startUs = esp_timer_get_time();
+  bool loaded = false;
+
+  sessionConfig.begin("session", false);
+
+  // 1. Current format: single CRC-checked blob
+  if (sessionConfig.isKey(SESSION_RECORD_KEY)) {
+    SessionRecord rec;
+    size_t len = sessionConfig.getBytesLength(SESSION_RECORD_KEY);
+    if (len == sizeof(rec) && sessionConfig.getBytes(SESSION_RECORD_KEY, &rec, sizeof(rec)) == sizeof(rec)) {
+      loaded = SessionRecordCodec::decode((const uint8_t *)&rec, sizeof(rec), state, timers, stats, config, &s_persistStats.sequence);
+    }
+    if (loaded) {
+      s_persistStats.format = "record";
+    } else {
+      log("Settings", "Session record invalid (CRC/Version). Trying legacy keys.");
+    }
   }
 
-  // 3. Save SessionStats
-  sessionConfig.putULong("s_streaks", stats.streaks);
-  sessionConfig.putULong("s_compl", stats.completed);
-  sessionConfig.putULong("s_abort", stats.aborted);
-  sessionConfig.putULong("s_payback", stats.paybackAccumulated);
-  sessionConfig.putULong("s_total", stats.totalLockedTime);
-
-  // 4. Save SessionConfig
-  sessionConfig.putUChar("c_durType", (uint8_t)config.durationType);
-  sessionConfig.putULong("c_durFix", config.durationFixed);
-  sessionConfig.putULong("c_durMin", config.durationMin);
-  sessionConfig.putULong("c_durMax", config.durationMax);
-  sessionConfig.putUChar("c_trigStrat", (uint8_t)config.triggerStrategy);
-  sessionConfig.putBool("c_hideTmr", config.hideTimer);
-  sessionConfig.putBool("c_disLED", config.disableLED);
-
-  // Config Channel Delays
-  for (int i = 0; i < MAX_CHANNELS; i++) {
-    snprintf(keyBuf, sizeof(keyBuf), "c_delay%d", i);
-    sessionConfig.putULong(keyBuf, config.channelDelays[i]);
+  // 2. Migration path: legacy per-key layout (pre-record firmware)
+  if (!loaded && sessionConfig.isKey("state")) {
+    loadLegacySessionState(state, timers, stats, config);
+    loaded = true;
+    s_persistStats.format = "legacy";
   }
 
   sessionConfig.end();
-}
 
-bool SettingsManager::loadSessionState(DeviceState &state, SessionTimers &timers, SessionStats &stats, SessionConfig &config) {
-  sessionConfig.begin("session", true);
+  // 3. Overlay the newest checkpoint taken since that record was written.
+  // Legacy data predates the journal, so there is nothing to extend.
+  if (loaded && strcmp(s_persistStats.format, "record") == 0) {
+    s_journalStats.restoredAtBoot = applyNewestCheckpoint(state, timers, stats);
+  }
+
+  s_persistStats.bootLoadUs = (uint32_t)(esp_timer_get_time() - startUs);
 
-  if (!sessionConfig.isKey("state")) {
+  if (loaded && strcmp(s_persistStats.format, "legacy") == 0) {
+    // Re-write as a record and drop the old keys so the next boot takes the fast path.
+    log("Settings", "Migrating legacy session keys to record format...");
+    sessionConfig.begin("session", false);
+    sessionConfig.clear();
     sessionConfig.end();
-    return false;
+    saveSessionState(state, timers, stats, config);
   }
 
+  char logBuf[96];
+  snprintf(logBuf, sizeof(logBuf), "Session load: %s%s in %u us", loaded ? s_persistStats.format : "none",
+           s_journalStats.restoredAtBoot ? " + checkpoint" : "", s_persistStats.bootLoadUs);
+  log("Settings", logBuf);
+
+  return loaded;
+}
+
+// =================================================================================
+// SECTION: CHECKPOINT JOURNAL
+// =================================================================================
+
+void SettingsManager::saveCheckpoint(const DeviceState &state, const SessionTimers &timers, const SessionStats &stats) {
+  PERF_PROBE(PROBE_SAVE_CHECKPOINT);
+  CheckpointSlot slot;
+  CheckpointJournal::encode(state, timers, stats, s_journalStats.sequence + 1, s_persistStats.sequence, slot);
+
+  char key[8];
+  journalKey(CheckpointJournal::slotIndex(slot.sequence), key, sizeof(key));
+
+  journalPrefs.begin("journal", false);
+  size_t written = journalPrefs.putBytes(key, &slot, sizeof(slot));
+  journalPrefs.end();
+
+  if (written != sizeof(slot)) {
+    s_journalStats.failedWrites++;
+    log("Settings", "Checkpoint write failed.");
+    return;
+  }
+
+  s_journalStats.sequence = slot.sequence;
+  s_journalStats.writes++;
+  s_journalStats.bytesWritten += sizeof(slot);
+}
+
+// Reads every slot, resumes the journal sequence and overlays the newest
+// checkpoint that extends the record just loaded.
+bool SettingsManager::applyNewestCheckpoint(DeviceState state, SessionTimers &timers, SessionStats &stats) {
+  CheckpointSlot slots[CHECKPOINT_SLOTS];
+  memset(slots, 0, sizeof(slots));
+
+  char key[8];
+  journalPrefs.begin("journal", true);
+  for (int i = 0; i < CHECKPOINT_SLOTS; i++) {
+    journalKey(i, key, sizeof(key));
+    if (journalPrefs.getBytesLength(key) == sizeof(CheckpointSlot))
+      journalPrefs.getBytes(key, &slots[i], sizeof(CheckpointSlot));
+  }
+  journalPrefs.end();
+
+  int newest = CheckpointJournal::findNewest(slots, CHECKPOINT_SLOTS);
+  if (newest < 0)
+    return false;
+
+  s_journalStats.sequence = slots[newest].sequence;
+  return CheckpointJournal::apply(slots[newest], s_persistStats.sequence, state, timers, stats);
+}
+
+const JournalStats &SettingsManager::getJournalStats() { return s_journalStats; }
+
+// Reads the pre-record layout. Caller owns the open "session" namespace.
+void SettingsManager::loadLegacySessionState(DeviceState &state, SessionTimers &timers, SessionStats &stats, SessionConfig &config) {
   // 1. Load Device State
   state = (DeviceState)sessionConfig.getUChar("state", (uint8_t)READY);
 
@@ -424,11 +976,10 @@ bool SettingsManager::loadSessionState(DeviceState &state, SessionTimers &timers
     snprintf(keyBuf, sizeof(keyBuf), "c_delay%d", i);
     config.channelDelays[i] = sessionConfig.getULong(keyBuf, 0);
   }
-
-  sessionConfig.end();
-  return true;
 }
 
+const PersistenceStats &SettingsManager::getPersistenceStats() { return s_persistStats; }
+
 // =================================================================================
 // SECTION: BOOT DIAGNOSTICS
 // =================================================================================
@@ -0,0 +1,164 @@
+/*
+ * =================================================================================
+ * Project:   Lobster Lock - Self-Bondage Session Manager
+ * File:      src/UdpCommand.cpp
+ *
+ * Description:
+ * UDP command channel. Handlers run in the AsyncUDP task; a keep-alive is
+ * one SipHash verify, one replay-window lookup and a short engine lock.
+ * =================================================================================
+ */
+#include <Arduino.h>
+#include <esp_timer.h>
+
+#include "EngineTracing.h"
+#include "Esp32SessionHAL.h"
+#include "PerfProbes.h"
+#include "SettingsManager.h"
+#include "UdpCommand.h"
+
+// =================================================================================
+// SECTION: SINGLETON & INIT
+// =================================================================================
+
+UdpCommandServer &UdpCommandServer::getInstance() {
+  static UdpCommandServer instance;
+  return instance;
+}
+
+static portMUX_TYPE s_keyMux = portMUX_INITIALIZER_UNLOCKED;
+
+UdpCommandServer::UdpCommandServer() : _engine(nullptr), _pairingUntilUs(0), _bootNonce(0) {
+  memset(_key, 0, sizeof(_key));
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+void UdpCommandServer::begin(SessionEngine *engine) {
+  _engine = engine;
+  SettingsManager::getUdpKey(_key);
+  _pairingUntilUs = esp_timer_get_time() + (int64_t)UDP_PAIRING_WINDOW_MS * 1000;
+
+  // Fresh every boot: datagrams captured before a reboot are never valid again
+  do {
+    _bootNonce = esp_random();
+  } while (_bootNonce == 0);
+
+  if (!_udp.listen(UDP_COMMAND_PORT)) {
+    Esp32SessionHAL::getInstance().logKeyValue("UDP", "Failed to open command port!");
+    return;
+  }
+  _udp.onPacket([this](AsyncUDPPacket packet) { handlePacket(packet); });
+
+  char logBuf[48];
+  snprintf(logBuf, sizeof(logBuf), "Command channel on port %d.", UDP_COMMAND_PORT);
+  Esp32SessionHAL::getInstance().logKeyValue("UDP", logBuf);
+}
+
+bool UdpCommandServer::isPairingOpen() const { return esp_timer_get_time() < _pairingUntilUs; }
+
+void UdpCommandServer::copyKey(uint8_t *out) const {
+  portENTER_CRITICAL(&s_keyMux);
+  memcpy(out, _key, UDP_KEY_SIZE);
+  portEXIT_CRITICAL(&s_keyMux);
+}
+
+void UdpCommandServer::resetKey() {
+  uint8_t key[UDP_KEY_SIZE];
+  SettingsManager::resetUdpKey(key);
+  portENTER_CRITICAL(&s_keyMux);
+  memcpy(_key, key, UDP_KEY_SIZE);
+  portEXIT_CRITICAL(&s_keyMux);
+  _pairingUntilUs = esp_timer_get_time() + (int64_t)UDP_PAIRING_WINDOW_MS * 1000;
+}
+
+// =================================================================================
+// SECTION: PACKET HANDLING
+// =================================================================================
+
+void UdpCommandServer::handlePacket(AsyncUDPPacket &packet) {
+  PERF_PROBE(PROBE_UDP_PACKET);
+  int64_t startUs = esp_timer_get_time();
+  _stats.received++;
+
+  // 1. Authenticate. Anything unauthenticated is dropped silently (no reflection)
+  uint8_t key[UDP_KEY_SIZE];
+  copyKey(key);
+  UdpRequest req;
+  UdpDecodeResult decoded = UdpProtocol::decodeRequest(key, packet.data(), packet.length(), req);
+  if (decoded != UDP_DECODE_OK) {
+    if (decoded == UDP_DECODE_BAD_TAG)
+      _stats.badTag++;
+    else
+      _stats.malformed++;
+    return;
+  }
+
+  // 2. Freshness, then the command itself
+  uint8_t result;
+  if (req.bootNonce != _bootNonce) {
+    result = UDP_RESULT_NONCE;
+    _stats.replays++;
+  } else if (!_replay.accept(req.clientId, req.seq)) {
+    result = UDP_RESULT_REPLAY;
+    _stats.replays++;
+  } else {
+    result = execute(req);
+  }
+
+  // 3. Reply with the current digest (signed, so clients can trust the nonce)
+  UdpResponse res;
+  res.opcode = req.opcode;
+  res.result = result;
+  res.bootNonce = _bootNonce;
+  res.clientId = req.clientId;
+  res.seq = req.seq;
+  fillDigest(res.digest);
+
+  uint8_t out[UDP_RESPONSE_SIZE];
+  size_t len = UdpProtocol::encodeResponse(key, res, out, sizeof(out));
+  packet.write(out, len);
+
+  uint32_t us = (uint32_t)(esp_timer_get_time() - startUs);
+  if (us > _stats.maxHandlerUs)
+    _stats.maxHandlerUs = us;
+}
+
+uint8_t UdpCommandServer::execute(const UdpRequest &req) {
+  if (req.opcode == UDP_OP_STATUS)
+    return UDP_RESULT_OK; // Digest only, no lock needed
+
+  if (req.opcode != UDP_OP_KEEPALIVE && req.opcode != UDP_OP_ABORT)
+    return UDP_RESULT_UNKNOWN_OP;
+
+  Esp32SessionHAL &hal = Esp32SessionHAL::getInstance();
+  if (!hal.lockState(UDP_LOCK_TIMEOUT_MS)) {
+    _stats.busy++;
+    return UDP_RESULT_BUSY;
+  }
+
+  if (req.opcode == UDP_OP_KEEPALIVE) {
+    TRACE_CALL(TRACE_CALL_PET);
+    _engine->petWatchdog();
+    _stats.keepAlives++;
+  } else {
+    TRACE_CALL(TRACE_CALL_ABORT);
+    _engine->abort("UDP Request");
+    _stats.aborts++;
+  }
+  hal.unlockState();
+  return UDP_RESULT_OK;
+}
+
+// From the engine's lock-free snapshot, same source as /status
+void UdpCommandServer::fillDigest(UdpDigest &digest) {
+  memset(&digest, 0, sizeof(digest));
+  EngineSnapshot es;
+  if (_engine == nullptr || !_engine->readSnapshot(es))
+    return;
+
+  digest.state = (uint8_t)es.state;
+  digest.outcome = (uint8_t)es.outcome;
+  digest.generation = es.generation;
+  digest.lockRemaining = es.timers.lockRemaining;
+  digest.penaltyRemaining = es.timers.penaltyRemaining;
+}
@@ -11,11 +11,19 @@
 #include <ArduinoJson.h>
 #include <WiFi.h>
 #include <esp_timer.h> // For uptime
+#include <memory>
 #include <string.h>
 
+#include "CheckpointJournal.h"
 #include "Config.h"
+#include "EngineTracing.h"
 #include "Esp32SessionHAL.h"
+#include "HistoryStore.h"
+#include "LogicUtils.h"
+#include "Network.h"
+#include "PerfProbes.h"
 #include "SettingsManager.h"
+#include "UdpCommand.h"
 #include "WebManager.h"
 #include "WebValidators.h"
 
@@ -28,7 +36,18 @@ WebManager &WebManager::getInstance() {
   return instance;
 }
 
-WebManager::WebManager() : _server(80), _engine(nullptr) {}
+WebManager::WebManager()
+    : _server(80), _events("/events"), _engine(nullptr), _eventsNeedSnapshot(false), _eventId(0), _detailsCached(false),
+      _detailsConfigGen(0), _detailsNetworkGen(0), _detailsChannelMask(0),
+      _admission(
+          {ADMISSION_BURST, ADMISSION_RATE_PER_SEC, ADMISSION_HEAVY_COST, ADMISSION_HEAVY_MAX_IN_FLIGHT, ADMISSION_HEAVY_MAX_WAIT_MS}) {
+  for (PendingBody &p : _pendingBodies) {
+    p.owner = nullptr;
+    p.arena = nullptr;
+  }
+  for (DeferredRequest &d : _deferred)
+    d.request = nullptr;
+}
 
 void WebManager::begin(SessionEngine *engine) {
   _engine = engine;
@@ -43,13 +62,273 @@ void WebManager::log(const char *key, const char *value) { Esp32SessionHAL::getI
 // SECTION: HELPER FUNCTIONS
 // =================================================================================
 
+// Image section bounds from the ESP32 linker script (for /details "memory")
+extern "C" char _bss_start, _bss_end, _data_start, _data_end;
+
+// Sent from flash when no arena is free (or a document outgrew one).
+static const char ARENA_BUSY_JSON[] = "{\"status\":\"error\",\"message\":\"Server busy, retry.\"}";
+
+/**
+ * Leases one response arena for the lifetime of a handler and exposes it as an
+ * ArduinoJson allocator. Declare it before the JsonDocument that uses it, so
+ * the document is destroyed (and stops touching the arena) first.
+ */
+class JsonArenaLease : public ArduinoJson::Allocator {
+public:
+  explicit JsonArenaLease(JsonArenaPool &pool) : _pool(pool), _arena(pool.acquire()) {}
+  // Takes over an arena already leased from 'pool' (see collectBody), or leases one if nullptr
+  JsonArenaLease(JsonArenaPool &pool, FixedArena *adopted) : _pool(pool), _arena(adopted ? adopted : pool.acquire()) {}
+  ~JsonArenaLease() {
+    if (_arena)
+      _pool.release(_arena);
+  }
+
+  bool ok() const { return _arena != nullptr; }
+  FixedArena &arena() { return *_arena; }
+
+  void *allocate(size_t size) override { return _arena ? _arena->allocate(size) : nullptr; }
+  void deallocate(void *ptr) override {
+    if (_arena)
+      _arena->deallocate(ptr);
+  }
+  void *reallocate(void *ptr, size_t size) override { return _arena ? _arena->reallocate(ptr, size) : nullptr; }
+
+private:
+  JsonArenaPool &_pool;
+  FixedArena *_arena;
+};
+
+void WebManager::sendArenaBusy(AsyncWebServerRequest *request) {
+  request->send(503, "application/json", (const uint8_t *)ARENA_BUSY_JSON, sizeof(ARENA_BUSY_JSON) - 1);
+}
+
+// Streams the document straight into the response (no intermediate String).
+void WebManager::sendJson(AsyncWebServerRequest *request, int code, JsonDocument &doc) {
+  if (doc.overflowed()) {
+    sendArenaBusy(request);
+    return;
+  }
+  AsyncResponseStream *response = request->beginResponseStream("application/json");
+  response->setCode(code);
+  serializeJson(doc, *response);
+  request->send(response);
+}
+
+// Admission rejections, also from flash (a flooding client must not cost an arena).
+static const char RATE_LIMITED_JSON[] = "{\"status\":\"error\",\"message\":\"Too many requests, slow down.\"}";
+static const char HEAVY_BUSY_JSON[] = "{\"status\":\"error\",\"message\":\"Too many large responses in progress, retry.\"}";
+
+/**
+ * Admission control. Runs in the async_tcp task, like every handler and the
+ * disconnect callback, so the controller needs no lock. A heavy request keeps
+ * its slot until the connection closes, i.e. until the response is sent.
+ * Rejections carry Retry-After (whole seconds).
+ *
+ * Heavy routes go through admittedHeavy(): over the cap the request is parked
+ * in _deferred (no response yet) and runs from releaseHeavy() when a slot
+ * frees. Waits are checked against ADMISSION_HEAVY_MAX_WAIT_MS whenever a heavy
+ * request arrives or finishes; since a slot only frees when its response is
+ * done, no waiter is stuck past the slowest heavy response in flight.
+ */
+static uint32_t clientAddress(AsyncWebServerRequest *request) {
+  return request->client() ? (uint32_t)request->client()->remoteIP() : 0;
+}
+
+bool WebManager::admit(AsyncWebServerRequest *request, AdmitLane lane) {
+  AdmitResult result = _admission.admit(clientAddress(request), lane, millis());
+  if (result == ADMIT_OK) {
+    if (lane == ADMIT_HEAVY)
+      request->onDisconnect([this]() { releaseHeavy(); });
+    return true;
+  }
+  sendAdmissionRejection(request, result);
+  return false;
+}
+
+// Charges a request admitted on ADMIT_NORMAL for what its body turned out to cost (see AdmissionController::settle)
+bool WebManager::settle(AsyncWebServerRequest *request, uint32_t cost) {
+  AdmitResult result = _admission.settle(clientAddress(request), cost, millis());
+  if (result == ADMIT_OK)
+    return true;
+  sendAdmissionRejection(request, result);
+  return false;
+}
+
+ArRequestHandlerFunction WebManager::admittedHeavy(HeavyHandler handler) {
+  return [this, handler](AsyncWebServerRequest *request) {
+    expireDeferred();
+    DeferredRequest *slot = nullptr;
+    for (DeferredRequest &d : _deferred) {
+      if (d.request == nullptr) {
+        slot = &d;
+        break;
+      }
+    }
+
+    AdmitResult result = _admission.admit(clientAddress(request), ADMIT_HEAVY, millis(), slot);
+    if (result == ADMIT_QUEUED) {
+      slot->request = request;
+      slot->handler = handler;
+      // A stale callback (the request was run or expired since) finds another request in the slot
+      request->onDisconnect([this, slot, request]() {
+        if (slot->request == request && _admission.cancel(slot))
+          slot->request = nullptr;
+      });
+      return;
+    }
+    if (result != ADMIT_OK) {
+      sendAdmissionRejection(request, result);
+      return;
+    }
+    runHeavy(request, handler);
+  };
+}
+
+void WebManager::runHeavy(AsyncWebServerRequest *request, HeavyHandler handler) {
+  request->onDisconnect([this]() { releaseHeavy(); });
+  (this->*handler)(request);
+}
+
+// A heavy response is done: its slot goes to the oldest waiter, which runs now
+void WebManager::releaseHeavy() {
+  expireDeferred();
+  DeferredRequest *next = (DeferredRequest *)_admission.release(ADMIT_HEAVY, millis());
+  if (next == nullptr)
+    return;
+  AsyncWebServerRequest *request = next->request;
+  next->request = nullptr;
+  runHeavy(request, next->handler);
+}
+
+void WebManager::expireDeferred() {
+  DeferredRequest *expired;
+  while ((expired = (DeferredRequest *)_admission.expire(millis())) != nullptr) {
+    AsyncWebServerRequest *request = expired->request;
+    expired->request = nullptr;
+    sendAdmissionRejection(request, ADMIT_BUSY);
+  }
+}
+
+void WebManager::sendAdmissionRejection(AsyncWebServerRequest *request, AdmitResult result) {
+  AsyncWebServerResponse *response;
+  uint32_t retrySec = 1;
+  if (result == ADMIT_RATE_LIMITED) {
+    response = request->beginResponse(429, "application/json", (const uint8_t *)RATE_LIMITED_JSON, sizeof(RATE_LIMITED_JSON) - 1);
+    retrySec = (_admission.retryAfterMs() + 999) / 1000;
+    if (retrySec == 0)
+      retrySec = 1;
+  } else {
+    response = request->beginResponse(503, "application/json", (const uint8_t *)HEAVY_BUSY_JSON, sizeof(HEAVY_BUSY_JSON) - 1);
+  }
+  char retry[12];
+  snprintf(retry, sizeof(retry), "%u", (unsigned)retrySec);
+  response->addHeader("Retry-After", retry);
+  request->send(response);
+}
+
+/**
+ * Reassembles a body handler's chunks; returns true once, on the last chunk.
+ * An unfragmented body is used in place ('arena' = nullptr). A fragmented one
+ * is copied into a leased arena that passes to the caller in 'arena' (adopt it
+ * with JsonArenaLease, so the document allocates after the body). Errors are
+ * answered here; on false the caller just returns.
+ */
+bool WebManager::collectBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total,
+                             const char *&body, size_t &bodyLen, FixedArena *&arena) {
+  arena = nullptr;
+  if (index == 0)
+    dropPendingBody(request);
+
+  PendingBody *pending = nullptr;
+  for (PendingBody &p : _pendingBodies) {
+    if (p.owner == request) {
+      pending = &p;
+      break;
+    }
+  }
+
+  if (index == 0 && len != total && total <= BODY_MAX_SIZE) {
+    // First of several chunks: claim a slot and an arena for the whole body
+    for (PendingBody &p : _pendingBodies) {
+      if (p.owner == nullptr) {
+        pending = &p;
+        break;
+      }
+    }
+    FixedArena *leased = pending ? _jsonArenas.acquire() : nullptr;
+    if (leased == nullptr) {
+      sendArenaBusy(request);
+      return false;
+    }
+    pending->owner = request;
+    pending->arena = leased;
+    request->onDisconnect([this, request]() { dropPendingBody(request); });
+  } else if (index != 0 && pending == nullptr) {
+    return false; // Already answered
+  }
+
+  BodyAccumulator whole;
+  BodyAccumulator &acc = pending ? pending->body : whole;
+  BodyStatus status = acc.feed(pending ? pending->arena : nullptr, data, len, index, total, BODY_MAX_SIZE);
+  if (status == BODY_PARTIAL)
+    return false;
+
+  if (status == BODY_COMPLETE) {
+    body = acc.data();
+    bodyLen = acc.length();
+    if (pending) {
+      arena = pending->arena; // Now owned by the caller's lease
+      pending->owner = nullptr;
+      pending->arena = nullptr;
+    }
+    return true;
+  }
+
+  dropPendingBody(request);
+  if (status == BODY_TOO_LARGE)
+    sendJsonError(request, 413, "Request body too large.");
+  else if (status == BODY_NO_MEMORY)
+    sendArenaBusy(request);
+  else
+    sendJsonError(request, 400, "Malformed request body.");
+  return false;
+}
+
+// Frees an abandoned (or failed) partial body.
+void WebManager::dropPendingBody(AsyncWebServerRequest *request) {
+  for (PendingBody &p : _pendingBodies) {
+    if (p.owner == request) {
+      _jsonArenas.release(p.arena);
+      p.owner = nullptr;
+      p.arena = nullptr;
+      p.body.reset();
+    }
+  }
+}
+
+// Wraps a route handler behind admit().
+ArRequestHandlerFunction WebManager::admitted(AdmitLane lane, ArRequestHandlerFunction handler) {
+  return [this, lane, handler](AsyncWebServerRequest *request) {
+    if (admit(request, lane))
+      handler(request);
+  };
+}
+
 void WebManager::sendJsonError(AsyncWebServerRequest *request, int code, const std::string &message) {
-  JsonDocument doc;
+  JsonArenaLease lease(_jsonArenas);
+  if (!lease.ok()) {
+    sendArenaBusy(request);
+    return;
+  }
+  JsonDocument doc(&lease);
+  sendJsonError(request, code, message, doc);
+}
+
+void WebManager::sendJsonError(AsyncWebServerRequest *request, int code, const std::string &message, JsonDocument &doc) {
+  doc.clear();
   doc["status"] = "error";
   doc["message"] = message;
-  String response;
-  serializeJson(doc, response);
-  request->send(code, "application/json", response);
+  sendJson(request, code, doc);
 }
 
 // =================================================================================
@@ -57,33 +336,65 @@ void WebManager::sendJsonError(AsyncWebServerRequest *request, int code, const s
 // =================================================================================
 
 void WebManager::registerEndpoints() {
+  // Lanes: ADMIT_SAFETY is never throttled (abort and keep-alive must always get
+  // through), ADMIT_HEAVY is charged more, capped in flight and queued over the cap (admittedHeavy),
+  // the rest is ADMIT_NORMAL.
+
   // 1. System & Health
-  _server.on("/", HTTP_GET, [this](AsyncWebServerRequest *r) { handleRoot(r); });
-  _server.on("/health", HTTP_GET, [this](AsyncWebServerRequest *r) { handleHealth(r); });
-  _server.on("/keepalive", HTTP_POST, [this](AsyncWebServerRequest *r) { handleKeepAlive(r); });
-  _server.on("/reboot", HTTP_POST, [this](AsyncWebServerRequest *r) { handleReboot(r); });
-  _server.on("/factory-reset", HTTP_POST, [this](AsyncWebServerRequest *r) { handleFactoryReset(r); });
+  _server.on("/", HTTP_GET, admitted(ADMIT_NORMAL, [this](AsyncWebServerRequest *r) { handleRoot(r); }));
+  _server.on("/health", HTTP_GET, admitted(ADMIT_NORMAL, [this](AsyncWebServerRequest *r) { handleHealth(r); }));
+  _server.on("/keepalive", HTTP_POST, admitted(ADMIT_SAFETY, [this](AsyncWebServerRequest *r) { handleKeepAlive(r); }));
+  _server.on("/reboot", HTTP_POST, admitted(ADMIT_NORMAL, [this](AsyncWebServerRequest *r) { handleReboot(r); }));
+  _server.on("/factory-reset", HTTP_POST, admitted(ADMIT_NORMAL, [this](AsyncWebServerRequest *r) { handleFactoryReset(r); }));
 
   // 2. Session Commands
-  _server.on("/start-test", HTTP_POST, [this](AsyncWebServerRequest *r) { handleStartTest(r); });
-  _server.on("/abort", HTTP_POST, [this](AsyncWebServerRequest *r) { handleAbort(r); });
-  _server.on("/time/add", HTTP_POST, [this](AsyncWebServerRequest *r) { handleTimeMod(r, true); });
-  _server.on("/time/remove", HTTP_POST, [this](AsyncWebServerRequest *r) { handleTimeMod(r, false); });
+  _server.on("/start-test", HTTP_POST, admitted(ADMIT_NORMAL, [this](AsyncWebServerRequest *r) { handleStartTest(r); }));
+  _server.on("/abort", HTTP_POST, admitted(ADMIT_SAFETY, [this](AsyncWebServerRequest *r) { handleAbort(r); }));
+  _server.on("/time/add", HTTP_POST, admitted(ADMIT_NORMAL, [this](AsyncWebServerRequest *r) { handleTimeMod(r, true); }));
+  _server.on("/time/remove", HTTP_POST, admitted(ADMIT_NORMAL, [this](AsyncWebServerRequest *r) { handleTimeMod(r, false); }));
 
   // 3. Status & Info
-  _server.on("/status", HTTP_GET, [this](AsyncWebServerRequest *r) { handleStatus(r); });
-  _server.on("/details", HTTP_GET, [this](AsyncWebServerRequest *r) { handleDetails(r); });
-  _server.on("/log", HTTP_GET, [this](AsyncWebServerRequest *r) { handleLog(r); });
-  _server.on("/reward", HTTP_GET, [this](AsyncWebServerRequest *r) { handleReward(r); });
-
-  // 4. Body Handlers (Arm & WiFi)
+  _server.on("/status", HTTP_GET, admitted(ADMIT_NORMAL, [this](AsyncWebServerRequest *r) { handleStatus(r); }));
+  _server.on("/details", HTTP_GET, admittedHeavy(&WebManager::handleDetails));
+  _server.on("/log", HTTP_GET, admittedHeavy(&WebManager::handleLog));
+  _server.on("/history", HTTP_GET, admittedHeavy(&WebManager::handleHistory));
+#ifdef ENGINE_TRACE
+  _server.on("/trace", HTTP_GET, admittedHeavy(&WebManager::handleTrace));
+#endif
+  _server.on("/latency/reset", HTTP_POST, admitted(ADMIT_NORMAL, [this](AsyncWebServerRequest *r) { handleLatencyReset(r); }));
+  _server.on("/reward", HTTP_GET, admitted(ADMIT_NORMAL, [this](AsyncWebServerRequest *r) { handleReward(r); }));
+  _server.on("/metrics", HTTP_GET, admittedHeavy(&WebManager::handleMetrics));
+  _server.on("/udp", HTTP_GET, admitted(ADMIT_NORMAL, [this](AsyncWebServerRequest *r) { handleUdpInfo(r); }));
+  _server.on("/udp/reset-key", HTTP_POST, admitted(ADMIT_NORMAL, [this](AsyncWebServerRequest *r) { handleUdpResetKey(r); }));
+
+  // 4. Event Stream (SSE)
+  // New subscribers get a full snapshot on the next publishEvents() pass.
+  _events.onConnect([this](AsyncEventSourceClient *client) { _eventsNeedSnapshot = true; });
+  _server.addHandler(&_events);
+
+  // 5. Body Handlers (Arm, Batch & WiFi)
+  // Admitted on the first chunk, before anything is buffered. /batch settles the rest once its ops are known.
   _server.on(
       "/arm", HTTP_POST, [](AsyncWebServerRequest *r) {}, NULL,
-      [this](AsyncWebServerRequest *r, uint8_t *data, size_t len, size_t index, size_t total) { handleArm(r, data, len, index, total); });
+      [this](AsyncWebServerRequest *r, uint8_t *data, size_t len, size_t index, size_t total) {
+        if (index == 0 && !admit(r, ADMIT_NORMAL))
+          return;
+        handleArm(r, data, len, index, total);
+      });
+
+  _server.on(
+      "/batch", HTTP_POST, [](AsyncWebServerRequest *r) {}, NULL,
+      [this](AsyncWebServerRequest *r, uint8_t *data, size_t len, size_t index, size_t total) {
+        if (index == 0 && !admit(r, ADMIT_NORMAL))
+          return;
+        handleBatch(r, data, len, index, total);
+      });
 
   _server.on(
       "/update-wifi", HTTP_POST, [](AsyncWebServerRequest *r) {}, NULL,
       [this](AsyncWebServerRequest *r, uint8_t *data, size_t len, size_t index, size_t total) {
+        if (index == 0 && !admit(r, ADMIT_NORMAL))
+          return;
         handleUpdateWifi(r, data, len, index, total);
       });
 }
@@ -93,43 +404,61 @@ void WebManager::registerEndpoints() {
 // =================================================================================
 
 void WebManager::handleArm(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-  if (index + len != total)
+  PERF_PROBE(PROBE_WEB_ARM);
+  const char *body;
+  size_t bodyLen;
+  FixedArena *bodyArena;
+  if (!collectBody(request, data, len, index, total, body, bodyLen, bodyArena))
     return;
 
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, (const char *)data, len);
+  JsonArenaLease lease(_jsonArenas, bodyArena);
+  if (!lease.ok()) {
+    sendArenaBusy(request);
+    return;
+  }
+  JsonDocument doc(&lease);
+  DeserializationError error = deserializeJson(doc, body, bodyLen);
+  if (error == DeserializationError::NoMemory) {
+    sendArenaBusy(request);
+    return;
+  }
   if (error) {
-    sendJsonError(request, 400, "Invalid JSON.");
+    sendJsonError(request, 400, "Invalid JSON.", doc);
     return;
   }
 
   SessionConfig intent;
   std::string err;
-  uint8_t mask = Esp32SessionHAL::getInstance().getChannelMask();
+  ChannelMask mask = Esp32SessionHAL::getInstance().getChannelMask();
 
   // Updated Validator handles the new TypeScript interface structure
   if (!WebValidators::parseSessionConfig(doc, mask, intent, err)) {
-    sendJsonError(request, 400, err);
+    sendJsonError(request, 400, err, doc);
     return;
   }
 
   if (Esp32SessionHAL::getInstance().lockState()) {
+    TRACE_START(intent);
     int result = _engine->startSession(intent);
+    TRACE_RESULT(result);
     Esp32SessionHAL::getInstance().unlockState();
 
     if (result == 200) {
       request->send(200, "application/json", "{\"status\":\"armed\"}");
     } else {
-      sendJsonError(request, result, "Session start failed (Engine rejected).");
+      sendJsonError(request, result, "Session start failed (Engine rejected).", doc);
     }
   } else {
-    sendJsonError(request, 503, "System Busy");
+    sendJsonError(request, 503, "System Busy", doc);
   }
 }
 
 void WebManager::handleStartTest(AsyncWebServerRequest *request) {
+  PERF_PROBE(PROBE_WEB_START_TEST);
   if (Esp32SessionHAL::getInstance().lockState()) {
+    TRACE_CALL(TRACE_CALL_TEST_START);
     int result = _engine->startTest();
+    TRACE_RESULT(result);
     Esp32SessionHAL::getInstance().unlockState();
     if (result == 200) {
       request->send(200, "application/json", "{\"status\":\"testing\"}");
@@ -142,30 +471,31 @@ void WebManager::handleStartTest(AsyncWebServerRequest *request) {
 }
 
 void WebManager::handleAbort(AsyncWebServerRequest *request) {
+  PERF_PROBE(PROBE_WEB_ABORT);
   if (Esp32SessionHAL::getInstance().lockState()) {
+    TRACE_CALL(TRACE_CALL_ABORT);
     _engine->abort("API Request");
     DeviceState s = _engine->getState();
+    Esp32SessionHAL::getInstance().unlockState();
+
     // TS Expects DeviceState enum string: 'ABORTED', 'COMPLETED', 'READY'
-    JsonDocument doc;
     if (s == ABORTED)
-      doc["status"] = "ABORTED";
+      request->send(200, "application/json", "{\"status\":\"ABORTED\"}");
     else if (s == COMPLETED)
-      doc["status"] = "COMPLETED";
+      request->send(200, "application/json", "{\"status\":\"COMPLETED\"}");
     else
-      doc["status"] = "READY";
-
-    String rJson;
-    serializeJson(doc, rJson);
-    Esp32SessionHAL::getInstance().unlockState();
-    request->send(200, "application/json", rJson);
+      request->send(200, "application/json", "{\"status\":\"READY\"}");
   } else {
     sendJsonError(request, 503, "System Busy");
   }
 }
 
 void WebManager::handleTimeMod(AsyncWebServerRequest *request, bool increase) {
+  PERF_PROBE(PROBE_WEB_TIME_MOD);
   if (Esp32SessionHAL::getInstance().lockState()) {
+    TRACE_CALL_FLAG(TRACE_CALL_MODIFY, increase);
     int code = _engine->modifyTime(increase);
+    TRACE_RESULT(code);
     Esp32SessionHAL::getInstance().unlockState();
 
     if (code == 200) {
@@ -178,42 +508,234 @@ void WebManager::handleTimeMod(AsyncWebServerRequest *request, bool increase) {
   }
 }
 
+/**
+ * Runs up to BATCH_MAX_OPS operations in order under one state lock, so e.g.
+ * "keepalive then status" is atomic. Reads (status, reward) are copied into
+ * the response arena while the lock is held; JSON is built after releasing it.
+ * Each result carries the code its standalone endpoint would have returned.
+ */
+void WebManager::handleBatch(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  PERF_PROBE(PROBE_WEB_BATCH);
+  const char *body;
+  size_t bodyLen;
+  FixedArena *bodyArena;
+  if (!collectBody(request, data, len, index, total, body, bodyLen, bodyArena))
+    return;
+
+  JsonArenaLease lease(_jsonArenas, bodyArena);
+  if (!lease.ok()) {
+    sendArenaBusy(request);
+    return;
+  }
+  JsonDocument doc(&lease);
+  DeserializationError error = deserializeJson(doc, body, bodyLen);
+  if (error == DeserializationError::NoMemory) {
+    sendArenaBusy(request);
+    return;
+  }
+  if (error) {
+    sendJsonError(request, 400, "Invalid JSON.", doc);
+    return;
+  }
+
+  BatchOp ops[BATCH_MAX_OPS];
+  size_t count = 0;
+  std::string err;
+  if (!WebValidators::parseBatch(doc, ops, BATCH_MAX_OPS, count, err)) {
+    sendJsonError(request, 400, err, doc);
+    return;
+  }
+
+  // One token per op that is not keep-alive or abort; a safety-only batch is free like the standalone calls
+  uint32_t cost = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (ops[i] != BATCH_KEEPALIVE && ops[i] != BATCH_ABORT)
+      cost++;
+  }
+  if (!settle(request, cost))
+    return;
+  doc.clear(); // The arena now holds the response
+
+  // 1. Execute under one lock; reads are snapshots taken at their position
+  int codes[BATCH_MAX_OPS];
+  void *reads[BATCH_MAX_OPS] = {}; // StatusSnapshot / EngineSnapshot in the arena
+  Esp32SessionHAL &hal = Esp32SessionHAL::getInstance();
+  if (!hal.lockState()) {
+    sendJsonError(request, 503, "System Busy", doc);
+    return;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    codes[i] = 200;
+    switch (ops[i]) {
+    case BATCH_KEEPALIVE:
+      TRACE_CALL(TRACE_CALL_PET);
+      _engine->petWatchdog();
+      break;
+    case BATCH_TIME_ADD:
+    case BATCH_TIME_REMOVE:
+      TRACE_CALL_FLAG(TRACE_CALL_MODIFY, ops[i] == BATCH_TIME_ADD);
+      codes[i] = _engine->modifyTime(ops[i] == BATCH_TIME_ADD);
+      TRACE_RESULT(codes[i]);
+      break;
+    case BATCH_ABORT:
+      TRACE_CALL(TRACE_CALL_ABORT);
+      _engine->abort("API Request");
+      break;
+    case BATCH_STATUS: {
+      StatusSnapshot *snap = (StatusSnapshot *)lease.arena().allocate(sizeof(StatusSnapshot));
+      if (snap == nullptr || !captureStatus(*snap))
+        codes[i] = 503;
+      reads[i] = snap;
+      break;
+    }
+    case BATCH_REWARD: {
+      EngineSnapshot *snap = (EngineSnapshot *)lease.arena().allocate(sizeof(EngineSnapshot));
+      if (snap == nullptr || !_engine->readSnapshot(*snap))
+        codes[i] = 503;
+      else if (!snap->rewardsVisible)
+        codes[i] = 403;
+      reads[i] = snap;
+      break;
+    }
+    default:
+      codes[i] = 400;
+      break;
+    }
+  }
+  DeviceState finalState = _engine->getState();
+  hal.unlockState();
+
+  // 2. Serialize outside the lock
+  JsonArray results = doc["results"].to<JsonArray>();
+  for (size_t i = 0; i < count; i++) {
+    JsonObject r = results.add<JsonObject>();
+    r["op"] = WebValidators::batchOpName(ops[i]);
+    r["code"] = codes[i];
+    if (codes[i] != 200)
+      continue;
+
+    if (ops[i] == BATCH_STATUS) {
+      buildStatusJson(r["status"].to<JsonObject>(), *(StatusSnapshot *)reads[i]);
+    } else if (ops[i] == BATCH_REWARD) {
+      const EngineSnapshot &snap = *(EngineSnapshot *)reads[i];
+      JsonArray arr = r["rewards"].to<JsonArray>();
+      for (int k = 0; k < REWARD_HISTORY_SIZE; k++) {
+        if (strlen(snap.rewards[k].code) > 0) {
+          JsonObject rw = arr.add<JsonObject>();
+          rw["code"] = snap.rewards[k].code;
+          rw["checksum"] = snap.rewards[k].checksum;
+        }
+      }
+    }
+  }
+  doc["state"] = stateToString(finalState);
+
+  if (doc.overflowed()) {
+    sendArenaBusy(request);
+    return;
+  }
+  sendJson(request, 200, doc);
+}
+
 // =================================================================================
 // SECTION: STATUS & INFO
 // =================================================================================
 
 void WebManager::handleStatus(AsyncWebServerRequest *request) {
-  if (!Esp32SessionHAL::getInstance().lockState()) {
+  PERF_PROBE(PROBE_WEB_STATUS);
+  StatusSnapshot snap;
+  if (!captureStatus(snap)) {
     request->send(503, "text/plain", "Busy");
     return;
   }
 
-  // Snapshot Data
-  DeviceState s = _engine->getState();
-  SessionOutcome o = _engine->getOutcome();
-  SessionTimers t = _engine->getTimers();
-  SessionStats stats = _engine->getStats();
-  SessionConfig cfg = _engine->getActiveConfig();
-  bool verified = _engine->isHardwarePermitted();
-
-  // Hardware reading
-  bool btnPressed = Esp32SessionHAL::getInstance().isButtonPressed();
-  int rssi = WiFi.RSSI();
-  uint32_t heap = ESP.getFreeHeap();
-  float temp = temperatureRead();
-  int64_t uptime = esp_timer_get_time() / 1000; // micro to milli
+  char etag[32];
+  formatStatusETag(snap, etag, sizeof(etag));
 
-  uint32_t currentPressDurationMs = Esp32SessionHAL::getInstance().getCurrentPressDurationMs();
+  // 1. Conditional: nothing but telemetry moved since the client's copy
+  if (request->hasHeader("If-None-Match") && request->header("If-None-Match") == etag) {
+    AsyncWebServerResponse *notModified = request->beginResponse(304);
+    notModified->addHeader("ETag", etag);
+    request->send(notModified);
+    return;
+  }
 
-  Esp32SessionHAL::getInstance().unlockState();
+  // 2. Delta: client already holds this generation, send only the counters
+  bool deltaOnly = false;
+  if (request->hasParam("since")) {
+    uint32_t since = strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
+    deltaOnly = (since == snap.generation);
+  }
+
+  JsonArenaLease lease(_jsonArenas);
+  if (!lease.ok()) {
+    sendArenaBusy(request);
+    return;
+  }
+  JsonDocument doc(&lease);
+  if (deltaOnly)
+    buildTimerDeltaJson(doc.to<JsonObject>(), snap);
+  else
+    buildStatusJson(doc.to<JsonObject>(), snap);
+  if (doc.overflowed()) {
+    sendArenaBusy(request);
+    return;
+  }
 
   AsyncResponseStream *response = request->beginResponseStream("application/json");
-  JsonDocument doc;
+  response->addHeader("ETag", etag);
+  serializeJson(doc, *response);
+  request->send(response);
+}
+
+// Weak validator: generation + the per-second counters. Telemetry is excluded,
+// so a 304 may carry slightly stale RSSI/heap/uptime readings.
+void WebManager::formatStatusETag(const StatusSnapshot &snap, char *buf, size_t len) {
+  uint32_t crc = LogicUtils::crc32((const uint8_t *)&snap.timers, sizeof(snap.timers));
+  crc = LogicUtils::crc32((const uint8_t *)&snap.stats.totalLockedTime, sizeof(snap.stats.totalLockedTime), crc);
+  snprintf(buf, len, "W/\"%lu-%08lx\"", (unsigned long)snap.generation, (unsigned long)crc);
+}
+
+// Copies the engine's published snapshot. Lock-free: never waits on tick() or NVS.
+// Returns false only if every read attempt overlapped a publish.
+bool WebManager::captureStatus(StatusSnapshot &snap) {
+  EngineSnapshot es;
+  if (!_engine->readSnapshot(es))
+    return false;
+
+  snap.state = es.state;
+  snap.outcome = es.outcome;
+  snap.timers = es.timers;
+  snap.stats = es.stats;
+  snap.config = es.config;
+  snap.generation = es.generation;
+  snap.verified = es.interlockValid;
+
+  // Button state is ISR-maintained (volatile), no lock required
+  snap.buttonPressed = Esp32SessionHAL::getInstance().isButtonPressed();
+  snap.currentPressDurationMs = Esp32SessionHAL::getInstance().getCurrentPressDurationMs();
+  return true;
+}
+
+void WebManager::buildStatusJson(JsonObject doc, const StatusSnapshot &snap) {
+  const SessionTimers &t = snap.timers;
+  const SessionStats &stats = snap.stats;
+  const SessionConfig &cfg = snap.config;
+
+  // Smoothed readings from the HAL sampler (no hardware access per request)
+  SensorSample sensors;
+  Esp32SessionHAL::getInstance().getSensorSample(sensors);
+  int rssi = sensors.rssi.valid() ? (int)lroundf(sensors.rssi.ema()) : 0;
+  uint32_t heap = (uint32_t)sensors.heap.last();
+  float temp = sensors.temperature.valid() ? sensors.temperature.ema() : NAN;
+  int64_t uptime = esp_timer_get_time() / 1000; // micro to milli
 
   // 1. Root Status
-  doc["state"] = stateToString(s);
-  doc["outcome"] = outcomeToString(o);
-  doc["verified"] = verified;
+  doc["state"] = stateToString(snap.state);
+  doc["outcome"] = outcomeToString(snap.outcome);
+  doc["verified"] = snap.verified;
+  doc["generation"] = snap.generation;
 
   // 2. Config Echo (Matching SessionConfig Interface)
   JsonObject cObj = doc["config"].to<JsonObject>();
@@ -226,7 +748,7 @@ void WebManager::handleStatus(AsyncWebServerRequest *request) {
   cObj["disableLED"] = cfg.disableLED;
 
   JsonArray cDelays = cObj["channelDelays"].to<JsonArray>();
-  for (int i = 0; i < 4; i++)
+  for (int i = 0; i < MAX_CHANNELS; i++)
     cDelays.add(cfg.channelDelays[i]);
 
   // 3. Timers (Matching SessionTimers Interface)
@@ -240,7 +762,7 @@ void WebManager::handleStatus(AsyncWebServerRequest *request) {
   tObj["triggerTimeout"] = t.triggerTimeout;
 
   JsonArray tDelays = tObj["channelDelays"].to<JsonArray>();
-  for (int i = 0; i < 4; i++)
+  for (int i = 0; i < MAX_CHANNELS; i++)
     tDelays.add(t.channelDelays[i]);
 
   // 4. Stats
@@ -253,8 +775,8 @@ void WebManager::handleStatus(AsyncWebServerRequest *request) {
 
   // 5. Telemetry
   JsonObject tel = doc["telemetry"].to<JsonObject>();
-  tel["buttonPressed"] = btnPressed;
-  tel["currentPressDurationMs"] = currentPressDurationMs;
+  tel["buttonPressed"] = snap.buttonPressed;
+  tel["currentPressDurationMs"] = snap.currentPressDurationMs;
   tel["rssi"] = rssi;
   tel["freeHeap"] = heap;
   tel["uptime"] = uptime;
@@ -262,23 +784,123 @@ void WebManager::handleStatus(AsyncWebServerRequest *request) {
     tel["internalTempC"] = "N/A";
   else
     tel["internalTempC"] = temp;
+}
 
-  serializeJson(doc, *response);
-  request->send(response);
+// Compact per-tick payload: only the counters that move every second.
+void WebManager::buildTimerDeltaJson(JsonObject doc, const StatusSnapshot &snap) {
+  const SessionTimers &t = snap.timers;
+
+  doc["state"] = stateToString(snap.state);
+  doc["generation"] = snap.generation;
+
+  JsonObject tObj = doc["timers"].to<JsonObject>();
+  tObj["lockRemaining"] = t.lockRemaining;
+  tObj["penaltyRemaining"] = t.penaltyRemaining;
+  tObj["testRemaining"] = t.testRemaining;
+  tObj["triggerTimeout"] = t.triggerTimeout;
+
+  JsonArray tDelays = tObj["channelDelays"].to<JsonArray>();
+  for (int i = 0; i < MAX_CHANNELS; i++)
+    tDelays.add(t.channelDelays[i]);
+
+  doc["totalLockedTime"] = snap.stats.totalLockedTime;
+}
+
+// =================================================================================
+// SECTION: EVENT STREAM (SSE)
+// =================================================================================
+
+void WebManager::publishEvents(bool ticked, bool stateChanged) {
+  PERF_PROBE(PROBE_WEB_EVENTS);
+  if (_engine == nullptr || _events.count() == 0)
+    return;
+
+  bool full = stateChanged || _eventsNeedSnapshot;
+  if (!full && !ticked)
+    return;
+
+  StatusSnapshot snap;
+  if (!captureStatus(snap)) {
+    // Snapshot mid-publish: retry on the next pass, drop this delta.
+    if (full)
+      _eventsNeedSnapshot = true;
+    return;
+  }
+  _eventsNeedSnapshot = false;
+
+  // Arenas busy: same as a torn snapshot, try again next pass.
+  JsonArenaLease lease(_jsonArenas);
+  if (!lease.ok()) {
+    if (full)
+      _eventsNeedSnapshot = true;
+    return;
+  }
+  JsonDocument doc(&lease);
+  if (full)
+    buildStatusJson(doc.to<JsonObject>(), snap);
+  else
+    buildTimerDeltaJson(doc.to<JsonObject>(), snap);
+
+  // Serialize once (into the same arena), fan out to every subscriber.
+  size_t len = measureJson(doc);
+  char *payload = doc.overflowed() ? nullptr : (char *)lease.arena().allocate(len + 1);
+  if (payload == nullptr) {
+    if (full)
+      _eventsNeedSnapshot = true;
+    return;
+  }
+  serializeJson(doc, payload, len + 1);
+  _events.send(payload, full ? "status" : "timers", ++_eventId);
 }
 
 // =================================================================================
 // SECTION: DEVICE DETAILS
 // =================================================================================
 
-void WebManager::handleDetails(AsyncWebServerRequest *request) {
+// Forwards a serialized JSON object without its enclosing braces, so its
+// members can be spliced into a larger object (holds one byte back to drop
+// the closing brace).
+class ObjectMembersPrint : public Print {
+public:
+  explicit ObjectMembersPrint(Print &out) : _out(out), _started(false), _hasHeld(false), _held(0) {}
+
+  size_t write(uint8_t c) override {
+    if (!_started) {
+      _started = true; // Opening '{'
+      return 1;
+    }
+    if (_hasHeld)
+      _out.write(_held);
+    _held = c;
+    _hasHeld = true;
+    return 1;
+  }
+
+private:
+  Print &_out;
+  bool _started;
+  bool _hasHeld;
+  uint8_t _held;
+};
+
+/**
+ * Renders the parts of /details that only change with provisioning, settings
+ * or network events. Split in two around network.rssi, the one volatile field
+ * inside them:
+ *   _detailsHead = {"id":..,"identity":{..},"network":{..      (object left open)
+ *   _detailsBody = ,"features":[..],"channels":{..},..,"defaults":{..}
+ */
+bool WebManager::rebuildDetailsCache() {
   // 1. Prepare Identification
   uint8_t macRaw[6];
   esp_efuse_mac_get_default(macRaw);
   char idBuf[32];
   snprintf(idBuf, sizeof(idBuf), "lobster-lock-%02X%02X%02X", macRaw[3], macRaw[4], macRaw[5]);
 
-  JsonDocument doc;
+  JsonArenaLease lease(_jsonArenas);
+  if (!lease.ok())
+    return false;
+  JsonDocument doc(&lease);
 
   // -- Root ID
   doc["id"] = idBuf;
@@ -296,10 +918,9 @@ void WebManager::handleDetails(AsyncWebServerRequest *request) {
   identity["buildTime"] = __TIME__;
   identity["cppStandard"] = __cplusplus;
 
-  // -- Network Interface
+  // -- Network Interface (rssi is spliced in per request)
   JsonObject net = doc["network"].to<JsonObject>();
   net["ssid"] = WiFi.SSID();
-  net["rssi"] = WiFi.RSSI();
   net["mac"] = WiFi.macAddress();
   net["ip"] = WiFi.localIP().toString();
   net["subnetMask"] = WiFi.subnetMask().toString();
@@ -307,6 +928,14 @@ void WebManager::handleDetails(AsyncWebServerRequest *request) {
   net["hostname"] = WiFi.getHostname();
   net["port"] = 80;
 
+  if (doc.overflowed())
+    return false;
+  String head;
+  serializeJson(doc, head);
+  head.remove(head.length() - 2); // Reopen "network":{ ... }}
+
+  doc.clear();
+
   // -- Features
   JsonArray features = doc["features"].to<JsonArray>();
   features.add("footPedal");
@@ -315,13 +944,14 @@ void WebManager::handleDetails(AsyncWebServerRequest *request) {
 
   // -- Channels
   JsonObject chans = doc["channels"].to<JsonObject>();
-  chans["ch1"] = Esp32SessionHAL::getInstance().isChannelEnabled(0);
-  chans["ch2"] = Esp32SessionHAL::getInstance().isChannelEnabled(1);
-  chans["ch3"] = Esp32SessionHAL::getInstance().isChannelEnabled(2);
-  chans["ch4"] = Esp32SessionHAL::getInstance().isChannelEnabled(3);
+  for (int i = 0; i < MAX_CHANNELS; i++) {
+    char key[6];
+    snprintf(key, sizeof(key), "ch%d", i + 1);
+    chans[key] = Esp32SessionHAL::getInstance().isChannelEnabled(i);
+  }
 
-  // -- Retrieve Config Data
-  if (Esp32SessionHAL::getInstance().lockState()) {
+  // -- Retrieve Config Data (short wait: a heavy reader must not hold up the engine)
+  if (Esp32SessionHAL::getInstance().lockState(ADMISSION_HEAVY_LOCK_MS)) {
     const SessionPresets &presets = _engine->getPresets();
     const DeterrentConfig &det = _engine->getDeterrents();
 
@@ -354,8 +984,7 @@ void WebManager::handleDetails(AsyncWebServerRequest *request) {
 
     Esp32SessionHAL::getInstance().unlockState();
   } else {
-    sendJsonError(request, 503, "System Busy");
-    return;
+    return false;
   }
 
   // -- System Defaults
@@ -366,67 +995,646 @@ void WebManager::handleDetails(AsyncWebServerRequest *request) {
   def["keepAliveInterval"] = g_systemDefaults.keepAliveInterval;
   def["wifiMaxRetries"] = g_systemDefaults.wifiMaxRetries;
   def["armedTimeout"] = g_systemDefaults.armedTimeout;
-
-  String response;
-  serializeJson(doc, response);
-  request->send(200, "application/json", response);
+  def["checkpointInterval"] = g_systemDefaults.checkpointInterval;
+
+  if (doc.overflowed())
+    return false;
+  String body;
+  serializeJson(doc, body);
+  body.setCharAt(0, ','); // {"features":.. } -> ,"features":..
+  body.remove(body.length() - 1);
+
+  _detailsHead = head;
+  _detailsBody = body;
+  return true;
 }
 
-void WebManager::handleLog(AsyncWebServerRequest *request) {
-  AsyncResponseStream *response = request->beginResponseStream("text/plain");
-  Esp32SessionHAL &hal = Esp32SessionHAL::getInstance();
+void WebManager::handleDetails(AsyncWebServerRequest *request) {
+  PERF_PROBE(PROBE_WEB_DETAILS);
 
-  for (int i = 0; i < LOG_BUFFER_SIZE; i++) {
-    if (hal.lockState()) {
-      const char *line = hal.getLogLine(i);
-      char lineBuf[256];
-      strncpy(lineBuf, line, sizeof(lineBuf));
-      lineBuf[sizeof(lineBuf) - 1] = '\0';
-      hal.unlockState();
-
-      if (strlen(lineBuf) > 0) {
-        response->print(lineBuf);
-        response->print("\n");
-      }
-    } else {
-      response->print("[Busy]\n");
+  // 1. Static portion: rebuilt only after settings, channel or network changes
+  uint32_t configGen = SettingsManager::getConfigGeneration();
+  uint32_t networkGen = NetworkManager::getInstance().getEventGeneration();
+  ChannelMask channelMask = Esp32SessionHAL::getInstance().getChannelMask();
+
+  if (!_detailsCached || configGen != _detailsConfigGen || networkGen != _detailsNetworkGen ||
+      channelMask != _detailsChannelMask) {
+    if (!rebuildDetailsCache()) {
+      sendArenaBusy(request);
+      return;
     }
+    _detailsCached = true;
+    _detailsConfigGen = configGen;
+    _detailsNetworkGen = networkGen;
+    _detailsChannelMask = channelMask;
+  }
+
+  // 2. Volatile fields
+  JsonArenaLease lease(_jsonArenas);
+  if (!lease.ok()) {
+    sendArenaBusy(request);
+    return;
+  }
+  JsonDocument doc(&lease);
+
+  // -- Persistence Cost (Session Record)
+  const PersistenceStats &ps = SettingsManager::getPersistenceStats();
+  JsonObject pers = doc["persistence"].to<JsonObject>();
+  pers["format"] = ps.format;
+  pers["recordBytes"] = ps.recordBytes;
+  pers["sequence"] = ps.sequence;
+  pers["saves"] = ps.saves;
+  pers["failedSaves"] = ps.failedSaves;
+  pers["lastSaveUs"] = ps.lastSaveUs;
+  pers["maxSaveUs"] = ps.maxSaveUs;
+  pers["bootLoadUs"] = ps.bootLoadUs;
+
+  // -- Checkpoint Journal (flash write rate)
+  const JournalStats &js = SettingsManager::getJournalStats();
+  uint32_t uptimeSec = (uint32_t)(esp_timer_get_time() / 1000000);
+  JsonObject journal = doc["journal"].to<JsonObject>();
+  journal["slots"] = CHECKPOINT_SLOTS;
+  journal["slotBytes"] = js.slotBytes;
+  journal["sequence"] = js.sequence;
+  journal["writes"] = js.writes;
+  journal["failedWrites"] = js.failedWrites;
+  journal["bytesWritten"] = js.bytesWritten;
+  journal["writesPerHour"] = uptimeSec > 0 ? (uint32_t)((uint64_t)js.writes * 3600 / uptimeSec) : 0;
+  journal["bytesPerHour"] = uptimeSec > 0 ? (uint32_t)((uint64_t)js.bytesWritten * 3600 / uptimeSec) : 0;
+  journal["restoredAtBoot"] = js.restoredAtBoot;
+
+  // -- WiFi Connect Time (directed vs full scan)
+  WiFiConnectStats cs = NetworkManager::getInstance().getConnectStats();
+  JsonObject wifiConn = doc["wifiConnect"].to<JsonObject>();
+  wifiConn["attempts"] = cs.attempts;
+  wifiConn["connects"] = cs.connects;
+  wifiConn["directed"] = cs.directed;
+  wifiConn["fallbacks"] = cs.fallbacks;
+  wifiConn["lastMode"] = cs.lastMode;
+  wifiConn["addressing"] = cs.addressing;
+  wifiConn["lastMs"] = cs.lastMs;
+  wifiConn["avgMs"] = cs.avgMs;
+  wifiConn["maxMs"] = cs.maxMs;
+
+  // -- RAM Log Arena
+  Esp32SessionHAL::LogStats ls = Esp32SessionHAL::getInstance().getLogStats();
+  JsonObject logObj = doc["log"].to<JsonObject>();
+  logObj["arenaBytes"] = ls.capacityBytes;
+  logObj["usedBytes"] = ls.usedBytes;
+  logObj["lines"] = ls.lines;
+  logObj["linesPerKB"] = ls.capacityBytes > 0 ? (float)ls.lines * 1024.0f / ls.capacityBytes : 0.0f;
+  logObj["nextSeq"] = ls.nextSeq;
+  logObj["serialDropped"] = ls.serialDropped;
+
+  // -- Safety Latency (input detected -> engine processed -> mask written)
+  Esp32SessionHAL::LatencyReport lr;
+  Esp32SessionHAL::getInstance().copyLatencyStats(lr);
+  static const char *const causeKeys[SAFETY_CAUSE_COUNT] = {"longPress", "interlock", "keepAlive"};
+  JsonObject latency = doc["latency"].to<JsonObject>();
+  for (uint8_t c = 0; c < SAFETY_CAUSE_COUNT; c++) {
+    const Esp32SessionHAL::LatencyReport::CauseStats &cs = lr.stats(c);
+    JsonObject cause = latency[causeKeys[c]].to<JsonObject>();
+    cause["count"] = cs.total.count();
+    cause["minUs"] = cs.total.minUs();
+    cause["avgUs"] = cs.total.avgUs();
+    cause["maxUs"] = cs.total.maxUs();
+    JsonObject dte = cause["detectToEngine"].to<JsonObject>();
+    dte["minUs"] = cs.detectToEngine.minUs();
+    dte["avgUs"] = cs.detectToEngine.avgUs();
+    dte["maxUs"] = cs.detectToEngine.maxUs();
+    JsonObject etm = cause["engineToMask"].to<JsonObject>();
+    etm["minUs"] = cs.engineToMask.minUs();
+    etm["avgUs"] = cs.engineToMask.avgUs();
+    etm["maxUs"] = cs.engineToMask.maxUs();
+    JsonArray hist = cause["histogram"].to<JsonArray>();
+    for (uint8_t i = 0; i < LATENCY_BUCKETS; i++)
+      hist.add(cs.total.bucket(i));
+  }
+
+  // -- Power (see Config.h: Low Power)
+  Esp32SessionHAL::PowerReport pr;
+  Esp32SessionHAL::getInstance().getPowerReport(pr);
+  static const char *const modemKeys[] = {"off", "min", "max"};
+  JsonObject power = doc["power"].to<JsonObject>();
+  power["mode"] = pr.meter.mode() == POWER_LOW ? "low" : "active";
+  power["pm"] = pr.pmActive;
+  power["lightSleep"] = pr.lightSleep;
+  power["modemSleep"] = modemKeys[pr.modemSleep];
+  power["activeSeconds"] = (uint32_t)(pr.meter.timeInUs(POWER_ACTIVE, pr.nowUs) / 1000000);
+  power["lowPowerSeconds"] = (uint32_t)(pr.meter.timeInUs(POWER_LOW, pr.nowUs) / 1000000);
+  if (pr.sleepMeasured) {
+    power["sleptSeconds"] = (uint32_t)(pr.meter.sleptUs() / 1000000);
+    power["sleeps"] = pr.meter.sleeps();
+    power["sleepPermille"] = pr.meter.sleepPermille(pr.nowUs);
+    power["estimatedMa"] = pr.meter.estimateLowPowerMicroAmps(POWER_AWAKE_UA, POWER_LIGHT_SLEEP_UA, pr.nowUs) / 1000.0f;
+  }
+  const LatencyHistogram *wakes[] = {&pr.meter.timerWake, &pr.meter.inputWake};
+  static const char *const wakeKeys[] = {"timer", "input"};
+  JsonObject wake = power["wakeLatency"].to<JsonObject>();
+  for (uint8_t i = 0; i < 2; i++) {
+    JsonObject w = wake[wakeKeys[i]].to<JsonObject>();
+    w["count"] = wakes[i]->count();
+    w["avgUs"] = wakes[i]->avgUs();
+    w["maxUs"] = wakes[i]->maxUs();
   }
+
+  // -- Memory (per-module build breakdown: scripts/memory_budget.py)
+  JsonObject mem = doc["memory"].to<JsonObject>();
+  mem["bss"] = (uint32_t)(&_bss_end - &_bss_start);
+  mem["data"] = (uint32_t)(&_data_end - &_data_start);
+  mem["heapFree"] = ESP.getFreeHeap();
+  mem["heapMinFree"] = ESP.getMinFreeHeap();
+  mem["heapLargest"] = ESP.getMaxAllocHeap();
+  JsonObject statics = mem["static"].to<JsonObject>();
+  statics["engine"] = sizeof(SessionEngine);
+  statics["hal"] = sizeof(Esp32SessionHAL);
+  statics["logArena"] = LOG_ARENA_SIZE;
+  statics["serialRing"] = SERIAL_RING_SIZE;
+  statics["web"] = sizeof(WebManager);
+  statics["jsonArenas"] = sizeof(_jsonArenas);
+  statics["network"] = sizeof(NetworkManager);
+  statics["udp"] = sizeof(UdpCommandServer);
+  statics["history"] = sizeof(HistoryStore);
+
+  if (doc.overflowed()) {
+    sendArenaBusy(request);
+    return;
+  }
+
+  // 3. Splice: head + rssi + body + volatile members
+  AsyncResponseStream *response = request->beginResponseStream("application/json");
+  response->print(_detailsHead);
+  SensorSample sensors;
+  Esp32SessionHAL::getInstance().getSensorSample(sensors);
+  response->printf(",\"rssi\":%d}", sensors.rssi.valid() ? (int)lroundf(sensors.rssi.ema()) : 0);
+  response->print(_detailsBody);
+  response->print(',');
+  ObjectMembersPrint members(*response);
+  serializeJson(doc, members);
+  response->print('}');
   request->send(response);
 }
 
-void WebManager::handleReward(AsyncWebServerRequest *request) {
-  if (Esp32SessionHAL::getInstance().lockState()) {
+// Pairing info for the UDP command channel. The key is only included while
+// pairing is open and the device is READY (trust model in UdpCommand.h).
+void WebManager::handleUdpInfo(AsyncWebServerRequest *request) {
+  PERF_PROBE(PROBE_WEB_UDP_INFO);
+  UdpCommandServer &udp = UdpCommandServer::getInstance();
+  EngineSnapshot snap;
+  bool pairing = udp.isPairingOpen() && _engine->readSnapshot(snap) && snap.state == READY;
+
+  JsonArenaLease lease(_jsonArenas);
+  if (!lease.ok()) {
+    sendArenaBusy(request);
+    return;
+  }
+  JsonDocument doc(&lease);
+  doc["port"] = UDP_COMMAND_PORT;
+  doc["version"] = UDP_PROTOCOL_VERSION;
+  doc["pairing"] = pairing;
+  if (pairing) {
+    uint8_t key[UDP_KEY_SIZE];
+    udp.copyKey(key);
+    char keyHex[UDP_KEY_SIZE * 2 + 1];
+    for (int i = 0; i < UDP_KEY_SIZE; i++)
+      snprintf(&keyHex[i * 2], 3, "%02x", key[i]);
+    doc["key"] = keyHex;
+  }
+  doc["bootNonce"] = udp.getBootNonce();
+  sendJson(request, 200, doc);
+}
 
-    const Reward *history = _engine->getRewardHistory();
+// Revokes every paired UDP client and reopens pairing. READY only, like the other resets.
+void WebManager::handleUdpResetKey(AsyncWebServerRequest *request) {
+  PERF_PROBE(PROBE_WEB_UDP_RESET_KEY);
+  if (!Esp32SessionHAL::getInstance().lockState()) {
+    sendJsonError(request, 503, "System Busy");
+    return;
+  }
+  DeviceState s = _engine->getState();
+  Esp32SessionHAL::getInstance().unlockState();
+  if (s != READY) {
+    sendJsonError(request, 409, "Cannot reset the UDP key while active.");
+    return;
+  }
 
-    // 1. Check for Null Pointer (Safety Feature: Rewards are hidden in active states)
-    if (history == nullptr) {
-      Esp32SessionHAL::getInstance().unlockState();
-      sendJsonError(request, 403, "Rewards are hidden during active session or penalty.");
-      return;
-    }
+  UdpCommandServer::getInstance().resetKey();
+  log("WebAPI", "UDP command key reset.");
+  request->send(200, "application/json", "{\"status\":\"ok\"}");
+}
 
-    // 2. Serialize Data
-    JsonDocument doc;
-    JsonArray arr = doc.to<JsonArray>();
+void WebManager::handleLatencyReset(AsyncWebServerRequest *request) {
+  PERF_PROBE(PROBE_WEB_LATENCY_RESET);
+  Esp32SessionHAL::getInstance().resetLatencyStats();
+  request->send(200);
+}
 
-    for (int i = 0; i < REWARD_HISTORY_SIZE; i++) {
-      if (strlen(history[i].code) > 0) {
-        JsonObject r = arr.add<JsonObject>();
-        r["code"] = history[i].code;
-        r["checksum"] = history[i].checksum;
-      }
+// =================================================================================
+// SECTION: METRICS (Prometheus text exposition)
+// =================================================================================
+
+void WebManager::handleMetrics(AsyncWebServerRequest *request) {
+  PERF_PROBE(PROBE_WEB_METRICS);
+  AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4; charset=utf-8");
+
+  // -- Heap
+  response->print("# HELP lobster_heap_free_bytes Free heap.\n# TYPE lobster_heap_free_bytes gauge\n");
+  SensorSample sensors;
+  Esp32SessionHAL::getInstance().getSensorSample(sensors);
+  response->printf("lobster_heap_free_bytes %u\n", (unsigned)sensors.heap.last());
+  response->print("# HELP lobster_heap_min_free_bytes Lowest free heap since boot.\n# TYPE lobster_heap_min_free_bytes gauge\n");
+  response->printf("lobster_heap_min_free_bytes %u\n", (unsigned)ESP.getMinFreeHeap());
+  response->print("# HELP lobster_heap_largest_free_block_bytes Largest allocatable block.\n"
+                  "# TYPE lobster_heap_largest_free_block_bytes gauge\n");
+  response->printf("lobster_heap_largest_free_block_bytes %u\n", (unsigned)ESP.getMaxAllocHeap());
+  response->print("# HELP lobster_uptime_seconds Time since boot.\n# TYPE lobster_uptime_seconds counter\n");
+  response->printf("lobster_uptime_seconds %llu\n", (unsigned long long)(esp_timer_get_time() / 1000000));
+
+  // -- Sensors (smoothed by the HAL sampler; absent until a valid reading)
+  if (sensors.temperature.valid()) {
+    response->print("# HELP lobster_temperature_celsius Die temperature (avg = moving average, min/max since boot).\n"
+                    "# TYPE lobster_temperature_celsius gauge\n");
+    response->printf("lobster_temperature_celsius{stat=\"avg\"} %.1f\n", sensors.temperature.ema());
+    response->printf("lobster_temperature_celsius{stat=\"min\"} %.1f\n", sensors.temperature.minimum());
+    response->printf("lobster_temperature_celsius{stat=\"max\"} %.1f\n", sensors.temperature.maximum());
+  }
+  if (sensors.rssi.valid()) {
+    response->print("# HELP lobster_wifi_rssi_dbm WiFi signal (avg = moving average, min/max since connecting).\n"
+                    "# TYPE lobster_wifi_rssi_dbm gauge\n");
+    response->printf("lobster_wifi_rssi_dbm{stat=\"avg\"} %.1f\n", sensors.rssi.ema());
+    response->printf("lobster_wifi_rssi_dbm{stat=\"min\"} %.0f\n", sensors.rssi.minimum());
+    response->printf("lobster_wifi_rssi_dbm{stat=\"max\"} %.0f\n", sensors.rssi.maximum());
+  }
+
+  // -- Response Arenas
+  response->print("# HELP lobster_json_arenas_in_use Response arenas currently leased.\n# TYPE lobster_json_arenas_in_use gauge\n");
+  response->printf("lobster_json_arenas_in_use %u\n", (unsigned)_jsonArenas.inUse());
+  response->print("# HELP lobster_json_arena_high_water_bytes Largest fill of any response arena.\n"
+                  "# TYPE lobster_json_arena_high_water_bytes gauge\n");
+  response->printf("lobster_json_arena_high_water_bytes %u\n", (unsigned)_jsonArenas.highWater());
+  response->print("# HELP lobster_json_arena_exhausted_total Requests answered 503 because every arena was leased.\n"
+                  "# TYPE lobster_json_arena_exhausted_total counter\n");
+  response->printf("lobster_json_arena_exhausted_total %u\n", (unsigned)_jsonArenas.exhausted());
+  response->print("# HELP lobster_json_arena_overflow_total Allocations refused by a full arena.\n"
+                  "# TYPE lobster_json_arena_overflow_total counter\n");
+  response->printf("lobster_json_arena_overflow_total %u\n", (unsigned)_jsonArenas.failures());
+
+  // -- UDP Command Channel
+  UdpCommandStats us = UdpCommandServer::getInstance().getStats();
+  response->print("# HELP lobster_udp_datagrams_total UDP command datagrams by outcome.\n"
+                  "# TYPE lobster_udp_datagrams_total counter\n");
+  response->printf("lobster_udp_datagrams_total{result=\"keepalive\"} %u\n", (unsigned)us.keepAlives);
+  response->printf("lobster_udp_datagrams_total{result=\"abort\"} %u\n", (unsigned)us.aborts);
+  response->printf("lobster_udp_datagrams_total{result=\"bad_tag\"} %u\n", (unsigned)us.badTag);
+  response->printf("lobster_udp_datagrams_total{result=\"malformed\"} %u\n", (unsigned)us.malformed);
+  response->printf("lobster_udp_datagrams_total{result=\"replay\"} %u\n", (unsigned)us.replays);
+  response->printf("lobster_udp_datagrams_total{result=\"busy\"} %u\n", (unsigned)us.busy);
+  response->print("# HELP lobster_udp_received_total UDP command datagrams received.\n# TYPE lobster_udp_received_total counter\n");
+  response->printf("lobster_udp_received_total %u\n", (unsigned)us.received);
+  response->print("# HELP lobster_udp_handler_max_us Slowest UDP command handler since boot.\n"
+                  "# TYPE lobster_udp_handler_max_us gauge\n");
+  response->printf("lobster_udp_handler_max_us %u\n", (unsigned)us.maxHandlerUs);
+
+  // -- HTTP Admission Control
+  const AdmissionStats &as = _admission.stats();
+  response->print("# HELP lobster_http_admitted_total HTTP requests admitted by lane.\n"
+                  "# TYPE lobster_http_admitted_total counter\n");
+  response->printf("lobster_http_admitted_total{lane=\"safety\"} %u\n", (unsigned)as.admitted[ADMIT_SAFETY]);
+  response->printf("lobster_http_admitted_total{lane=\"normal\"} %u\n", (unsigned)as.admitted[ADMIT_NORMAL]);
+  response->printf("lobster_http_admitted_total{lane=\"heavy\"} %u\n", (unsigned)as.admitted[ADMIT_HEAVY]);
+  response->print("# HELP lobster_http_rejected_total HTTP requests turned away by admission control.\n"
+                  "# TYPE lobster_http_rejected_total counter\n");
+  response->printf("lobster_http_rejected_total{reason=\"rate_limited\"} %u\n", (unsigned)as.rateLimited);
+  response->printf("lobster_http_rejected_total{reason=\"heavy_busy\"} %u\n", (unsigned)as.busy);
+  response->printf("lobster_http_rejected_total{reason=\"queue_timeout\"} %u\n", (unsigned)as.queueTimeouts);
+  response->print("# HELP lobster_http_heavy_in_flight Heavy responses being built or sent (this one included).\n"
+                  "# TYPE lobster_http_heavy_in_flight gauge\n");
+  response->printf("lobster_http_heavy_in_flight %u\n", (unsigned)as.heavyInFlight);
+  response->print("# HELP lobster_http_heavy_in_flight_max Most heavy responses in flight at once since boot.\n"
+                  "# TYPE lobster_http_heavy_in_flight_max gauge\n");
+  response->printf("lobster_http_heavy_in_flight_max %u\n", (unsigned)as.heavyInFlightMax);
+  response->print("# HELP lobster_http_queued_total Heavy requests that waited for a slot instead of being rejected.\n"
+                  "# TYPE lobster_http_queued_total counter\n");
+  response->printf("lobster_http_queued_total %u\n", (unsigned)as.queued);
+  response->print("# HELP lobster_http_queue_cancelled_total Queued heavy requests whose client left before their turn.\n"
+                  "# TYPE lobster_http_queue_cancelled_total counter\n");
+  response->printf("lobster_http_queue_cancelled_total %u\n", (unsigned)as.queueCancels);
+  response->print("# HELP lobster_http_queue_depth Heavy requests waiting for a slot.\n# TYPE lobster_http_queue_depth gauge\n");
+  response->printf("lobster_http_queue_depth %u\n", (unsigned)as.queueDepth);
+  response->print("# HELP lobster_http_queue_depth_max Most heavy requests waiting at once since boot.\n"
+                  "# TYPE lobster_http_queue_depth_max gauge\n");
+  response->printf("lobster_http_queue_depth_max %u\n", (unsigned)as.queueDepthMax);
+  response->print("# HELP lobster_http_queue_wait_ms_total Time queued heavy requests waited before running.\n"
+                  "# TYPE lobster_http_queue_wait_ms_total counter\n");
+  response->printf("lobster_http_queue_wait_ms_total %u\n", (unsigned)as.queueWaitMsTotal);
+  response->print("# HELP lobster_http_queue_wait_max_ms Longest wait of a queued heavy request that ran.\n"
+                  "# TYPE lobster_http_queue_wait_max_ms gauge\n");
+  response->printf("lobster_http_queue_wait_max_ms %u\n", (unsigned)as.queueWaitMsMax);
+  response->print("# HELP lobster_http_client_evictions_total Clients dropped from the rate limit table for a new one.\n"
+                  "# TYPE lobster_http_client_evictions_total counter\n");
+  response->printf("lobster_http_client_evictions_total %u\n", (unsigned)as.evictions);
+
+  // -- Session History
+  HistoryStats hs = HistoryStore::getInstance().getStats();
+  response->print("# HELP lobster_history_entries Session records stored in the flash ring.\n# TYPE lobster_history_entries gauge\n");
+  response->printf("lobster_history_entries %u\n", (unsigned)(hs.next - hs.first));
+  response->print("# HELP lobster_history_records_total Session records by outcome of the write since boot.\n"
+                  "# TYPE lobster_history_records_total counter\n");
+  response->printf("lobster_history_records_total{result=\"written\"} %u\n", (unsigned)hs.written);
+  response->printf("lobster_history_records_total{result=\"dropped\"} %u\n", (unsigned)hs.dropped);
+  response->printf("lobster_history_records_total{result=\"failed\"} %u\n", (unsigned)hs.failed);
+  response->print("# HELP lobster_history_append_max_us Slowest history append since boot (sector erases included).\n"
+                  "# TYPE lobster_history_append_max_us gauge\n");
+  response->printf("lobster_history_append_max_us %u\n", (unsigned)hs.maxAppendUs);
+
+  // -- Power (mode time always; sleep residency and the current estimate when the framework reports sleeps)
+  Esp32SessionHAL::PowerReport pr;
+  Esp32SessionHAL::getInstance().getPowerReport(pr);
+  response->print("# HELP lobster_power_low_mode 1 while in low-power mode (LOCKED/ABORTED).\n# TYPE lobster_power_low_mode gauge\n");
+  response->printf("lobster_power_low_mode %u\n", pr.meter.mode() == POWER_LOW ? 1u : 0u);
+  response->print("# HELP lobster_power_mode_seconds_total Time spent in each power mode.\n"
+                  "# TYPE lobster_power_mode_seconds_total counter\n");
+  response->printf("lobster_power_mode_seconds_total{mode=\"active\"} %.3f\n", pr.meter.timeInUs(POWER_ACTIVE, pr.nowUs) / 1e6);
+  response->printf("lobster_power_mode_seconds_total{mode=\"low\"} %.3f\n", pr.meter.timeInUs(POWER_LOW, pr.nowUs) / 1e6);
+  if (pr.sleepMeasured) {
+    response->print("# HELP lobster_power_light_sleep_seconds_total Time in automatic light sleep.\n"
+                    "# TYPE lobster_power_light_sleep_seconds_total counter\n");
+    response->printf("lobster_power_light_sleep_seconds_total %.3f\n", pr.meter.sleptUs() / 1e6);
+    response->print("# HELP lobster_power_estimated_current_ma Average board current in low-power mode, from the sleep residency "
+                    "(excludes LED and channel loads).\n# TYPE lobster_power_estimated_current_ma gauge\n");
+    response->printf("lobster_power_estimated_current_ma %.2f\n",
+                     pr.meter.estimateLowPowerMicroAmps(POWER_AWAKE_UA, POWER_LIGHT_SLEEP_UA, pr.nowUs) / 1000.0);
+  }
+  response->print("# HELP lobster_power_wake_latency_us Engine wake-up latency in low-power mode "
+                  "(timer: past its deadline, input: edge interrupt to engine).\n# TYPE lobster_power_wake_latency_us gauge\n");
+  response->printf("lobster_power_wake_latency_us{source=\"timer\",stat=\"avg\"} %u\n", (unsigned)pr.meter.timerWake.avgUs());
+  response->printf("lobster_power_wake_latency_us{source=\"timer\",stat=\"max\"} %u\n", (unsigned)pr.meter.timerWake.maxUs());
+  response->printf("lobster_power_wake_latency_us{source=\"input\",stat=\"avg\"} %u\n", (unsigned)pr.meter.inputWake.avgUs());
+  response->printf("lobster_power_wake_latency_us{source=\"input\",stat=\"max\"} %u\n", (unsigned)pr.meter.inputWake.maxUs());
+  response->print("# HELP lobster_power_wakes_total Engine wake-ups in low-power mode by source.\n"
+                  "# TYPE lobster_power_wakes_total counter\n");
+  response->printf("lobster_power_wakes_total{source=\"timer\"} %u\n", (unsigned)pr.meter.timerWake.count());
+  response->printf("lobster_power_wakes_total{source=\"input\"} %u\n", (unsigned)pr.meter.inputWake.count());
+
+#ifdef PERF_PROBES
+  PerfProbeStats probes[PROBE_COUNT];
+  uint32_t iterations = 0;
+  PerfProbes::snapshot(probes, iterations);
+
+  // -- Engine service passes (rate over the interval since the previous scrape)
+  static uint32_t s_lastIterations = 0;
+  static int64_t s_lastScrapeUs = 0;
+  int64_t nowUs = esp_timer_get_time();
+  float rateHz = 0.0f;
+  if (s_lastScrapeUs != 0 && nowUs > s_lastScrapeUs)
+    rateHz = (float)(iterations - s_lastIterations) * 1e6f / (float)(nowUs - s_lastScrapeUs);
+  s_lastIterations = iterations;
+  s_lastScrapeUs = nowUs;
+
+  response->print("# HELP lobster_engine_iterations_total Engine service passes.\n"
+                  "# TYPE lobster_engine_iterations_total counter\n");
+  response->printf("lobster_engine_iterations_total %u\n", (unsigned)iterations);
+  response->print("# HELP lobster_engine_iteration_rate_hz Engine service passes per second since the previous scrape.\n"
+                  "# TYPE lobster_engine_iteration_rate_hz gauge\n");
+  response->printf("lobster_engine_iteration_rate_hz %.2f\n", rateHz);
+
+  // -- Probes
+  response->print("# HELP lobster_probe_calls_total Times each probed scope ran.\n# TYPE lobster_probe_calls_total counter\n");
+  for (uint8_t i = 0; i < PROBE_COUNT; i++)
+    response->printf("lobster_probe_calls_total{probe=\"%s\"} %u\n", PerfProbes::name((PerfProbeId)i), (unsigned)probes[i].count);
+
+  response->print("# HELP lobster_probe_time_us_total Time spent in each probed scope.\n"
+                  "# TYPE lobster_probe_time_us_total counter\n");
+  for (uint8_t i = 0; i < PROBE_COUNT; i++)
+    response->printf("lobster_probe_time_us_total{probe=\"%s\"} %llu\n", PerfProbes::name((PerfProbeId)i),
+                     (unsigned long long)probes[i].totalUs);
+
+  response->print("# HELP lobster_probe_max_us Longest single run of each probed scope.\n# TYPE lobster_probe_max_us gauge\n");
+  for (uint8_t i = 0; i < PROBE_COUNT; i++)
+    response->printf("lobster_probe_max_us{probe=\"%s\"} %u\n", PerfProbes::name((PerfProbeId)i), (unsigned)probes[i].maxUs);
+#endif
+
+  request->send(response);
+}
+
+/**
+ * One /log response in flight: an arena cursor and the line being sent.
+ * Nothing is copied up front, so a response costs this struct, not the log.
+ */
+struct LogPager {
+  Esp32SessionHAL::LogCursor cursor;
+  uint32_t endSeq; // Exclusive, fixed when the headers are sent
+  char text[LOG_ARENA_MAX_LINE + 2];
+  size_t len, off;
+
+  // Renders the next line. False when the range is done.
+  bool fill() {
+    off = 0;
+    if (!Esp32SessionHAL::getInstance().readLogLine(cursor, endSeq, text, sizeof(text) - 1, len))
+      return false;
+    text[len++] = '\n';
+    return true;
+  }
+};
+
+void WebManager::handleLog(AsyncWebServerRequest *request) {
+  PERF_PROBE(PROBE_WEB_LOG);
+  // 1. Cursor & Page Size
+  uint32_t since = 0;
+  uint32_t limit = UINT32_MAX; // Default: everything retained
+  if (request->hasParam("since"))
+    since = strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
+  if (request->hasParam("limit")) {
+    long requested = request->getParam("limit")->value().toInt();
+    if (requested > 0)
+      limit = (uint32_t)requested;
+  }
+
+  // 2. Fix the range now (the headers carry it); only a cursor is kept
+  Esp32SessionHAL &hal = Esp32SessionHAL::getInstance();
+  auto pager = std::make_shared<LogPager>();
+  uint32_t nextSeq = hal.seekLog(since, pager->cursor);
+  uint32_t firstSeq = pager->cursor.seq;
+  if (limit < nextSeq - firstSeq)
+    nextSeq = firstSeq + limit;
+  pager->endSeq = nextSeq;
+  pager->len = pager->off = 0;
+
+  // 3. Stream: lines are copied and rendered one at a time as the TCP window allows
+  AsyncWebServerResponse *response =
+      request->beginChunkedResponse("text/plain", [pager](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+        size_t n = 0;
+        while (n < maxLen) {
+          if (pager->off >= pager->len && !pager->fill())
+            break;
+          size_t k = pager->len - pager->off;
+          if (k > maxLen - n)
+            k = maxLen - n;
+          memcpy(buffer + n, pager->text + pager->off, k);
+          pager->off += k;
+          n += k;
+        }
+        return n;
+      });
+
+  response->addHeader("X-Log-First-Seq", String(firstSeq));
+  response->addHeader("X-Log-Next-Seq", String(nextSeq));
+  request->send(response);
+}
+
+/**
+ * One /history response in flight: a flash cursor and the text piece being
+ * sent. Records are read one at a time as the TCP window allows.
+ */
+struct HistoryPager {
+  HistoryLog::Cursor cursor;
+  uint32_t left;  // Entries still allowed on this page
+  uint32_t count; // Entries sent so far
+  bool done;
+  char text[200];
+  size_t len, off;
+
+  // Renders the next piece (an entry or the closing object). False when nothing is left.
+  bool fill() {
+    if (done)
+      return false;
+    off = 0;
+
+    HistoryEntry e;
+    if (left > 0 && HistoryStore::getInstance().next(cursor, e)) {
+      char start[12];
+      if (e.startS)
+        snprintf(start, sizeof(start), "%u", (unsigned)e.startS);
+      else
+        strcpy(start, "null");
+      len = snprintf(text, sizeof(text),
+                     "%s{\"seq\":%u,\"boot\":%u,\"start\":%s,\"end\":%u,\"outcome\":\"%s\",\"locked\":%u,\"planned\":%u,"
+                     "\"penalty\":%u,\"timeMod\":%d}",
+                     count ? "," : "", (unsigned)e.seq, (unsigned)e.boot, start, (unsigned)e.endS,
+                     outcomeToString((SessionOutcome)e.outcome), (unsigned)e.lockedS, (unsigned)e.plannedS,
+                     (unsigned)e.penaltyS, (int)e.timeModS);
+      left--;
+      count++;
+      return true;
     }
 
-    String rJson;
-    serializeJson(doc, rJson);
+    // Closing: where the next page starts, or null at the end of the log
+    if (cursor.ctx.seq < HistoryStore::getInstance().getStats().next)
+      len = snprintf(text, sizeof(text), "],\"nextCursor\":%u}", (unsigned)cursor.ctx.seq);
+    else
+      len = snprintf(text, sizeof(text), "],\"nextCursor\":null}");
+    done = true;
+    return true;
+  }
+};
+
+void WebManager::handleHistory(AsyncWebServerRequest *request) {
+  PERF_PROBE(PROBE_WEB_HISTORY);
+  HistoryStore &store = HistoryStore::getInstance();
+  HistoryStats stats = store.getStats();
+
+  // 1. Cursor & Page Size (default: oldest first)
+  uint32_t cursor = stats.first;
+  if (request->hasParam("cursor"))
+    cursor = strtoul(request->getParam("cursor")->value().c_str(), nullptr, 10);
+  uint32_t limit = HISTORY_PAGE_DEFAULT;
+  if (request->hasParam("limit")) {
+    long requested = request->getParam("limit")->value().toInt();
+    if (requested > 0)
+      limit = (uint32_t)requested;
+  }
+  if (limit > HISTORY_PAGE_MAX)
+    limit = HISTORY_PAGE_MAX;
+
+  // 2. Position the cursor; the log itself is never copied into RAM
+  auto pager = std::make_shared<HistoryPager>();
+  store.seek(cursor, pager->cursor);
+  pager->left = limit;
+  pager->count = 0;
+  pager->done = false;
+  pager->off = 0;
+  pager->len = snprintf(pager->text, sizeof(pager->text), "{\"first\":%u,\"next\":%u,\"boot\":%u,\"entries\":[",
+                        (unsigned)stats.first, (unsigned)stats.next, (unsigned)stats.boot);
+
+  // 3. Stream: each chunk is filled with as many rendered entries as fit
+  AsyncWebServerResponse *response =
+      request->beginChunkedResponse("application/json", [pager](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+        size_t n = 0;
+        while (n < maxLen) {
+          if (pager->off >= pager->len && !pager->fill())
+            break;
+          size_t k = pager->len - pager->off;
+          if (k > maxLen - n)
+            k = maxLen - n;
+          memcpy(buffer + n, pager->text + pager->off, k);
+          pager->off += k;
+          n += k;
+        }
+        return n;
+      });
+  request->send(response);
+}
 
-    Esp32SessionHAL::getInstance().unlockState();
-    request->send(200, "application/json", rJson);
-  } else {
+#ifdef ENGINE_TRACE
+/**
+ * Streams the engine trace recorded since boot (replay: test/TraceReplay.h).
+ * The size is taken once; recording only appends, so those bytes never
+ * change while they are sent.
+ */
+void WebManager::handleTrace(AsyncWebServerRequest *request) {
+  PERF_PROBE(PROBE_WEB_TRACE);
+  EngineTraceHAL &trace = engineTrace();
+  const uint8_t *data = trace.data();
+  size_t size = trace.size();
+
+  AsyncWebServerResponse *response =
+      request->beginResponse("application/octet-stream", size, [data, size](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+        if (index >= size)
+          return 0;
+        size_t n = size - index < maxLen ? size - index : maxLen;
+        memcpy(buffer, data + index, n);
+        return n;
+      });
+  response->addHeader("Content-Disposition", "attachment; filename=\"engine.trace\"");
+  response->addHeader("X-Trace-Capacity", String((uint32_t)trace.capacity()));
+  response->addHeader("X-Trace-Full", trace.full() ? "1" : "0");
+  request->send(response);
+}
+#endif
+
+void WebManager::handleReward(AsyncWebServerRequest *request) {
+  PERF_PROBE(PROBE_WEB_REWARD);
+  // Lock-free read of the published snapshot
+  EngineSnapshot snap;
+  if (!_engine->readSnapshot(snap)) {
     sendJsonError(request, 503, "Busy");
+    return;
   }
+
+  // 1. Safety Feature: Rewards are hidden in active states (not even copied)
+  if (!snap.rewardsVisible) {
+    sendJsonError(request, 403, "Rewards are hidden during active session or penalty.");
+    return;
+  }
+
+  // 2. Serialize Data
+  JsonArenaLease lease(_jsonArenas);
+  if (!lease.ok()) {
+    sendArenaBusy(request);
+    return;
+  }
+  JsonDocument doc(&lease);
+  JsonArray arr = doc.to<JsonArray>();
+
+  for (int i = 0; i < REWARD_HISTORY_SIZE; i++) {
+    if (strlen(snap.rewards[i].code) > 0) {
+      JsonObject r = arr.add<JsonObject>();
+      r["code"] = snap.rewards[i].code;
+      r["checksum"] = snap.rewards[i].checksum;
+    }
+  }
+
+  sendJson(request, 200, doc);
 }
 
 // =================================================================================
@@ -434,23 +1642,21 @@ void WebManager::handleReward(AsyncWebServerRequest *request) {
 // =================================================================================
 
 void WebManager::handleRoot(AsyncWebServerRequest *request) {
-  String html = "<html><head><title>" + String(DEVICE_NAME) + "</title></head><body>";
-  html += "<h1>" + String(DEVICE_NAME) + " API</h1>";
-  html += "<h2>" + String(DEVICE_VERSION) + "</h2>";
-  request->send(200, "text/html", html);
+  PERF_PROBE(PROBE_WEB_ROOT);
+  AsyncResponseStream *response = request->beginResponseStream("text/html");
+  response->printf("<html><head><title>%s</title></head><body><h1>%s API</h1><h2>%s</h2>", DEVICE_NAME, DEVICE_NAME, DEVICE_VERSION);
+  request->send(response);
 }
 
 void WebManager::handleHealth(AsyncWebServerRequest *request) {
-  JsonDocument doc;
-  doc["status"] = "ok";
-  doc["message"] = "Device is reachable.";
-  String response;
-  serializeJson(doc, response);
-  request->send(200, "application/json", response);
+  PERF_PROBE(PROBE_WEB_HEALTH);
+  request->send(200, "application/json", "{\"status\":\"ok\",\"message\":\"Device is reachable.\"}");
 }
 
 void WebManager::handleKeepAlive(AsyncWebServerRequest *request) {
+  PERF_PROBE(PROBE_WEB_KEEPALIVE);
   if (Esp32SessionHAL::getInstance().lockState()) {
+    TRACE_CALL(TRACE_CALL_PET);
     _engine->petWatchdog();
     Esp32SessionHAL::getInstance().unlockState();
     request->send(200);
@@ -460,6 +1666,7 @@ void WebManager::handleKeepAlive(AsyncWebServerRequest *request) {
 }
 
 void WebManager::handleReboot(AsyncWebServerRequest *request) {
+  PERF_PROBE(PROBE_WEB_REBOOT);
   if (Esp32SessionHAL::getInstance().lockState()) {
 
     DeviceState s = _engine->getState();
@@ -481,6 +1688,7 @@ void WebManager::handleReboot(AsyncWebServerRequest *request) {
 }
 
 void WebManager::handleFactoryReset(AsyncWebServerRequest *request) {
+  PERF_PROBE(PROBE_WEB_FACTORY_RESET);
   if (Esp32SessionHAL::getInstance().lockState()) {
 
     DeviceState s = _engine->getState();
@@ -502,40 +1710,66 @@ void WebManager::handleFactoryReset(AsyncWebServerRequest *request) {
 }
 
 void WebManager::handleUpdateWifi(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-  if (index + len != total)
+  PERF_PROBE(PROBE_WEB_UPDATE_WIFI);
+  const char *body;
+  size_t bodyLen;
+  FixedArena *bodyArena;
+  if (!collectBody(request, data, len, index, total, body, bodyLen, bodyArena))
     return;
 
-  if (Esp32SessionHAL::getInstance().lockState()) {
-
-    DeviceState s = _engine->getState();
-    if (s != READY) {
-      Esp32SessionHAL::getInstance().unlockState();
-      sendJsonError(request, 403, "Update WiFi denied. Device active.");
-      return;
-    }
+  JsonArenaLease lease(_jsonArenas, bodyArena);
+  if (!lease.ok()) {
+    sendArenaBusy(request);
+    return;
+  }
+  JsonDocument doc(&lease);
 
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, (const char *)data, len);
+  // The lock only guards the state check; every path below returns unlocked
+  if (!Esp32SessionHAL::getInstance().lockState()) {
+    sendJsonError(request, 503, "System Busy", doc);
+    return;
+  }
+  DeviceState s = _engine->getState();
+  Esp32SessionHAL::getInstance().unlockState();
+  if (s != READY) {
+    sendJsonError(request, 403, "Update WiFi denied. Device active.", doc);
+    return;
+  }
 
-    if (error) {
-      sendJsonError(request, 400, "Invalid JSON.");
-      return;
-    }
+  DeserializationError error = deserializeJson(doc, body, bodyLen);
+  if (error) {
+    sendJsonError(request, 400, "Invalid JSON.", doc);
+    return;
+  }
 
-    const char *ssid = doc["ssid"];
-    const char *pass = doc["pass"];
-    std::string err;
+  const char *ssid = doc["ssid"];
+  const char *pass = doc["pass"];
+  std::string err;
 
-    if (!WebValidators::validateWifiCredentials(ssid, pass, err)) {
-      sendJsonError(request, 400, err);
-      return;
-    }
+  if (!WebValidators::validateWifiCredentials(ssid, pass, err)) {
+    sendJsonError(request, 400, err, doc);
+    return;
+  }
 
-    SettingsManager::setWifiSSID(ssid);
-    SettingsManager::setWifiPassword(pass);
+  // Optional static addressing ({"ip":""} reverts to DHCP)
+  WifiStaticIp staticIp;
+  bool hasStaticIp = doc["staticIp"].is<JsonObject>();
+  if (hasStaticIp &&
+      !WebValidators::parseStaticIp(doc["staticIp"], staticIp.ip, staticIp.gateway, staticIp.subnet, staticIp.dns, err)) {
+    sendJsonError(request, 400, err, doc);
+    return;
+  }
 
-    request->send(200, "application/json", "{\"status\":\"saved\", \"message\":\"Reboot to apply.\"}");
-  } else {
-    sendJsonError(request, 503, "System Busy");
+  // All keys in one NVS commit
+  SettingsTransaction txn;
+  txn.setWifiSSID(ssid);
+  txn.setWifiPassword(pass);
+  if (hasStaticIp)
+    txn.setWifiStaticIp(staticIp);
+  if (!txn.commit()) {
+    sendJsonError(request, 500, "Failed to save credentials.", doc);
+    return;
   }
-}
\ No newline at end of file
+
+  request->send(200, "application/json", "{\"status\":\"saved\", \"message\":\"Reboot to apply.\"}");
+}
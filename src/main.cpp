@@ -8,36 +8,50 @@
  */
 
 #include <Arduino.h>
-#include <Ticker.h>
 #include <WiFi.h>
 #include <esp_task_wdt.h>
+#include <esp_timer.h>
+#include <new>
 
 // --- Module Includes ---
 #include "Config.h"
+#include "EngineTracing.h"
 #include "Esp32SessionHAL.h"
 #include "Globals.h"
+#include "HistoryStore.h"
 #include "Network.h"
+#include "PerfProbes.h"
 #include "SettingsManager.h"
+#include "UdpCommand.h"
 #include "WebManager.h"
 
 // --- Session Engine Includes ---
 #include "Session.h"
 #include "StandardRules.h"
 
-// --- Main ticker ---
-Ticker oneSecondMasterTicker;
-volatile uint32_t tickCounter = 0;
-portMUX_TYPE timerMux = portMUX_INITIALIZER_UNLOCKED;
+#ifndef LEGACY_SINGLE_LOOP
+// --- Engine task (see Config.h: Task Layout) ---
+TaskHandle_t engineTaskHandle = NULL;
+#endif
 
 // --- Dependencies ---
 Esp32SessionHAL &hal = Esp32SessionHAL::getInstance();
 NetworkManager &network = NetworkManager::getInstance();
 WebManager &web = WebManager::getInstance();
+UdpCommandServer &udpCommands = UdpCommandServer::getInstance();
 
 // --- Session Engine
+// Built in setup() from the restored settings, but in static storage rather than
+// on the heap, so its size is part of .bss and of the build's memory report.
+alignas(SessionEngine) static uint8_t sessionEngineStorage[sizeof(SessionEngine)];
 SessionEngine *sessionEngine = nullptr;
 StandardRules rules;
 
+void serviceEngine();
+#ifndef LEGACY_SINGLE_LOOP
+void engineTask(void *arg);
+#endif
+
 /**
  * Prints high-level firmware identity and build information.
  * Place this in main.cpp and call it during setup().
@@ -90,27 +104,23 @@ void printFirmwareDiagnostics() {
 // =================================================================
 
 void setup() {
+  // No settle delay: outputs must be held safe before anything else runs.
+  // Boot logs stay readable later through /log.
   Serial.begin(SERIAL_BAUD_RATE);
-  delay(3000);
 
-  // 1. Initialize Hardware
+  // --- Phase 1: Hardware & Safety ---
   hal.initialize();
+  hal.markBootPhase(BOOT_PHASE_HAL);
   printFirmwareDiagnostics();
 
-  hal.tick();
-
-  // 2. Load Deterrents & Session Presets
+  // --- Phase 2: Restore Settings & Session State (NVS) ---
   DeterrentConfig loadedDeterrents = {};
   SessionPresets sessionPresets = {};
-  uint8_t loadedChannelMask = 0x0F;
+  ChannelMask loadedChannelMask = CHANNEL_MASK_ALL;
   SettingsManager::loadProvisioningConfig(loadedDeterrents, sessionPresets, loadedChannelMask);
 
   hal.setChannelMask(loadedChannelMask);
 
-  // 3. Initialize Engine
-  sessionEngine = new SessionEngine(hal, rules, g_systemDefaults, sessionPresets, loadedDeterrents);
-
-  // 4. Load & Apply Saved Session State (Resume)
   DeviceState savedState = READY;
   SessionTimers savedTimers;
   SessionStats savedStats;
@@ -122,73 +132,136 @@ void setup() {
   memset(&savedConfig, 0, sizeof(savedConfig));
 
   bool hasState = SettingsManager::loadSessionState(savedState, savedTimers, savedStats, savedConfig);
+  HistoryStore::getInstance().begin(); // Before handleReboot(), which may record an abort
+  hal.markBootPhase(BOOT_PHASE_RESTORE);
+
+  // --- Phase 3: Engine & Timebase ---
+  TRACE_SETUP(g_systemDefaults, sessionPresets, loadedDeterrents);
+  sessionEngine =
+      new (sessionEngineStorage) SessionEngine(engineHal(), rules, g_systemDefaults, sessionPresets, loadedDeterrents);
 
   if (hasState) {
     hal.logKeyValue("System", "Restoring state to Session Engine...");
 
     // Load ALL data into engine memory first
+    TRACE_LOAD(savedState, savedTimers, savedStats, savedConfig);
     sessionEngine->loadState(savedState);
     sessionEngine->loadTimers(savedTimers);
     sessionEngine->loadStats(savedStats);
     sessionEngine->loadConfig(savedConfig);
 
     // Now perform the logic checks (which might trigger a re-save)
+    TRACE_CALL(TRACE_CALL_REBOOT);
     sessionEngine->handleReboot();
   } else {
     hal.logKeyValue("System", "No previous state. Starting fresh.");
   }
 
-  // 5. Network
+  // Seconds are due from now on
+  hal.logKeyValue("Session", "Starting millisecond engine timebase.");
+  unsigned long nowMs = hal.getMillis();
+  TRACE_UPDATE(nowMs);
+  sessionEngine->update(nowMs);
+
+#ifndef LEGACY_SINGLE_LOOP
+  // Hand over to the engine task; loop() retires itself.
+  // From here on the engine owns hal.tick() and engine state needs lockState().
+  hal.logKeyValue("System", "Starting engine task.");
+  xTaskCreatePinnedToCore(engineTask, "engine", ENGINE_TASK_STACK, NULL, ENGINE_TASK_PRIORITY, &engineTaskHandle,
+                          ENGINE_TASK_CORE);
+  hal.setInputWakeTask(engineTaskHandle);
+#endif
+  hal.markBootPhase(BOOT_PHASE_ENGINE);
+
+  // --- Phase 4: Network (connects in the background) ---
   network.connectOrRequestProvisioning();
+  hal.markBootPhase(BOOT_PHASE_NETWORK);
+
+  // --- Phase 5: Web API & UDP commands (listen before WiFi is up) ---
+  web.begin(sessionEngine);
+  udpCommands.begin(sessionEngine);
+  hal.markBootPhase(BOOT_PHASE_WEB);
 
-  // 6. Diagnostics
+  // --- Diagnostics ---
   hal.printStartupDiagnostics();
-  hal.tick();
 
-  sessionEngine->printStartupDiagnostics();
-  hal.tick();
+  if (hal.lockState()) {
+    TRACE_CALL(TRACE_CALL_DIAGNOSTICS);
+    sessionEngine->printStartupDiagnostics();
+    hal.unlockState();
+  }
 
   network.printStartupDiagnostics();
-  hal.tick();
 
   hal.log("==========================================================================");
-
-  // 7. Start Master Timer
-  hal.logKeyValue("Session", "Attaching master 1-second ticker.");
-  oneSecondMasterTicker.attach(1, []() {
-    portENTER_CRITICAL_ISR(&timerMux);
-    tickCounter++;
-    portEXIT_CRITICAL_ISR(&timerMux);
-  });
-
-  // 8. Start Web API
-  web.begin(sessionEngine);
 }
 
-void loop() {
+/**
+ * One pass of inputs, safety, engine ticks and the event stream.
+ * Runs in the engine task, or straight from loop() with LEGACY_SINGLE_LOOP.
+ */
+void serviceEngine() {
   // 1. System Housekeeping
   esp_task_wdt_reset();
+  PERF_COUNT_ITERATION();
 
   // 2. Hardware Tick (Inputs, LEDs, Health, Logging)
   hal.tick();
 
-  // 3. Session Engine Tick (Time, Rules, Safety, Network Checks)
-  uint32_t pendingTicks = 0;
-  portENTER_CRITICAL(&timerMux);
-  if (tickCounter > 0) {
-    pendingTicks = tickCounter;
-    tickCounter = 0;
+  // 2b. Immediate Abort: a confirmed long press drops the outputs now, not at the next tick
+  if (hal.isAbortPending() && sessionEngine != nullptr && hal.lockState()) {
+    PERF_PROBE(PROBE_ENGINE_INPUTS);
+    TRACE_CALL(TRACE_CALL_INPUTS);
+    sessionEngine->processInputs();
+    hal.unlockState();
   }
-  portEXIT_CRITICAL(&timerMux);
 
-  if (pendingTicks > 0) {
+  // 3. Session Engine (Time, Rules, Safety, Network Checks)
+  // Deadline based: a late wake-up or a lock timeout only delays the due
+  // seconds, it never drops them, and safety is evaluated once per pass.
+  bool ticked = false;
+  if (sessionEngine != nullptr && sessionEngine->msUntilNextSecond(hal.getMillis()) == 0) {
     if (hal.lockState()) {
-      while (pendingTicks > 0 && sessionEngine != nullptr) {
-        sessionEngine->tick();
-        pendingTicks--;
-      }
-
+      PERF_PROBE(PROBE_ENGINE_UPDATE);
+      unsigned long nowMs = hal.getMillis();
+      TRACE_UPDATE(nowMs);
+      ticked = sessionEngine->update(nowMs);
       hal.unlockState();
     }
   }
-}
\ No newline at end of file
+
+  // 4. Event Stream (full snapshot on transitions, timer delta on ticks)
+  web.publishEvents(ticked, hal.consumeStateChanged());
+}
+
+#ifndef LEGACY_SINGLE_LOOP
+/**
+ * Sleeps until the next engine second is due or a button edge notifies it.
+ * While a press, gesture or interlock debounce is in flight it wakes every
+ * INPUT_POLL_MS instead, so idle CPU is near zero but input latency stays bounded.
+ * In low-power mode this blocked wait is where the CPU light-sleeps.
+ */
+void engineTask(void *arg) {
+  esp_task_wdt_add(NULL);
+  for (;;) {
+    uint32_t waitMs = hal.inputPollIntervalMs();
+    uint32_t dueMs = sessionEngine->msUntilNextSecond(hal.getMillis());
+    if (dueMs < waitMs)
+      waitMs = dueMs;
+
+    int64_t dueUs = esp_timer_get_time() + (int64_t)waitMs * 1000;
+    uint32_t bits = 0;
+    bool notified = xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(waitMs)) == pdTRUE;
+    hal.recordEngineWake(notified && (bits & Esp32SessionHAL::NOTIFY_INPUT), dueUs);
+    serviceEngine();
+  }
+}
+
+void loop() {
+  // All work happens in the engine and io tasks
+  esp_task_wdt_delete(NULL);
+  vTaskDelete(NULL);
+}
+#else
+void loop() { serviceEngine(); }
+#endif
\ No newline at end of file
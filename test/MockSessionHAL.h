@@ -12,7 +12,8 @@
 class MockSessionHAL : public ISessionHAL {
 public:
     // --- Spy Variables ---
-    uint8_t lastSafetyMask = 0xFF; 
+    ChannelMask lastSafetyMask = (ChannelMask)~0u;
+    int safetyMaskWrites = 0;
     uint32_t lastWatchdogTimeout = 0;
     bool failsafeArmed = false;
     uint32_t lastFailsafeArmedSeconds = 0;
@@ -25,14 +26,24 @@ public:
     SessionStats savedStats;
     SessionConfig savedConfig;
 
+    // Checkpoint Spy
+    int checkpointCount = 0;
+    DeviceState checkpointState;
+    SessionTimers checkpointTimers;
+    SessionStats checkpointStats;
+
+    // History Spy
+    std::vector<HistoryEntry> history;
+
     // Simulation Variables
     uint32_t currentMillis = 1000; 
     std::vector<std::string> logs;
+    std::vector<EngineEvent> events;
     
     // Hardware 
     bool _mockSafetyRaw = false; 
     bool _mockSafetyValid = false;
-    uint8_t _mockChannelMask = 0x0F;
+    ChannelMask _mockChannelMask = CHANNEL_MASK_ALL;
     bool ledEnabled = true;
 
     // Input Event States
@@ -46,6 +57,7 @@ public:
     
     // RNG State
     uint32_t _rngSeed = 12345;
+    int fillRandomCalls = 0;
 
     // --- Helpers for Test Control ---
 
@@ -83,16 +95,17 @@ public:
 
     // --- ISessionHAL Implementation ---
 
-    void setHardwareSafetyMask(uint8_t mask) override {
+    void setHardwareSafetyMask(ChannelMask mask) override {
         lastSafetyMask = mask;
+        safetyMaskWrites++;
     }
 
     bool isChannelEnabled(int channelIndex) const override {
-        if (channelIndex < 0 || channelIndex >= 4) return false;
+        if (channelIndex < 0 || channelIndex >= MAX_CHANNELS) return false;
         return (_mockChannelMask >> channelIndex) & 1;
     }
 
-    void setChannelMask(uint8_t mask) {
+    void setChannelMask(ChannelMask mask) {
         _mockChannelMask = mask;
     }
 
@@ -173,29 +186,56 @@ public:
         savedConfig = config;
     }
 
+    void saveCheckpoint(const DeviceState& state, const SessionTimers& timers, const SessionStats& stats) override {
+        checkpointCount++;
+        checkpointState = state;
+        checkpointTimers = timers;
+        checkpointStats = stats;
+    }
+
+    void appendHistory(const HistoryEntry& entry) override {
+        history.push_back(entry);
+    }
+
     // --- Logging ---
     void log(const char* message) override {
         logs.push_back(std::string(message));
     }
 
+    // Records the typed event; the formatted line also lands in 'logs' so
+    // text-based assertions keep working.
+    void logEvent(const EngineEvent& event) override {
+        events.push_back(event);
+        char buf[128];
+        EngineEvents::format(event, buf, sizeof(buf));
+        logs.push_back(std::string(buf));
+    }
+
+    int countEvents(EngineEventId id) const {
+        int n = 0;
+        for (const auto& e : events) if (e.id == id) n++;
+        return n;
+    }
+
     // --- Time & Random ---
     unsigned long getMillis() override {
         return currentMillis;
     }
 
+    // Durations: deterministic "Average" to keep test timings exact.
+    uint32_t getRandom(uint32_t min, uint32_t max) override {
+        return (min + max) / 2; 
+    }
+
     /**
-     * Uses a simple Linear Congruential Generator (LCG) for the reward code range (0-3)
-     * to ensure the generated code varies, preventing collision loops.
-     * Falls back to "Average" for other ranges (durations) to preserve existing test logic.
+     * Reward codes: a simple Linear Congruential Generator (LCG) so generated
+     * codes vary, preventing collision loops.
      */
-    uint32_t getRandom(uint32_t min, uint32_t max) override {
-        // Specific case for Reward Code Generation
-        if (min == 0 && max == 4) {
+    void fillRandom(uint8_t* buf, size_t len) override {
+        fillRandomCalls++;
+        for (size_t i = 0; i < len; i++) {
             _rngSeed = _rngSeed * 1103515245 + 12345;
-            return (_rngSeed / 65536) % 4;
+            buf[i] = (uint8_t)(_rngSeed >> 16);
         }
-        
-        // Default behavior for durations (Deterministic Average)
-        return (min + max) / 2; 
     }
 };
\ No newline at end of file
@@ -0,0 +1,274 @@
+/*
+ * File: test/TraceReplay.h
+ * Description: Replays an EngineTrace (lib/SessionEngine/EngineTrace.h) on the host.
+ *
+ * A fresh SessionEngine is built from the trace's setup record, then every
+ * recorded call is made again in order. The engine's HAL queries are answered
+ * from the trace, and its outputs (safety mask, saved state, return codes)
+ * are compared with the recorded ones. Any difference is a divergence:
+ * - value: same interaction, different output (replay continues)
+ * - order: the engine asked for something else than was recorded, or left a
+ *   recorded input unread (replay stops, later records no longer line up)
+ * Each replayed call is timed per call kind, so a trace doubles as a benchmark.
+ */
+#pragma once
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <vector>
+
+#include "EngineTrace.h"
+#include "MockSessionHAL.h"
+#include "Session.h"
+#include "StandardRules.h"
+
+#define TRACE_CALL_KINDS (TRACE_CALL_END - TRACE_CALL_SETUP)
+
+// Report labels, in TraceKind order from TRACE_CALL_SETUP
+static const char *const TRACE_CALL_NAMES[TRACE_CALL_KINDS] = {
+    "setup", "load", "reboot", "update", "inputs", "start", "test_start",
+    "test_stop", "abort", "trigger", "pet", "modify", "diagnostics",
+};
+
+struct TraceDivergence {
+    uint32_t step;        // Calls replayed before it (0-based index of the call it happened in)
+    size_t offset;        // Byte offset of the recorded record
+    uint8_t expectedKind; // Recorded (0 = end of trace)
+    uint8_t actualKind;   // What the engine did (0 = nothing: the call returned)
+    uint32_t expected;
+    uint32_t actual;
+};
+
+struct TraceStepStats {
+    uint32_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+};
+
+// Answers the engine from the trace; the spy state of MockSessionHAL still updates
+class TraceReplayHAL : public MockSessionHAL {
+public:
+    TraceReplayHAL(TraceReader &reader, std::vector<TraceDivergence> &divergences)
+        : step(0), stopped(false), truncated(false), _reader(reader), _divergences(divergences) {}
+
+    uint32_t step;
+    bool stopped;   // Order divergence: the rest of the trace no longer lines up
+    bool truncated; // The trace ended inside a call (recording buffer was full)
+
+    // Next record must be 'kind'. On a mismatch the replay stops.
+    bool take(uint8_t kind, TraceRecord &r) {
+        if (stopped || truncated) return false;
+        if (!_reader.peek(r)) {
+            truncated = true;
+            return false;
+        }
+        if (r.kind != kind) {
+            diverge(r.offset, r.kind, kind, r.value, 0);
+            stopped = true;
+            return false;
+        }
+        _reader.consume(r);
+        return true;
+    }
+
+    void diverge(size_t offset, uint8_t expectedKind, uint8_t actualKind, uint32_t expected, uint32_t actual) {
+        _divergences.push_back(TraceDivergence{step, offset, expectedKind, actualKind, expected, actual});
+    }
+
+    // --- Inputs ---
+    unsigned long getMillis() override {
+        TraceRecord r;
+        if (take(TRACE_IN_MILLIS, r)) currentMillis = r.value;
+        return currentMillis;
+    }
+
+    uint32_t getRandom(uint32_t min, uint32_t max) override {
+        TraceRecord r;
+        return take(TRACE_IN_RANDOM, r) ? r.value : MockSessionHAL::getRandom(min, max);
+    }
+
+    void fillRandom(uint8_t *buf, size_t len) override {
+        fillRandomCalls++;
+        memset(buf, 0, len);
+        for (size_t off = 0; off < len;) {
+            TraceRecord r;
+            if (!take(TRACE_IN_FILL, r)) return;
+            size_t n = r.blobLen < len - off ? r.blobLen : len - off;
+            memcpy(buf + off, r.blob, n);
+            off += n;
+        }
+    }
+
+    bool checkTriggerAction() override { return flag(TRACE_IN_TRIGGER); }
+    bool checkAbortAction() override { return flag(TRACE_IN_ABORT); }
+    bool checkShortPressAction() override { return flag(TRACE_IN_SHORT_PRESS); }
+    bool isSafetyInterlockValid() override { return _mockSafetyValid = flag(TRACE_IN_INTERLOCK_VALID); }
+    bool isSafetyInterlockEngaged() override { return _mockSafetyRaw = flag(TRACE_IN_INTERLOCK_ENGAGED); }
+    bool isNetworkProvisioningRequested() override { return flag(TRACE_IN_PROVISIONING); }
+
+    bool isChannelEnabled(int channelIndex) const override {
+        TraceRecord r;
+        TraceReplayHAL *self = const_cast<TraceReplayHAL *>(this); // Replay state only
+        if (!self->take(TRACE_IN_CHANNEL, r)) return false;
+        if (r.value != (uint32_t)channelIndex) self->diverge(r.offset, TRACE_IN_CHANNEL, TRACE_IN_CHANNEL, r.value, channelIndex);
+        return r.flag;
+    }
+
+    // --- Outputs ---
+    void setHardwareSafetyMask(ChannelMask mask) override {
+        MockSessionHAL::setHardwareSafetyMask(mask);
+        expect(TRACE_OUT_MASK, mask);
+    }
+
+    void saveState(const DeviceState &state, const SessionTimers &timers, const SessionStats &stats,
+                   const SessionConfig &config) override {
+        MockSessionHAL::saveState(state, timers, stats, config);
+        expect(TRACE_OUT_STATE, state);
+    }
+
+    // Quiet: long traces would fill the spy vectors
+    void log(const char *message) override { (void)message; }
+    void logEvent(const EngineEvent &event) override { (void)event; }
+
+    void expect(uint8_t kind, uint32_t actual) {
+        TraceRecord r;
+        if (take(kind, r) && r.value != actual) diverge(r.offset, kind, kind, r.value, actual);
+    }
+
+private:
+    bool flag(uint8_t kind) {
+        TraceRecord r;
+        return take(kind, r) && r.flag;
+    }
+
+    TraceReader &_reader;
+    std::vector<TraceDivergence> &_divergences;
+};
+
+class TraceReplayer {
+public:
+    TraceReplayer(const uint8_t *data, size_t len) : _reader(data, len), _hal(_reader, _divergences), _steps(0) {
+        memset(_stats, 0, sizeof(_stats));
+    }
+
+    /**
+     * Replays the whole trace.
+     * @return true when it was valid and replayed without any divergence.
+     */
+    bool run() {
+        if (!_reader.valid()) return false;
+
+        TraceRecord r;
+        while (!_hal.stopped && !_hal.truncated && _reader.next(r)) {
+            if (TraceCodec::isCall(r.kind)) {
+                _hal.step = _steps;
+                int result = 0;
+                typedef std::chrono::steady_clock Clock;
+                Clock::time_point start = Clock::now();
+                bool hasResult = execute(r, result);
+                uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+                TraceStepStats &s = _stats[r.kind - TRACE_CALL_SETUP];
+                s.count++;
+                s.totalNs += ns;
+                if (ns > s.maxNs) s.maxNs = ns;
+                _steps++;
+
+                // A recorded result follows calls that return one
+                TraceRecord next;
+                if (hasResult && _reader.peek(next) && next.kind == TRACE_OUT_RESULT) {
+                    _reader.consume(next);
+                    if (next.value != HistoryCodec::zigzag(result))
+                        _hal.diverge(next.offset, TRACE_OUT_RESULT, TRACE_OUT_RESULT, next.value, HistoryCodec::zigzag(result));
+                }
+            } else if (!_hal.truncated) {
+                // Recorded inside the previous call, but the engine never asked for it
+                _hal.diverge(r.offset, r.kind, 0, r.value, 0);
+                _hal.stopped = true;
+            }
+        }
+        return _divergences.empty() && !_reader.corrupt();
+    }
+
+    bool valid() const { return _reader.valid(); }
+    bool corrupt() const { return _reader.corrupt(); }
+    bool truncated() const { return _hal.truncated; }
+    uint32_t steps() const { return _steps; }
+    const std::vector<TraceDivergence> &divergences() const { return _divergences; }
+    const TraceStepStats &stats(TraceKind call) const { return _stats[call - TRACE_CALL_SETUP]; }
+    const SessionEngine *engine() const { return _engine.get(); }
+    const TraceReplayHAL &hal() const { return _hal; }
+
+    void printReport(FILE *f) const {
+        fprintf(f, "trace: %u calls replayed%s%s, %u divergences\n", (unsigned)_steps, truncated() ? ", truncated" : "",
+                corrupt() ? ", corrupt" : "", (unsigned)_divergences.size());
+        for (const TraceDivergence &d : _divergences)
+            fprintf(f, "  call %u @%u: recorded kind %u value %u, replay kind %u value %u\n", (unsigned)d.step,
+                    (unsigned)d.offset, d.expectedKind, (unsigned)d.expected, d.actualKind, (unsigned)d.actual);
+        for (int k = 0; k < TRACE_CALL_KINDS; k++) {
+            const TraceStepStats &s = _stats[k];
+            if (s.count)
+                fprintf(f, "  %-12s %6u calls, avg %8.0f ns, max %8llu ns\n", TRACE_CALL_NAMES[k],
+                        (unsigned)s.count, (double)s.totalNs / s.count, (unsigned long long)s.maxNs);
+        }
+    }
+
+private:
+    // Returns true when the call has a return code
+    bool execute(const TraceRecord &r, int &result) {
+        if (r.kind == TRACE_CALL_SETUP) {
+            if (!TraceCodec::decodeSetup(r.blob, r.blobLen, _defaults, _presets, _deterrents)) return corruptCall(r);
+            _engine.reset(new SessionEngine(_hal, _rules, _defaults, _presets, _deterrents));
+            return false;
+        }
+        if (!_engine) return corruptCall(r); // Every other call needs the engine
+
+        switch (r.kind) {
+        case TRACE_CALL_LOAD: {
+            DeviceState state;
+            SessionTimers timers;
+            SessionStats stats;
+            SessionConfig config;
+            if (!SessionRecordCodec::decode(r.blob, r.blobLen, state, timers, stats, config)) return corruptCall(r);
+            _engine->loadState(state);
+            _engine->loadTimers(timers);
+            _engine->loadStats(stats);
+            _engine->loadConfig(config);
+            return false;
+        }
+        case TRACE_CALL_REBOOT: _engine->handleReboot(); return false;
+        case TRACE_CALL_UPDATE: _engine->update(r.value); return false;
+        case TRACE_CALL_INPUTS: _engine->processInputs(); return false;
+        case TRACE_CALL_START: {
+            SessionConfig config;
+            if (!TraceCodec::decodeConfig(r.blob, r.blobLen, config)) return corruptCall(r);
+            result = _engine->startSession(config);
+            return true;
+        }
+        case TRACE_CALL_TEST_START: result = _engine->startTest(); return true;
+        case TRACE_CALL_TEST_STOP: _engine->stopTest(); return false;
+        case TRACE_CALL_ABORT: _engine->abort("Replay"); return false;
+        case TRACE_CALL_TRIGGER: _engine->trigger("Replay"); return false;
+        case TRACE_CALL_PET: _engine->petWatchdog(); return false;
+        case TRACE_CALL_MODIFY: result = _engine->modifyTime(r.flag); return true;
+        case TRACE_CALL_DIAGNOSTICS: _engine->printStartupDiagnostics(); return false;
+        default: return corruptCall(r);
+        }
+    }
+
+    bool corruptCall(const TraceRecord &r) {
+        _hal.diverge(r.offset, r.kind, 0, 0, 0);
+        _hal.stopped = true;
+        return false;
+    }
+
+    TraceReader _reader;
+    std::vector<TraceDivergence> _divergences;
+    TraceReplayHAL _hal;
+    StandardRules _rules;
+    SystemDefaults _defaults;
+    SessionPresets _presets;
+    DeterrentConfig _deterrents;
+    std::unique_ptr<SessionEngine> _engine;
+    uint32_t _steps;
+    TraceStepStats _stats[TRACE_CALL_KINDS];
+};
@@ -0,0 +1,276 @@
+/*
+ * File: test/bench_engine/bench_engine.cpp
+ * Description: Native host benchmarks for SessionEngine and WebValidators.
+ *
+ * Not a Unity suite (no test_ prefix, so `pio test` skips it). Built and run by
+ *   BENCH_JSON=bench_results.json pio run -e native_bench -t exec
+ * and compared against a stored baseline by scripts/compare_bench.py.
+ *
+ * Every metric reports ns/op and heap allocations/op. Engine allocations are
+ * counted via the global operator new; ArduinoJson allocations via a counting
+ * ArduinoJson::Allocator. Timing varies between machines, allocation counts
+ * are deterministic.
+ *
+ * With BENCH_TRACE=<file> a trace downloaded from GET /trace is replayed as
+ * well, adding one trace_<call> metric per engine call kind (timing only).
+ */
+#include <ArduinoJson.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "MockSessionHAL.h"
+#include "Session.h"
+#include "StandardRules.h"
+#include "TraceReplay.h"
+#include "WebValidators.h"
+
+// ============================================================================
+// COUNTING ALLOCATOR HOOKS
+// ============================================================================
+
+static uint64_t g_allocCount = 0;
+static uint64_t g_allocBytes = 0;
+
+void *operator new(size_t size) {
+    g_allocCount++;
+    g_allocBytes += size;
+    void *p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+class CountingJsonAllocator : public ArduinoJson::Allocator {
+public:
+    void *allocate(size_t size) override {
+        g_allocCount++;
+        g_allocBytes += size;
+        return malloc(size);
+    }
+    void deallocate(void *p) override { free(p); }
+    void *reallocate(void *p, size_t size) override {
+        g_allocCount++;
+        g_allocBytes += size;
+        return realloc(p, size);
+    }
+};
+
+static CountingJsonAllocator g_jsonAllocator;
+
+// ============================================================================
+// HARNESS
+// ============================================================================
+
+// Mock HAL without the spy log vectors, so they do not dominate the cost
+class BenchHAL : public MockSessionHAL {
+public:
+    void log(const char *message) override { (void)message; }
+    void logEvent(const EngineEvent &event) override { (void)event; }
+};
+
+struct Metric {
+    std::string name;
+    uint64_t ops;
+    uint64_t totalNs;
+    uint64_t allocs;
+    uint64_t allocBytes;
+};
+
+static std::vector<Metric> g_metrics;
+
+typedef std::chrono::steady_clock BenchClock;
+
+// Accumulates one timed op; setup/teardown stay outside the window
+class OpTimer {
+public:
+    explicit OpTimer(Metric &m) : _m(m), _allocs(g_allocCount), _bytes(g_allocBytes), _start(BenchClock::now()) {}
+    ~OpTimer() {
+        _m.totalNs += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - _start).count();
+        _m.allocs += g_allocCount - _allocs;
+        _m.allocBytes += g_allocBytes - _bytes;
+        _m.ops++;
+    }
+
+private:
+    Metric &_m;
+    uint64_t _allocs;
+    uint64_t _bytes;
+    BenchClock::time_point _start;
+};
+
+static Metric &newMetric(const char *name) {
+    g_metrics.push_back(Metric{name, 0, 0, 0, 0});
+    return g_metrics.back();
+}
+
+// --- Configuration (matches the test suites, with a long ceiling for tick runs) ---
+static const SystemDefaults defaults = {5, 10, 240, 10000, 4, 5, 30000, 3, 60, 60};
+static const SessionPresets presets = {300, 600, 900, 1800, 3600, 7200, 14 * 86400, 10};
+static const DeterrentConfig deterrents = {true, true, DETERRENT_FIXED, 300, 900, 300, true, DETERRENT_FIXED, 60, 120, 60, true, 300};
+
+static SessionConfig lockConfig(uint32_t seconds) {
+    SessionConfig cfg = {};
+    cfg.durationType = DUR_FIXED;
+    cfg.durationFixed = seconds;
+    cfg.triggerStrategy = STRAT_BUTTON_TRIGGER;
+    return cfg;
+}
+
+// ============================================================================
+// BENCHMARKS
+// ============================================================================
+
+static void benchTick() {
+    BenchHAL hal;
+    StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    hal.setSafetyInterlock(true);
+    engine.startSession(lockConfig(14 * 86400));
+    engine.trigger("Bench");
+
+    Metric &m = newMetric("engine_tick");
+    for (int i = 0; i < 200000; i++) {
+        OpTimer t(m);
+        engine.tick();
+    }
+}
+
+static void benchAdvance() {
+    BenchHAL hal;
+    StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    hal.setSafetyInterlock(true);
+    engine.startSession(lockConfig(14 * 86400));
+    engine.trigger("Bench");
+
+    Metric &m = newMetric("engine_advance_1h");
+    for (int i = 0; i < 300; i++) {
+        OpTimer t(m);
+        engine.advance(3600);
+    }
+}
+
+static void benchSessionApi() {
+    const int N = 2000;
+    Metric &start = newMetric("start_session");
+    Metric &abortOp = newMetric("abort");
+    Metric &modify = newMetric("modify_time");
+    Metric &reward = newMetric("reward_generate");
+
+    for (int i = 0; i < N; i++) {
+        BenchHAL hal;
+        StandardRules rules;
+        hal.setSafetyInterlock(true);
+
+        // The constructor's work is reward generation plus the first snapshot.
+        // Its one allocation is the engine object itself.
+        SessionEngine *engine;
+        {
+            OpTimer t(reward);
+            engine = new SessionEngine(hal, rules, defaults, presets, deterrents);
+        }
+
+        SessionConfig cfg = lockConfig(3600);
+        {
+            OpTimer t(start);
+            engine->startSession(cfg);
+        }
+        engine->trigger("Bench");
+
+        {
+            OpTimer t(modify);
+            engine->modifyTime((i & 1) == 0);
+        }
+        {
+            OpTimer t(abortOp);
+            engine->abort("Bench");
+        }
+        delete engine;
+    }
+}
+
+static void benchParseSessionConfig() {
+    static const char body[] = "{\"durationType\":\"DUR_FIXED\",\"durationFixed\":3600,"
+                               "\"triggerStrategy\":\"STRAT_AUTO_COUNTDOWN\",\"channelDelays\":[0,10,20,30],"
+                               "\"hideTimer\":false,\"disableLED\":true}";
+
+    Metric &m = newMetric("parse_session_config");
+    std::string err;
+    for (int i = 0; i < 20000; i++) {
+        OpTimer t(m);
+        JsonDocument doc(&g_jsonAllocator);
+        deserializeJson(doc, body);
+        SessionConfig cfg;
+        WebValidators::parseSessionConfig(doc.as<JsonVariant>(), 0x0F, cfg, err);
+    }
+}
+
+static bool benchTraceReplay() {
+    const char *path = getenv("BENCH_TRACE");
+    if (path == nullptr || *path == '\0') return true;
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "bench_engine: cannot read %s\n", path);
+        return false;
+    }
+    std::vector<uint8_t> trace;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) trace.insert(trace.end(), chunk, chunk + n);
+    fclose(f);
+
+    TraceReplayer replay(trace.data(), trace.size());
+    bool ok = replay.run();
+    if (!ok) replay.printReport(stderr); // A diverging trace times a different run
+    for (int k = 0; k < TRACE_CALL_KINDS; k++) {
+        const TraceStepStats &s = replay.stats((TraceKind)(TRACE_CALL_SETUP + k));
+        if (s.count) g_metrics.push_back(Metric{std::string("trace_") + TRACE_CALL_NAMES[k], s.count, s.totalNs, 0, 0});
+    }
+    return ok;
+}
+
+// ============================================================================
+// REPORT
+// ============================================================================
+
+static void writeJson(FILE *f) {
+    fprintf(f, "{\n  \"suite\": \"bench_engine\",\n  \"metrics\": {\n");
+    for (size_t i = 0; i < g_metrics.size(); i++) {
+        const Metric &m = g_metrics[i];
+        double ops = m.ops ? (double)m.ops : 1.0;
+        fprintf(f, "    \"%s\": {\"ops\": %llu, \"nsPerOp\": %.1f, \"opsPerSec\": %.0f, \"allocsPerOp\": %.2f, \"allocBytesPerOp\": %.1f}%s\n",
+                m.name.c_str(), (unsigned long long)m.ops, m.totalNs / ops, m.totalNs ? 1e9 * ops / m.totalNs : 0.0,
+                m.allocs / ops, m.allocBytes / ops, i + 1 < g_metrics.size() ? "," : "");
+    }
+    fprintf(f, "  }\n}\n");
+}
+
+int main() {
+    g_metrics.reserve(16 + TRACE_CALL_KINDS);
+
+    benchTick();
+    benchAdvance();
+    benchSessionApi();
+    benchParseSessionConfig();
+    if (!benchTraceReplay()) return 1;
+
+    writeJson(stdout);
+
+    const char *path = getenv("BENCH_JSON");
+    if (path && *path) {
+        FILE *f = fopen(path, "w");
+        if (!f) {
+            fprintf(stderr, "bench_engine: cannot write %s\n", path);
+            return 1;
+        }
+        writeJson(f);
+        fclose(f);
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * File: test/test_admission_control/test_admission_control.cpp
+ * Description: Unit tests for HTTP admission control: token bucket refill,
+ * per-client isolation, the heavy in-flight cap and its wait queue, the safety
+ * lane and settling requests whose cost is only known after parsing.
+ */
+#include <unity.h>
+#include "AdmissionControl.h"
+
+// 4 token burst, 2 tokens/s, heavy costs 2, one heavy in flight, queued up to 500 ms
+static const AdmissionConfig cfg = {4, 2, 2, 1, 500};
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================================================
+// TOKEN BUCKET
+// ============================================================================
+
+void test_bucket_drains_and_refills(void) {
+    TokenBucket b;
+    b.reset(0, 4);
+    for (int i = 0; i < 4; i++) TEST_ASSERT_TRUE(b.take(0, 1, 4, 2));
+    TEST_ASSERT_FALSE(b.take(0, 1, 4, 2));
+    TEST_ASSERT_EQUAL_UINT32(500, b.msUntil(1, 2));
+
+    TEST_ASSERT_FALSE(b.take(499, 1, 4, 2));
+    TEST_ASSERT_TRUE(b.take(500, 1, 4, 2));
+
+    // Refill never exceeds the burst
+    TEST_ASSERT_TRUE(b.take(60000, 4, 4, 2));
+    TEST_ASSERT_FALSE(b.take(60000, 1, 4, 2));
+}
+
+// ============================================================================
+// CONTROLLER
+// ============================================================================
+
+void test_clients_have_separate_buckets(void) {
+    AdmissionController<4> ac(cfg);
+    for (int i = 0; i < 4; i++) TEST_ASSERT_EQUAL(ADMIT_OK, ac.admit(1, ADMIT_NORMAL, 1000));
+    TEST_ASSERT_EQUAL(ADMIT_RATE_LIMITED, ac.admit(1, ADMIT_NORMAL, 1000));
+    TEST_ASSERT_EQUAL_UINT32(500, ac.retryAfterMs());
+
+    // The flooder does not affect anyone else
+    TEST_ASSERT_EQUAL(ADMIT_OK, ac.admit(2, ADMIT_NORMAL, 1000));
+    TEST_ASSERT_EQUAL_UINT32(1, ac.stats().rateLimited);
+    TEST_ASSERT_EQUAL_UINT32(5, ac.stats().admitted[ADMIT_NORMAL]);
+}
+
+void test_safety_lane_is_always_admitted(void) {
+    AdmissionController<4> ac(cfg);
+    for (int i = 0; i < 4; i++) ac.admit(1, ADMIT_NORMAL, 1000);
+    TEST_ASSERT_EQUAL(ADMIT_RATE_LIMITED, ac.admit(1, ADMIT_NORMAL, 1000));
+
+    for (int i = 0; i < 50; i++) TEST_ASSERT_EQUAL(ADMIT_OK, ac.admit(1, ADMIT_SAFETY, 1000));
+    TEST_ASSERT_EQUAL_UINT32(50, ac.stats().admitted[ADMIT_SAFETY]);
+}
+
+void test_heavy_lane_is_capped_until_release(void) {
+    AdmissionController<4> ac(cfg);
+    TEST_ASSERT_EQUAL(ADMIT_OK, ac.admit(1, ADMIT_HEAVY, 1000));
+    TEST_ASSERT_EQUAL(ADMIT_BUSY, ac.admit(2, ADMIT_HEAVY, 1000));
+    TEST_ASSERT_EQUAL_UINT8(1, ac.stats().heavyInFlight);
+
+    ac.release(ADMIT_HEAVY, 1000);
+    TEST_ASSERT_EQUAL(ADMIT_OK, ac.admit(2, ADMIT_HEAVY, 1000));
+    ac.release(ADMIT_HEAVY, 1000);
+
+    // Heavy costs 2: client 1 has 2 tokens left
+    TEST_ASSERT_EQUAL(ADMIT_OK, ac.admit(1, ADMIT_HEAVY, 1000));
+    ac.release(ADMIT_HEAVY, 1000);
+    TEST_ASSERT_EQUAL(ADMIT_RATE_LIMITED, ac.admit(1, ADMIT_HEAVY, 1000));
+    TEST_ASSERT_EQUAL_UINT8(0, ac.stats().heavyInFlight);
+    TEST_ASSERT_EQUAL_UINT8(1, ac.stats().heavyInFlightMax);
+}
+
+void test_heavy_requests_queue_for_a_slot(void) {
+    AdmissionController<4, 2> ac(cfg);
+    int a, b, c;
+    TEST_ASSERT_EQUAL(ADMIT_OK, ac.admit(1, ADMIT_HEAVY, 1000, &a));
+    TEST_ASSERT_EQUAL(ADMIT_QUEUED, ac.admit(2, ADMIT_HEAVY, 1000, &b));
+    TEST_ASSERT_EQUAL(ADMIT_QUEUED, ac.admit(3, ADMIT_HEAVY, 1100, &c));
+    TEST_ASSERT_EQUAL(ADMIT_BUSY, ac.admit(4, ADMIT_HEAVY, 1100, &a)); // Queue full
+    TEST_ASSERT_EQUAL(ADMIT_BUSY, ac.admit(4, ADMIT_HEAVY, 1100));     // No waiter: no queueing
+    TEST_ASSERT_EQUAL_UINT8(2, ac.stats().queueDepth);
+
+    // The slot passes to the oldest waiter; the in-flight count does not drop
+    TEST_ASSERT_NULL(ac.expire(1200));
+    TEST_ASSERT_EQUAL_PTR(&b, ac.release(ADMIT_HEAVY, 1200));
+    TEST_ASSERT_EQUAL_UINT8(1, ac.stats().heavyInFlight);
+    TEST_ASSERT_EQUAL_UINT32(200, ac.stats().queueWaitMsMax);
+    TEST_ASSERT_EQUAL_UINT32(2, ac.stats().admitted[ADMIT_HEAVY]);
+
+    // A waiter past heavyMaxWaitMs is expired, not run
+    TEST_ASSERT_EQUAL_PTR(&c, ac.expire(1600));
+    TEST_ASSERT_NULL(ac.release(ADMIT_HEAVY, 1600));
+    TEST_ASSERT_EQUAL_UINT8(0, ac.stats().heavyInFlight);
+    TEST_ASSERT_EQUAL_UINT32(1, ac.stats().queueTimeouts);
+
+    // A cancelled waiter leaves the queue
+    TEST_ASSERT_EQUAL(ADMIT_OK, ac.admit(1, ADMIT_HEAVY, 1600, &a));
+    TEST_ASSERT_EQUAL(ADMIT_QUEUED, ac.admit(2, ADMIT_HEAVY, 1600, &b));
+    TEST_ASSERT_TRUE(ac.cancel(&b));
+    TEST_ASSERT_FALSE(ac.cancel(&b));
+    TEST_ASSERT_NULL(ac.release(ADMIT_HEAVY, 1700));
+    TEST_ASSERT_EQUAL_UINT32(3, ac.stats().queued);
+    TEST_ASSERT_EQUAL_UINT32(1, ac.stats().queueCancels);
+    TEST_ASSERT_EQUAL_UINT8(2, ac.stats().queueDepthMax);
+}
+
+void test_settle_charges_each_op_or_refunds(void) {
+    AdmissionController<4> ac(cfg);
+
+    // Three ops cost three tokens: one at admission, two when settled
+    TEST_ASSERT_EQUAL(ADMIT_OK, ac.admit(1, ADMIT_NORMAL, 1000));
+    TEST_ASSERT_EQUAL(ADMIT_OK, ac.settle(1, 3, 1000));
+    TEST_ASSERT_EQUAL(ADMIT_OK, ac.admit(1, ADMIT_NORMAL, 1000));
+    TEST_ASSERT_EQUAL(ADMIT_RATE_LIMITED, ac.settle(1, 2, 1000));
+    TEST_ASSERT_EQUAL_UINT32(500, ac.retryAfterMs());
+
+    // Safety-only content gets its admission token back
+    AdmissionController<4> fresh(cfg);
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(ADMIT_OK, fresh.admit(2, ADMIT_NORMAL, 1000));
+        TEST_ASSERT_EQUAL(ADMIT_OK, fresh.settle(2, 0, 1000));
+    }
+    TEST_ASSERT_EQUAL_UINT32(10, fresh.stats().admitted[ADMIT_SAFETY]);
+    TEST_ASSERT_EQUAL_UINT32(0, fresh.stats().admitted[ADMIT_NORMAL]);
+    for (int i = 0; i < 4; i++) TEST_ASSERT_EQUAL(ADMIT_OK, fresh.admit(2, ADMIT_NORMAL, 1000));
+    TEST_ASSERT_EQUAL(ADMIT_RATE_LIMITED, fresh.admit(2, ADMIT_NORMAL, 1000));
+}
+
+void test_least_recent_client_is_evicted(void) {
+    AdmissionController<2> ac(cfg);
+    for (int i = 0; i < 4; i++) ac.admit(1, ADMIT_NORMAL, 1000);
+    ac.admit(2, ADMIT_NORMAL, 2000);
+    ac.admit(3, ADMIT_NORMAL, 3000); // Evicts client 1 (seen longest ago)
+    TEST_ASSERT_EQUAL_UINT32(1, ac.stats().evictions);
+
+    // Client 1 comes back with a fresh bucket
+    TEST_ASSERT_EQUAL(ADMIT_OK, ac.admit(1, ADMIT_NORMAL, 3000));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_bucket_drains_and_refills);
+    RUN_TEST(test_clients_have_separate_buckets);
+    RUN_TEST(test_safety_lane_is_always_admitted);
+    RUN_TEST(test_heavy_lane_is_capped_until_release);
+    RUN_TEST(test_heavy_requests_queue_for_a_slot);
+    RUN_TEST(test_settle_charges_each_op_or_refunds);
+    RUN_TEST(test_least_recent_client_is_evicted);
+    return UNITY_END();
+}
@@ -0,0 +1,113 @@
+/*
+ * File: test/test_button_gesture/test_button_gesture.cpp
+ * Description: Unit tests for the edge-timestamp gesture classifier that
+ * replaces OneButton. Covers click, double-click, long press, debounce
+ * and recovery from lost edges.
+ */
+#include <unity.h>
+#include "ButtonGesture.h"
+
+static ButtonGesture makeButton() {
+    ButtonGesture b;
+    ButtonGesture::Config cfg = {50, 400, 5000};
+    b.configure(cfg);
+    return b;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================================================
+// CLICKS
+// ============================================================================
+
+void test_single_click_reports_after_window(void) {
+    ButtonGesture b = makeButton();
+    TEST_ASSERT_EQUAL(GESTURE_PRESS, b.onEdge(1000, true));
+    TEST_ASSERT_TRUE(b.isPressed());
+    TEST_ASSERT_EQUAL(GESTURE_NONE, b.onEdge(1120, false));
+
+    // Still inside the double-click window
+    TEST_ASSERT_EQUAL(GESTURE_NONE, b.update(1400, false));
+    TEST_ASSERT_FALSE(b.isIdle());
+
+    TEST_ASSERT_EQUAL(GESTURE_CLICK, b.update(1520, false));
+    TEST_ASSERT_TRUE(b.isIdle());
+}
+
+void test_double_click_reports_on_second_release(void) {
+    ButtonGesture b = makeButton();
+    b.onEdge(1000, true);
+    b.onEdge(1100, false);
+    TEST_ASSERT_EQUAL(GESTURE_PRESS, b.onEdge(1250, true));
+    TEST_ASSERT_EQUAL(GESTURE_DOUBLE_CLICK, b.onEdge(1350, false));
+    TEST_ASSERT_TRUE(b.isIdle());
+
+    // No trailing single click
+    TEST_ASSERT_EQUAL(GESTURE_NONE, b.update(3000, false));
+}
+
+// ============================================================================
+// LONG PRESS
+// ============================================================================
+
+void test_long_press_uses_edge_timestamp(void) {
+    ButtonGesture b = makeButton();
+    b.onEdge(1000, true);
+
+    TEST_ASSERT_EQUAL(GESTURE_NONE, b.update(5999, true));
+    TEST_ASSERT_EQUAL(GESTURE_LONG_START, b.update(6000, true));
+    TEST_ASSERT_EQUAL(GESTURE_NONE, b.update(6010, true)); // Reported once
+    TEST_ASSERT_EQUAL(GESTURE_LONG_STOP, b.onEdge(7000, false));
+    TEST_ASSERT_TRUE(b.isIdle());
+}
+
+void test_late_processing_still_classifies_long_press(void) {
+    ButtonGesture b = makeButton();
+    // Both edges processed together (e.g. the caller was busy): durations come from timestamps
+    b.onEdge(1000, true);
+    TEST_ASSERT_EQUAL(GESTURE_LONG_START | GESTURE_LONG_STOP, b.onEdge(6500, false));
+}
+
+void test_hold_after_tap_is_long_press(void) {
+    ButtonGesture b = makeButton();
+    b.onEdge(1000, true);
+    b.onEdge(1100, false);
+    b.onEdge(1200, true);
+    TEST_ASSERT_EQUAL(GESTURE_LONG_START, b.update(6200, true));
+}
+
+// ============================================================================
+// DEBOUNCE & RECOVERY
+// ============================================================================
+
+void test_bounces_inside_lockout_are_ignored(void) {
+    ButtonGesture b = makeButton();
+    TEST_ASSERT_EQUAL(GESTURE_PRESS, b.onEdge(1000, true));
+    TEST_ASSERT_EQUAL(GESTURE_NONE, b.onEdge(1005, false));
+    TEST_ASSERT_EQUAL(GESTURE_NONE, b.onEdge(1010, true));
+    TEST_ASSERT_TRUE(b.isPressed());
+}
+
+void test_update_recovers_lost_release_edge(void) {
+    ButtonGesture b = makeButton();
+    b.onEdge(1000, true);
+    b.onEdge(1100, false);
+    b.onEdge(1200, true);
+
+    // The final release edge was lost; the raw level says released
+    TEST_ASSERT_EQUAL(GESTURE_DOUBLE_CLICK, b.update(1300, false));
+    TEST_ASSERT_FALSE(b.isPressed());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_single_click_reports_after_window);
+    RUN_TEST(test_double_click_reports_on_second_release);
+    RUN_TEST(test_long_press_uses_edge_timestamp);
+    RUN_TEST(test_late_processing_still_classifies_long_press);
+    RUN_TEST(test_hold_after_tap_is_long_press);
+    RUN_TEST(test_bounces_inside_lockout_are_ignored);
+    RUN_TEST(test_update_recovers_lost_release_edge);
+    return UNITY_END();
+}
@@ -0,0 +1,104 @@
+/*
+ * File: test/test_channel_scheduler/test_channel_scheduler.cpp
+ * Description: Unit tests for the deadline-ordered auto countdown scheduler
+ * (next deadline, incremental mask, remaining delays, wide boards).
+ */
+#include <unity.h>
+#include "ChannelScheduler.h"
+
+typedef ChannelScheduler<4, uint8_t> Scheduler4;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_next_deadline_is_shortest_delay(void) {
+    Scheduler4 s;
+    uint32_t delays[4] = {30, 10, 0, 20};
+    s.start(delays);
+
+    TEST_ASSERT_TRUE(s.isRunning());
+    TEST_ASSERT_EQUAL_UINT32(10, s.secondsUntilNext());
+    TEST_ASSERT_EQUAL_HEX8(0x04, s.activeMask()); // Zero delay is on at once
+
+    s.advance(4);
+    TEST_ASSERT_EQUAL_UINT32(6, s.secondsUntilNext());
+    TEST_ASSERT_EQUAL_HEX8(0x04, s.activeMask());
+}
+
+void test_mask_fills_as_deadlines_pass(void) {
+    Scheduler4 s;
+    uint32_t delays[4] = {30, 10, 0, 20};
+    s.start(delays);
+
+    s.advance(10);
+    TEST_ASSERT_EQUAL_HEX8(0x06, s.activeMask());
+    TEST_ASSERT_EQUAL_UINT32(10, s.secondsUntilNext());
+
+    // One span across two deadlines activates both
+    s.advance(25);
+    TEST_ASSERT_EQUAL_HEX8(0x0F, s.activeMask());
+    TEST_ASSERT_EQUAL_UINT32(0, s.secondsUntilNext());
+}
+
+void test_equal_deadlines_fire_together(void) {
+    Scheduler4 s;
+    uint32_t delays[4] = {5, 5, 5, 7};
+    s.start(delays);
+
+    s.advance(5);
+    TEST_ASSERT_EQUAL_HEX8(0x07, s.activeMask());
+    TEST_ASSERT_EQUAL_UINT32(2, s.secondsUntilNext());
+}
+
+void test_remaining_delays_are_derived(void) {
+    Scheduler4 s;
+    uint32_t delays[4] = {30, 10, 0, 20};
+    s.start(delays);
+    s.advance(15);
+
+    uint32_t out[4];
+    s.copyRemaining(out);
+    TEST_ASSERT_EQUAL_UINT32(15, out[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, out[1]);
+    TEST_ASSERT_EQUAL_UINT32(0, out[2]);
+    TEST_ASSERT_EQUAL_UINT32(5, out[3]);
+    TEST_ASSERT_EQUAL_UINT32(0, s.remaining(9)); // Out of range
+}
+
+void test_clear_stops_the_countdown(void) {
+    Scheduler4 s;
+    uint32_t delays[4] = {0, 0, 0, 0};
+    s.start(delays);
+    TEST_ASSERT_EQUAL_HEX8(0x0F, s.activeMask());
+    TEST_ASSERT_EQUAL_UINT32(0, s.secondsUntilNext());
+
+    s.clear();
+    TEST_ASSERT_FALSE(s.isRunning());
+    TEST_ASSERT_EQUAL_HEX8(0x00, s.activeMask());
+}
+
+void test_sixteen_channels_use_a_wide_mask(void) {
+    ChannelScheduler<16, uint16_t> s;
+    uint32_t delays[16];
+    for (int i = 0; i < 16; i++) delays[i] = 16 - i; // Reverse order
+    s.start(delays);
+
+    TEST_ASSERT_EQUAL_UINT32(1, s.secondsUntilNext());
+    s.advance(1);
+    TEST_ASSERT_EQUAL_HEX16(0x8000, s.activeMask());
+    s.advance(14);
+    TEST_ASSERT_EQUAL_HEX16(0xFFFE, s.activeMask());
+    s.advance(1);
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, s.activeMask());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_next_deadline_is_shortest_delay);
+    RUN_TEST(test_mask_fills_as_deadlines_pass);
+    RUN_TEST(test_equal_deadlines_fire_together);
+    RUN_TEST(test_remaining_delays_are_derived);
+    RUN_TEST(test_clear_stops_the_countdown);
+    RUN_TEST(test_sixteen_channels_use_a_wide_mask);
+    return UNITY_END();
+}
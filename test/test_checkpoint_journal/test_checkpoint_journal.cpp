@@ -0,0 +1,201 @@
+/*
+ * File: test/test_checkpoint_journal/test_checkpoint_journal.cpp
+ * Description: Tests for the running-countdown checkpoint journal.
+ * Covers the engine checkpoint cadence and the slot codec used at boot
+ * to pick and overlay the newest valid checkpoint.
+ */
+#include <unity.h>
+#include <string.h>
+#include "Session.h"
+#include "MockSessionHAL.h"
+#include "StandardRules.h"
+#include "CheckpointJournal.h"
+
+// --- Defaults (checkpoint every 3 s) ---
+const SystemDefaults defaults = { 5, 10, 240, 10000, 4, 5, 30000, 3, 60, 3 };
+const SystemDefaults noJournalDefaults = { 5, 10, 240, 10000, 4, 5, 30000, 3, 60 };
+const SessionPresets presets = { 300, 600, 900, 1800, 3600, 7200, 14400, 10 };
+const DeterrentConfig deterrents = {
+    true, true, DETERRENT_FIXED, 300, 900, 300,
+    true, DETERRENT_FIXED, 60, 120, 60
+};
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --- Helpers ---
+
+static SessionEngine* createEngine(MockSessionHAL& hal, StandardRules& rules, const SystemDefaults& defs) {
+    return new SessionEngine(hal, rules, defs, presets, deterrents);
+}
+
+static void buildSlot(CheckpointSlot& slot, DeviceState state, uint32_t seq, uint32_t recordSeq,
+                      uint32_t lockRemaining, uint32_t penaltyRemaining, uint32_t totalLocked) {
+    SessionTimers t = {0};
+    SessionStats st = {0};
+    t.lockRemaining = lockRemaining;
+    t.penaltyRemaining = penaltyRemaining;
+    st.totalLockedTime = totalLocked;
+    CheckpointJournal::encode(state, t, st, seq, recordSeq, slot);
+}
+
+// ============================================================================
+// ENGINE CADENCE
+// ============================================================================
+
+void test_locked_countdown_checkpoints_every_interval(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine* engine = createEngine(hal, rules, defaults);
+    hal.setSafetyInterlock(true);
+
+    engine->loadState(LOCKED);
+    SessionTimers t = {0};
+    t.lockDuration = 600;
+    t.lockRemaining = 100;
+    engine->loadTimers(t);
+
+    for (int i = 0; i < 7; i++) engine->tick();
+
+    TEST_ASSERT_EQUAL(2, hal.checkpointCount);
+    TEST_ASSERT_EQUAL(LOCKED, hal.checkpointState);
+    TEST_ASSERT_EQUAL_UINT32(94, hal.checkpointTimers.lockRemaining);
+
+    delete engine;
+}
+
+void test_penalty_countdown_checkpoints(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine* engine = createEngine(hal, rules, defaults);
+    hal.setSafetyInterlock(true);
+
+    engine->loadState(ABORTED);
+    SessionTimers t = {0};
+    t.penaltyDuration = 300;
+    t.penaltyRemaining = 50;
+    engine->loadTimers(t);
+
+    for (int i = 0; i < 3; i++) engine->tick();
+
+    TEST_ASSERT_EQUAL(1, hal.checkpointCount);
+    TEST_ASSERT_EQUAL(ABORTED, hal.checkpointState);
+    TEST_ASSERT_EQUAL_UINT32(47, hal.checkpointTimers.penaltyRemaining);
+
+    delete engine;
+}
+
+void test_checkpoints_disabled_when_interval_zero(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine* engine = createEngine(hal, rules, noJournalDefaults);
+    hal.setSafetyInterlock(true);
+
+    engine->loadState(ABORTED);
+    SessionTimers t = {0};
+    t.penaltyRemaining = 50;
+    engine->loadTimers(t);
+
+    for (int i = 0; i < 10; i++) engine->tick();
+
+    TEST_ASSERT_EQUAL(0, hal.checkpointCount);
+
+    delete engine;
+}
+
+void test_no_checkpoint_while_timers_paused(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine* engine = createEngine(hal, rules, defaults);
+
+    engine->loadState(ABORTED);
+    SessionTimers t = {0};
+    t.penaltyRemaining = 50;
+    engine->loadTimers(t);
+
+    // Hardware disconnected: countdown is paused, nothing new to record
+    hal.setSafetyInterlock(false);
+    for (int i = 0; i < 10; i++) engine->tick();
+
+    TEST_ASSERT_EQUAL(0, hal.checkpointCount);
+    TEST_ASSERT_EQUAL_UINT32(50, engine->getTimers().penaltyRemaining);
+
+    delete engine;
+}
+
+// ============================================================================
+// SLOT CODEC
+// ============================================================================
+
+void test_find_newest_skips_corrupt_slots(void) {
+    CheckpointSlot slots[CHECKPOINT_SLOTS];
+    memset(slots, 0, sizeof(slots));
+
+    buildSlot(slots[CheckpointJournal::slotIndex(9)], LOCKED, 9, 4, 500, 0, 100);
+    buildSlot(slots[CheckpointJournal::slotIndex(10)], LOCKED, 10, 4, 440, 0, 160);
+    buildSlot(slots[CheckpointJournal::slotIndex(11)], LOCKED, 11, 4, 380, 0, 220);
+
+    // Torn write on the newest slot
+    ((uint8_t*)&slots[CheckpointJournal::slotIndex(11)])[12] ^= 0xFF;
+
+    int newest = CheckpointJournal::findNewest(slots, CHECKPOINT_SLOTS);
+    TEST_ASSERT_EQUAL(CheckpointJournal::slotIndex(10), newest);
+    TEST_ASSERT_EQUAL_UINT32(10, slots[newest].sequence);
+}
+
+void test_find_newest_empty_journal(void) {
+    CheckpointSlot slots[CHECKPOINT_SLOTS];
+    memset(slots, 0, sizeof(slots));
+    TEST_ASSERT_EQUAL(-1, CheckpointJournal::findNewest(slots, CHECKPOINT_SLOTS));
+}
+
+void test_apply_overlays_matching_checkpoint(void) {
+    CheckpointSlot slot;
+    buildSlot(slot, LOCKED, 3, 7, 380, 0, 1220);
+
+    SessionTimers t = {0};
+    SessionStats st = {0};
+    t.lockRemaining = 500;
+    st.totalLockedTime = 1100;
+
+    TEST_ASSERT_TRUE(CheckpointJournal::apply(slot, 7, LOCKED, t, st));
+    TEST_ASSERT_EQUAL_UINT32(380, t.lockRemaining);
+    TEST_ASSERT_EQUAL_UINT32(1220, st.totalLockedTime);
+}
+
+void test_apply_rejects_stale_or_mismatched(void) {
+    CheckpointSlot slot;
+    buildSlot(slot, LOCKED, 3, 7, 380, 0, 1220);
+
+    SessionTimers t = {0};
+    SessionStats st = {0};
+    t.lockRemaining = 500;
+
+    // A full save happened after this checkpoint
+    TEST_ASSERT_FALSE(CheckpointJournal::apply(slot, 8, LOCKED, t, st));
+    // State moved on (e.g. aborted) since the checkpoint
+    TEST_ASSERT_FALSE(CheckpointJournal::apply(slot, 7, ABORTED, t, st));
+    TEST_ASSERT_EQUAL_UINT32(500, t.lockRemaining);
+}
+
+void test_apply_never_moves_time_backwards(void) {
+    CheckpointSlot slot;
+    buildSlot(slot, ABORTED, 3, 7, 0, 200, 0);
+
+    SessionTimers t = {0};
+    SessionStats st = {0};
+    t.penaltyRemaining = 150; // Record is already further along
+
+    CheckpointJournal::apply(slot, 7, ABORTED, t, st);
+    TEST_ASSERT_EQUAL_UINT32(150, t.penaltyRemaining);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_locked_countdown_checkpoints_every_interval);
+    RUN_TEST(test_penalty_countdown_checkpoints);
+    RUN_TEST(test_checkpoints_disabled_when_interval_zero);
+    RUN_TEST(test_no_checkpoint_while_timers_paused);
+    RUN_TEST(test_find_newest_skips_corrupt_slots);
+    RUN_TEST(test_find_newest_empty_journal);
+    RUN_TEST(test_apply_overlays_matching_checkpoint);
+    RUN_TEST(test_apply_rejects_stale_or_mismatched);
+    RUN_TEST(test_apply_never_moves_time_backwards);
+    return UNITY_END();
+}
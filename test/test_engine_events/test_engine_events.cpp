@@ -0,0 +1,161 @@
+/*
+ * File: test/test_engine_events/test_engine_events.cpp
+ * Description: Tests for the deferred-format binary event log.
+ * Verifies the engine emits typed events on hot paths and that the
+ * deferred formatter reproduces the text log lines.
+ */
+#include <unity.h>
+#include <string.h>
+#include "Session.h"
+#include "MockSessionHAL.h"
+#include "StandardRules.h"
+
+// --- Defaults ---
+const SystemDefaults defaults = { 5, 10, 240, 10000, 4, 5, 30000, 3, 60 };
+const SessionPresets presets = { 300, 600, 900, 1800, 3600, 7200, 14400, 10 };
+const DeterrentConfig deterrents = {
+    true, true, DETERRENT_FIXED, 300, 900, 300,
+    true, DETERRENT_FIXED, 60, 120, 60,
+    true, 300
+};
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void startLocked(SessionEngine& engine, uint32_t seconds) {
+    SessionConfig cfg = {};
+    cfg.durationType = DUR_FIXED;
+    cfg.durationFixed = seconds;
+    cfg.triggerStrategy = STRAT_BUTTON_TRIGGER;
+    engine.startSession(cfg);
+    engine.trigger("API");
+}
+
+static const EngineEvent* lastEvent(const MockSessionHAL& hal, EngineEventId id) {
+    for (auto it = hal.events.rbegin(); it != hal.events.rend(); ++it) {
+        if (it->id == id) return &(*it);
+    }
+    return nullptr;
+}
+
+// ============================================================================
+// FORMATTER
+// ============================================================================
+
+void test_format_matches_text_log(void) {
+    char buf[128];
+
+    EngineEvent e = EngineEvents::make(0, EVT_STATE_CHANGE, LOCKED);
+    EngineEvents::format(e, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING(" Session  : >>> STATE CHANGE: LOCKED", buf);
+
+    e = EngineEvents::make(0, EVT_TIME_MODIFIED, 0, 300, 1200);
+    EngineEvents::format(e, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING(" Session  : Time Mod: - 300 s. Rem: 1200", buf);
+
+    e = EngineEvents::make(0, EVT_REWARD_GENERATED, EngineEvents::packChars("UDLR"), EngineEvents::packChars("RLDU"));
+    EngineEvents::format(e, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING(" Session  : New Reward Code Generated: UDLRRLDU...", buf);
+}
+
+void test_format_truncates_and_handles_unknown_ids(void) {
+    char small[12];
+    EngineEvent e = EngineEvents::make(0, EVT_STATE_CHANGE, READY);
+    TEST_ASSERT_EQUAL(sizeof(small) - 1, EngineEvents::format(e, small, sizeof(small)));
+    TEST_ASSERT_EQUAL(sizeof(small) - 1, strlen(small));
+
+    char buf[128];
+    e = EngineEvents::make(0, (EngineEventId)200, 1, 2, 3);
+    EngineEvents::format(e, buf, sizeof(buf));
+    TEST_ASSERT_NOT_NULL(strstr(buf, "Unknown event 200"));
+}
+
+// ============================================================================
+// ENGINE EMISSION
+// ============================================================================
+
+void test_state_change_emits_typed_event(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    hal.setSafetyInterlock(true);
+    hal.currentMillis = 5000;
+
+    startLocked(engine, 600);
+
+    const EngineEvent* e = lastEvent(hal, EVT_STATE_CHANGE);
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT_EQUAL_UINT32(LOCKED, e->args[0]);
+    TEST_ASSERT_EQUAL_UINT32(5000, e->timestampMs);
+    TEST_ASSERT_EQUAL(2, hal.countEvents(EVT_STATE_CHANGE)); // ARMED, LOCKED
+}
+
+void test_time_mod_emits_step_and_remaining(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    hal.setSafetyInterlock(true);
+
+    startLocked(engine, 600);
+    uint32_t before = engine.getTimers().lockRemaining;
+    TEST_ASSERT_EQUAL(200, engine.modifyTime(true));
+
+    const EngineEvent* e = lastEvent(hal, EVT_TIME_MODIFIED);
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT_EQUAL_UINT32(1, e->args[0]);
+    TEST_ASSERT_EQUAL_UINT32(300, e->args[1]);
+    TEST_ASSERT_EQUAL_UINT32(before + 300, e->args[2]);
+}
+
+void test_abort_emits_penalty_event(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    hal.setSafetyInterlock(true);
+
+    startLocked(engine, 600);
+    engine.abort("API");
+
+    const EngineEvent* e = lastEvent(hal, EVT_PENALTY_ENFORCED);
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT_EQUAL_UINT32(300, e->args[0]);
+    TEST_ASSERT_EQUAL_UINT32(ABORTED, lastEvent(hal, EVT_STATE_CHANGE)->args[0]);
+}
+
+void test_long_press_abort_emits_cause(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    hal.setSafetyInterlock(true);
+
+    startLocked(engine, 600);
+    hal.simulateLongPress();
+    engine.processInputs();
+
+    const EngineEvent* e = lastEvent(hal, EVT_SAFETY_ABORT);
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT_EQUAL_UINT32(SAFETY_CAUSE_LONG_PRESS, e->args[0]);
+}
+
+void test_interlock_loss_emits_cause(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    hal.setSafetyInterlock(true);
+
+    startLocked(engine, 600);
+    hal.setSafetyInterlock(false);
+    engine.tick();
+
+    const EngineEvent* e = lastEvent(hal, EVT_SAFETY_ABORT);
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT_EQUAL_UINT32(SAFETY_CAUSE_INTERLOCK, e->args[0]);
+    TEST_ASSERT_EQUAL(1, hal.countEvents(EVT_SAFETY_ABORT));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_format_matches_text_log);
+    RUN_TEST(test_format_truncates_and_handles_unknown_ids);
+    RUN_TEST(test_state_change_emits_typed_event);
+    RUN_TEST(test_time_mod_emits_step_and_remaining);
+    RUN_TEST(test_abort_emits_penalty_event);
+    RUN_TEST(test_long_press_abort_emits_cause);
+    RUN_TEST(test_interlock_loss_emits_cause);
+    return UNITY_END();
+}
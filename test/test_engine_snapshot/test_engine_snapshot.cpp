@@ -0,0 +1,109 @@
+/*
+ * File: test/test_engine_snapshot/test_engine_snapshot.cpp
+ * Description: Tests for the lock-free engine snapshot used by read-only
+ * Web API handlers. Verifies publish points and the reward visibility gate.
+ */
+#include <unity.h>
+#include <string.h>
+#include "Session.h"
+#include "MockSessionHAL.h"
+#include "StandardRules.h"
+
+// --- Defaults ---
+const SystemDefaults defaults = { 5, 10, 240, 10000, 4, 5, 30000, 3, 60 };
+const SessionPresets presets = { 300, 600, 900, 1800, 3600, 7200, 14400, 10 };
+const DeterrentConfig deterrents = {
+    true, true, DETERRENT_FIXED, 300, 900, 300,
+    true, DETERRENT_FIXED, 60, 120, 60
+};
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void startLocked(SessionEngine& engine, uint32_t seconds) {
+    SessionConfig cfg = {};
+    cfg.durationType = DUR_FIXED;
+    cfg.durationFixed = seconds;
+    cfg.triggerStrategy = STRAT_BUTTON_TRIGGER;
+    engine.startSession(cfg);
+    engine.trigger("API");
+}
+
+// ============================================================================
+// SEQLOCK
+// ============================================================================
+
+void test_seqlock_roundtrip(void) {
+    SnapshotSeqLock lock;
+    EngineSnapshot in;
+    memset(&in, 0, sizeof(in));
+    in.state = ABORTED;
+    in.timers.penaltyRemaining = 123;
+    in.generation = 9;
+
+    lock.publish(in);
+
+    EngineSnapshot out;
+    TEST_ASSERT_TRUE(lock.read(out));
+    TEST_ASSERT_EQUAL(ABORTED, out.state);
+    TEST_ASSERT_EQUAL_UINT32(123, out.timers.penaltyRemaining);
+    TEST_ASSERT_EQUAL_UINT32(9, out.generation);
+    TEST_ASSERT_EQUAL_UINT32(1, lock.publishCount());
+}
+
+// ============================================================================
+// ENGINE PUBLISH POINTS
+// ============================================================================
+
+void test_snapshot_available_after_construction(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+
+    EngineSnapshot snap;
+    TEST_ASSERT_TRUE(engine.readSnapshot(snap));
+    TEST_ASSERT_EQUAL(READY, snap.state);
+    TEST_ASSERT_TRUE(snap.rewardsVisible);
+    TEST_ASSERT_TRUE(strlen(snap.rewards[0].code) > 0);
+}
+
+void test_snapshot_follows_state_change_and_tick(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    hal.setSafetyInterlock(true);
+
+    startLocked(engine, 120);
+
+    EngineSnapshot snap;
+    TEST_ASSERT_TRUE(engine.readSnapshot(snap));
+    TEST_ASSERT_EQUAL(LOCKED, snap.state);
+    TEST_ASSERT_EQUAL_UINT32(engine.getGeneration(), snap.generation);
+    uint32_t before = snap.timers.lockRemaining;
+
+    engine.tick();
+
+    TEST_ASSERT_TRUE(engine.readSnapshot(snap));
+    TEST_ASSERT_EQUAL_UINT32(before - 1, snap.timers.lockRemaining);
+    TEST_ASSERT_TRUE(snap.interlockValid);
+}
+
+void test_snapshot_hides_rewards_during_session(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    hal.setSafetyInterlock(true);
+
+    startLocked(engine, 120);
+
+    EngineSnapshot snap;
+    TEST_ASSERT_TRUE(engine.readSnapshot(snap));
+    TEST_ASSERT_FALSE(snap.rewardsVisible);
+    TEST_ASSERT_EQUAL(0, strlen(snap.rewards[0].code));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_seqlock_roundtrip);
+    RUN_TEST(test_snapshot_available_after_construction);
+    RUN_TEST(test_snapshot_follows_state_change_and_tick);
+    RUN_TEST(test_snapshot_hides_rewards_during_session);
+    return UNITY_END();
+}
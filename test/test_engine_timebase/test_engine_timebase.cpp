@@ -0,0 +1,200 @@
+/*
+ * File: test/test_engine_timebase/test_engine_timebase.cpp
+ * Description: Tests for the millisecond engine timebase (update()).
+ * Verifies sub-second carry, catch-up after a late wake-up with a single
+ * safety evaluation, deadline-accurate channel activation, and O(1)
+ * fast-forward via advance().
+ */
+#include <unity.h>
+#include "Session.h"
+#include "MockSessionHAL.h"
+#include "StandardRules.h"
+
+// --- Defaults ---
+const SystemDefaults defaults = { 5, 10, 240, 10000, 4, 5, 30000, 3, 60 };
+const SessionPresets presets = { 300, 600, 900, 1800, 3600, 7200, 14400, 10 };
+const DeterrentConfig deterrents = {
+    true, true, DETERRENT_FIXED, 300, 900, 300,
+    true, DETERRENT_FIXED, 60, 120, 60,
+    true, 300
+};
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void startLocked(SessionEngine& engine, uint32_t seconds) {
+    SessionConfig cfg = {};
+    cfg.durationType = DUR_FIXED;
+    cfg.durationFixed = seconds;
+    cfg.triggerStrategy = STRAT_BUTTON_TRIGGER;
+    engine.startSession(cfg);
+    engine.trigger("API");
+}
+
+// ============================================================================
+// CARRY
+// ============================================================================
+
+void test_sub_second_remainder_is_carried(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    hal.setSafetyInterlock(true);
+
+    startLocked(engine, 600);
+    uint32_t start = engine.getTimers().lockRemaining;
+
+    // Wake-ups at 1.5 s and 2.4 s: only one second is due
+    hal.advanceTime(1500);
+    TEST_ASSERT_TRUE(engine.update(hal.getMillis()));
+    hal.advanceTime(900);
+    TEST_ASSERT_TRUE(engine.update(hal.getMillis()));
+    TEST_ASSERT_EQUAL_UINT32(start - 2, engine.getTimers().lockRemaining);
+
+    // The 0.4 s remainder was kept: 0.6 s more completes the third second
+    TEST_ASSERT_EQUAL_UINT32(600, engine.msUntilNextSecond(hal.getMillis()));
+    hal.advanceTime(599);
+    TEST_ASSERT_FALSE(engine.update(hal.getMillis()));
+    hal.advanceTime(1);
+    TEST_ASSERT_TRUE(engine.update(hal.getMillis()));
+    TEST_ASSERT_EQUAL_UINT32(start - 3, engine.getTimers().lockRemaining);
+}
+
+// ============================================================================
+// CATCH-UP
+// ============================================================================
+
+void test_late_wakeup_consumes_all_seconds_once(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    hal.setSafetyInterlock(true);
+
+    startLocked(engine, 600);
+    engine.petWatchdog();
+    uint32_t start = engine.getTimers().lockRemaining;
+    int writesBefore = hal.safetyMaskWrites;
+
+    // A 7.3 s stall (e.g. NVS or WiFi reconnect)
+    hal.advanceTime(7300);
+    engine.petWatchdog();
+    TEST_ASSERT_TRUE(engine.update(hal.getMillis()));
+
+    TEST_ASSERT_EQUAL_UINT32(start - 7, engine.getTimers().lockRemaining);
+    TEST_ASSERT_EQUAL(writesBefore + 1, hal.safetyMaskWrites);
+    TEST_ASSERT_EQUAL_UINT32(700, engine.msUntilNextSecond(hal.getMillis()));
+}
+
+void test_catch_up_completes_session_without_overshoot(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    hal.setSafetyInterlock(true);
+
+    startLocked(engine, 600);
+    uint32_t start = engine.getTimers().lockRemaining;
+
+    // Keep the watchdog happy across the whole jump
+    hal.advanceTime((start + 5) * 1000);
+    engine.petWatchdog();
+    engine.update(hal.getMillis());
+
+    TEST_ASSERT_EQUAL(COMPLETED, engine.getState());
+    TEST_ASSERT_EQUAL_UINT32(0, engine.getTimers().lockRemaining);
+    TEST_ASSERT_EQUAL(0x00, hal.lastSafetyMask);
+}
+
+// ============================================================================
+// DEADLINES
+// ============================================================================
+
+void test_channel_delay_runs_from_arm_request(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    hal.setSafetyInterlock(true);
+
+    // Clock already running with an arbitrary phase
+    hal.currentMillis = 10250;
+    engine.update(hal.getMillis());
+
+    SessionConfig cfg = {};
+    cfg.durationType = DUR_FIXED;
+    cfg.durationFixed = 600;
+    cfg.triggerStrategy = STRAT_AUTO_COUNTDOWN;
+    cfg.channelDelays[0] = 2;
+    cfg.channelDelays[1] = 3;
+    hal.currentMillis = 10900;
+    TEST_ASSERT_EQUAL(200, engine.startSession(cfg));
+
+    // 1.9 s after arming: channel 1 is not due yet even though two old-phase boundaries passed
+    hal.currentMillis = 12800;
+    engine.update(hal.getMillis());
+    TEST_ASSERT_EQUAL(0, hal.lastSafetyMask & 0x01);
+
+    hal.currentMillis = 12900;
+    engine.update(hal.getMillis());
+    TEST_ASSERT_EQUAL(0x01, hal.lastSafetyMask & 0x03);
+    TEST_ASSERT_EQUAL(ARMED, engine.getState());
+}
+
+// ============================================================================
+// FAST-FORWARD
+// ============================================================================
+
+void test_advance_matches_per_second_ticks(void) {
+    MockSessionHAL halA, halB; StandardRules rulesA, rulesB;
+    SessionEngine a(halA, rulesA, defaults, presets, deterrents);
+    SessionEngine b(halB, rulesB, defaults, presets, deterrents);
+    halA.setSafetyInterlock(true);
+    halB.setSafetyInterlock(true);
+
+    SessionConfig cfg = {};
+    cfg.durationType = DUR_FIXED;
+    cfg.durationFixed = 600;
+    cfg.triggerStrategy = STRAT_AUTO_COUNTDOWN;
+    cfg.channelDelays[0] = 3;
+    cfg.channelDelays[2] = 7;
+    a.startSession(cfg);
+    b.startSession(cfg);
+
+    // Through both channel activations, into LOCKED and 100 s beyond
+    for (int i = 0; i < 112; i++) a.tick();
+    b.advance(112);
+
+    TEST_ASSERT_EQUAL(LOCKED, b.getState());
+    TEST_ASSERT_EQUAL(a.getState(), b.getState());
+    TEST_ASSERT_EQUAL_UINT32(a.getTimers().lockRemaining, b.getTimers().lockRemaining);
+    TEST_ASSERT_EQUAL_UINT32(a.getStats().totalLockedTime, b.getStats().totalLockedTime);
+    TEST_ASSERT_EQUAL(halA.lastSafetyMask, halB.lastSafetyMask);
+}
+
+void test_advance_simulates_two_week_session_instantly(void) {
+    const uint32_t TWO_WEEKS = 14 * 86400;
+    const SessionPresets longPresets = { 300, 600, 900, 1800, 3600, 7200, TWO_WEEKS, 10 };
+    const SystemDefaults checkpointed = { 5, 10, 240, 10000, 4, 5, 30000, 3, 60, 60 };
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine engine(hal, rules, checkpointed, longPresets, deterrents);
+    hal.setSafetyInterlock(true);
+
+    startLocked(engine, TWO_WEEKS);
+    uint32_t lockTime = engine.getTimers().lockRemaining;
+    engine.advance(lockTime - 1);
+
+    TEST_ASSERT_EQUAL(LOCKED, engine.getState());
+    TEST_ASSERT_EQUAL_UINT32(1, engine.getTimers().lockRemaining);
+    TEST_ASSERT_EQUAL_UINT32(lockTime - 1, engine.getStats().totalLockedTime);
+    TEST_ASSERT_EQUAL(1, hal.checkpointCount); // One checkpoint for the whole span
+
+    // Overshooting stops at the completion boundary
+    engine.advance(3600);
+    TEST_ASSERT_EQUAL(COMPLETED, engine.getState());
+    TEST_ASSERT_EQUAL_UINT32(lockTime, engine.getStats().totalLockedTime);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sub_second_remainder_is_carried);
+    RUN_TEST(test_late_wakeup_consumes_all_seconds_once);
+    RUN_TEST(test_catch_up_completes_session_without_overshoot);
+    RUN_TEST(test_channel_delay_runs_from_arm_request);
+    RUN_TEST(test_advance_matches_per_second_ticks);
+    RUN_TEST(test_advance_simulates_two_week_session_instantly);
+    return UNITY_END();
+}
@@ -0,0 +1,94 @@
+/*
+ * File: test/test_fixed_arena/test_fixed_arena.cpp
+ * Description: Unit tests for the per-request bump arenas behind the web
+ * JSON responses. Covers alignment, in-place growth of the last block,
+ * exhaustion, and pool leasing.
+ */
+#include <unity.h>
+#include "FixedArena.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================================================
+// ARENA
+// ============================================================================
+
+void test_allocations_are_aligned_and_bounded(void) {
+    ArenaPool<64, 1> pool;
+    FixedArena *a = pool.acquire();
+    TEST_ASSERT_NOT_NULL(a);
+
+    uint8_t *p1 = (uint8_t *)a->allocate(3);
+    uint8_t *p2 = (uint8_t *)a->allocate(8);
+    TEST_ASSERT_NOT_NULL(p1);
+    TEST_ASSERT_EQUAL(0, ((uintptr_t)p2) % FIXED_ARENA_ALIGN);
+    TEST_ASSERT_TRUE(p2 >= p1 + 3);
+
+    // 16 used; 49 more does not fit
+    TEST_ASSERT_NULL(a->allocate(49));
+    TEST_ASSERT_EQUAL_UINT32(1, a->failures());
+    TEST_ASSERT_NOT_NULL(a->allocate(48));
+}
+
+void test_last_block_grows_and_frees_in_place(void) {
+    ArenaPool<128, 1> pool;
+    FixedArena *a = pool.acquire();
+
+    char *s = (char *)a->allocate(4);
+    memcpy(s, "abc", 4);
+    TEST_ASSERT_EQUAL_PTR(s, a->reallocate(s, 32));
+    TEST_ASSERT_EQUAL_STRING("abc", s);
+    TEST_ASSERT_EQUAL_PTR(s, a->reallocate(s, 8)); // Shrink to fit
+    TEST_ASSERT_EQUAL(8, a->used());
+
+    a->deallocate(s);
+    TEST_ASSERT_EQUAL(0, a->used());
+}
+
+void test_older_block_is_moved_on_growth(void) {
+    ArenaPool<128, 1> pool;
+    FixedArena *a = pool.acquire();
+
+    char *first = (char *)a->allocate(8);
+    memcpy(first, "arena", 6);
+    a->allocate(8);
+
+    char *moved = (char *)a->reallocate(first, 24);
+    TEST_ASSERT_NOT_NULL(moved);
+    TEST_ASSERT_TRUE(moved != first);
+    TEST_ASSERT_EQUAL_STRING("arena", moved);
+}
+
+// ============================================================================
+// POOL
+// ============================================================================
+
+void test_pool_exhaustion_and_reuse(void) {
+    ArenaPool<32, 2> pool;
+    FixedArena *a = pool.acquire();
+    FixedArena *b = pool.acquire();
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_TRUE(a != b);
+    TEST_ASSERT_EQUAL(2, pool.inUse());
+
+    TEST_ASSERT_NULL(pool.acquire());
+    TEST_ASSERT_EQUAL_UINT32(1, pool.exhausted());
+
+    a->allocate(20);
+    pool.release(a);
+    FixedArena *c = pool.acquire();
+    TEST_ASSERT_EQUAL_PTR(a, c);
+    TEST_ASSERT_EQUAL(0, c->used()); // Leased arenas start empty
+    TEST_ASSERT_EQUAL(20, pool.highWater());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_allocations_are_aligned_and_bounded);
+    RUN_TEST(test_last_block_grows_and_frees_in_place);
+    RUN_TEST(test_older_block_is_moved_on_growth);
+    RUN_TEST(test_pool_exhaustion_and_reuse);
+    return UNITY_END();
+}
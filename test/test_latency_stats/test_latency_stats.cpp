@@ -0,0 +1,97 @@
+/*
+ * File: test/test_latency_stats/test_latency_stats.cpp
+ * Description: Unit tests for the safety-path latency histograms and the
+ * three-stage (detected / processed / mask written) tracker.
+ */
+#include <unity.h>
+#include "LatencyStats.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================================================
+// HISTOGRAM
+// ============================================================================
+
+void test_histogram_tracks_min_avg_max(void) {
+    LatencyHistogram h;
+    TEST_ASSERT_EQUAL_UINT32(0, h.minUs());
+    TEST_ASSERT_EQUAL_UINT32(0, h.avgUs());
+
+    h.record(100);
+    h.record(300);
+    h.record(200);
+
+    TEST_ASSERT_EQUAL_UINT32(3, h.count());
+    TEST_ASSERT_EQUAL_UINT32(100, h.minUs());
+    TEST_ASSERT_EQUAL_UINT32(200, h.avgUs());
+    TEST_ASSERT_EQUAL_UINT32(300, h.maxUs());
+
+    h.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, h.count());
+}
+
+void test_histogram_buckets_are_log2(void) {
+    TEST_ASSERT_EQUAL_UINT8(0, LatencyHistogram::bucketFor(0));
+    TEST_ASSERT_EQUAL_UINT8(0, LatencyHistogram::bucketFor(1));
+    TEST_ASSERT_EQUAL_UINT8(1, LatencyHistogram::bucketFor(2));
+    TEST_ASSERT_EQUAL_UINT8(1, LatencyHistogram::bucketFor(3));
+    TEST_ASSERT_EQUAL_UINT8(9, LatencyHistogram::bucketFor(1000));   // 512..1023
+    TEST_ASSERT_EQUAL_UINT8(19, LatencyHistogram::bucketFor(1000000)); // ~1 s
+    TEST_ASSERT_EQUAL_UINT8(LATENCY_BUCKETS - 1, LatencyHistogram::bucketFor(UINT32_MAX));
+}
+
+// ============================================================================
+// TRACKER
+// ============================================================================
+
+void test_tracker_records_each_stage(void) {
+    LatencyTracker<3> t;
+    t.markDetected(0, 1000);
+    t.markProcessed(0, 1500);
+    TEST_ASSERT_TRUE(t.hasPending());
+    t.markMaskWritten(1600);
+    TEST_ASSERT_FALSE(t.hasPending());
+
+    TEST_ASSERT_EQUAL_UINT32(1, t.stats(0).total.count());
+    TEST_ASSERT_EQUAL_UINT32(600, t.stats(0).total.maxUs());
+    TEST_ASSERT_EQUAL_UINT32(500, t.stats(0).detectToEngine.maxUs());
+    TEST_ASSERT_EQUAL_UINT32(100, t.stats(0).engineToMask.maxUs());
+    TEST_ASSERT_EQUAL_UINT32(0, t.stats(1).total.count());
+}
+
+void test_tracker_ignores_unprocessed_detection(void) {
+    LatencyTracker<3> t;
+    // Detected while nothing was running: the engine never aborts
+    t.markDetected(1, 1000);
+    t.markMaskWritten(2000);
+    TEST_ASSERT_EQUAL_UINT32(0, t.stats(1).total.count());
+
+    // A later real event restarts the trace from its own detection
+    t.markDetected(1, 50000);
+    t.markProcessed(1, 51000);
+    t.markMaskWritten(51200);
+    TEST_ASSERT_EQUAL_UINT32(1, t.stats(1).total.count());
+    TEST_ASSERT_EQUAL_UINT32(1200, t.stats(1).total.maxUs());
+}
+
+void test_tracker_engine_detected_cause(void) {
+    LatencyTracker<3> t;
+    t.markProcessed(2, 7000);
+    t.markMaskWritten(7040);
+    TEST_ASSERT_EQUAL_UINT32(0, t.stats(2).detectToEngine.maxUs());
+    TEST_ASSERT_EQUAL_UINT32(40, t.stats(2).total.maxUs());
+
+    t.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, t.stats(2).total.count());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_histogram_tracks_min_avg_max);
+    RUN_TEST(test_histogram_buckets_are_log2);
+    RUN_TEST(test_tracker_records_each_stage);
+    RUN_TEST(test_tracker_ignores_unprocessed_detection);
+    RUN_TEST(test_tracker_engine_detected_cause);
+    return UNITY_END();
+}
@@ -0,0 +1,99 @@
+/*
+ * File: test/test_led_pattern/test_led_pattern.cpp
+ * Description: Unit tests for the hardware LED pattern table, the segment
+ * sequencer and the LEDC fade step planning.
+ */
+#include <unity.h>
+#include "LedPattern.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================================================
+// PATTERNS & SEQUENCER
+// ============================================================================
+
+void test_every_state_has_a_pattern(void) {
+    DeviceState states[] = {READY, ARMED, LOCKED, ABORTED, COMPLETED, TESTING};
+    for (DeviceState s : states) {
+        LedPattern p = LedPatterns::forState(s);
+        TEST_ASSERT_NOT_NULL(p.segments);
+        TEST_ASSERT_GREATER_THAN(0, p.count);
+    }
+
+    // Solid on is one segment held forever
+    LedPattern locked = LedPatterns::forState(LOCKED);
+    TEST_ASSERT_EQUAL(1, locked.count);
+    TEST_ASSERT_EQUAL(0, locked.segments[0].ms);
+    TEST_ASSERT_EQUAL(LED_LEVEL_MAX, locked.segments[0].level);
+}
+
+void test_sequencer_loops_and_tracks_level(void) {
+    LedSequencer seq;
+    seq.start(LedPatterns::forState(READY));
+    TEST_ASSERT_TRUE(seq.current().fade);
+    TEST_ASSERT_EQUAL(LED_LEVEL_MAX, seq.current().level);
+
+    TEST_ASSERT_TRUE(seq.advance());
+    TEST_ASSERT_EQUAL(LED_LEVEL_MAX, seq.startLevel()); // Fading down from full
+    TEST_ASSERT_EQUAL(0, seq.current().level);
+
+    TEST_ASSERT_TRUE(seq.advance()); // Wraps around
+    TEST_ASSERT_EQUAL(0, seq.startLevel());
+    TEST_ASSERT_EQUAL(LED_LEVEL_MAX, seq.current().level);
+}
+
+void test_sequencer_holds_static_pattern(void) {
+    LedSequencer seq;
+    seq.start(LedPatterns::forState(LOCKED));
+    TEST_ASSERT_FALSE(seq.advance());
+    TEST_ASSERT_EQUAL(LED_LEVEL_MAX, seq.current().level);
+
+    seq.start(LedPatterns::off());
+    TEST_ASSERT_FALSE(seq.advance());
+    TEST_ASSERT_EQUAL(0, seq.current().level);
+}
+
+// ============================================================================
+// FADE PLANNING
+// ============================================================================
+
+void test_fade_plan_slow_ramp_uses_single_steps(void) {
+    LedFadePlan plan;
+    TEST_ASSERT_TRUE(LedFadePlan::compute(0, 255, 2000, 5000, plan));
+    TEST_ASSERT_TRUE(plan.increase);
+    TEST_ASSERT_EQUAL_UINT32(1, plan.scale);
+    TEST_ASSERT_EQUAL_UINT32(255, plan.steps);
+    TEST_ASSERT_EQUAL_UINT32(39, plan.cyclesPerStep); // 255 * 39 / 5 kHz = 1.99 s
+}
+
+void test_fade_plan_fast_ramp_uses_coarse_steps(void) {
+    LedFadePlan plan;
+    TEST_ASSERT_TRUE(LedFadePlan::compute(255, 0, 10, 5000, plan)); // 50 PWM cycles
+    TEST_ASSERT_FALSE(plan.increase);
+    TEST_ASSERT_EQUAL_UINT32(6, plan.scale);
+    TEST_ASSERT_EQUAL_UINT32(42, plan.steps);
+    TEST_ASSERT_EQUAL_UINT32(1, plan.cyclesPerStep);
+
+    // Nothing to ramp
+    TEST_ASSERT_FALSE(LedFadePlan::compute(10, 10, 500, 5000, plan));
+    TEST_ASSERT_FALSE(LedFadePlan::compute(0, 255, 0, 5000, plan));
+}
+
+void test_fade_plan_clamps_very_slow_ramps(void) {
+    LedFadePlan plan;
+    TEST_ASSERT_TRUE(LedFadePlan::compute(0, 4, 2000, 5000, plan));
+    TEST_ASSERT_EQUAL_UINT32(4, plan.steps);
+    TEST_ASSERT_EQUAL_UINT32(LedFadePlan::MAX_FIELD, plan.cyclesPerStep);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_state_has_a_pattern);
+    RUN_TEST(test_sequencer_loops_and_tracks_level);
+    RUN_TEST(test_sequencer_holds_static_pattern);
+    RUN_TEST(test_fade_plan_slow_ramp_uses_single_steps);
+    RUN_TEST(test_fade_plan_fast_ramp_uses_coarse_steps);
+    RUN_TEST(test_fade_plan_clamps_very_slow_ramps);
+    return UNITY_END();
+}
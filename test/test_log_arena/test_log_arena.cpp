@@ -0,0 +1,222 @@
+/*
+ * File: test/test_log_arena/test_log_arena.cpp
+ * Description: Unit tests for the byte-packed log ring.
+ * Covers sequencing, eviction, wrap-around, binary records and independent reader cursors.
+ */
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "LogArena.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Walks a framed copySince() buffer and joins the records as '\n'-terminated text.
+template <size_t N> static void copyText(const LogArena<N> &arena, uint32_t since, uint32_t limit, char *text,
+                                         size_t textSize, uint32_t &first, uint32_t &next) {
+    uint8_t raw[N];
+    size_t rawLen = arena.copySince(since, limit, raw, sizeof(raw), first, next);
+
+    size_t pos = 0, written = 0, recLen = 0;
+    const uint8_t *rec = nullptr;
+    while (LogArena<N>::nextFramed(raw, rawLen, pos, rec, recLen) && written + recLen + 2 <= textSize) {
+        memcpy(text + written, rec, recLen);
+        written += recLen;
+        text[written++] = '\n';
+    }
+    text[written] = '\0';
+}
+
+// Reads the next record as a NUL-terminated string.
+template <size_t N>
+static bool nextText(const LogArena<N> &arena, typename LogArena<N>::Cursor &c, char *out, size_t outSize) {
+    size_t len = 0;
+    if (!arena.next(c, (uint8_t *)out, outSize - 1, len)) return false;
+    out[len] = '\0';
+    return true;
+}
+
+// ============================================================================
+// APPEND & COPY
+// ============================================================================
+
+void test_append_assigns_sequence_and_packs_bytes(void) {
+    LogArena<512> arena;
+    TEST_ASSERT_EQUAL_UINT32(0, arena.append("alpha"));
+    TEST_ASSERT_EQUAL_UINT32(1, arena.append("bravo"));
+
+    TEST_ASSERT_EQUAL_UINT32(2, arena.lineCount());
+    TEST_ASSERT_EQUAL(2 * (2 + 5), arena.bytesUsed());
+}
+
+void test_copy_since_returns_oldest_first(void) {
+    LogArena<512> arena;
+    arena.append("one");
+    arena.append("two");
+    arena.append("three");
+
+    char out[64];
+    uint32_t first = 0, next = 0;
+    copyText(arena, 1, 10, out, sizeof(out), first, next);
+
+    TEST_ASSERT_EQUAL_STRING("two\nthree\n", out);
+    TEST_ASSERT_EQUAL_UINT32(1, first);
+    TEST_ASSERT_EQUAL_UINT32(3, next);
+}
+
+void test_copy_since_respects_limit_and_cursor(void) {
+    LogArena<512> arena;
+    arena.append("a");
+    arena.append("b");
+    arena.append("c");
+
+    char out[64];
+    uint32_t first = 0, next = 0;
+    copyText(arena, 0, 2, out, sizeof(out), first, next);
+    TEST_ASSERT_EQUAL_STRING("a\nb\n", out);
+    TEST_ASSERT_EQUAL_UINT32(2, next);
+
+    // Tail from the returned cursor
+    copyText(arena, next, 10, out, sizeof(out), first, next);
+    TEST_ASSERT_EQUAL_STRING("c\n", out);
+    TEST_ASSERT_EQUAL_UINT32(3, next);
+
+    // Up to date: nothing new
+    uint8_t raw[64];
+    TEST_ASSERT_EQUAL(0, arena.copySince(next, 10, raw, sizeof(raw), first, next));
+}
+
+// ============================================================================
+// EVICTION & WRAP
+// ============================================================================
+
+void test_eviction_drops_oldest_and_wraps(void) {
+    LogArena<300> arena;
+    char line[32];
+    for (int i = 0; i < 100; i++) {
+        snprintf(line, sizeof(line), "line-%03d", i); // 8 chars -> 10 byte records
+        arena.append(line);
+    }
+
+    TEST_ASSERT_LESS_OR_EQUAL(300, arena.bytesUsed());
+    TEST_ASSERT_EQUAL_UINT32(30, arena.lineCount());
+    TEST_ASSERT_EQUAL_UINT32(100, arena.nextSeq());
+
+    // Stale cursor restarts at the oldest retained line
+    char out[512];
+    uint32_t first = 0, next = 0;
+    copyText(arena, 0, 1, out, sizeof(out), first, next);
+    TEST_ASSERT_EQUAL_UINT32(70, first);
+    TEST_ASSERT_EQUAL_STRING("line-070\n", out);
+
+    // Newest line intact across the wrap boundary
+    copyText(arena, 99, 1, out, sizeof(out), first, next);
+    TEST_ASSERT_EQUAL_STRING("line-099\n", out);
+}
+
+void test_long_lines_are_truncated(void) {
+    LogArena<1024> arena;
+    char longLine[400];
+    memset(longLine, 'x', sizeof(longLine) - 1);
+    longLine[sizeof(longLine) - 1] = '\0';
+
+    arena.append(longLine);
+    TEST_ASSERT_EQUAL(2 + LOG_ARENA_MAX_LINE, arena.bytesUsed());
+}
+
+void test_binary_records_roundtrip(void) {
+    LogArena<128> arena;
+    const uint8_t blob[] = {0x1E, 0x00, 0xFF, 0x00, 0x7F};
+    arena.append("text");
+    arena.append(blob, sizeof(blob));
+
+    // Embedded NULs survive: records are length-prefixed, not strings
+    LogArena<128>::Cursor c = arena.oldest();
+    uint8_t out[16];
+    size_t len = 0;
+    TEST_ASSERT_TRUE(arena.next(c, out, sizeof(out), len));
+    TEST_ASSERT_EQUAL(4, len);
+    TEST_ASSERT_TRUE(arena.next(c, out, sizeof(out), len));
+    TEST_ASSERT_EQUAL(sizeof(blob), len);
+    TEST_ASSERT_EQUAL_MEMORY(blob, out, sizeof(blob));
+}
+
+void test_seek_then_page_with_next(void) {
+    LogArena<512> arena;
+    arena.append("one");
+    arena.append("two");
+    arena.append("three");
+
+    char out[16];
+    LogArena<512>::Cursor c = arena.seek(1);
+    TEST_ASSERT_EQUAL_UINT32(1, c.seq);
+    TEST_ASSERT_TRUE(nextText(arena, c, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("two", out);
+    TEST_ASSERT_TRUE(nextText(arena, c, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("three", out);
+    TEST_ASSERT_FALSE(nextText(arena, c, out, sizeof(out)));
+
+    // Same restart rule as copySince: a cursor from the future starts at the oldest line
+    c = arena.seek(99);
+    TEST_ASSERT_EQUAL_UINT32(0, c.seq);
+    TEST_ASSERT_TRUE(nextText(arena, c, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("one", out);
+}
+
+// ============================================================================
+// INDEPENDENT READERS
+// ============================================================================
+
+void test_cursor_readers_are_independent(void) {
+    LogArena<512> arena;
+    arena.append("first");
+    arena.append("second");
+
+    LogArena<512>::Cursor pager = arena.oldest();
+    char out[32];
+
+    TEST_ASSERT_TRUE(nextText(arena, pager, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("first", out);
+
+    // A range copy still sees everything
+    char text[64];
+    uint32_t first = 0, next = 0;
+    copyText(arena, 0, 10, text, sizeof(text), first, next);
+    TEST_ASSERT_EQUAL_STRING("first\nsecond\n", text);
+
+    TEST_ASSERT_TRUE(nextText(arena, pager, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("second", out);
+    TEST_ASSERT_FALSE(nextText(arena, pager, out, sizeof(out)));
+}
+
+void test_lagging_cursor_restarts_at_oldest(void) {
+    LogArena<64> arena;
+    LogArena<64>::Cursor pager = arena.oldest();
+
+    char line[16];
+    for (int i = 0; i < 20; i++) {
+        snprintf(line, sizeof(line), "l%02d", i); // 5 byte records
+        arena.append(line);
+    }
+
+    uint32_t oldest = 20 - arena.lineCount();
+    char out[16], expected[16];
+    snprintf(expected, sizeof(expected), "l%02u", (unsigned)oldest);
+    TEST_ASSERT_TRUE(nextText(arena, pager, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING(expected, out);
+    TEST_ASSERT_EQUAL_UINT32(oldest + 1, pager.seq);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_append_assigns_sequence_and_packs_bytes);
+    RUN_TEST(test_copy_since_returns_oldest_first);
+    RUN_TEST(test_copy_since_respects_limit_and_cursor);
+    RUN_TEST(test_eviction_drops_oldest_and_wraps);
+    RUN_TEST(test_long_lines_are_truncated);
+    RUN_TEST(test_binary_records_roundtrip);
+    RUN_TEST(test_seek_then_page_with_next);
+    RUN_TEST(test_cursor_readers_are_independent);
+    RUN_TEST(test_lagging_cursor_restarts_at_oldest);
+    return UNITY_END();
+}
@@ -0,0 +1,81 @@
+/*
+ * File: test/test_power_policy/test_power_policy.cpp
+ * Description: Unit tests for the low-power policy (which states sleep, how
+ * deep the modem may sleep for a keep-alive interval) and the power meter
+ * (mode time, sleep residency, current estimate).
+ */
+#include <unity.h>
+#include "PowerPolicy.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================================================
+// POLICY
+// ============================================================================
+
+void test_only_long_quiet_states_sleep(void) {
+    TEST_ASSERT_TRUE(PowerPolicy::wantsLowPower(LOCKED));
+    TEST_ASSERT_TRUE(PowerPolicy::wantsLowPower(ABORTED));
+    TEST_ASSERT_FALSE(PowerPolicy::wantsLowPower(READY));
+    TEST_ASSERT_FALSE(PowerPolicy::wantsLowPower(ARMED));
+    TEST_ASSERT_FALSE(PowerPolicy::wantsLowPower(TESTING));
+    TEST_ASSERT_FALSE(PowerPolicy::wantsLowPower(COMPLETED));
+}
+
+void test_modem_sleep_fits_keepalive_budget(void) {
+    // 10 s keep-alive, a quarter of it may be spent waiting for the radio
+    TEST_ASSERT_EQUAL(MODEM_SLEEP_MAX, PowerPolicy::modemSleepFor(10000, 4, 103, 308));
+    // 1 s keep-alive: 250 ms budget covers DTIM wakes but not the listen interval
+    TEST_ASSERT_EQUAL(MODEM_SLEEP_MIN, PowerPolicy::modemSleepFor(1000, 4, 103, 308));
+    // Too tight for any sleep
+    TEST_ASSERT_EQUAL(MODEM_SLEEP_NONE, PowerPolicy::modemSleepFor(400, 4, 103, 308));
+    // A zero divisor is treated as 1
+    TEST_ASSERT_EQUAL(MODEM_SLEEP_MAX, PowerPolicy::modemSleepFor(400, 0, 103, 308));
+}
+
+// ============================================================================
+// METER
+// ============================================================================
+
+void test_meter_accounts_time_per_mode(void) {
+    PowerMeter m;
+    m.reset(1000);
+    m.enter(POWER_LOW, 5000);
+    m.enter(POWER_LOW, 7000); // Same mode again: no time lost
+    TEST_ASSERT_EQUAL_UINT32(4000, (uint32_t)m.timeInUs(POWER_ACTIVE, 9000));
+    TEST_ASSERT_EQUAL_UINT32(4000, (uint32_t)m.timeInUs(POWER_LOW, 9000)); // Running interval included
+
+    m.enter(POWER_ACTIVE, 10000);
+    TEST_ASSERT_EQUAL(POWER_ACTIVE, m.mode());
+    TEST_ASSERT_EQUAL_UINT32(5000, (uint32_t)m.timeInUs(POWER_LOW, 20000));
+    TEST_ASSERT_EQUAL_UINT32(14000, (uint32_t)m.timeInUs(POWER_ACTIVE, 20000));
+}
+
+void test_meter_estimates_current_from_residency(void) {
+    PowerMeter m;
+    m.reset(0);
+    TEST_ASSERT_EQUAL_UINT32(0, m.sleepPermille(1000)); // No low-power time yet
+
+    m.enter(POWER_LOW, 0);
+    m.addSleep(600000);
+    m.addSleep(300000);
+    TEST_ASSERT_EQUAL_UINT32(2, m.sleeps());
+    TEST_ASSERT_EQUAL_UINT32(900, m.sleepPermille(1000000));
+
+    // 10% at 30 mA, 90% at 1 mA
+    TEST_ASSERT_EQUAL_UINT32(3900, m.estimateLowPowerMicroAmps(30000, 1000, 1000000));
+
+    // Residency never exceeds the low-power time
+    m.addSleep(500000);
+    TEST_ASSERT_EQUAL_UINT32(1000, m.sleepPermille(1000000));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_only_long_quiet_states_sleep);
+    RUN_TEST(test_modem_sleep_fits_keepalive_budget);
+    RUN_TEST(test_meter_accounts_time_per_mode);
+    RUN_TEST(test_meter_estimates_current_from_residency);
+    return UNITY_END();
+}
@@ -0,0 +1,114 @@
+/*
+ * File: test/test_provisioning_codec/test_provisioning_codec.cpp
+ * Description: Unit tests for the packed (TLV) BLE provisioning format.
+ * Covers round trips, legacy single-value writes, forward compatibility
+ * and all-or-nothing rejection of malformed packets.
+ */
+#include <unity.h>
+#include "ProvisioningCodec.h"
+
+static ProvisioningFields makeFields() {
+    ProvisioningFields f;
+    memset(&f, 0, sizeof(f));
+    f.channelMask = 0x0F;
+    return f;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================================================
+// PACKETS
+// ============================================================================
+
+void test_full_packet_round_trip(void) {
+    ProvisioningFields in = makeFields();
+    strcpy(in.ssid, "HomeNet");
+    strcpy(in.pass, "hunter22");
+    in.config.enableRewardCode = true;
+    in.config.rewardPenaltyStrategy = DETERRENT_RANDOM;
+    in.config.rewardPenaltyMin = 600;
+    in.config.rewardPenaltyMax = 1800;
+    in.presets.minSessionDuration = 60;
+    in.presets.maxSessionDuration = 86400;
+    in.channelMask = 0x05;
+    in.present = PROV_TAG_BIT(PROV_TAG_SSID) | PROV_TAG_BIT(PROV_TAG_PASS) | PROV_TAG_BIT(PROV_TAG_ENABLE_REWARD_CODE) |
+                 PROV_TAG_BIT(PROV_TAG_REWARD_STRATEGY) | PROV_TAG_BIT(PROV_TAG_REWARD_MIN) | PROV_TAG_BIT(PROV_TAG_REWARD_MAX) |
+                 PROV_TAG_BIT(PROV_TAG_MIN_SESSION) | PROV_TAG_BIT(PROV_TAG_MAX_SESSION) | PROV_TAG_BIT(PROV_TAG_CHANNEL_MASK);
+
+    uint8_t buf[256];
+    size_t len = ProvisioningCodec::encodePacket(in, buf, sizeof(buf));
+    TEST_ASSERT_TRUE(len > 0);
+    TEST_ASSERT_EQUAL_UINT8(PROV_PACKET_VERSION, buf[0]);
+
+    ProvisioningFields out = makeFields();
+    TEST_ASSERT_EQUAL(PROV_DECODE_OK, ProvisioningCodec::decodePacket(buf, len, out));
+    TEST_ASSERT_EQUAL_UINT32(in.present, out.present);
+    TEST_ASSERT_EQUAL_STRING("HomeNet", out.ssid);
+    TEST_ASSERT_EQUAL_STRING("hunter22", out.pass);
+    TEST_ASSERT_TRUE(out.config.enableRewardCode);
+    TEST_ASSERT_EQUAL(DETERRENT_RANDOM, out.config.rewardPenaltyStrategy);
+    TEST_ASSERT_EQUAL_UINT32(1800, out.config.rewardPenaltyMax);
+    TEST_ASSERT_EQUAL_UINT32(86400, out.presets.maxSessionDuration);
+    TEST_ASSERT_EQUAL_UINT8(0x05, out.channelMask);
+
+    // Too small for the payload
+    TEST_ASSERT_EQUAL(0, ProvisioningCodec::encodePacket(in, buf, 16));
+}
+
+void test_unknown_tags_are_skipped(void) {
+    const uint8_t pkt[] = {PROV_PACKET_VERSION, 200, 2, 0xAA, 0xBB, PROV_TAG_PAYBACK_TIME, 2, 0x2C, 0x01};
+    ProvisioningFields f = makeFields();
+    TEST_ASSERT_EQUAL(PROV_DECODE_OK, ProvisioningCodec::decodePacket(pkt, sizeof(pkt), f));
+    TEST_ASSERT_EQUAL_UINT32(300, f.config.paybackTime);
+    TEST_ASSERT_EQUAL_UINT32(PROV_TAG_BIT(PROV_TAG_PAYBACK_TIME), f.present);
+}
+
+void test_malformed_packet_changes_nothing(void) {
+    ProvisioningFields f = makeFields();
+    f.config.paybackTime = 900;
+
+    // Valid first record, then a record running past the end
+    const uint8_t truncated[] = {PROV_PACKET_VERSION, PROV_TAG_PAYBACK_TIME, 1, 60, PROV_TAG_SSID, 8, 'a', 'b'};
+    TEST_ASSERT_EQUAL(PROV_DECODE_TRUNCATED, ProvisioningCodec::decodePacket(truncated, sizeof(truncated), f));
+    TEST_ASSERT_EQUAL_UINT32(900, f.config.paybackTime);
+    TEST_ASSERT_EQUAL_UINT32(0, f.present);
+
+    const uint8_t wideInt[] = {PROV_PACKET_VERSION, PROV_TAG_PAYBACK_TIME, 5, 1, 2, 3, 4, 5};
+    TEST_ASSERT_EQUAL(PROV_DECODE_BAD_LENGTH, ProvisioningCodec::decodePacket(wideInt, sizeof(wideInt), f));
+
+    const uint8_t future[] = {PROV_PACKET_VERSION + 1, PROV_TAG_PAYBACK_TIME, 1, 60};
+    TEST_ASSERT_EQUAL(PROV_DECODE_BAD_VERSION, ProvisioningCodec::decodePacket(future, sizeof(future), f));
+    TEST_ASSERT_EQUAL_UINT32(900, f.config.paybackTime);
+}
+
+// ============================================================================
+// LEGACY VALUES
+// ============================================================================
+
+void test_legacy_values_use_the_same_table(void) {
+    ProvisioningFields f = makeFields();
+
+    const uint8_t u32[] = {0x10, 0x0E, 0x00, 0x00}; // 3600, as the old characteristics send it
+    TEST_ASSERT_EQUAL(PROV_DECODE_OK, ProvisioningCodec::decodeValue(PROV_TAG_LONG_MIN, u32, sizeof(u32), f));
+    TEST_ASSERT_EQUAL_UINT32(3600, f.presets.longMin);
+
+    const uint8_t off = 0;
+    TEST_ASSERT_EQUAL(PROV_DECODE_OK, ProvisioningCodec::decodeValue(PROV_TAG_CH2_ENABLE, &off, 1, f));
+    TEST_ASSERT_EQUAL_UINT8(0x0D, f.channelMask);
+
+    char longSsid[PROV_SSID_MAX + 1];
+    memset(longSsid, 'x', sizeof(longSsid));
+    TEST_ASSERT_EQUAL(PROV_DECODE_BAD_LENGTH,
+                      ProvisioningCodec::decodeValue(PROV_TAG_SSID, (const uint8_t *)longSsid, sizeof(longSsid), f));
+    TEST_ASSERT_FALSE(f.has(PROV_TAG_SSID));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_full_packet_round_trip);
+    RUN_TEST(test_unknown_tags_are_skipped);
+    RUN_TEST(test_malformed_packet_changes_nothing);
+    RUN_TEST(test_legacy_values_use_the_same_table);
+    return UNITY_END();
+}
@@ -177,6 +177,35 @@ void test_reward_preserved_after_penalty_and_reboot(void) {
     delete engine;
 }
 
+void test_history_order_survives_ring_wrap(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine* engine = createEngine(hal, rules);
+
+    // Rotate past the ring size several times (TESTING -> reboot -> READY)
+    const int rotations = REWARD_HISTORY_SIZE * 2 + 3;
+    char codes[rotations + 1][REWARD_CODE_LENGTH + 1];
+    strcpy(codes[0], engine->getRewardHistory()[0].code);
+    for (int r = 1; r <= rotations; r++) {
+        TEST_ASSERT_EQUAL(200, engine->startTest());
+        int callsBefore = hal.fillRandomCalls;
+        engine->handleReboot();
+        TEST_ASSERT_TRUE(hal.fillRandomCalls > callsBefore); // One bulk read per attempt
+        strcpy(codes[r], engine->getRewardHistory()[0].code);
+    }
+
+    // Newest first, with unique checksums
+    const Reward* history = engine->getRewardHistory();
+    for (int i = 0; i < REWARD_HISTORY_SIZE; i++) {
+        TEST_ASSERT_EQUAL_STRING(codes[rotations - i], history[i].code);
+        TEST_ASSERT_EQUAL(REWARD_CODE_LENGTH, strlen(history[i].code));
+        for (int j = 0; j < i; j++) {
+            TEST_ASSERT_NOT_EQUAL(0, strcmp(history[i].checksum, history[j].checksum));
+        }
+    }
+
+    delete engine;
+}
+
 int main(void) {
     UNITY_BEGIN();
     
@@ -185,6 +214,6 @@ int main(void) {
     RUN_TEST(test_reward_hidden_in_penalty_box);
     RUN_TEST(test_reward_visible_and_correct_on_completion);
     RUN_TEST(test_reward_preserved_after_penalty_and_reboot);
-
+    RUN_TEST(test_history_order_survives_ring_wrap);
     return UNITY_END();
 }
\ No newline at end of file
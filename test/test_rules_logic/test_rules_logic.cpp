@@ -188,6 +188,18 @@ void test_completion_reduces_debt_fairly(void) {
     TEST_ASSERT_EQUAL_UINT32(25200, stats.paybackAccumulated);
 }
 
+void test_elapsed_locked_equals_repeated_ticks(void) {
+    StandardRules rules;
+    SessionStats perTick = {0};
+    SessionStats bulk = {0};
+
+    for (int i = 0; i < 90; i++) rules.onTickLocked(perTick);
+    rules.onElapsedLocked(bulk, 90);
+
+    TEST_ASSERT_EQUAL_UINT32(90, bulk.totalLockedTime);
+    TEST_ASSERT_EQUAL_UINT32(perTick.totalLockedTime, bulk.totalLockedTime);
+}
+
 // --- Runner ---
 int main(void) {
     UNITY_BEGIN();
@@ -202,6 +214,8 @@ int main(void) {
     
     RUN_TEST(test_completion_clamps_debt_at_zero);
     RUN_TEST(test_completion_reduces_debt_fairly);
+
+    RUN_TEST(test_elapsed_locked_equals_repeated_ticks);
     
     return UNITY_END();
 }
\ No newline at end of file
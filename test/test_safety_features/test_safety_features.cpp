@@ -173,6 +173,29 @@ void test_hardware_abort_works_without_validated_hardware(void) {
     TEST_ASSERT_EQUAL(ABORTED, engine.getState());
 }
 
+void test_long_press_drops_mask_between_ticks(void) {
+    MockSessionHAL hal; StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    hal.setSafetyInterlock(true);
+
+    SessionConfig cfg = { DUR_FIXED, 600, 0, 0, STRAT_AUTO_COUNTDOWN };
+    engine.startSession(cfg);
+    engine.tick();
+    TEST_ASSERT_EQUAL(LOCKED, engine.getState());
+    TEST_ASSERT_EQUAL_HEX8(0x0F, hal.lastSafetyMask);
+
+    // Input wake-up only: no tick() in between
+    hal.simulateLongPress();
+    engine.processInputs();
+
+    TEST_ASSERT_EQUAL(ABORTED, engine.getState());
+    TEST_ASSERT_EQUAL_HEX8(0x00, hal.lastSafetyMask);
+
+    EngineSnapshot snap;
+    TEST_ASSERT_TRUE(engine.readSnapshot(snap));
+    TEST_ASSERT_EQUAL(ABORTED, snap.state);
+}
+
 // ============================================================================
 // EXTENDED REBOOT SCENARIOS
 // ============================================================================
@@ -528,6 +551,7 @@ int main(void) {
     RUN_TEST(test_watchdog_petting_prevents_timeout_and_resets_strikes);
     RUN_TEST(test_ui_watchdog_timeout_aborts_session);
     RUN_TEST(test_hardware_abort_works_without_validated_hardware);
+    RUN_TEST(test_long_press_drops_mask_between_ticks);
 
     // 2. Reboot Scenarios
     RUN_TEST(test_reboot_from_locked_enforces_penalty);
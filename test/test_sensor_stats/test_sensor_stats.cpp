@@ -0,0 +1,59 @@
+/*
+ * File: test/test_sensor_stats/test_sensor_stats.cpp
+ * Description: Unit tests for SmoothedReading: average seeding, EMA
+ * convergence, min/max tracking and rejection of failed reads.
+ */
+#include <unity.h>
+#include <math.h>
+#include "SensorStats.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_first_sample_seeds_everything(void) {
+    SmoothedReading r(0.25f);
+    TEST_ASSERT_FALSE(r.valid());
+
+    r.add(42.0f);
+    TEST_ASSERT_TRUE(r.valid());
+    TEST_ASSERT_EQUAL_FLOAT(42.0f, r.ema());
+    TEST_ASSERT_EQUAL_FLOAT(42.0f, r.minimum());
+    TEST_ASSERT_EQUAL_FLOAT(42.0f, r.maximum());
+}
+
+void test_ema_smooths_a_spike(void) {
+    SmoothedReading r(0.25f);
+    r.add(40.0f);
+    r.add(80.0f); // One bad read moves the average a quarter of the way
+    TEST_ASSERT_EQUAL_FLOAT(50.0f, r.ema());
+    TEST_ASSERT_EQUAL_FLOAT(80.0f, r.last());
+    TEST_ASSERT_EQUAL_FLOAT(80.0f, r.maximum());
+
+    // A sustained change is followed
+    for (int i = 0; i < 40; i++) r.add(60.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60.0f, r.ema());
+    TEST_ASSERT_EQUAL_FLOAT(40.0f, r.minimum());
+}
+
+void test_failed_reads_are_ignored(void) {
+    SmoothedReading r(0.5f);
+    r.add(NAN);
+    TEST_ASSERT_FALSE(r.valid());
+
+    r.add(30.0f);
+    r.add(NAN);
+    r.add(INFINITY);
+    TEST_ASSERT_EQUAL_UINT32(1, r.count());
+    TEST_ASSERT_EQUAL_FLOAT(30.0f, r.ema());
+
+    r.reset();
+    TEST_ASSERT_FALSE(r.valid());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_sample_seeds_everything);
+    RUN_TEST(test_ema_smooths_a_spike);
+    RUN_TEST(test_failed_reads_are_ignored);
+    return UNITY_END();
+}
@@ -424,6 +424,33 @@ void test_outcome_immediate_abort(void) {
     TEST_ASSERT_EQUAL(OUTCOME_ABORTED, engine.getOutcome()); 
 }
 
+// Generation counter drives conditional /status responses
+void test_generation_tracks_state_not_ticks(void) {
+    MockSessionHAL hal;
+    StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    engageSafetyInterlock(hal, engine);
+
+    SessionConfig cfg = {};
+    cfg.durationType = DUR_FIXED;
+    cfg.durationFixed = 60;
+    cfg.triggerStrategy = STRAT_BUTTON_TRIGGER;
+
+    uint32_t g0 = engine.getGeneration();
+    engine.startSession(cfg);
+    engine.trigger("API");
+    uint32_t g1 = engine.getGeneration();
+    TEST_ASSERT_GREATER_THAN(g0, g1);
+
+    // Countdown alone does not bump the generation
+    for (int i = 0; i < 5; i++) engine.tick();
+    TEST_ASSERT_EQUAL(LOCKED, engine.getState());
+    TEST_ASSERT_EQUAL_UINT32(g1, engine.getGeneration());
+
+    engine.abort("API");
+    TEST_ASSERT_GREATER_THAN(g1, engine.getGeneration());
+}
+
 // ============================================================================
 // MAIN RUNNER
 // ============================================================================
@@ -457,6 +484,7 @@ int main(void) {
     RUN_TEST(test_start_auto_countdown_zeros_disabled_channels);
     RUN_TEST(test_led_logic_with_disable_feature);
     RUN_TEST(test_outcome_immediate_abort);
+    RUN_TEST(test_generation_tracks_state_not_ticks);
 
     return UNITY_END();
 }
\ No newline at end of file
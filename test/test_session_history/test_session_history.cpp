@@ -0,0 +1,339 @@
+/*
+ * File: test/test_session_history/test_session_history.cpp
+ * Description: Unit tests for the flash session history: record codec,
+ * append/paging over a RAM-backed flash, ring wrap, recovery at mount,
+ * and the engine writing exactly one record per finished session.
+ */
+#include <unity.h>
+#include <vector>
+#include "SessionHistory.h"
+#include "Session.h"
+#include "MockSessionHAL.h"
+#include "StandardRules.h"
+
+// NOR-like flash: erase sets 0xFF, writes only clear bits
+class RamFlash : public IHistoryFlash {
+public:
+    std::vector<uint8_t> mem;
+    int erases = 0;
+
+    explicit RamFlash(size_t sectors) : mem(sectors * HISTORY_SECTOR_SIZE, 0xFF) {}
+
+    bool read(uint32_t addr, void *buf, size_t len) override {
+        if (addr + len > mem.size()) return false;
+        memcpy(buf, &mem[addr], len);
+        return true;
+    }
+    bool write(uint32_t addr, const void *buf, size_t len) override {
+        if (addr + len > mem.size()) return false;
+        const uint8_t *b = static_cast<const uint8_t *>(buf);
+        for (size_t i = 0; i < len; i++) mem[addr + i] &= b[i];
+        return true;
+    }
+    bool eraseSector(uint32_t addr) override {
+        if (addr % HISTORY_SECTOR_SIZE || addr >= mem.size()) return false;
+        memset(&mem[addr], 0xFF, HISTORY_SECTOR_SIZE);
+        erases++;
+        return true;
+    }
+};
+
+typedef SessionHistory<4> History;
+
+static HistoryEntry makeEntry(uint32_t boot, uint32_t endS, uint32_t locked) {
+    HistoryEntry e;
+    memset(&e, 0, sizeof(e));
+    e.boot = boot;
+    e.endS = endS;
+    e.startS = endS - locked;
+    e.outcome = OUTCOME_SUCCESS;
+    e.lockedS = locked;
+    e.plannedS = locked;
+    return e;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================================================
+// CODEC
+// ============================================================================
+
+void test_codec_roundtrip_and_size(void) {
+    HistoryContext prev = {7, 1, 1000};
+    HistoryEntry e = makeEntry(1, 4600, 3600);
+    e.outcome = OUTCOME_ABORTED;
+    e.plannedS = 3900;
+    e.penaltyS = 300;
+    e.timeModS = -120;
+
+    uint8_t buf[HISTORY_RECORD_MAX];
+    size_t n = HistoryCodec::encode(e, prev, buf);
+    TEST_ASSERT_TRUE(n <= 18); // Deltas keep a typical session small
+
+    HistoryEntry out;
+    size_t used = 0;
+    TEST_ASSERT_TRUE(HistoryCodec::decode(buf, n, prev, out, used));
+    TEST_ASSERT_EQUAL_UINT32(n, used);
+    TEST_ASSERT_EQUAL_UINT32(7, out.seq);
+    TEST_ASSERT_EQUAL_UINT32(1, out.boot);
+    TEST_ASSERT_EQUAL_UINT32(1000, out.startS);
+    TEST_ASSERT_EQUAL_UINT32(4600, out.endS);
+    TEST_ASSERT_EQUAL(OUTCOME_ABORTED, out.outcome);
+    TEST_ASSERT_EQUAL_UINT32(3600, out.lockedS);
+    TEST_ASSERT_EQUAL_UINT32(3900, out.plannedS);
+    TEST_ASSERT_EQUAL_UINT32(300, out.penaltyS);
+    TEST_ASSERT_EQUAL_INT32(-120, out.timeModS);
+
+    // Unknown start survives, so does a new boot (end time restarts)
+    e.startS = 0;
+    e.boot = 2;
+    e.endS = 50;
+    n = HistoryCodec::encode(e, prev, buf);
+    TEST_ASSERT_TRUE(HistoryCodec::decode(buf, n, prev, out, used));
+    TEST_ASSERT_EQUAL_UINT32(0, out.startS);
+    TEST_ASSERT_EQUAL_UINT32(2, out.boot);
+    TEST_ASSERT_EQUAL_UINT32(50, out.endS);
+}
+
+void test_codec_rejects_erased_and_corrupt(void) {
+    HistoryContext prev = {0, 0, 0};
+    HistoryEntry e = makeEntry(0, 100, 60);
+    uint8_t buf[HISTORY_RECORD_MAX];
+    size_t n = HistoryCodec::encode(e, prev, buf);
+
+    HistoryEntry out;
+    size_t used;
+    buf[2] ^= 0x01;
+    TEST_ASSERT_FALSE(HistoryCodec::decode(buf, n, prev, out, used));
+
+    uint8_t erased[HISTORY_RECORD_MAX];
+    memset(erased, 0xFF, sizeof(erased));
+    TEST_ASSERT_FALSE(HistoryCodec::decode(erased, sizeof(erased), prev, out, used));
+}
+
+// ============================================================================
+// RING
+// ============================================================================
+
+void test_append_and_page(void) {
+    RamFlash flash(4);
+    History log;
+    log.mount(&flash);
+    TEST_ASSERT_EQUAL_UINT32(0, log.nextSeq());
+
+    for (uint32_t i = 0; i < 10; i++) {
+        HistoryEntry e = makeEntry(0, 1000 + i * 100, 60);
+        TEST_ASSERT_TRUE(log.append(e));
+        TEST_ASSERT_EQUAL_UINT32(i, e.seq);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, log.firstSeq());
+    TEST_ASSERT_EQUAL_UINT32(10, log.nextSeq());
+
+    History::Cursor c;
+    log.seek(4, c);
+    HistoryEntry out;
+    for (uint32_t i = 4; i < 7; i++) {
+        TEST_ASSERT_TRUE(log.next(c, out));
+        TEST_ASSERT_EQUAL_UINT32(i, out.seq);
+        TEST_ASSERT_EQUAL_UINT32(1000 + i * 100, out.endS);
+    }
+
+    // Appends while a reader is paging are picked up
+    HistoryEntry late = makeEntry(0, 5000, 60);
+    log.append(late);
+    uint32_t seen = 0;
+    while (log.next(c, out)) seen++;
+    TEST_ASSERT_EQUAL_UINT32(4, seen); // 7, 8, 9, 10
+    TEST_ASSERT_EQUAL_UINT32(10, out.seq);
+}
+
+void test_ring_wraps_and_recycles_oldest(void) {
+    RamFlash flash(4);
+    History log;
+    log.mount(&flash);
+
+    History::Cursor c;
+    log.seek(0, c);
+
+    // Far more than four sectors' worth
+    const uint32_t total = 2000;
+    for (uint32_t i = 0; i < total; i++) {
+        HistoryEntry e = makeEntry(0, 10 + i * 7, 5);
+        TEST_ASSERT_TRUE(log.append(e));
+    }
+    TEST_ASSERT_EQUAL_UINT32(total, log.nextSeq());
+    TEST_ASSERT_TRUE(log.firstSeq() > 0);
+    TEST_ASSERT_TRUE(flash.erases > 4);
+
+    // The stale cursor resumes at the oldest record kept, then reads to the end in order
+    HistoryEntry out;
+    TEST_ASSERT_TRUE(log.next(c, out));
+    TEST_ASSERT_EQUAL_UINT32(log.firstSeq(), out.seq);
+    uint32_t expect = out.seq + 1;
+    while (log.next(c, out)) {
+        TEST_ASSERT_EQUAL_UINT32(expect, out.seq);
+        TEST_ASSERT_EQUAL_UINT32(10 + expect * 7, out.endS);
+        expect++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(total, expect);
+}
+
+void test_mount_restores_end_of_log(void) {
+    RamFlash flash(4);
+    {
+        History log;
+        log.mount(&flash);
+        for (uint32_t i = 0; i < 5; i++) {
+            HistoryEntry e = makeEntry(0, 100 + i, 1);
+            log.append(e);
+        }
+    }
+
+    History log;
+    log.mount(&flash);
+    TEST_ASSERT_EQUAL_UINT32(0, log.firstSeq());
+    TEST_ASSERT_EQUAL_UINT32(5, log.nextSeq());
+
+    // The delta base carries over: a new-boot entry after remount decodes correctly
+    HistoryEntry e = makeEntry(1, 30, 20);
+    TEST_ASSERT_TRUE(log.append(e));
+    TEST_ASSERT_EQUAL_UINT32(5, e.seq);
+
+    History::Cursor c;
+    log.seek(4, c);
+    HistoryEntry out;
+    TEST_ASSERT_TRUE(log.next(c, out));
+    TEST_ASSERT_EQUAL_UINT32(104, out.endS);
+    TEST_ASSERT_TRUE(log.next(c, out));
+    TEST_ASSERT_EQUAL_UINT32(1, out.boot);
+    TEST_ASSERT_EQUAL_UINT32(10, out.startS);
+    TEST_ASSERT_FALSE(log.next(c, out));
+}
+
+void test_torn_record_closes_sector(void) {
+    RamFlash flash(4);
+    {
+        History log;
+        log.mount(&flash);
+        for (uint32_t i = 0; i < 3; i++) {
+            HistoryEntry e = makeEntry(0, 100 + i, 1);
+            log.append(e);
+        }
+    }
+    // Power lost mid-write: a length byte with no valid body
+    size_t end = sizeof(HistorySectorHeader);
+    while (flash.mem[end] != 0xFF) end++;
+    flash.mem[end] = 12;
+
+    History log;
+    log.mount(&flash);
+    TEST_ASSERT_EQUAL_UINT32(3, log.nextSeq());
+
+    HistoryEntry e = makeEntry(0, 200, 1);
+    TEST_ASSERT_TRUE(log.append(e));
+    TEST_ASSERT_EQUAL_UINT32(3, e.seq);
+
+    // Written to a fresh sector, and still readable in order across the boundary
+    History::Cursor c;
+    log.seek(0, c);
+    HistoryEntry out;
+    uint32_t n = 0;
+    while (log.next(c, out)) n++;
+    TEST_ASSERT_EQUAL_UINT32(4, n);
+    TEST_ASSERT_EQUAL_UINT32(200, out.endS);
+}
+
+// ============================================================================
+// ENGINE
+// ============================================================================
+
+const SystemDefaults defaults = {5, 10, 240, 10000, 4, 5, 30000, 3, 60};
+const SessionPresets presets = {300, 600, 900, 1800, 3600, 7200, 14400, 10};
+
+static void lockFor(MockSessionHAL &hal, SessionEngine &engine, uint32_t seconds) {
+    hal.setSafetyInterlock(true);
+    engine.tick();
+    hal.advanceTime(11000);
+    engine.tick();
+
+    SessionConfig cfg = {};
+    cfg.durationType = DUR_FIXED;
+    cfg.durationFixed = seconds;
+    cfg.triggerStrategy = STRAT_AUTO_COUNTDOWN;
+    engine.startSession(cfg);
+    engine.tick();
+}
+
+void test_engine_records_completed_session(void) {
+    DeterrentConfig deterrents = {};
+    deterrents.enableTimeModification = true;
+    deterrents.timeModificationStep = 60;
+
+    MockSessionHAL hal;
+    StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    lockFor(hal, engine, 600);
+    TEST_ASSERT_EQUAL(LOCKED, engine.getState());
+    uint32_t startS = hal.getMillis() / 1000;
+
+    TEST_ASSERT_EQUAL(200, engine.modifyTime(true));
+    TEST_ASSERT_EQUAL(200, engine.modifyTime(true));
+    TEST_ASSERT_EQUAL(200, engine.modifyTime(false));
+
+    for (int i = 0; i < 660 && engine.getState() == LOCKED; i++) {
+        hal.advanceTime(1000);
+        engine.petWatchdog();
+        engine.tick();
+    }
+    TEST_ASSERT_EQUAL(COMPLETED, engine.getState());
+
+    TEST_ASSERT_EQUAL(1, (int)hal.history.size());
+    const HistoryEntry &e = hal.history[0];
+    TEST_ASSERT_EQUAL(OUTCOME_SUCCESS, e.outcome);
+    TEST_ASSERT_EQUAL_UINT32(startS, e.startS);
+    TEST_ASSERT_TRUE(e.endS > e.startS);
+    TEST_ASSERT_EQUAL_UINT32(660, e.plannedS);
+    TEST_ASSERT_EQUAL_UINT32(660, e.lockedS);
+    TEST_ASSERT_EQUAL_UINT32(0, e.penaltyS);
+    TEST_ASSERT_EQUAL_INT32(60, e.timeModS);
+}
+
+void test_engine_records_abort_once(void) {
+    DeterrentConfig deterrents = {};
+    deterrents.enableRewardCode = true;
+    deterrents.rewardPenaltyStrategy = DETERRENT_FIXED;
+    deterrents.rewardPenalty = 300;
+
+    MockSessionHAL hal;
+    StandardRules rules;
+    SessionEngine engine(hal, rules, defaults, presets, deterrents);
+    lockFor(hal, engine, 600);
+    for (int i = 0; i < 100; i++) engine.tick();
+
+    engine.abort("Test");
+    TEST_ASSERT_EQUAL(ABORTED, engine.getState());
+    TEST_ASSERT_EQUAL(1, (int)hal.history.size());
+    TEST_ASSERT_EQUAL(OUTCOME_ABORTED, hal.history[0].outcome);
+    TEST_ASSERT_EQUAL_UINT32(100, hal.history[0].lockedS);
+    TEST_ASSERT_EQUAL_UINT32(600, hal.history[0].plannedS);
+    TEST_ASSERT_EQUAL_UINT32(300, hal.history[0].penaltyS);
+
+    // Serving the penalty does not add a second record
+    engine.advance(300);
+    TEST_ASSERT_EQUAL(COMPLETED, engine.getState());
+    TEST_ASSERT_EQUAL(1, (int)hal.history.size());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_codec_roundtrip_and_size);
+    RUN_TEST(test_codec_rejects_erased_and_corrupt);
+    RUN_TEST(test_append_and_page);
+    RUN_TEST(test_ring_wraps_and_recycles_oldest);
+    RUN_TEST(test_mount_restores_end_of_log);
+    RUN_TEST(test_torn_record_closes_sector);
+    RUN_TEST(test_engine_records_completed_session);
+    RUN_TEST(test_engine_records_abort_once);
+    return UNITY_END();
+}
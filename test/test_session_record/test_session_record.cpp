@@ -0,0 +1,134 @@
+/*
+ * File: test/test_session_record/test_session_record.cpp
+ * Description: Unit tests for the packed, CRC-checked session state record.
+ * Verifies lossless round trips and rejection of corrupt or foreign blobs.
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "SessionRecord.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --- Fixture ---
+
+static void fillSample(DeviceState& s, SessionTimers& t, SessionStats& st, SessionConfig& c) {
+    s = ABORTED;
+
+    memset(&t, 0, sizeof(t));
+    t.lockDuration = 3600;
+    t.potentialDebtServed = 600;
+    t.penaltyDuration = 900;
+    t.lockRemaining = 0;
+    t.penaltyRemaining = 845;
+    t.testRemaining = 0;
+    t.triggerTimeout = 12;
+    for (int i = 0; i < MAX_CHANNELS; i++) t.channelDelays[i] = 10 * (i + 1);
+
+    memset(&st, 0, sizeof(st));
+    st.streaks = 3;
+    st.completed = 17;
+    st.aborted = 2;
+    st.paybackAccumulated = 1200;
+    st.totalLockedTime = 987654;
+
+    memset(&c, 0, sizeof(c));
+    c.durationType = DUR_RANGE_MEDIUM;
+    c.durationFixed = 0;
+    c.durationMin = 1800;
+    c.durationMax = 7200;
+    c.triggerStrategy = STRAT_BUTTON_TRIGGER;
+    c.hideTimer = true;
+    c.disableLED = false;
+    for (int i = 0; i < MAX_CHANNELS; i++) c.channelDelays[i] = 5 * (i + 1);
+}
+
+// --- CRC ---
+
+void test_crc32_known_vector(void) {
+    // Standard check value for "123456789"
+    const char* v = "123456789";
+    TEST_ASSERT_EQUAL_UINT32(0xCBF43926, LogicUtils::crc32((const uint8_t*)v, strlen(v)));
+}
+
+// --- Round Trip ---
+
+void test_record_roundtrip_preserves_all_fields(void) {
+    DeviceState s; SessionTimers t; SessionStats st; SessionConfig c;
+    fillSample(s, t, st, c);
+
+    SessionRecord rec;
+    SessionRecordCodec::encode(s, t, st, c, 42, rec);
+
+    DeviceState s2 = READY; SessionTimers t2 = {0}; SessionStats st2 = {0}; SessionConfig c2 = {};
+    uint32_t seq = 0;
+    TEST_ASSERT_TRUE(SessionRecordCodec::decode((const uint8_t*)&rec, sizeof(rec), s2, t2, st2, c2, &seq));
+
+    TEST_ASSERT_EQUAL(s, s2);
+    TEST_ASSERT_EQUAL_UINT32(42, seq);
+    TEST_ASSERT_EQUAL_UINT32(t.lockDuration, t2.lockDuration);
+    TEST_ASSERT_EQUAL_UINT32(t.potentialDebtServed, t2.potentialDebtServed);
+    TEST_ASSERT_EQUAL_UINT32(t.penaltyRemaining, t2.penaltyRemaining);
+    TEST_ASSERT_EQUAL_UINT32(t.triggerTimeout, t2.triggerTimeout);
+    TEST_ASSERT_EQUAL_UINT32(st.totalLockedTime, st2.totalLockedTime);
+    TEST_ASSERT_EQUAL_UINT32(st.paybackAccumulated, st2.paybackAccumulated);
+    TEST_ASSERT_EQUAL(c.durationType, c2.durationType);
+    TEST_ASSERT_EQUAL(c.triggerStrategy, c2.triggerStrategy);
+    TEST_ASSERT_TRUE(c2.hideTimer);
+    TEST_ASSERT_FALSE(c2.disableLED);
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        TEST_ASSERT_EQUAL_UINT32(t.channelDelays[i], t2.channelDelays[i]);
+        TEST_ASSERT_EQUAL_UINT32(c.channelDelays[i], c2.channelDelays[i]);
+    }
+}
+
+// --- Rejection ---
+
+void test_record_rejects_corrupted_byte(void) {
+    DeviceState s; SessionTimers t; SessionStats st; SessionConfig c;
+    fillSample(s, t, st, c);
+
+    SessionRecord rec;
+    SessionRecordCodec::encode(s, t, st, c, 1, rec);
+    ((uint8_t*)&rec)[12] ^= 0x01; // Flip a bit inside the timers
+
+    DeviceState s2 = READY; SessionTimers t2 = {0}; SessionStats st2 = {0}; SessionConfig c2 = {};
+    TEST_ASSERT_FALSE(SessionRecordCodec::decode((const uint8_t*)&rec, sizeof(rec), s2, t2, st2, c2));
+
+    // Outputs untouched on failure
+    TEST_ASSERT_EQUAL(READY, s2);
+    TEST_ASSERT_EQUAL_UINT32(0, t2.lockDuration);
+}
+
+void test_record_rejects_unknown_version(void) {
+    DeviceState s; SessionTimers t; SessionStats st; SessionConfig c;
+    fillSample(s, t, st, c);
+
+    SessionRecord rec;
+    SessionRecordCodec::encode(s, t, st, c, 1, rec);
+    rec.version = SESSION_RECORD_VERSION + 1;
+
+    TEST_ASSERT_FALSE(SessionRecordCodec::decode((const uint8_t*)&rec, sizeof(rec), s, t, st, c));
+}
+
+void test_record_rejects_truncated_blob(void) {
+    DeviceState s; SessionTimers t; SessionStats st; SessionConfig c;
+    fillSample(s, t, st, c);
+
+    SessionRecord rec;
+    SessionRecordCodec::encode(s, t, st, c, 1, rec);
+
+    TEST_ASSERT_FALSE(SessionRecordCodec::decode((const uint8_t*)&rec, sizeof(rec) - 1, s, t, st, c));
+    TEST_ASSERT_FALSE(SessionRecordCodec::decode(nullptr, sizeof(rec), s, t, st, c));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_crc32_known_vector);
+    RUN_TEST(test_record_roundtrip_preserves_all_fields);
+    RUN_TEST(test_record_rejects_corrupted_byte);
+    RUN_TEST(test_record_rejects_unknown_version);
+    RUN_TEST(test_record_rejects_truncated_blob);
+    return UNITY_END();
+}
@@ -0,0 +1,114 @@
+/*
+ * File: test/test_spsc_ring/test_spsc_ring.cpp
+ * Description: Unit tests for the lock-free SPSC record queue behind the serial drain.
+ * Covers FIFO order, wrap-around, full-ring rejection and a two-thread stress run.
+ */
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include "SpscRing.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static bool popString(SpscRing<64> &ring, char *out, size_t outSize) {
+    size_t len = 0;
+    if (!ring.pop((uint8_t *)out, outSize - 1, len)) return false;
+    out[len] = '\0';
+    return true;
+}
+
+// ============================================================================
+// BASIC QUEUEING
+// ============================================================================
+
+void test_push_pop_is_fifo(void) {
+    SpscRing<64> ring;
+    TEST_ASSERT_TRUE(ring.empty());
+    TEST_ASSERT_TRUE(ring.push((const uint8_t *)"one", 3));
+    TEST_ASSERT_TRUE(ring.push((const uint8_t *)"two", 3));
+    TEST_ASSERT_EQUAL(2 * (2 + 3), ring.bytesUsed());
+
+    char out[16];
+    TEST_ASSERT_TRUE(popString(ring, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("one", out);
+    TEST_ASSERT_TRUE(popString(ring, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("two", out);
+    TEST_ASSERT_FALSE(popString(ring, out, sizeof(out)));
+    TEST_ASSERT_TRUE(ring.empty());
+}
+
+void test_full_ring_rejects_without_overwriting(void) {
+    SpscRing<64> ring;
+    uint8_t blob[20];
+    memset(blob, 'z', sizeof(blob));
+
+    // 3 x 22 bytes > 64: the third push must fail
+    TEST_ASSERT_TRUE(ring.push(blob, sizeof(blob)));
+    TEST_ASSERT_TRUE(ring.push(blob, sizeof(blob)));
+    TEST_ASSERT_FALSE(ring.push(blob, sizeof(blob)));
+
+    // Oversized records are rejected outright
+    uint8_t big[100] = {0};
+    TEST_ASSERT_FALSE(ring.push(big, sizeof(big)));
+
+    // Existing records are intact
+    uint8_t out[32];
+    size_t len = 0;
+    TEST_ASSERT_TRUE(ring.pop(out, sizeof(out), len));
+    TEST_ASSERT_EQUAL(sizeof(blob), len);
+    TEST_ASSERT_EQUAL_MEMORY(blob, out, sizeof(blob));
+}
+
+void test_records_survive_wrap_around(void) {
+    SpscRing<64> ring;
+    char line[16], out[16];
+    for (int i = 0; i < 200; i++) {
+        snprintf(line, sizeof(line), "rec-%03d", i); // 9 byte records, offsets drift across the boundary
+        TEST_ASSERT_TRUE(ring.push((const uint8_t *)line, strlen(line)));
+        TEST_ASSERT_TRUE(popString(ring, out, sizeof(out)));
+        TEST_ASSERT_EQUAL_STRING(line, out);
+    }
+}
+
+// ============================================================================
+// CONCURRENCY
+// ============================================================================
+
+void test_two_thread_stream_is_ordered_and_complete(void) {
+    static SpscRing<256> ring;
+    const uint32_t total = 20000;
+
+    std::thread producer([&]() {
+        for (uint32_t i = 0; i < total; i++) {
+            while (!ring.push((const uint8_t *)&i, sizeof(i))) std::this_thread::yield(); // Full: wait for the consumer
+        }
+    });
+
+    uint32_t expected = 0;
+    bool ordered = true;
+    while (expected < total) {
+        uint32_t v = 0;
+        size_t len = 0;
+        if (ring.pop((uint8_t *)&v, sizeof(v), len)) {
+            if (len != sizeof(v) || v != expected) ordered = false;
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    TEST_ASSERT_TRUE(ordered);
+    TEST_ASSERT_TRUE(ring.empty());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_push_pop_is_fifo);
+    RUN_TEST(test_full_ring_rejects_without_overwriting);
+    RUN_TEST(test_records_survive_wrap_around);
+    RUN_TEST(test_two_thread_stream_is_ordered_and_complete);
+    return UNITY_END();
+}
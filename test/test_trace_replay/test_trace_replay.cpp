@@ -0,0 +1,299 @@
+/*
+ * File: test/test_trace_replay/test_trace_replay.cpp
+ * Description: Records engine traces through TraceRecordingHAL and replays them
+ * with TraceReplayer (bit-exact replay, divergence detection, truncated traces).
+ *
+ * Set ENGINE_TRACE_FILE to a trace downloaded from GET /trace to replay it as
+ * part of the suite; its report (divergences, per-call timing) is printed.
+ */
+#include <unity.h>
+#include <stdlib.h>
+#include "TraceReplay.h"
+
+// --- Constants ---
+const SystemDefaults defaults = { 5, 10, 240, 10, 4, 5, 30000, 3, 60, 60 };
+const SessionPresets presets = { 300, 600, 900, 1800, 3600, 7200, 14400, 10 };
+const DeterrentConfig deterrents = { true, true, DETERRENT_FIXED, 300, 900, 300, true, DETERRENT_FIXED, 60, 120, 60, true, 30 };
+
+typedef TraceRecordingHAL<65536> Recorder;
+
+// --- Helpers (record each call, then make it, like the firmware's call sites) ---
+static void update(Recorder &rec, MockSessionHAL &hal, SessionEngine &engine, uint32_t ms) {
+    hal.advanceTime(ms);
+    rec.recordUpdate(hal.currentMillis);
+    engine.update(hal.currentMillis);
+}
+
+static void pet(Recorder &rec, SessionEngine &engine) {
+    rec.recordCall(TRACE_CALL_PET);
+    engine.petWatchdog();
+}
+
+static int start(Recorder &rec, SessionEngine &engine, uint32_t seconds) {
+    SessionConfig cfg = {};
+    cfg.durationType = DUR_FIXED;
+    cfg.durationFixed = seconds;
+    cfg.triggerStrategy = STRAT_AUTO_COUNTDOWN;
+    cfg.channelDelays[1] = 5;
+    rec.recordStart(cfg);
+    int result = engine.startSession(cfg);
+    rec.recordResult(result);
+    return result;
+}
+
+// One recorded "device": the engine runs on the recorder, which wraps the mock
+struct Incident {
+    MockSessionHAL hal;
+    Recorder rec{hal};
+    StandardRules rules;
+    std::unique_ptr<SessionEngine> engine;
+};
+
+/**
+ * A lock with keep-alives, a time modification, interlock flapping inside the
+ * grace period and finally a long-press abort.
+ */
+static void recordIncident(Incident &in) {
+    in.rec.recordSetup(defaults, presets, deterrents);
+    in.engine.reset(new SessionEngine(in.rec, in.rules, defaults, presets, deterrents));
+    SessionEngine &engine = *in.engine;
+
+    in.hal.setSafetyInterlock(true);
+    for (int i = 0; i < 12; i++) update(in.rec, in.hal, engine, 1000);
+    start(in.rec, engine, 120);
+
+    for (int s = 0; s < 60; s++) {
+        if (s % 7 == 3) in.hal.setSafetyRawButKeepValid(false, true); // Flapping, still in grace
+        if (s % 7 == 4) in.hal.setSafetyInterlock(true);
+        if (s % 5 == 0) pet(in.rec, engine);
+        if (s == 20) {
+            in.rec.recordCall(TRACE_CALL_MODIFY, true);
+            in.rec.recordResult(engine.modifyTime(true));
+        }
+        update(in.rec, in.hal, engine, 1000);
+    }
+
+    in.hal.simulateLongPress();
+    in.rec.recordCall(TRACE_CALL_INPUTS);
+    engine.processInputs();
+    for (int i = 0; i < 3; i++) update(in.rec, in.hal, engine, 1000);
+}
+
+// Offset of the n-th record of 'kind' (or 0)
+static size_t findRecord(const uint8_t *data, size_t len, uint8_t kind, int n = 0) {
+    TraceReader reader(data, len);
+    TraceRecord r;
+    while (reader.next(r)) {
+        if (r.kind == kind && n-- == 0) return r.offset;
+    }
+    return 0;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// ============================================================================
+// TESTS
+// ============================================================================
+
+void test_codec_blobs_roundtrip(void) {
+    uint8_t blob[TRACE_BLOB_MAX];
+    size_t n = TraceCodec::encodeSetup(defaults, presets, deterrents, blob);
+    SystemDefaults d;
+    SessionPresets p;
+    DeterrentConfig c;
+    TEST_ASSERT_TRUE(TraceCodec::decodeSetup(blob, n, d, p, c));
+    TEST_ASSERT_EQUAL_UINT32(defaults.keepAliveInterval, d.keepAliveInterval);
+    TEST_ASSERT_EQUAL_UINT32(defaults.checkpointInterval, d.checkpointInterval);
+    TEST_ASSERT_EQUAL_UINT32(presets.maxSessionDuration, p.maxSessionDuration);
+    TEST_ASSERT_TRUE(c.enableTimeModification);
+    TEST_ASSERT_EQUAL_UINT32(deterrents.timeModificationStep, c.timeModificationStep);
+    TEST_ASSERT_FALSE(TraceCodec::decodeSetup(blob, n - 1, d, p, c)); // Truncated
+
+    SessionConfig cfg = {};
+    cfg.durationType = DUR_RANGE_LONG;
+    cfg.durationMax = 7200;
+    cfg.triggerStrategy = STRAT_BUTTON_TRIGGER;
+    cfg.channelDelays[MAX_CHANNELS - 1] = 90;
+    cfg.disableLED = true;
+    SessionConfig out;
+    n = TraceCodec::encodeConfig(cfg, blob);
+    TEST_ASSERT_TRUE(TraceCodec::decodeConfig(blob, n, out));
+    TEST_ASSERT_EQUAL(DUR_RANGE_LONG, out.durationType);
+    TEST_ASSERT_EQUAL_UINT32(7200, out.durationMax);
+    TEST_ASSERT_EQUAL_UINT32(90, out.channelDelays[MAX_CHANNELS - 1]);
+    TEST_ASSERT_FALSE(out.hideTimer);
+    TEST_ASSERT_TRUE(out.disableLED);
+}
+
+void test_replay_is_bit_exact(void) {
+    Incident in;
+    recordIncident(in);
+    TEST_ASSERT_EQUAL(ABORTED, in.engine->getState());
+    TEST_ASSERT_FALSE(in.rec.full());
+
+    TraceReplayer replay(in.rec.data(), in.rec.size());
+    bool ok = replay.run();
+    if (!ok) replay.printReport(stdout);
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_FALSE(replay.truncated());
+    TEST_ASSERT_EQUAL(ABORTED, replay.engine()->getState());
+
+    // Same timers, same reward code, same mask as on the "device"
+    TEST_ASSERT_EQUAL_UINT32(in.engine->getTimers().penaltyRemaining, replay.engine()->getTimers().penaltyRemaining);
+    TEST_ASSERT_EQUAL_UINT32(in.engine->getTimers().lockDuration, replay.engine()->getTimers().lockDuration);
+    EngineSnapshot recorded, replayed;
+    TEST_ASSERT_TRUE(in.engine->readSnapshot(recorded));
+    TEST_ASSERT_TRUE(replay.engine()->readSnapshot(replayed));
+    TEST_ASSERT_EQUAL_STRING(recorded.rewards[0].code, replayed.rewards[0].code);
+    TEST_ASSERT_EQUAL_HEX8(in.hal.lastSafetyMask, replay.hal().lastSafetyMask);
+
+    // 1 setup, 12 + 60 + 3 updates, 1 start, 12 pets, 1 modify, 1 inputs
+    TEST_ASSERT_EQUAL_UINT32(91, replay.steps());
+    TEST_ASSERT_EQUAL_UINT32(75, replay.stats(TRACE_CALL_UPDATE).count);
+    TEST_ASSERT_EQUAL_UINT32(12, replay.stats(TRACE_CALL_PET).count);
+}
+
+void test_trace_is_compact(void) {
+    Incident in;
+    recordIncident(in);
+
+    // Under 16 bytes per engine second, setup and reward codes included
+    TEST_ASSERT_LESS_THAN(75 * 16, in.rec.size());
+}
+
+void test_changed_output_is_reported(void) {
+    Incident in;
+    recordIncident(in);
+
+    std::vector<uint8_t> trace(in.rec.data(), in.rec.data() + in.rec.size());
+    size_t at = findRecord(trace.data(), trace.size(), TRACE_OUT_STATE);
+    TEST_ASSERT_NOT_EQUAL(0, at);
+    trace[at + 1] = COMPLETED; // The recorded engine "saved" another state
+
+    TraceReplayer replay(trace.data(), trace.size());
+    TEST_ASSERT_FALSE(replay.run());
+    TEST_ASSERT_EQUAL(1, replay.divergences().size());
+    const TraceDivergence &d = replay.divergences()[0];
+    TEST_ASSERT_EQUAL(TRACE_OUT_STATE, d.expectedKind);
+    TEST_ASSERT_EQUAL(COMPLETED, d.expected);
+    TEST_ASSERT_EQUAL(at, d.offset);
+    TEST_ASSERT_EQUAL(ABORTED, replay.engine()->getState()); // Value divergences do not stop the replay
+}
+
+void test_reordered_input_stops_replay(void) {
+    Incident in;
+    recordIncident(in);
+
+    // Drop one interlock reading from the middle of the lock
+    std::vector<uint8_t> trace(in.rec.data(), in.rec.data() + in.rec.size());
+    size_t at = findRecord(trace.data(), trace.size(), TRACE_IN_INTERLOCK_VALID, 30);
+    TEST_ASSERT_NOT_EQUAL(0, at);
+    trace.erase(trace.begin() + at);
+
+    TraceReplayer replay(trace.data(), trace.size());
+    TEST_ASSERT_FALSE(replay.run());
+    TEST_ASSERT_EQUAL(1, replay.divergences().size());
+    TEST_ASSERT_EQUAL(TRACE_IN_INTERLOCK_VALID, replay.divergences()[0].actualKind);
+    TEST_ASSERT_LESS_THAN(91, replay.steps());
+}
+
+void test_full_buffer_replays_as_truncated(void) {
+    MockSessionHAL hal;
+    TraceRecordingHAL<300> rec(hal);
+    StandardRules rules;
+    rec.recordSetup(defaults, presets, deterrents);
+    SessionEngine engine(rec, rules, defaults, presets, deterrents);
+    hal.setSafetyInterlock(true);
+    for (int i = 0; i < 200; i++) {
+        hal.advanceTime(1000);
+        rec.recordUpdate(hal.currentMillis);
+        engine.update(hal.currentMillis);
+    }
+    TEST_ASSERT_TRUE(rec.full());
+    TEST_ASSERT_LESS_OR_EQUAL(300, rec.size());
+
+    TraceReplayer replay(rec.data(), rec.size());
+    TEST_ASSERT_TRUE(replay.run());
+    TEST_ASSERT_GREATER_THAN(10, replay.stats(TRACE_CALL_UPDATE).count);
+    TEST_ASSERT_LESS_THAN(200, replay.stats(TRACE_CALL_UPDATE).count);
+}
+
+void test_restored_state_and_reboot_replay(void) {
+    MockSessionHAL hal;
+    Recorder rec(hal);
+    StandardRules rules;
+    hal.setSafetyInterlock(true);
+
+    SessionTimers timers = {};
+    timers.lockDuration = 600;
+    timers.lockRemaining = 400;
+    SessionStats stats = {};
+    stats.streaks = 3;
+    SessionConfig config = {};
+    config.durationType = DUR_FIXED;
+    config.durationFixed = 600;
+
+    rec.recordSetup(defaults, presets, deterrents);
+    SessionEngine engine(rec, rules, defaults, presets, deterrents);
+    rec.recordLoad(LOCKED, timers, stats, config);
+    engine.loadState(LOCKED);
+    engine.loadTimers(timers);
+    engine.loadStats(stats);
+    engine.loadConfig(config);
+    rec.recordCall(TRACE_CALL_REBOOT);
+    engine.handleReboot();
+    rec.recordCall(TRACE_CALL_DIAGNOSTICS);
+    engine.printStartupDiagnostics();
+
+    TraceReplayer replay(rec.data(), rec.size());
+    bool ok = replay.run();
+    if (!ok) replay.printReport(stdout);
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_EQUAL(engine.getState(), replay.engine()->getState());
+    TEST_ASSERT_EQUAL_UINT32(engine.getTimers().penaltyRemaining, replay.engine()->getTimers().penaltyRemaining);
+    TEST_ASSERT_EQUAL_UINT32(engine.getStats().streaks, replay.engine()->getStats().streaks);
+    TEST_ASSERT_EQUAL_UINT32(engine.getStats().aborted, replay.engine()->getStats().aborted);
+}
+
+void test_foreign_trace_is_rejected(void) {
+    uint8_t bad[8] = {0x45, 0x54, TRACE_VERSION, MAX_CHANNELS + 1, TRACE_CALL_PET};
+    TraceReplayer replay(bad, sizeof(bad));
+    TEST_ASSERT_FALSE(replay.run());
+    TEST_ASSERT_FALSE(replay.valid());
+    TEST_ASSERT_EQUAL_UINT32(0, replay.steps());
+}
+
+// Replays a downloaded trace (regression / benchmark input)
+void test_replay_trace_file(void) {
+    const char *path = getenv("ENGINE_TRACE_FILE");
+    if (path == nullptr || *path == '\0') return;
+
+    FILE *f = fopen(path, "rb");
+    TEST_ASSERT_NOT_NULL(f);
+    std::vector<uint8_t> trace;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) trace.insert(trace.end(), chunk, chunk + n);
+    fclose(f);
+
+    TraceReplayer replay(trace.data(), trace.size());
+    bool ok = replay.run();
+    replay.printReport(stdout);
+    TEST_ASSERT_TRUE(replay.valid());
+    TEST_ASSERT_TRUE(ok);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_codec_blobs_roundtrip);
+    RUN_TEST(test_replay_is_bit_exact);
+    RUN_TEST(test_trace_is_compact);
+    RUN_TEST(test_changed_output_is_reported);
+    RUN_TEST(test_reordered_input_stops_replay);
+    RUN_TEST(test_full_buffer_replays_as_truncated);
+    RUN_TEST(test_restored_state_and_reboot_replay);
+    RUN_TEST(test_foreign_trace_is_rejected);
+    RUN_TEST(test_replay_trace_file);
+    return UNITY_END();
+}
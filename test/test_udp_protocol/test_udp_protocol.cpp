@@ -0,0 +1,119 @@
+/*
+ * File: test/test_udp_protocol/test_udp_protocol.cpp
+ * Description: Unit tests for the authenticated UDP keep-alive protocol.
+ * Covers the SipHash reference vectors, request/response round trips,
+ * tag rejection and the per-client replay window.
+ */
+#include <unity.h>
+#include <string.h>
+#include "UdpProtocol.h"
+
+static uint8_t key[UDP_KEY_SIZE];
+
+void setUp(void) {
+    for (int i = 0; i < UDP_KEY_SIZE; i++) key[i] = (uint8_t)i;
+}
+void tearDown(void) {}
+
+// ============================================================================
+// SIPHASH
+// ============================================================================
+
+void test_siphash_reference_vectors(void) {
+    uint8_t msg[15];
+    for (int i = 0; i < 15; i++) msg[i] = (uint8_t)i;
+
+    // Key 00..0f, messages 00..(n-1), from the SipHash paper's test set
+    TEST_ASSERT_TRUE(SipHash::hash(key, msg, 0) == 0x726fdb47dd0e0e31ULL);
+    TEST_ASSERT_TRUE(SipHash::hash(key, msg, 8) == 0x93f5f5799a932462ULL);
+    TEST_ASSERT_TRUE(SipHash::hash(key, msg, 15) == 0xa129ca6149be45e5ULL);
+}
+
+// ============================================================================
+// FRAMING
+// ============================================================================
+
+void test_request_round_trip(void) {
+    UdpRequest req = {UDP_OP_KEEPALIVE, 0xA1B2C3D4, 77, 5};
+    uint8_t buf[UDP_REQUEST_SIZE];
+    TEST_ASSERT_EQUAL(UDP_REQUEST_SIZE, UdpProtocol::encodeRequest(key, req, buf, sizeof(buf)));
+
+    UdpRequest out = {};
+    TEST_ASSERT_EQUAL(UDP_DECODE_OK, UdpProtocol::decodeRequest(key, buf, sizeof(buf), out));
+    TEST_ASSERT_EQUAL_UINT8(UDP_OP_KEEPALIVE, out.opcode);
+    TEST_ASSERT_EQUAL_HEX32(0xA1B2C3D4, out.bootNonce);
+    TEST_ASSERT_EQUAL_UINT32(77, out.clientId);
+    TEST_ASSERT_EQUAL_UINT32(5, out.seq);
+
+    // A request is never accepted as a response, and vice versa
+    UdpResponse res;
+    TEST_ASSERT_EQUAL(UDP_DECODE_MALFORMED, UdpProtocol::decodeResponse(key, buf, sizeof(buf), res));
+    TEST_ASSERT_EQUAL(UDP_DECODE_MALFORMED, UdpProtocol::decodeRequest(key, buf, sizeof(buf) - 1, out));
+}
+
+void test_tampered_or_wrong_key_is_rejected(void) {
+    UdpRequest req = {UDP_OP_ABORT, 1, 2, 3};
+    uint8_t buf[UDP_REQUEST_SIZE];
+    UdpProtocol::encodeRequest(key, req, buf, sizeof(buf));
+
+    UdpRequest out;
+    buf[2] = UDP_OP_KEEPALIVE; // Opcode flipped in transit
+    TEST_ASSERT_EQUAL(UDP_DECODE_BAD_TAG, UdpProtocol::decodeRequest(key, buf, sizeof(buf), out));
+
+    buf[2] = UDP_OP_ABORT;
+    uint8_t otherKey[UDP_KEY_SIZE];
+    memcpy(otherKey, key, sizeof(otherKey));
+    otherKey[0] ^= 1;
+    TEST_ASSERT_EQUAL(UDP_DECODE_BAD_TAG, UdpProtocol::decodeRequest(otherKey, buf, sizeof(buf), out));
+    TEST_ASSERT_EQUAL(UDP_DECODE_OK, UdpProtocol::decodeRequest(key, buf, sizeof(buf), out));
+}
+
+void test_response_carries_digest(void) {
+    UdpResponse res = {UDP_OP_STATUS, UDP_RESULT_OK, 9, 77, 5, {3, 1, 42, 600, 0}};
+    uint8_t buf[UDP_RESPONSE_SIZE];
+    TEST_ASSERT_EQUAL(UDP_RESPONSE_SIZE, UdpProtocol::encodeResponse(key, res, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_HEX8(UDP_OP_STATUS | UDP_RESPONSE_FLAG, buf[2]);
+
+    UdpResponse out = {};
+    TEST_ASSERT_EQUAL(UDP_DECODE_OK, UdpProtocol::decodeResponse(key, buf, sizeof(buf), out));
+    TEST_ASSERT_EQUAL_UINT8(UDP_OP_STATUS, out.opcode);
+    TEST_ASSERT_EQUAL_UINT32(5, out.seq);
+    TEST_ASSERT_EQUAL_UINT8(3, out.digest.state);
+    TEST_ASSERT_EQUAL_UINT32(42, out.digest.generation);
+    TEST_ASSERT_EQUAL_UINT32(600, out.digest.lockRemaining);
+}
+
+// ============================================================================
+// REPLAY GUARD
+// ============================================================================
+
+void test_replay_guard_requires_increasing_seq(void) {
+    UdpReplayGuard<2> guard;
+    TEST_ASSERT_TRUE(guard.accept(1, 10));
+    TEST_ASSERT_FALSE(guard.accept(1, 10)); // Replayed
+    TEST_ASSERT_FALSE(guard.accept(1, 9));  // Older
+    TEST_ASSERT_TRUE(guard.accept(1, 11));
+    TEST_ASSERT_TRUE(guard.accept(2, 1));   // Independent per client
+}
+
+void test_replay_guard_evicts_least_recent(void) {
+    UdpReplayGuard<2> guard;
+    guard.accept(1, 10);
+    guard.accept(2, 10);
+    guard.accept(1, 11); // Client 2 is now the least recent
+    guard.accept(3, 1);  // Evicts client 2
+
+    TEST_ASSERT_FALSE(guard.accept(1, 11)); // Client 1 kept its window
+    TEST_ASSERT_TRUE(guard.accept(2, 5));   // Forgotten, starts over
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_siphash_reference_vectors);
+    RUN_TEST(test_request_round_trip);
+    RUN_TEST(test_tampered_or_wrong_key_is_rejected);
+    RUN_TEST(test_response_carries_digest);
+    RUN_TEST(test_replay_guard_requires_increasing_seq);
+    RUN_TEST(test_replay_guard_evicts_least_recent);
+    return UNITY_END();
+}
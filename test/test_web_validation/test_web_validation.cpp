@@ -2,11 +2,13 @@
  * File: test/test_web_validation/test_web_validation.cpp
  * Description: Unit tests for WebValidators input validation.
  * Verifies reasonable lengths for WiFi credentials and valid SessionConfig parsing.
+ * Also feeds fragmented request bodies through BodyAccumulator.
  */
 #include <unity.h>
 #include <string.h>
 #include <ArduinoJson.h>
 #include "WebValidators.h"
+#include "BodyAccumulator.h"
 #include "Types.h"
 
 // ============================================================================
@@ -108,6 +110,24 @@ void test_parse_channel_mask_enforcement(void) {
     TEST_ASSERT_EQUAL_STRING("Cannot set delay for disabled/missing channel index: 1", err.c_str());
 }
 
+void test_parse_delays_cover_every_channel(void) {
+    // Runs at MAX_CHANNELS 4 (env:native) and 12 (env:native_wide)
+    JsonDocument doc;
+    JsonArray delays = doc["channelDelays"].to<JsonArray>();
+    for (int i = 0; i <= MAX_CHANNELS; i++) delays.add(10 * (i + 1)); // One extra entry
+
+    SessionConfig cfg;
+    std::string err;
+    TEST_ASSERT_TRUE(WebValidators::parseSessionConfig(doc, CHANNEL_MASK_ALL, cfg, err));
+    for (int i = 0; i < MAX_CHANNELS; i++) TEST_ASSERT_EQUAL_UINT32(10 * (i + 1), cfg.channelDelays[i]);
+
+    // The last channel is still checked against the mask
+    ChannelMask withoutLast = (ChannelMask)(CHANNEL_MASK_ALL & ~(1u << (MAX_CHANNELS - 1)));
+    TEST_ASSERT_FALSE(WebValidators::parseSessionConfig(doc, withoutLast, cfg, err));
+    std::string expected = "Cannot set delay for disabled/missing channel index: " + std::to_string(MAX_CHANNELS - 1);
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), err.c_str());
+}
+
 void test_parse_random_range_sanity(void) {
     JsonDocument doc;
     doc["durationType"] = "DUR_RANDOM"; 
@@ -122,6 +142,163 @@ void test_parse_random_range_sanity(void) {
     TEST_ASSERT_EQUAL_STRING("durationMin cannot be greater than durationMax.", err.c_str());
 }
 
+// ============================================================================
+// STATIC IP PARSING TESTS
+// ============================================================================
+
+void test_parse_ipv4(void) {
+    uint32_t ip = 0;
+    TEST_ASSERT_TRUE(WebValidators::parseIPv4("192.168.1.20", ip));
+    TEST_ASSERT_EQUAL_HEX32(0x1401A8C0, ip); // First octet in the low byte
+
+    TEST_ASSERT_FALSE(WebValidators::parseIPv4("192.168.1", ip));
+    TEST_ASSERT_FALSE(WebValidators::parseIPv4("192.168.1.256", ip));
+    TEST_ASSERT_FALSE(WebValidators::parseIPv4("192.168.1.20x", ip));
+    TEST_ASSERT_FALSE(WebValidators::parseIPv4("192..1.20", ip));
+}
+
+void test_static_ip_empty_means_dhcp(void) {
+    JsonDocument doc;
+    doc["ip"] = "";
+    uint32_t ip = 1, gw = 1, mask = 1, dns = 1;
+    std::string err;
+
+    TEST_ASSERT_TRUE(WebValidators::parseStaticIp(doc, ip, gw, mask, dns, err));
+    TEST_ASSERT_EQUAL_UINT32(0, ip);
+    TEST_ASSERT_EQUAL_UINT32(0, mask);
+}
+
+void test_static_ip_validates_subnet(void) {
+    JsonDocument doc;
+    doc["ip"] = "192.168.1.20";
+    doc["gateway"] = "192.168.1.1";
+    doc["subnet"] = "255.255.255.0";
+    uint32_t ip, gw, mask, dns;
+    std::string err;
+
+    TEST_ASSERT_TRUE(WebValidators::parseStaticIp(doc, ip, gw, mask, dns, err));
+    TEST_ASSERT_EQUAL_HEX32(gw, dns); // DNS defaults to the gateway
+
+    doc["subnet"] = "255.0.255.0";
+    TEST_ASSERT_FALSE(WebValidators::parseStaticIp(doc, ip, gw, mask, dns, err));
+    TEST_ASSERT_EQUAL_STRING("Invalid subnet.", err.c_str());
+
+    doc["subnet"] = "255.255.255.0";
+    doc["gateway"] = "10.0.0.1";
+    TEST_ASSERT_FALSE(WebValidators::parseStaticIp(doc, ip, gw, mask, dns, err));
+    TEST_ASSERT_EQUAL_STRING("Gateway is outside the subnet.", err.c_str());
+}
+
+// ============================================================================
+// BATCH PARSING TESTS
+// ============================================================================
+
+void test_parse_batch_keeps_order(void) {
+    JsonDocument doc;
+    JsonArray list = doc["ops"].to<JsonArray>();
+    list.add("keepalive");
+    list.add("time/add");
+    list.add("status");
+
+    BatchOp ops[BATCH_MAX_OPS];
+    size_t count = 0;
+    std::string err;
+    TEST_ASSERT_TRUE(WebValidators::parseBatch(doc, ops, BATCH_MAX_OPS, count, err));
+    TEST_ASSERT_EQUAL(3, count);
+    TEST_ASSERT_EQUAL(BATCH_KEEPALIVE, ops[0]);
+    TEST_ASSERT_EQUAL(BATCH_TIME_ADD, ops[1]);
+    TEST_ASSERT_EQUAL(BATCH_STATUS, ops[2]);
+    TEST_ASSERT_EQUAL_STRING("time/add", WebValidators::batchOpName(ops[1]));
+}
+
+void test_parse_batch_rejects_unknown_and_oversized(void) {
+    JsonDocument doc;
+    JsonArray list = doc["ops"].to<JsonArray>();
+    list.add("keepalive");
+    list.add("reboot");
+
+    BatchOp ops[BATCH_MAX_OPS];
+    size_t count = 0;
+    std::string err;
+    TEST_ASSERT_FALSE(WebValidators::parseBatch(doc, ops, BATCH_MAX_OPS, count, err));
+    TEST_ASSERT_EQUAL_STRING("Unknown op: reboot", err.c_str());
+    TEST_ASSERT_EQUAL(0, count);
+
+    doc.clear();
+    list = doc["ops"].to<JsonArray>();
+    for (int i = 0; i < 3; i++) list.add("status");
+    TEST_ASSERT_FALSE(WebValidators::parseBatch(doc, ops, 2, count, err));
+    TEST_ASSERT_EQUAL_STRING("Too many ops (max 2).", err.c_str());
+
+    doc.clear();
+    doc["ops"] = "status";
+    TEST_ASSERT_FALSE(WebValidators::parseBatch(doc, ops, BATCH_MAX_OPS, count, err));
+    TEST_ASSERT_EQUAL_STRING("ops must be an array.", err.c_str());
+}
+
+// ============================================================================
+// REQUEST BODY TESTS
+// ============================================================================
+
+static const char ARM_BODY[] =
+    "{\"durationType\":\"DUR_FIXED\",\"durationFixed\":600,\"triggerStrategy\":\"STRAT_BUTTON_TRIGGER\"}";
+
+void test_body_unfragmented_is_used_in_place(void) {
+    BodyAccumulator body;
+    const uint8_t *raw = (const uint8_t *)ARM_BODY;
+    size_t n = sizeof(ARM_BODY) - 1;
+
+    TEST_ASSERT_EQUAL(BODY_COMPLETE, body.feed(nullptr, raw, n, 0, n, 2048));
+    TEST_ASSERT_TRUE(body.data() == ARM_BODY);
+    TEST_ASSERT_FALSE(body.buffered());
+}
+
+void test_body_fragmented_reassembles_for_parser(void) {
+    static uint8_t storage[512];
+    FixedArena arena;
+    arena.attach(storage, sizeof(storage));
+
+    // Three TCP segments, split mid-key and mid-number
+    const uint8_t *raw = (const uint8_t *)ARM_BODY;
+    size_t n = sizeof(ARM_BODY) - 1;
+    size_t cut1 = 7, cut2 = 40;
+
+    BodyAccumulator body;
+    TEST_ASSERT_EQUAL(BODY_PARTIAL, body.feed(&arena, raw, cut1, 0, n, 2048));
+    TEST_ASSERT_EQUAL(BODY_PARTIAL, body.feed(&arena, raw + cut1, cut2 - cut1, cut1, n, 2048));
+    TEST_ASSERT_EQUAL(BODY_COMPLETE, body.feed(&arena, raw + cut2, n - cut2, cut2, n, 2048));
+    TEST_ASSERT_TRUE(body.buffered());
+    TEST_ASSERT_TRUE(arena.owns(body.data()));
+    TEST_ASSERT_EQUAL(n, body.length());
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, body.data(), body.length()));
+    SessionConfig cfg;
+    std::string err;
+    TEST_ASSERT_TRUE(WebValidators::parseSessionConfig(doc, 0x0F, cfg, err));
+    TEST_ASSERT_EQUAL_UINT32(600, cfg.durationFixed);
+}
+
+void test_body_rejects_oversized_gaps_and_full_arena(void) {
+    static uint8_t storage[32];
+    FixedArena arena;
+    arena.attach(storage, sizeof(storage));
+    const uint8_t *raw = (const uint8_t *)ARM_BODY;
+    size_t n = sizeof(ARM_BODY) - 1;
+
+    BodyAccumulator body;
+    TEST_ASSERT_EQUAL(BODY_TOO_LARGE, body.feed(&arena, raw, 10, 0, n, 16));
+
+    // Does not fit the arena
+    TEST_ASSERT_EQUAL(BODY_NO_MEMORY, body.feed(&arena, raw, 10, 0, n, 2048));
+
+    // A chunk that skips bytes, or arrives without a first chunk
+    TEST_ASSERT_EQUAL(BODY_PARTIAL, body.feed(&arena, raw, 4, 0, 20, 2048));
+    TEST_ASSERT_EQUAL(BODY_BAD_CHUNK, body.feed(&arena, raw + 8, 4, 8, 20, 2048));
+    BodyAccumulator fresh;
+    TEST_ASSERT_EQUAL(BODY_BAD_CHUNK, fresh.feed(&arena, raw + 4, 4, 4, 20, 2048));
+}
+
 // ============================================================================
 // MAIN
 // ============================================================================
@@ -143,7 +320,22 @@ int main(void) {
     RUN_TEST(test_parse_valid_fixed_config);
     RUN_TEST(test_parse_invalid_duration_type);
     RUN_TEST(test_parse_channel_mask_enforcement);
+    RUN_TEST(test_parse_delays_cover_every_channel);
     RUN_TEST(test_parse_random_range_sanity);
 
+    // Static IP Validation
+    RUN_TEST(test_parse_ipv4);
+    RUN_TEST(test_static_ip_empty_means_dhcp);
+    RUN_TEST(test_static_ip_validates_subnet);
+
+    // Batch Parsing
+    RUN_TEST(test_parse_batch_keeps_order);
+    RUN_TEST(test_parse_batch_rejects_unknown_and_oversized);
+
+    // Request Bodies
+    RUN_TEST(test_body_unfragmented_is_used_in_place);
+    RUN_TEST(test_body_fragmented_reassembles_for_parser);
+    RUN_TEST(test_body_rejects_oversized_gaps_and_full_arena);
+
     return UNITY_END();
 }
\ No newline at end of file